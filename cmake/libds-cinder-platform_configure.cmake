@@ -9,6 +9,10 @@ if( NOT DS_CINDER_MSW )
 	add_definitions( -Wfatal-errors )
 endif()
 
+if( DS_CINDER_TRACK_ALLOCATIONS )
+	list( APPEND DS_CINDER_DEFINES "-DDS_TRACK_ALLOCATIONS" )
+endif()
+
 # Load cmake modules from our own cmake Modules path
 list( APPEND CMAKE_MODULE_PATH ${DS_CINDER_CMAKE_DIR} ${CMAKE_CURRENT_LIST_DIR}/modules )
 
@@ -20,6 +20,8 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/arc/arc_layer.cpp
 	${ROOT_PATH}/src/ds/arc/arc_io.cpp
 	${ROOT_PATH}/src/ds/gl/uniform.cpp
+	${ROOT_PATH}/src/ds/gl/compressed_texture.cpp
+	${ROOT_PATH}/src/ds/gl/block_compression.cpp
 	${ROOT_PATH}/src/ds/network/http_client.cpp		# error: invalid initialization of non-const reference of type ‘std::unique_ptr<ds::WorkRequest>&’ from an rvalue of type ‘std::unique_ptr<ds::WorkRequest>’
 	${ROOT_PATH}/src/ds/network/node_watcher.cpp
 	${ROOT_PATH}/src/ds/network/packet_chunker.cpp
@@ -32,9 +34,11 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/time/timer.cpp
 	${ROOT_PATH}/src/ds/thread/work_request.cpp
 	${ROOT_PATH}/src/ds/thread/work_manager.cpp
-	${ROOT_PATH}/src/ds/thread/gl_thread.cpp			# Uses win32 and WGL APIs
+	${ROOT_PATH}/src/ds/thread/gl_upload_pool.cpp
 	${ROOT_PATH}/src/ds/thread/runnable_client.cpp		# error: invalid initialization of non-const reference of type ‘std::unique_ptr<ds::WorkRequest>&’ from an rvalue of type ‘std::unique_ptr<ds::WorkRequest>’
 	${ROOT_PATH}/src/ds/thread/work_client.cpp
+	${ROOT_PATH}/src/ds/thread/task.cpp
+	${ROOT_PATH}/src/ds/thread/parallel_for.cpp
 	#${ROOT_PATH}/src/ds/storage/directory_watcher_win32.cpp	# Uses win32 apis
 	${ROOT_PATH}/src/ds/storage/persistent_cache.cpp
 	${ROOT_PATH}/src/ds/storage/directory_watcher.cpp
@@ -60,6 +64,7 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/app/engine/engine_io_defs.cpp
 	${ROOT_PATH}/src/ds/app/engine/engine_standalone.cpp
 	${ROOT_PATH}/src/ds/app/engine/engine_clientserver.cpp
+	${ROOT_PATH}/src/ds/app/engine/engine_headless.cpp
 	${ROOT_PATH}/src/ds/app/error.cpp
 	${ROOT_PATH}/src/ds/app/blob_reader.cpp
 	${ROOT_PATH}/src/ds/app/camera_utils.cpp
@@ -73,6 +78,7 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/app/auto_draw.cpp
 	${ROOT_PATH}/src/ds/app/event_notifier.cpp
 	${ROOT_PATH}/src/ds/app/auto_update_list.cpp
+	${ROOT_PATH}/src/ds/app/parallel_update.cpp
 	${ROOT_PATH}/src/ds/ui/touch/button_behaviour.cpp
 	${ROOT_PATH}/src/ds/ui/touch/picking.cpp
 	${ROOT_PATH}/src/ds/ui/touch/momentum.cpp
@@ -84,11 +90,15 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/ui/touch/select_picking.cpp
 	${ROOT_PATH}/src/ds/ui/touch/touch_translator.cpp
 	${ROOT_PATH}/src/ds/ui/touch/touch_mode.cpp
+	${ROOT_PATH}/src/ds/ui/touch/tuio_receiver.cpp
+	${ROOT_PATH}/src/ds/ui/touch/gesture_engine.cpp
+	${ROOT_PATH}/src/ds/ui/touch/gesture_recognizers.cpp
 	${ROOT_PATH}/src/ds/ui/tween/tweenline.cpp
 	${ROOT_PATH}/src/ds/ui/tween/sprite_anim.cpp
 	${ROOT_PATH}/src/ds/ui/service/glsl_image_service.cpp
 	${ROOT_PATH}/src/ds/ui/service/pango_font_service.cpp
 	${ROOT_PATH}/src/ds/ui/service/load_image_service.cpp
+	${ROOT_PATH}/src/ds/ui/service/glyph_atlas.cpp
 	${ROOT_PATH}/src/ds/ui/sprite/util/blend.cpp
 	${ROOT_PATH}/src/ds/ui/sprite/util/clip_plane.cpp
 	${ROOT_PATH}/src/ds/ui/sprite/sprite_engine.cpp
@@ -109,6 +119,7 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/ui/ip/ip_function.cpp
 	${ROOT_PATH}/src/ds/ui/ip/ip_defs.cpp
 	${ROOT_PATH}/src/ds/ui/ip/ip_function_list.cpp
+	${ROOT_PATH}/src/ds/ui/ip/ip_simd.cpp
 	${ROOT_PATH}/src/ds/ui/image_source/image_client.cpp
 	${ROOT_PATH}/src/ds/ui/image_source/image_glsl.cpp
 	${ROOT_PATH}/src/ds/ui/image_source/image_drop_shadow.cpp
@@ -131,6 +142,10 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/debug/computer_info.cpp
 	${ROOT_PATH}/src/ds/debug/debug_defines.cpp
 	${ROOT_PATH}/src/ds/debug/logger.cpp
+	${ROOT_PATH}/src/ds/debug/profiler.cpp
+	${ROOT_PATH}/src/ds/debug/touch_latency_log.cpp
+	${ROOT_PATH}/src/ds/debug/touch_recorder.cpp
+	${ROOT_PATH}/src/ds/debug/touch_replayer.cpp
 	${ROOT_PATH}/src/ds/math/math_func.cpp
 	${ROOT_PATH}/src/ds/cfg/cfg_nine_patch.cpp
 	${ROOT_PATH}/src/ds/cfg/settings.cpp
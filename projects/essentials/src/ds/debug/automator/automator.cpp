@@ -4,6 +4,7 @@
 
 #include <cinder/Rand.h>
 
+#include <ds/cfg/settings.h>
 #include <ds/ui/sprite/sprite_engine.h>
 #include <ds/ui/touch/touch_event.h>
 
@@ -32,6 +33,13 @@ Automator::Automator(ds::ui::SpriteEngine& engine, const std::string& watermarkT
 	addFactory(std::shared_ptr<BaseActionFactory>(new TapActionFactory()));
 
 	clear();
+
+	// Headless runs drive themselves, the same way every time
+	const ds::cfg::Settings&	settings = mEngine.getSettings("engine");
+	if(settings.getBool("headless:automator", 0, false)){
+		setSeed(static_cast<uint32_t>(settings.getInt("headless:seed", 0, 1)));
+		activate();
+	}
 }
 
 void Automator::setFrame(const ci::Rectf& f){
@@ -42,6 +50,10 @@ void Automator::setPeriod(const float period){
 	mPeriod = period;
 }
 
+void Automator::setSeed(const uint32_t seed){
+	ci::randSeed(seed);
+}
+
 void Automator::addFactory(const std::shared_ptr<BaseActionFactory>& fac){
 	if(fac.get() == nullptr) return;
 
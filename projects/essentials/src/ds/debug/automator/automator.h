@@ -40,6 +40,8 @@ public:
 
 	void						setFrame(const ci::Rectf&);
 	void						setPeriod(const float period);
+	// Seed the random actions, so a run can be repeated
+	void						setSeed(const uint32_t seed);
 
 	// Supply factories for any actions you would like this automator to perform.
 	void						addFactory(const std::shared_ptr<BaseActionFactory>&);
@@ -3,9 +3,12 @@
 #include "png_sequence_sprite.h"
 
 #include <cinder/app/App.h>
+#include <cinder/gl/gl.h>
 
 #include <ds/debug/logger.h>
 
+#include "png_sequence_stream.h"
+
 namespace ds{
 namespace ui{
 
@@ -30,12 +33,27 @@ PngSequenceSprite::PngSequenceSprite(SpriteEngine& engine)
 	, mCurrentFrameIndex(0)
 	, mPlaying(true)
 	, mFrameTime(0.0f)
+	, mNumFrames(0)
 {
 	mLayoutFixedAspect = true;
 	mLastFrameTime = ci::app::getElapsedSeconds();
 }
 
+PngSequenceSprite::~PngSequenceSprite(){
+}
+
 void PngSequenceSprite::setImages(const std::vector<std::string>& imageFiles){
+	if(mStream){
+		mStream->setSource(imageFiles);
+		mNumFrames = imageFiles.size();
+		mCurrentFrameIndex = 0;
+		if(mNumFrames == 0){
+			DS_LOG_WARNING("Png Sequence didn't load any frames. Whoops.");
+			mPlaying = false;
+		}
+		return;
+	}
+
 	size_t i=0;
 	for(auto it = imageFiles.begin(); it < imageFiles.end(); ++it){
 		bool created_new_frames = false;
@@ -95,6 +113,7 @@ const bool PngSequenceSprite::isPlaying()const{
 void PngSequenceSprite::setCurrentFrameIndex(const int frameIndex){
 	if(frameIndex < 0 || frameIndex > mNumFrames - 1) return;
 	mCurrentFrameIndex = frameIndex;
+	if(mStream) return;
 
 	for(int i = 0; i < mNumFrames; i++){
 		if(i == mCurrentFrameIndex){
@@ -114,18 +133,69 @@ const size_t PngSequenceSprite::getNumberOfFrames(){
 }
 
 ds::ui::Image* PngSequenceSprite::getFrameAtIndex(const int frameIndex){
-	if(frameIndex < 0 || frameIndex > mNumFrames - 1) return nullptr;
+	if(mStream || frameIndex < 0 || frameIndex > mNumFrames - 1) return nullptr;
 	return mFrames[frameIndex];
 }
 
 void PngSequenceSprite::sizeToFirstImage(){
-	if(mFrames.empty()){
+	if(mStream){
+		// Known up front for packs, otherwise once the first frame has decoded
+		const ci::vec2 frameSize = mStream->getFrameSize();
+		setSize(frameSize.x, frameSize.y);
+	} else if(mFrames.empty()){
 		setSize(0.0f, 0.0f);
 	} else {
 		setSize(mFrames[0]->getScaleWidth(), mFrames[0]->getScaleHeight());
 	}
 }
 
+void PngSequenceSprite::setStreaming(const bool streaming, const int framesAhead){
+	if(!streaming){
+		if(!mStream) return;
+		mStream.reset();
+		mNumFrames = 0;
+		mCurrentFrameIndex = 0;
+		setTransparent(true);
+		setUseShaderTexture(false);
+		return;
+	}
+
+	if(!mStream){
+		clearFrames();
+		mStream.reset(new PngSequenceStream(mEngine));
+		setTransparent(false);
+		setUseShaderTexture(true);
+	}
+	mStream->setFramesAhead(framesAhead);
+}
+
+bool PngSequenceSprite::setPackedSequence(const std::string& packFile){
+	if(!mStream) setStreaming(true);
+
+	const bool opened = mStream->setPackedSource(packFile);
+	mNumFrames = mStream->getNumberOfFrames();
+	mCurrentFrameIndex = 0;
+	if(!opened){
+		DS_LOG_WARNING("Png Sequence couldn't open packed sequence " << packFile);
+		mPlaying = false;
+	}
+	return opened;
+}
+
+size_t PngSequenceSprite::getSkippedFrameCount() const {
+	if(!mStream) return 0;
+	return mStream->getSkippedFrames();
+}
+
+void PngSequenceSprite::clearFrames(){
+	for(auto it = mFrames.begin(); it < mFrames.end(); ++it){
+		(*it)->release();
+	}
+	mFrames.clear();
+	mNumFrames = 0;
+	mCurrentFrameIndex = 0;
+}
+
 void PngSequenceSprite::onUpdateServer(const ds::UpdateParams& p){
 	// Remove old (unused) Image sprites from the back of the frames if the count has changed...
 	while ( mFrames.size() > mNumFrames ) {
@@ -151,7 +221,7 @@ void PngSequenceSprite::onUpdateServer(const ds::UpdateParams& p){
 
 		if(advanceFrame){
 			// hide the old frame
-			mFrames[mCurrentFrameIndex]->hide();
+			if(!mStream) mFrames[mCurrentFrameIndex]->hide();
 
 			// advance the frame
 			mCurrentFrameIndex++;
@@ -168,10 +238,29 @@ void PngSequenceSprite::onUpdateServer(const ds::UpdateParams& p){
 			}
 
 			// show the new frame
-			mFrames[mCurrentFrameIndex]->show();
+			if(!mStream) mFrames[mCurrentFrameIndex]->show();
 		}
 
 	}
+
+	if(mStream && mNumFrames > 0){
+		mStream->update(mCurrentFrameIndex, mLoopStyle == Loop);
+	}
+}
+
+void PngSequenceSprite::drawLocalClient(){
+	if(!mStream) return;
+
+	const ci::gl::TextureRef& tex = mStream->getTexture();
+	if(!tex) return;
+
+	ci::gl::ScopedTextureBind scopedTexture(tex);
+	// Same as Image, perspective cameras have y up so the frame is flipped
+	if(getPerspective()){
+		ci::gl::drawSolidRect(ci::Rectf(0.0f, getHeight(), getWidth(), 0.0f));
+	} else {
+		ci::gl::drawSolidRect(ci::Rectf(0.0f, 0.0f, getWidth(), getHeight()));
+	}
 }
 } // namespace ui
 } // namespace ds
@@ -2,12 +2,14 @@
 #ifndef ESSENTIALS_DS_UI_SPRITE_PNG_SEQUENCE_SPRITE_H_
 #define ESSENTIALS_DS_UI_SPRITE_PNG_SEQUENCE_SPRITE_H_
 
+#include <memory>
 #include <ds/ui/sprite/image.h>
 #include <ds/ui/sprite/sprite.h>
 #include <ds/ui/sprite/sprite_engine.h>
 
 namespace ds {
 namespace ui {
+class PngSequenceStream;
 
 /**
 * \class ds::ui::PngSequenceSprite
@@ -23,6 +25,7 @@ typedef enum { Loop = 0, Once} LoopStyle;
 // Default behavior: playing, one image per server frame, looping
 PngSequenceSprite(SpriteEngine& engine);
 PngSequenceSprite(SpriteEngine& engine, const std::vector<std::string>& imageFiles);
+~PngSequenceSprite();
 
 	void						setImages(const std::vector<std::string>& imageFiles);
 
@@ -59,8 +62,22 @@ PngSequenceSprite(SpriteEngine& engine, const std::vector<std::string>& imageFil
 	// If there are no images, the size will be 0,0
 	void						sizeToFirstImage();
 
+	// Streaming mode decodes frames in the background a few at a time, ahead of the
+	// playhead, instead of loading every frame as an Image. Use it for long sequences
+	// that would otherwise hold every frame in memory. Frames that can't be decoded in
+	// time are skipped. Streamed frames are drawn locally and are not sent to clients.
+	// Call before setImages() or setPackedSequence().
+	void						setStreaming(const bool streaming, const int framesAhead = 6);
+	bool						isStreaming() const { return mStream != nullptr; }
+	// Stream from a pack built with ds::ui::PngSequencePack::write(). Turns on streaming.
+	bool						setPackedSequence(const std::string& packFile);
+	// Frames the playhead reached before they were decoded. Streaming only.
+	size_t						getSkippedFrameCount() const;
+
 private:
 	virtual void				onUpdateServer(const ds::UpdateParams& p) override;
+	virtual void				drawLocalClient() override;
+	void						clearFrames();
 
 	LoopStyle					mLoopStyle;
 	size_t						mCurrentFrameIndex;
@@ -69,6 +86,8 @@ private:
 	float						mFrameTime;
 	double						mLastFrameTime;
 	std::vector<ds::ui::Image*>	mFrames;
+	std::unique_ptr<PngSequenceStream>
+								mStream;
 
 };
 
@@ -0,0 +1,385 @@
+#include "stdafx.h"
+
+#include "png_sequence_stream.h"
+
+#include <fstream>
+#include <string.h>
+#include <cinder/ImageIo.h>
+#include <Poco/File.h>
+#include <ds/app/environment.h>
+#include <ds/debug/logger.h>
+#include <ds/ui/sprite/sprite_engine.h>
+#include "snappy.h"
+
+namespace ds {
+namespace ui {
+
+namespace {
+// File layout, all little endian:
+//	magic "DSSQ", version, width, height, channel order code, frame count
+//	frame table: offset (u64) and compressed size (u32) per frame
+//	compressed frames
+const uint32_t			PACK_MAGIC = 0x51535344;
+const uint32_t			PACK_VERSION = 1;
+const size_t			PACK_HEADER_SIZE = 24;
+const size_t			PACK_FRAME_ENTRY_SIZE = 12;
+
+// Recycled upload textures. Three lets the driver keep reading one while we write another.
+const size_t			TEXTURE_POOL_SIZE = 3;
+const size_t			NO_FRAME = static_cast<size_t>(-1);
+
+uint32_t				read_u32(const char* p) {
+	const unsigned char* d = reinterpret_cast<const unsigned char*>(p);
+	return d[0] | (d[1] << 8) | (d[2] << 16) | (static_cast<uint32_t>(d[3]) << 24);
+}
+
+void					write_u32(std::ostream& os, const uint32_t v) {
+	const char			b[4] = { static_cast<char>(v & 0xff), static_cast<char>((v >> 8) & 0xff),
+								 static_cast<char>((v >> 16) & 0xff), static_cast<char>((v >> 24) & 0xff) };
+	os.write(b, 4);
+}
+
+// Distance from a to b going forward through the sequence
+size_t					forward_distance(const size_t a, const size_t b, const size_t count, const bool looping) {
+	if (b >= a) return b - a;
+	return looping ? (count - a + b) : NO_FRAME;
+}
+}
+
+/**
+* \class ds::ui::PngSequencePack
+*/
+PngSequencePack::PngSequencePack()
+	: mWidth(0)
+	, mHeight(0)
+	, mChannelOrder(ci::SurfaceChannelOrder::RGBA)
+{
+}
+
+bool PngSequencePack::open(const std::string& filename){
+	mMemory.reset();
+	mFrames.clear();
+	mWidth = mHeight = 0;
+
+	try {
+		const Poco::File	file(ds::Environment::expand(filename));
+		if(!file.exists()) return false;
+		mMemory.reset(new Poco::SharedMemory(file, Poco::SharedMemory::AM_READ));
+	} catch(std::exception const& ex){
+		DS_LOG_WARNING("PngSequencePack::open() could not map " << filename << " ex=" << ex.what());
+		mMemory.reset();
+		return false;
+	}
+
+	const char*			data = mMemory->begin();
+	const size_t		size = static_cast<size_t>(mMemory->end() - mMemory->begin());
+	if(size < PACK_HEADER_SIZE || read_u32(data) != PACK_MAGIC || read_u32(data + 4) != PACK_VERSION){
+		DS_LOG_WARNING("PngSequencePack::open() not a sequence pack: " << filename);
+		mMemory.reset();
+		return false;
+	}
+
+	mWidth = static_cast<int>(read_u32(data + 8));
+	mHeight = static_cast<int>(read_u32(data + 12));
+	mChannelOrder = static_cast<int>(read_u32(data + 16));
+	const size_t		count = read_u32(data + 20);
+	if(size < PACK_HEADER_SIZE + count * PACK_FRAME_ENTRY_SIZE){
+		mMemory.reset();
+		return false;
+	}
+
+	mFrames.resize(count);
+	const char*			entry = data + PACK_HEADER_SIZE;
+	for(size_t i = 0; i < count; ++i, entry += PACK_FRAME_ENTRY_SIZE){
+		mFrames[i].mOffset = static_cast<uint64_t>(read_u32(entry)) | (static_cast<uint64_t>(read_u32(entry + 4)) << 32);
+		mFrames[i].mSize = read_u32(entry + 8);
+		if(mFrames[i].mOffset + mFrames[i].mSize > size){
+			DS_LOG_WARNING("PngSequencePack::open() truncated pack: " << filename);
+			mFrames.clear();
+			mMemory.reset();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool PngSequencePack::isOpen() const {
+	return mMemory != nullptr;
+}
+
+bool PngSequencePack::decodeFrame(const size_t frameIndex, ci::Surface8u& s) const {
+	if(!mMemory || frameIndex >= mFrames.size()) return false;
+
+	const Frame&		f = mFrames[frameIndex];
+	const char*			src = mMemory->begin() + f.mOffset;
+	size_t				rawSize = 0;
+	if(!snappy::GetUncompressedLength(src, f.mSize, &rawSize)) return false;
+	if(rawSize != static_cast<size_t>(mWidth) * mHeight * 4) return false;
+
+	if(!s.getData() || s.getWidth() != mWidth || s.getHeight() != mHeight || !s.hasAlpha()){
+		s = ci::Surface8u(mWidth, mHeight, true, ci::SurfaceChannelOrder(mChannelOrder));
+	}
+
+	// Surfaces are normally tightly packed, but don't count on it.
+	if(s.getRowBytes() == static_cast<int32_t>(mWidth * 4)){
+		return snappy::RawUncompress(src, f.mSize, reinterpret_cast<char*>(s.getData()));
+	}
+	std::vector<char>	tmp(rawSize);
+	if(!snappy::RawUncompress(src, f.mSize, tmp.data())) return false;
+	for(int y = 0; y < mHeight; ++y){
+		memcpy(s.getData() + y * s.getRowBytes(), tmp.data() + static_cast<size_t>(y) * mWidth * 4, mWidth * 4);
+	}
+	return true;
+}
+
+bool PngSequencePack::write(const std::vector<std::string>& imageFiles, const std::string& outFile){
+	if(imageFiles.empty()) return false;
+
+	std::vector<std::string>	frames;
+	std::vector<char>			raw;
+	int							width = 0,
+								height = 0,
+								channelOrder = 0;
+	try {
+		for(auto it = imageFiles.begin(), end = imageFiles.end(); it != end; ++it){
+			ci::Surface8u		s(ci::loadImage(ds::Environment::expand(*it)), ci::SurfaceConstraintsDefault(), true);
+			if(!s.getData()){
+				DS_LOG_WARNING("PngSequencePack::write() could not load " << *it);
+				return false;
+			}
+			if(frames.empty()){
+				width = s.getWidth();
+				height = s.getHeight();
+				channelOrder = s.getChannelOrder().getCode();
+			} else if(s.getWidth() != width || s.getHeight() != height || s.getChannelOrder().getCode() != channelOrder){
+				DS_LOG_WARNING("PngSequencePack::write() frame size mismatch for " << *it);
+				return false;
+			}
+
+			raw.resize(static_cast<size_t>(width) * height * 4);
+			for(int y = 0; y < height; ++y){
+				memcpy(raw.data() + static_cast<size_t>(y) * width * 4, s.getData() + y * s.getRowBytes(), width * 4);
+			}
+			frames.push_back(std::string());
+			snappy::Compress(raw.data(), raw.size(), &frames.back());
+		}
+	} catch(std::exception const& ex){
+		DS_LOG_WARNING("PngSequencePack::write() ex=" << ex.what());
+		return false;
+	}
+
+	std::ofstream				os(ds::Environment::expand(outFile), std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+	if(!os.is_open()) return false;
+
+	write_u32(os, PACK_MAGIC);
+	write_u32(os, PACK_VERSION);
+	write_u32(os, static_cast<uint32_t>(width));
+	write_u32(os, static_cast<uint32_t>(height));
+	write_u32(os, static_cast<uint32_t>(channelOrder));
+	write_u32(os, static_cast<uint32_t>(frames.size()));
+
+	uint64_t					offset = PACK_HEADER_SIZE + frames.size() * PACK_FRAME_ENTRY_SIZE;
+	for(auto it = frames.begin(), end = frames.end(); it != end; ++it){
+		write_u32(os, static_cast<uint32_t>(offset & 0xffffffff));
+		write_u32(os, static_cast<uint32_t>(offset >> 32));
+		write_u32(os, static_cast<uint32_t>(it->size()));
+		offset += it->size();
+	}
+	for(auto it = frames.begin(), end = frames.end(); it != end; ++it){
+		os.write(it->data(), it->size());
+	}
+	return os.good();
+}
+
+/**
+* \class ds::ui::PngSequenceStream
+*/
+PngSequenceStream::PngSequenceStream(ds::ui::SpriteEngine& engine)
+	: mDecoder(engine)
+	, mGeneration(0)
+	, mFramesAhead(6)
+	, mTexturePoolIndex(0)
+	, mShownFrame(NO_FRAME)
+	, mLastPlayhead(NO_FRAME)
+	, mSkippedFrames(0)
+{
+	mDecoder.setReplyHandler([this](DecodeRunnable& r){ onDecoded(r); });
+	reset();
+}
+
+void PngSequenceStream::setSource(const std::vector<std::string>& imageFiles){
+	mPack.reset();
+	mFiles = imageFiles;
+	mFrameSize = ci::vec2();
+	reset();
+}
+
+bool PngSequenceStream::setPackedSource(const std::string& packFile){
+	mFiles.clear();
+	mFrameSize = ci::vec2();
+	std::shared_ptr<PngSequencePack>	pack(new PngSequencePack());
+	if(pack->open(packFile)){
+		mPack = pack;
+		mFrameSize = ci::vec2(static_cast<float>(pack->getWidth()), static_cast<float>(pack->getHeight()));
+	} else {
+		mPack.reset();
+	}
+	reset();
+	return mPack != nullptr;
+}
+
+void PngSequenceStream::clear(){
+	mPack.reset();
+	mFiles.clear();
+	mFrameSize = ci::vec2();
+	reset();
+	mTexturePool.clear();
+	mTexture = nullptr;
+}
+
+void PngSequenceStream::setFramesAhead(const int framesAhead){
+	if(framesAhead < 1 || framesAhead == mFramesAhead) return;
+	mFramesAhead = framesAhead;
+	reset();
+}
+
+size_t PngSequenceStream::getNumberOfFrames() const {
+	if(mPack) return mPack->getNumberOfFrames();
+	return mFiles.size();
+}
+
+ci::vec2 PngSequenceStream::getFrameSize() const {
+	return mFrameSize;
+}
+
+void PngSequenceStream::reset(){
+	++mGeneration;
+	mSlots.clear();
+	// One extra slot holds the frame on screen while the others fill
+	mSlots.resize(static_cast<size_t>(mFramesAhead) + 1);
+	mShownFrame = NO_FRAME;
+	mLastPlayhead = NO_FRAME;
+	mSkippedFrames = 0;
+}
+
+void PngSequenceStream::update(const size_t playhead, const bool looping){
+	const size_t			count = getNumberOfFrames();
+	if(count < 1 || playhead >= count) return;
+
+	// The playhead moved on without the previous frame ever reaching the screen
+	if(playhead != mLastPlayhead){
+		if(mLastPlayhead != NO_FRAME && mShownFrame != mLastPlayhead) ++mSkippedFrames;
+		mLastPlayhead = playhead;
+	}
+
+	// Fill the window ahead of the playhead, nearest frames first
+	const size_t			window = std::min(mSlots.size(), count);
+	for(size_t i = 0; i < window; ++i){
+		const size_t		frame = playhead + i;
+		if(frame >= count && !looping) break;
+		request(frame % count);
+	}
+
+	Slot&					slot = mSlots[playhead % mSlots.size()];
+	if(slot.mFrame == playhead && slot.mState == Slot::READY && mShownFrame != playhead){
+		upload(slot);
+		mShownFrame = playhead;
+	}
+}
+
+void PngSequenceStream::request(const size_t frame){
+	Slot&					slot = mSlots[frame % mSlots.size()];
+	if(slot.mFrame == frame && slot.mState != Slot::EMPTY) return;
+	// An older frame is still decoding in this slot; wait for it to come back before reusing it
+	if(slot.mState == Slot::DECODING) return;
+
+	slot.mFrame = frame;
+	slot.mState = Slot::DECODING;
+	// Hand the slot's old surface to the runnable so its memory can be reused
+	ci::Surface8u			recycled = slot.mSurface;
+	slot.mSurface = ci::Surface8u();
+	const int				generation = mGeneration;
+	const std::string		filename = (frame < mFiles.size() ? mFiles[frame] : std::string());
+	std::shared_ptr<PngSequencePack>	pack = mPack;
+	const bool started = mDecoder.start([frame, generation, filename, pack, recycled](DecodeRunnable& r){
+		r.mFrame = frame;
+		r.mGeneration = generation;
+		r.mFilename = filename;
+		r.mPack = pack;
+		r.mSurface = recycled;
+		r.mError = false;
+	});
+	if(!started) slot.mState = Slot::EMPTY;
+}
+
+void PngSequenceStream::onDecoded(DecodeRunnable& r){
+	r.mPack.reset();
+	// Results from a previous source, or a reset ring, are ignored
+	if(r.mGeneration != mGeneration) return;
+
+	Slot&					slot = mSlots[r.mFrame % mSlots.size()];
+	if(slot.mFrame != r.mFrame || slot.mState != Slot::DECODING) return;
+
+	if(r.mError){
+		slot.mState = Slot::EMPTY;
+		slot.mFrame = NO_FRAME;
+		return;
+	}
+
+	// Swap rather than copy, so the runnable keeps a surface to decode into next time
+	std::swap(slot.mSurface, r.mSurface);
+	slot.mState = Slot::READY;
+	if(mFrameSize.x < 1.0f && slot.mSurface.getData()){
+		mFrameSize = ci::vec2(static_cast<float>(slot.mSurface.getWidth()), static_cast<float>(slot.mSurface.getHeight()));
+	}
+}
+
+void PngSequenceStream::upload(Slot& slot){
+	if(!slot.mSurface.getData()) return;
+	if(mTexturePool.size() < TEXTURE_POOL_SIZE) mTexturePool.resize(TEXTURE_POOL_SIZE);
+
+	mTexturePoolIndex = (mTexturePoolIndex + 1) % mTexturePool.size();
+	ci::gl::TextureRef&		tex = mTexturePool[mTexturePoolIndex];
+	if(tex && tex->getWidth() == slot.mSurface.getWidth() && tex->getHeight() == slot.mSurface.getHeight()){
+		tex->update(slot.mSurface);
+	} else {
+		tex = ci::gl::Texture::create(slot.mSurface);
+	}
+	mTexture = tex;
+}
+
+/**
+* \class ds::ui::PngSequenceStream::DecodeRunnable
+*/
+PngSequenceStream::DecodeRunnable::DecodeRunnable()
+	: mFrame(0)
+	, mGeneration(0)
+	, mError(false)
+{
+}
+
+void PngSequenceStream::DecodeRunnable::run(){
+	mError = true;
+	try {
+		if(mPack){
+			mError = !mPack->decodeFrame(mFrame, mSurface);
+		} else if(!mFilename.empty()){
+			mSurface = ci::Surface8u(ci::loadImage(ds::Environment::expand(mFilename)), ci::SurfaceConstraintsDefault(), true);
+			mError = (mSurface.getData() == nullptr);
+		}
+	} catch(std::exception const& ex){
+		DS_LOG_WARNING("PngSequenceStream could not decode frame " << mFrame << " (" << mFilename << ") ex=" << ex.what());
+	}
+}
+
+/**
+* \class ds::ui::PngSequenceStream::Slot
+*/
+PngSequenceStream::Slot::Slot()
+	: mFrame(NO_FRAME)
+	, mState(EMPTY)
+{
+}
+
+} // namespace ui
+} // namespace ds
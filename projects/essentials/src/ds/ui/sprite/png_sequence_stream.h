@@ -0,0 +1,145 @@
+#pragma once
+#ifndef ESSENTIALS_DS_UI_SPRITE_PNG_SEQUENCE_STREAM_H_
+#define ESSENTIALS_DS_UI_SPRITE_PNG_SEQUENCE_STREAM_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cinder/Surface.h>
+#include <cinder/gl/Texture.h>
+#include <Poco/Runnable.h>
+#include <Poco/SharedMemory.h>
+#include <ds/thread/parallel_runnable.h>
+
+namespace ds {
+namespace ui {
+class SpriteEngine;
+
+/**
+* \class ds::ui::PngSequencePack
+* \brief A pre-packed image sequence: every frame is snappy-compressed raw pixels,
+* concatenated into one file behind a frame table. The file is memory mapped, and
+* frames can be decoded from any thread.
+* Build one offline with PngSequencePack::write().
+*/
+class PngSequencePack {
+public:
+	PngSequencePack();
+
+	bool						open(const std::string& filename);
+	bool						isOpen() const;
+
+	size_t						getNumberOfFrames() const { return mFrames.size(); }
+	int							getWidth() const { return mWidth; }
+	int							getHeight() const { return mHeight; }
+
+	// Decode a frame into the surface, reusing its memory if the size matches. Thread safe.
+	bool						decodeFrame(const size_t frameIndex, ci::Surface8u&) const;
+
+	// Load each image file and write them out as a pack. Answers false if any frame fails
+	// to load or the frames aren't all the same size.
+	static bool					write(const std::vector<std::string>& imageFiles, const std::string& outFile);
+
+private:
+	struct Frame {
+		uint64_t				mOffset;
+		uint32_t				mSize;
+	};
+
+	std::unique_ptr<Poco::SharedMemory>
+								mMemory;
+	int							mWidth,
+								mHeight,
+								mChannelOrder;
+	std::vector<Frame>			mFrames;
+};
+
+/**
+* \class ds::ui::PngSequenceStream
+* \brief Streams an image sequence through a small ring of decoded frames that runs
+* ahead of the playhead. Frames are decoded on the work manager's threads and uploaded
+* into a few recycled textures, so memory stays flat no matter how long the sequence is.
+* If decoding falls behind, frames the playhead has already passed are dropped.
+*/
+class PngSequenceStream {
+public:
+	PngSequenceStream(ds::ui::SpriteEngine&);
+
+	void						setSource(const std::vector<std::string>& imageFiles);
+	bool						setPackedSource(const std::string& packFile);
+	void						clear();
+
+	// How many frames to keep decoded ahead of the playhead
+	void						setFramesAhead(const int framesAhead);
+	int							getFramesAhead() const { return mFramesAhead; }
+
+	size_t						getNumberOfFrames() const;
+	// The size of the frames, if known (from the pack, or the first decoded frame).
+	ci::vec2					getFrameSize() const;
+
+	// Call once per update with the frame that should be on screen. Schedules decodes
+	// ahead of it and uploads it if it's ready.
+	void						update(const size_t playhead, const bool looping);
+
+	// The texture for the most recently uploaded frame, which may lag the playhead
+	const ci::gl::TextureRef&	getTexture() const { return mTexture; }
+	// Number of frames the playhead reached before they were decoded
+	size_t						getSkippedFrames() const { return mSkippedFrames; }
+
+private:
+	class DecodeRunnable : public Poco::Runnable {
+	public:
+		DecodeRunnable();
+
+		virtual void			run();
+
+		size_t					mFrame;
+		int						mGeneration;
+		std::string				mFilename;
+		std::shared_ptr<PngSequencePack>
+								mPack;
+		ci::Surface8u			mSurface;
+		bool					mError;
+	};
+
+	struct Slot {
+		Slot();
+		static const int		EMPTY = 0;
+		static const int		DECODING = 1;
+		static const int		READY = 2;
+
+		size_t					mFrame;
+		int						mState;
+		ci::Surface8u			mSurface;
+	};
+
+	void						reset();
+	void						onDecoded(DecodeRunnable&);
+	void						request(const size_t frame);
+	void						upload(Slot&);
+
+	ds::ParallelRunnable<DecodeRunnable>
+								mDecoder;
+	std::vector<std::string>	mFiles;
+	std::shared_ptr<PngSequencePack>
+								mPack;
+	// Bumped whenever the source changes, so stale decodes can be ignored
+	int							mGeneration;
+	int							mFramesAhead;
+	std::vector<Slot>			mSlots;
+
+	// Upload targets, used round-robin so we never write into a texture that was just drawn
+	std::vector<ci::gl::TextureRef>
+								mTexturePool;
+	size_t						mTexturePoolIndex;
+	ci::gl::TextureRef			mTexture;
+	size_t						mShownFrame;
+	size_t						mLastPlayhead;
+	ci::vec2					mFrameSize;
+	size_t						mSkippedFrames;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif
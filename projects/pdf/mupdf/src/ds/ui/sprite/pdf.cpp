@@ -293,7 +293,7 @@ void Pdf::ResHolder::clear() {
 bool Pdf::ResHolder::setResourceFilename(const std::string& filename) {
 	clear();
 	bool success = false;
-	mRes = new ds::pdf::PdfRes(mService.mThread);
+	mRes = new ds::pdf::PdfRes(mService.mEngine.getGlUploadPool());
 	if (mRes) {
 		success = mRes->loadPDF(ds::Environment::expand(filename));
 	}
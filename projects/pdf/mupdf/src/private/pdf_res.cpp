@@ -248,8 +248,9 @@ ci::Surface8uRef PdfRes::renderPage(const std::string& path) {
 	//return s;
 }
 
-PdfRes::PdfRes(ds::GlThread& t)
-		: ds::GlThreadClient<PdfRes>(t)
+PdfRes::PdfRes(ds::GlUploadPool& t)
+		: mUploads(t)
+		, mTextureChanged(false)
 		, mPageCount(0)
 		, mPixelsChanged(false) 
 		, mPrintedError(false)
@@ -258,11 +259,9 @@ PdfRes::PdfRes(ds::GlThread& t)
 }
 
 void PdfRes::scheduleDestructor() {
-	performOnWorkerThread(&PdfRes::_destructor);
-}
-
-void PdfRes::_destructor() {
-	delete this;
+	// Serial jobs run in order, so this waits for any page being drawn.
+	mUploads.cancel(this);
+	mUploads.uploadSerial(this, [this]() { delete this; });
 }
 
 PdfRes::~PdfRes() {
@@ -364,31 +363,28 @@ bool PdfRes::update() {
 	// set, I only need the next pending redraw to perform, everything else
 	// is unnecessary.
 	if(needsUpdate()){
-		performOnWorkerThread(&PdfRes::_redrawPage, true);
+		mUploads.uploadSerial(this, [this]() { _redrawPage(); }, [this]() { onPageUploaded(); }, true);
 	}
 
-	bool pixelsWereUpdated = false;
+	const bool pixelsWereUpdated = mTextureChanged;
+	mTextureChanged = false;
 	{
 		std::lock_guard<decltype(mMutex)>		l(mMutex);
-		if (mPixelsChanged) {
-			pixelsWereUpdated = true;
-			mPixelsChanged = false;
-			if (mPixels.empty()) {
-				mTexture = nullptr;
-			} else {
-				ci::gl::Texture::Format formatty;
-				formatty.setMinFilter(GL_LINEAR);
-				formatty.setMagFilter(GL_LINEAR);
-				mTexture = ci::gl::Texture::create(mPixels.getData(), GL_RGB, mPixels.getWidth(), mPixels.getHeight(), formatty);
-				if(!mTexture) return false;
-			}
-		}
 		mState.mPageSize = mDrawState.mPageSize;
 	}
 
 	return pixelsWereUpdated;
 }
 
+void PdfRes::onPageUploaded() {
+	std::lock_guard<decltype(mMutex)>		l(mMutex);
+	if (!mPixelsChanged) return;
+	mPixelsChanged = false;
+	mTexture = mPageTexture;
+	mPageTexture = nullptr;
+	mTextureChanged = true;
+}
+
 bool PdfRes::needsUpdate() {
 	std::lock_guard<decltype(mMutex)>		l(mMutex);
 	if (mPageCount < 1) return false;
@@ -480,10 +476,19 @@ void PdfRes::_redrawPage() {
 		return;
 	}
 	drawState.mPageSize = draw.getPageSize();
-	
+
+	// Only this thread touches the pixels, so they can go to the GPU without the lock.
+	ci::gl::TextureRef							texture;
+	if (!mPixels.empty()) {
+		ci::gl::Texture::Format formatty;
+		formatty.setMinFilter(GL_LINEAR);
+		formatty.setMagFilter(GL_LINEAR);
+		texture = ci::gl::Texture::create(mPixels.getData(), GL_RGB, mPixels.getWidth(), mPixels.getHeight(), formatty);
+	}
 
 	std::lock_guard<decltype(mMutex)>			l(mMutex);
 	mPixelsChanged = true;
+	mPageTexture = texture;
 	mDrawState = drawState;
 	// No reason to copy the string which will generally be the same
 	if (mDrawFileName != fn) mDrawFileName = fn;
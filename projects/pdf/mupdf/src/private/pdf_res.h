@@ -6,7 +6,7 @@
 #include <cinder/Surface.h>
 #include <cinder/gl/Texture.h>
 
-#include <ds/thread/gl_thread.h>
+#include <ds/thread/gl_upload_pool.h>
 #include <ds/ui/sprite/pdf.h>
 
 namespace ds {
@@ -14,13 +14,15 @@ namespace pdf {
 
 /**
  * \class ds::ui::sprite::PdfRes
+ * \brief Pages are rasterized and uploaded on a GL upload thread, one
+ * job at a time, so the main thread only swaps in the new texture.
  */
-class PdfRes : public ds::GlThreadClient<PdfRes> {
+class PdfRes {
 public:
 	// Utility to get a render of the first page of a PDF.
 	static ci::Surface8uRef	renderPage(const std::string& path);
 
-	PdfRes(ds::GlThread&);
+	PdfRes(ds::GlUploadPool&);
 	// Clients should never delete this class, instead schedule it for deletion and consider it invalid.
 	void scheduleDestructor();
 
@@ -51,8 +53,9 @@ public:
 
 protected:
 	// worker thread calls
-	void _destructor();
 	void _redrawPage();
+	// main thread, once the new page is on the GPU
+	void onPageUploaded();
 
 private:
 	struct state {
@@ -89,9 +92,11 @@ private:
 	bool						needsUpdate();
 
 	mutable std::mutex			mMutex;
+	ds::GlUploadPool&			mUploads;
 
 	// MAIN THREAD
 	ci::gl::TextureRef			mTexture;
+	bool						mTextureChanged;
 	
 	// WORKER THREAD
 
@@ -99,7 +104,8 @@ private:
 	bool						mRequestUpdate;
 	int							mPageCount;		// Page count < 1 means no PDF has been loaded
 	Pixels						mPixels;		// The buffer of data.
-	bool						mPixelsChanged;	// Indicates the main thread needs to load in the pixels.
+	bool						mPixelsChanged;	// Indicates the main thread needs to swap in mPageTexture.
+	ci::gl::TextureRef			mPageTexture;	// The latest page, made from the pixels on the worker thread.
 	std::string					mFileName;
 	state						mState;			// Store the current state as set by the main thread.  This data is only
 													// read by the worker thread, so it's safe to read it in the main without a lock.
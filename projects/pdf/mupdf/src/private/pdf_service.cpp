@@ -27,11 +27,8 @@ Service::Service(ds::Engine& engine)
 }
 
 Service::~Service(){
-	mThread.waitForNoInput();
-}
-
-void Service::start(){
-	mThread.start(false);
+	// Let any pages being drawn, and resources being deleted, finish.
+	mEngine.getGlUploadPool().waitForIdle();
 }
 
 } // namespace pdf
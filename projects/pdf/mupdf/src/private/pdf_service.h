@@ -3,7 +3,6 @@
 #define PRIVATE_PDFSERVICE_H_
 
 #include <ds/app/engine/engine_service.h>
-#include <ds/thread/gl_thread.h>
 
 namespace ds {
 
@@ -13,19 +12,15 @@ namespace pdf {
 
 /**
  * \class ds::pdf::PdfService
- * \brief The engine service object that provides access to the
- * PDF rendering thread.
+ * \brief The engine service object for PDF sprites. Pages are
+ * rendered on the engine's GL upload threads.
  */
 class Service : public ds::EngineService {
 public:
 	Service(ds::Engine& engine);
 	~Service();
 
-	virtual void		start();
-
 	ds::Engine&			mEngine;
-
-	GlThread			mThread;
 };
 
 } // namespace ui
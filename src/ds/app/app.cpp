@@ -18,6 +18,7 @@
 #endif
 #include "ds/debug/logger.h"
 #include "ds/debug/debug_defines.h"
+#include "ds/debug/profiler.h"
 
 // For installing the sprite types
 #include "ds/app/engine/engine_stats_view.h"
@@ -259,6 +260,7 @@ void App::setup() {
 }
 
 void App::update() {
+	ds::Profiler::get().frame();
 	mEngine.setAverageFps(getAverageFps());
 	if (mEngine.getHideMouse() && !mMouseHidden) {
 		mMouseHidden = true;
@@ -272,6 +274,7 @@ void App::update() {
 
 void App::draw() {
 	mEngine.draw();
+	mEngine.getTouchManager().getLatencyLog().drawn();
 }
 
 void App::mouseDown(ci::app::MouseEvent event ) {
@@ -337,6 +340,15 @@ void App::keyDown(ci::app::KeyEvent e) {
 		mEngine.nextTouchMode();
 	} else if(ci::app::KeyEvent::KEY_F8 == code){
 		saveTransparentScreenshot();
+	} else if(ci::app::KeyEvent::KEY_F9 == code){
+		// First press starts recording, the next writes what's been recorded
+		ds::Profiler&	profiler = ds::Profiler::get();
+		if(profiler.isEnabled()) {
+			profiler.writeTrace();
+		} else {
+			profiler.setEnabled(true);
+			DS_LOG_INFO("Profiler recording, press F9 again to write " << profiler.getTracePath());
+		}
 	} else if(ci::app::KeyEvent::KEY_k == code && mCtrlDown){
 		system("taskkill /f /im RestartOnCrash.exe");
 		system("taskkill /f /im DSNode-Host.exe");
@@ -488,5 +500,6 @@ static ds::Engine&    new_engine(	ds::App& app, const ds::EngineSettings& settin
 	if (arch == "client") return *(new ds::EngineClient(app, settings, ed, roots));
 	if (arch == "server") return *(new ds::EngineServer(app, settings, ed, roots));
 	if (arch == "clientserver") return *(new ds::EngineClientServer(app, settings, ed, roots));
+	if (arch == "headless") DS_LOG_WARNING("Headless runs don't have an app, see ds::EngineHeadless::run(). Running standalone.");
 	return *(new ds::EngineStandalone(app, settings, ed, roots));
 }
@@ -13,7 +13,8 @@ namespace ds {
  */
 AutoUpdate::AutoUpdate(ds::ui::SpriteEngine &e, const int mask)
 		: mEngine(e)
-		, mMask(mask) {
+		, mMask(mask)
+		, mParallel(false) {
 	try {
 		if ((mask&AutoUpdateType::SERVER) != 0) e.getAutoUpdateList(AutoUpdateType::SERVER).addWaiting(this);
 		if ((mask&AutoUpdateType::CLIENT) != 0) e.getAutoUpdateList(AutoUpdateType::CLIENT).addWaiting(this);
@@ -30,4 +31,8 @@ AutoUpdate::~AutoUpdate() {
 	}
 }
 
+void AutoUpdate::setParallel(const bool on) {
+	mParallel = on;
+}
+
 } // namespace ds
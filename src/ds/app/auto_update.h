@@ -27,12 +27,17 @@ protected:
 	friend class			AutoUpdateList;
 	virtual void			update(const ds::UpdateParams&) = 0;
 
+	// Parallel updates run after the others, across threads, alongside the
+	// engine's parallel sprites. Only for updates that touch nothing but their own data.
+	void					setParallel(const bool);
+
 	ds::ui::SpriteEngine&	mEngine;
 
 private:
 	AutoUpdate();
 
 	const int				mMask;
+	bool					mParallel;
 };
 
 } // namespace ds
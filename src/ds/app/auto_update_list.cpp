@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <Poco/Timestamp.h>
 #include "ds/app/auto_update.h"
+#include "ds/app/parallel_update.h"
 #include "ds/params/update_params.h"
 
 namespace ds {
@@ -12,7 +13,8 @@ namespace ds {
 /**
  * \class ds::AutoUpdateList
  */
-AutoUpdateList::AutoUpdateList() {
+AutoUpdateList::AutoUpdateList()
+		: mParallelUpdate(nullptr) {
 	mRunning.reserve(32);
 	mWaiting.reserve(8);
 }
@@ -26,9 +28,20 @@ void AutoUpdateList::update(const ds::UpdateParams &p) {
 	}
 	if (mRunning.empty()) return;
 
+	const bool		parallel = mParallelUpdate && mParallelUpdate->isEnabled();
+	mParallel.clear();
 	for (auto it=mRunning.begin(), end=mRunning.end(); it != end; ++it) {
-		(*it)->update(p);
+		if (parallel && (*it)->mParallel) mParallel.push_back(*it);
+		else (*it)->update(p);
 	}
+	if (mParallel.empty()) return;
+
+	mParallelUpdate->run(static_cast<int>(mParallel.size()), [this, &p](const int index) { mParallel[index]->update(p); });
+	mParallel.clear();
+}
+
+void AutoUpdateList::setParallelUpdate(ParallelUpdate* pu) {
+	mParallelUpdate = pu;
 }
 
 void AutoUpdateList::addWaiting(AutoUpdate *v) {
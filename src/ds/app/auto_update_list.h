@@ -6,6 +6,7 @@
 
 namespace ds {
 class AutoUpdate;
+class ParallelUpdate;
 class UpdateParams;
 
 /**
@@ -18,6 +19,9 @@ public:
 
 	void						update(const ds::UpdateParams&);
 
+	// Parallel updates run on this. Without it, they run in order with everything else.
+	void						setParallelUpdate(ParallelUpdate*);
+
 private:
 	void						addWaiting(AutoUpdate*);
 	void						remove(AutoUpdate*);
@@ -29,6 +33,8 @@ private:
 	// at the start of the next update cycle. This prevents a
 	// a bug where the vector gets modified during an update.
 	std::vector<AutoUpdate*>	mWaiting;
+	ParallelUpdate*				mParallelUpdate;
+	std::vector<AutoUpdate*>	mParallel;
 };
 
 } // namespace ds
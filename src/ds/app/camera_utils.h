@@ -31,6 +31,8 @@ public:
 		, mCameraDirection( glm::normalize( cameraPersp.getViewDirection()) )
 	{}
 
+	const ci::Ray&				getPickRay() const { return mPickRay; }
+
 	const bool					testHitSprite( ds::ui::Sprite* sprite, ci::vec3& hitWorldPos ) const;
 	const float					calcHitDepth( const ci::vec3& hitWorldPos ) const;
 
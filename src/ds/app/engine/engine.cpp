@@ -11,7 +11,9 @@
 #include "ds/cfg/settings.h"
 #include "ds/debug/debug_defines.h"
 #include "ds/debug/logger.h"
+#include "ds/debug/profiler.h"
 #include "ds/math/math_defs.h"
+#include "ds/thread/work_manager.h"
 #include "ds/ui/ip/ip_defs.h"
 #include "ds/ui/ip/functions/ip_circle_mask.h"
 #include "ds/ui/touch/draw_touch_view.h"
@@ -25,6 +27,7 @@
 //! function Poco::Path::expand. This slowly needs
 //! to get removed. Poco is not part of the Cinder.
 #include <Poco/Path.h>
+#include <Poco/Timestamp.h>
 
 //#include <boost/algorithm/string/predicate.hpp>
 
@@ -41,23 +44,35 @@ namespace ds {
 const int Engine::NumberOfNetworkThreads = 2;
 
 Engine::Engine(	ds::App& app, const ds::EngineSettings &settings,
-				ds::EngineData& ed, const RootList& _roots)
+				ds::EngineData& ed, const RootList& _roots, const double fixedDt)
+	: Engine(&app, settings, ed, _roots, fixedDt)
+{
+}
+
+Engine::Engine(	ds::App* app, const ds::EngineSettings &settings,
+				ds::EngineData& ed, const RootList& _roots, const double fixedDt)
 	: ds::ui::SpriteEngine(ed)
-	, mTweenline(app.timeline())
+	, mFixedDt(fixedDt > 0.0 ? fixedDt : 0.0)
+	, mFixedTime(0.0)
+	, mFixedTimeline(mFixedDt > 0.0 || !app ? ci::Timeline::create() : nullptr)
+	, mTweenline(mFixedTimeline ? *mFixedTimeline : app->timeline())
 	, mIdling(true)
+	, mLateLatch(false)
+	, mTimeTouches(false)
 	, mTouchMode(ds::ui::TouchMode::kTuioAndMouse)
 	, mTouchManager(*this, mTouchMode)
+	, mGestureEngine(*this)
 	, mPangoFontService(*this)
 	, mSettings(settings)
-	, mTouchBeginEvents(mTouchMutex,	mLastTouchTime, mIdling, [&app, this](const ds::ui::TouchEvent& e) {app.onTouchesBegan(e); this->mTouchManager.touchesBegin(e);}, "touchbegin")
-	, mTouchMovedEvents(mTouchMutex,	mLastTouchTime, mIdling, [&app, this](const ds::ui::TouchEvent& e) {app.onTouchesMoved(e); this->mTouchManager.touchesMoved(e);}, "touchmoved")
-	, mTouchEndedEvents(mTouchMutex,	mLastTouchTime, mIdling, [&app, this](const ds::ui::TouchEvent& e) {app.onTouchesEnded(e); this->mTouchManager.touchesEnded(e);}, "touchend")
+	, mTouchBeginEvents(mTouchMutex,	mLastTouchTime, mIdling, [app, this](const ds::ui::TouchEvent& e) {if (app) app->onTouchesBegan(e); this->mTouchManager.touchesBegin(e);}, "touchbegin")
+	, mTouchMovedEvents(mTouchMutex,	mLastTouchTime, mIdling, [app, this](const ds::ui::TouchEvent& e) {if (app) app->onTouchesMoved(e); this->mTouchManager.touchesMoved(e);}, "touchmoved")
+	, mTouchEndedEvents(mTouchMutex,	mLastTouchTime, mIdling, [app, this](const ds::ui::TouchEvent& e) {if (app) app->onTouchesEnded(e); this->mTouchManager.touchesEnded(e);}, "touchend")
 	, mMouseBeginEvents(mTouchMutex,	mLastTouchTime, mIdling, [this](const MousePair& e)  {handleMouseTouchBegin(e.first, e.second);}, "mousebegin")
 	, mMouseMovedEvents(mTouchMutex,	mLastTouchTime, mIdling, [this](const MousePair& e)  {handleMouseTouchMoved(e.first, e.second);}, "mousemoved")
 	, mMouseEndedEvents(mTouchMutex,	mLastTouchTime, mIdling, [this](const MousePair& e)  {handleMouseTouchEnded(e.first, e.second);}, "mouseend")
-	, mTuioObjectsBegin(mTouchMutex,	mLastTouchTime, mIdling, [&app](const TuioObject& e) {app.tuioObjectBegan(e);}, "tuiobegin")
-	, mTuioObjectsMoved(mTouchMutex,	mLastTouchTime, mIdling, [&app](const TuioObject& e) {app.tuioObjectMoved(e);}, "tuiomoved")
-	, mTuioObjectsEnded(mTouchMutex,	mLastTouchTime, mIdling, [&app](const TuioObject& e) {app.tuioObjectEnded(e);}, "tuioend")
+	, mTuioObjectsBegin(mTouchMutex,	mLastTouchTime, mIdling, [app](const TuioObject& e) {if (app) app->tuioObjectBegan(e);}, "tuiobegin")
+	, mTuioObjectsMoved(mTouchMutex,	mLastTouchTime, mIdling, [app](const TuioObject& e) {if (app) app->tuioObjectMoved(e);}, "tuiomoved")
+	, mTuioObjectsEnded(mTouchMutex,	mLastTouchTime, mIdling, [app](const TuioObject& e) {if (app) app->tuioObjectEnded(e);}, "tuioend")
 	, mHideMouse(false)
 	, mUniqueColor(0, 0, 0)
 	, mAutoDraw(new AutoDrawService())
@@ -100,6 +115,27 @@ Engine::Engine(	ds::App& app, const ds::EngineSettings &settings,
 	mData.mSwipeQueueSize = settings.getInt("touch:swipe:queue_size", 0, 4);
 	mData.mSwipeMinVelocity = settings.getFloat("touch:swipe:minimum_velocity", 0, 800.0f);
 	mData.mSwipeMaxTime = settings.getFloat("touch:swipe:maximum_time", 0, 0.5f);
+	mData.mPredictionDragWeight = settings.getFloat("touch:predict:drag", 0, 1.0f);
+	mData.mPredictionScaleRotateWeight = settings.getFloat("touch:predict:scale_rotate", 0, 1.0f);
+	mTouchManager.setPrediction(settings.getFloat("touch:predict:ms", 0, 0.0f),
+								settings.getFloat("touch:predict:max_distance", 0, 50.0f),
+								settings.getFloat("touch:predict:acceleration", 0, 0.0f));
+	mLateLatch = settings.getBool("touch:late_latch", 0, false);
+	const std::string latencyLog = settings.getText("touch:latency_log", 0, "");
+	if (!latencyLog.empty()) mTouchManager.getLatencyLog().setPath(ds::Environment::expand(latencyLog));
+	const std::string touchRecord = settings.getText("touch:record", 0, "");
+	if (!touchRecord.empty()) mTouchRecorder.setPath(ds::Environment::expand(touchRecord));
+	const std::string touchReplay = settings.getText("touch:replay", 0, "");
+	if (!touchReplay.empty()) {
+		mTouchReplayer.setHandlers(	[this](const ds::ui::TouchEvent& e) {injectTouchesBegin(e);},
+									[this](const ds::ui::TouchEvent& e) {injectTouchesMoved(e);},
+									[this](const ds::ui::TouchEvent& e) {injectTouchesEnded(e);});
+		mTouchReplayer.setSpeed(settings.getFloat("touch:replay:speed", 0, 1.0f));
+		mTouchReplayer.setLoop(settings.getBool("touch:replay:loop", 0, false));
+		const std::string timing = settings.getText("touch:replay:timing", 0, "");
+		if (!timing.empty()) mTouchReplayer.setTimingPath(ds::Environment::expand(timing));
+		mTouchReplayer.load(ds::Environment::expand(touchReplay));
+	}
 	mData.mFrameRate = settings.getFloat("frame_rate", 0, 60.0f);
 
 	const bool verboseTouchLogging = settings.getBool("touch_overlay:verbose_logging", 0, false);
@@ -129,6 +165,12 @@ Engine::Engine(	ds::App& app, const ds::EngineSettings &settings,
 		
 	}
 
+	if((mData.mDstRect.getWidth() < 1 || mData.mDstRect.getHeight() < 1) && !app){
+		// No display to ask without an app, so the screen is the world
+		if(mData.mWorldSize.x < 1 || mData.mWorldSize.y < 1) mData.mWorldSize = ci::vec2(1920.0f, 1080.0f);
+		mData.mSrcRect = ci::Rectf(0.0f, 0.0f, mData.mWorldSize.x, mData.mWorldSize.y);
+		mData.mDstRect = mData.mSrcRect;
+	}
 	if(mData.mDstRect.getWidth() < 1 || mData.mDstRect.getHeight() < 1){
 		DS_LOG_WARNING("Screen rect is 0 width or height. Overriding to full screen size");
 		ci::DisplayRef mainDisplay = ci::Display::getMainDisplay();
@@ -228,13 +270,29 @@ Engine::Engine(	ds::App& app, const ds::EngineSettings &settings,
 
 	setIdleTimeout((int)settings.getFloat("idle_time", 0, 300));
 	setMute(settings.getBool("platform:mute", 0, false));
+
+	mParallelUpdate.setEnabled(settings.getBool("update:parallel", 0, true));
+	mAutoUpdateServer.setParallelUpdate(&mParallelUpdate);
+	mAutoUpdateClient.setParallelUpdate(&mParallelUpdate);
+	mPangoFontService.setAsyncText(settings.getBool("text:async", 0, false));
+	mPangoFontService.setUseGlyphAtlas(settings.getBool("text:glyph_atlas", 0, false));
+	const int			glyphPages = settings.getInt("text:glyph_atlas_pages", 0, static_cast<int>(ds::ui::GlyphAtlas::DEFAULT_PAGE_BUDGET));
+	if (glyphPages > 0) mPangoFontService.getGlyphAtlas().setPageBudget(static_cast<size_t>(glyphPages));
+
+	ds::Profiler&		profiler(ds::Profiler::get());
+	const int			profileEvents = settings.getInt("profiler:events_per_thread", 0, 16384);
+	if (profileEvents > 0) profiler.setEventsPerThread(static_cast<size_t>(profileEvents));
+	profiler.setTracePath(ds::Environment::expand(settings.getText("profiler:trace_path", 0, "%LOCAL%/ds_trace.json")));
+	profiler.setTraceAfter(settings.getInt("profiler:trace_after_frames", 0, 0));
+	profiler.setAllocationBudget(settings.getInt("profiler:alloc_budget", 0, 0));
+	profiler.setEnabled(settings.getBool("profiler:enabled", 0, false));
 }
 
 
 void Engine::prepareSettings(ci::app::AppBase::Settings& settings){
 	// TODO: remove this null_renderer bullshit
 	std::string screenMode = "window";
-	if(mSettings.getBoolSize("null_renderer") > 0 && mSettings.getBool("null_renderer"))
+	if(hasNullRenderer())
 	{
 		// a 50x25 window for null renderer.
 		settings.setWindowSize(50, 25);
@@ -267,6 +325,7 @@ void Engine::prepareSettings(ci::app::AppBase::Settings& settings){
 	mTuioPort = mSettings.getInt("tuio_port", 0, 3333);
 	setTouchSmoothing(mSettings.getBool("touch_smoothing", 0, true));
 	setTouchSmoothFrames(mSettings.getInt("touch_smooth_frames", 0, 5));
+	mTouchManager.setCoalesceMoves(mSettings.getBool("touch:coalesce_moves", 0, true));
 
 	settings.setFrameRate(mData.mFrameRate);
 
@@ -301,6 +360,22 @@ void Engine::setup(ds::App& app) {
 		}
 	}
 
+	setupCommon(!hasNullRenderer());
+}
+
+void Engine::setupWithoutWindow() {
+	// Touches come in screen space, and the screen is the src rect
+	mTouchTranslator.setTranslation(mData.mSrcRect.x1, mData.mSrcRect.y1);
+	mTouchTranslator.setScale(1.0f, 1.0f);
+
+	for(auto it = mRoots.begin(), end = mRoots.end(); it != end; ++it) {
+		(*it)->postAppSetup();
+	}
+
+	setupCommon(false);
+}
+
+void Engine::setupCommon(const bool hasContext) {
 	const int		w = static_cast<int>(getWidth()),
 		h = static_cast<int>(getHeight());
 	if(w < 1 || h < 1) {
@@ -309,13 +384,20 @@ void Engine::setup(ds::App& app) {
 		DS_LOG_WARNING("Engine::setup() on 0 size width or height");
 	}
 
-	float curr = static_cast<float>(ci::app::getElapsedSeconds());
+	float curr = static_cast<float>(getElapsedTimeSeconds());
 	mLastTime = curr;
 	mLastTouchTime = 0;
 
 	mUpdateParams.setDeltaTime(0.0f);
 	mUpdateParams.setElapsedTime(curr);
 
+	getWorkManager().setUpdateBudget(mSettings.getFloat("work:update_budget", 0, 0.004f));
+
+	// The null renderer has no context to share
+	if(hasContext) {
+		mGlUploadPool.start(mSettings.getInt("gl:upload_threads", 0, 2));
+	}
+
 	// Start any library services
 	if(!mData.mServices.empty()) {
 		for(auto it = mData.mServices.begin(), end = mData.mServices.end(); it != end; ++it) {
@@ -326,7 +408,16 @@ void Engine::setup(ds::App& app) {
 
 void Engine::setupTouch(ds::App& a) {
 	
-	if(ds::ui::TouchMode::hasTuio(mTouchMode)) {
+	if(ds::ui::TouchMode::hasTuio(mTouchMode) && mSettings.getBool("tuio:native", 0, false)
+			&& !mSettings.getBool("tuio:receive_objects", 0, false)) {
+		mTuioReceiver.setHandlers(	[this](const ds::ui::TouchEvent& e) {touchesBegin(e);},
+									[this](const ds::ui::TouchEvent& e) {touchesMoved(e);},
+									[this](const ds::ui::TouchEvent& e) {touchesEnded(e);});
+		mTuioReceiver.setScale(ci::vec2(ci::app::getWindowSize()));
+		if(mTuioReceiver.start(mTuioPort)) {
+			DS_LOG_INFO("TUIO receiver listening on port " << mTuioPort);
+		}
+	} else if(ds::ui::TouchMode::hasTuio(mTouchMode)) {
 		ci::tuio::Client&		tuioClient = getTuioClient();
 		tuioClient.registerTouches(&a);
 		registerForTuioObjects(tuioClient);
@@ -402,10 +493,13 @@ void Engine::createStatsView(sprite_id_t root_id){
 
 Engine::~Engine() {
 	mTuio.disconnect();
+	mTuioReceiver.stop();
 
 	// Important to do this here before the auto update list is destructed.
 	// so any autoupdate services get removed.
 	mData.clearServices();
+	// Services can hand off cleanup to the upload threads, so they go after.
+	mGlUploadPool.stop();
 }
 
 ds::EventNotifier& Engine::getChannel(const std::string &name) {
@@ -510,46 +604,63 @@ const RootList::Root& Engine::getRootBuilder(const size_t index){
 }
 
 void Engine::updateClient() {
-	float curr = static_cast<float>(ci::app::getElapsedSeconds());
+	DS_PROFILE_SCOPE("Engine::updateClient");
+	float curr = static_cast<float>(getElapsedTimeSeconds());
 	float dt = curr - mLastTime;
 	mLastTime = curr;
 
 	if (!mIdling && (curr - mLastTouchTime) >= (float)getIdleTimeout()) {
 		mIdling = true;
 	}
+	updateTouchTranslator();
+	mTouchReplayer.update(getElapsedTimeSeconds());
 	{
 		std::lock_guard<std::mutex> lock(mTouchMutex);
 		mMouseBeginEvents.lockedUpdate();
 		mMouseMovedEvents.lockedUpdate();
 		mMouseEndedEvents.lockedUpdate();
+
+		mTouchBeginEvents.lockedUpdate();
+		mTouchMovedEvents.lockedUpdate();
+		mTouchEndedEvents.lockedUpdate();
 	}
 
-	mMouseBeginEvents.update(curr);
-	mMouseMovedEvents.update(curr);
-	mMouseEndedEvents.update(curr);
+	{
+		DS_PROFILE_SCOPE("touch dispatch");
+		mMouseBeginEvents.update(curr);
+		mMouseMovedEvents.update(curr);
+		mMouseEndedEvents.update(curr);
+
+		mTouchBeginEvents.update(curr);
+		mTouchMovedEvents.update(curr);
+		mTouchEndedEvents.update(curr);
+	}
 
 	mUpdateParams.setDeltaTime(dt);
 	mUpdateParams.setElapsedTime(curr);
 
+	mData.mNotifier.flushDeferred();
+	mGlUploadPool.update();
 	mAutoUpdateClient.update(mUpdateParams);
 
 	for (auto it=mRoots.begin(), end=mRoots.end(); it!=end; ++it) {
 		(*it)->updateClient(mUpdateParams);
 	}
+	mParallelUpdate.runClient(mUpdateParams);
 }
 
 void Engine::updateServer() {
-	if(mCachedWindowW != ci::app::getWindowWidth() || mCachedWindowH != ci::app::getWindowHeight()) {
-		mCachedWindowW = ci::app::getWindowWidth();
-		mCachedWindowH = ci::app::getWindowHeight();
-		mTouchTranslator.setScale(	mData.mSrcRect.getWidth() / static_cast<float>(mCachedWindowW),
-									mData.mSrcRect.getHeight() / static_cast<float>(mCachedWindowH));
-	}
+	DS_PROFILE_SCOPE("Engine::updateServer");
+	updateTouchTranslator();
 
-	const float		curr = static_cast<float>(ci::app::getElapsedSeconds());
+	const float		curr = static_cast<float>(getElapsedTimeSeconds());
 	const float		dt = curr - mLastTime;
 	mLastTime = curr;
 
+	mTimeTouches = mTouchReplayer.isPlaying();
+	mGestureEngine.setTimed(mTimeTouches);
+	mTouchReplayer.update(getElapsedTimeSeconds());
+
 	//////////////////////////////////////////////////////////////////////////
 	{
 		std::lock_guard<std::mutex> lock(mTouchMutex);
@@ -567,17 +678,23 @@ void Engine::updateServer() {
 	} // unlock touch mutex
 	//////////////////////////////////////////////////////////////////////////
 
-	mMouseBeginEvents.update(curr);
-	mMouseMovedEvents.update(curr);
-	mMouseEndedEvents.update(curr);
-
-	mTouchBeginEvents.update(curr);
-	mTouchMovedEvents.update(curr);
-	mTouchEndedEvents.update(curr);
-
-	mTuioObjectsBegin.update(curr);
-	mTuioObjectsMoved.update(curr);
-	mTuioObjectsEnded.update(curr);
+	const Poco::Timestamp	dispatchStart;
+	{
+		DS_PROFILE_SCOPE("touch dispatch");
+		mMouseBeginEvents.update(curr);
+		mMouseMovedEvents.update(curr);
+		mMouseEndedEvents.update(curr);
+
+		mTouchBeginEvents.update(curr);
+		mTouchMovedEvents.update(curr);
+		mTouchManager.dispatchMoves();
+		mTouchEndedEvents.update(curr);
+
+		mTuioObjectsBegin.update(curr);
+		mTuioObjectsMoved.update(curr);
+		mTuioObjectsEnded.update(curr);
+	}
+	const Poco::Timestamp::TimeDiff	dispatchTime = dispatchStart.elapsed();
 
 	if (!mIdling && (curr - mLastTouchTime) >= (float)getIdleTimeout()) {
 		mIdling = true;
@@ -586,11 +703,22 @@ void Engine::updateServer() {
 	mUpdateParams.setDeltaTime(dt);
 	mUpdateParams.setElapsedTime(curr);
 
+	mData.mNotifier.flushDeferred();
+	mGlUploadPool.update();
 	mAutoUpdateServer.update(mUpdateParams);
+	{
+		DS_PROFILE_SCOPE("gestures");
+		mGestureEngine.update(mUpdateParams);
+	}
+	if (mTimeTouches) {
+		mTouchReplayer.frameTiming(dispatchTime, mGestureEngine.takeTime());
+		mTimeTouches = false;
+	}
 
 	for (auto it=mRoots.begin(), end=mRoots.end(); it!=end; ++it) {
 		(*it)->updateServer(mUpdateParams);
 	}
+	mParallelUpdate.runServer(mUpdateParams);
 }
 
 void Engine::markCameraDirty() {
@@ -687,21 +815,65 @@ void Engine::registerForTuioObjects(ci::tuio::Client& client) {
 }
 
 void Engine::drawClient() {
+	DS_PROFILE_SCOPE("Engine::drawClient");
 	ci::gl::enableAlphaBlending();
 
 	ci::gl::clear(ci::ColorA(0.0f, 0.0f, 0.0f, 0.0f));
 
 	for(auto it = getRoots().begin(), end = getRoots().end(); it != end; ++it){
+		DS_PROFILE_SCOPE("root draw");
 		(*it)->drawClient(getDrawParams(), getAutoDrawService());
 	}
 }
 
+void Engine::updateTouchTranslator() {
+	// Set once in setupWithoutWindow()
+	if(!mCinderWindow) return;
+	if(mCachedWindowW != ci::app::getWindowWidth() || mCachedWindowH != ci::app::getWindowHeight()) {
+		mCachedWindowW = ci::app::getWindowWidth();
+		mCachedWindowH = ci::app::getWindowHeight();
+		mTouchTranslator.setScale(	mData.mSrcRect.getWidth() / static_cast<float>(mCachedWindowW),
+									mData.mSrcRect.getHeight() / static_cast<float>(mCachedWindowH));
+		mTuioReceiver.setScale(ci::vec2(static_cast<float>(mCachedWindowW), static_cast<float>(mCachedWindowH)));
+	}
+}
+
+void Engine::setTouchHandlers(	const std::function<void(const ds::ui::TouchEvent&)>& began,
+								const std::function<void(const ds::ui::TouchEvent&)>& moved,
+								const std::function<void(const ds::ui::TouchEvent&)>& ended) {
+	mTouchBeginEvents.setUpdateFn(began);
+	mTouchMovedEvents.setUpdateFn(moved);
+	mTouchEndedEvents.setUpdateFn(ended);
+}
+
+void Engine::lateLatchTouches() {
+	if (!mLateLatch) return;
+
+	DS_PROFILE_SCOPE("touch late latch");
+	{
+		std::lock_guard<std::mutex> lock(mTouchMutex);
+		if (mTouchBeginEvents.lockedHasIncoming() || mTouchEndedEvents.lockedHasIncoming()
+				|| mMouseBeginEvents.lockedHasIncoming() || mMouseEndedEvents.lockedHasIncoming()) {
+			return;
+		}
+		mMouseMovedEvents.lockedUpdate();
+		mTouchMovedEvents.lockedUpdate();
+	}
+
+	const float		curr = static_cast<float>(getElapsedTimeSeconds());
+	mMouseMovedEvents.update(curr);
+	mTouchMovedEvents.update(curr);
+	mTouchManager.dispatchMoves();
+}
+
 void Engine::drawServer() {
+	DS_PROFILE_SCOPE("Engine::drawServer");
 	ci::gl::enableAlphaBlending();
 
 	ci::gl::clear(ci::ColorA(0.0f, 0.0f, 0.0f, 0.0f));
 
 	for(auto it = getRoots().cbegin(), end = getRoots().cend(); it != end; ++it){
+		DS_PROFILE_SCOPE("root draw");
 		(*it)->drawServer(getDrawParams());
 	}
 }
@@ -756,14 +928,20 @@ ci::Color8u Engine::getUniqueColor() {
 }
 
 void Engine::touchesBegin(const ds::ui::TouchEvent &e) {
+	mTouchRecorder.record(ds::TouchRecorder::BEGAN, e);
 	mTouchBeginEvents.incoming(mTouchTranslator.toWorldSpace(e));
 }
 
 void Engine::touchesMoved(const ds::ui::TouchEvent &e) {
-	mTouchMovedEvents.incoming(mTouchTranslator.toWorldSpace(e));
+	mTouchRecorder.record(ds::TouchRecorder::MOVED, e);
+	ds::ui::TouchEvent		worldEvent(mTouchTranslator.toWorldSpace(e));
+	// Moves forwarded from a client already know when they arrived there
+	if (worldEvent.getReceivedTime() <= 0) worldEvent.setReceivedTime(Poco::Timestamp().epochMicroseconds());
+	mTouchMovedEvents.incoming(worldEvent);
 }
 
 void Engine::touchesEnded(const ds::ui::TouchEvent &e) {
+	mTouchRecorder.record(ds::TouchRecorder::ENDED, e);
 	mTouchEndedEvents.incoming(mTouchTranslator.toWorldSpace(e));
 }
 
@@ -773,19 +951,19 @@ ci::tuio::Client &Engine::getTuioClient() {
 
 void Engine::mouseTouchBegin(const ci::app::MouseEvent &e, int id) {
 	if (ds::ui::TouchMode::hasMouse(mTouchMode)) {
-		mMouseBeginEvents.incoming(MousePair(alteredMouseEvent(e), id));
+		mMouseBeginEvents.incoming(MousePair(e, id));
 	}
 }
 
 void Engine::mouseTouchMoved(const ci::app::MouseEvent &e, int id) {
 	if (ds::ui::TouchMode::hasMouse(mTouchMode)) {
-		mMouseMovedEvents.incoming(MousePair(alteredMouseEvent(e), id));
+		mMouseMovedEvents.incoming(MousePair(e, id));
 	}
 }
 
 void Engine::mouseTouchEnded(const ci::app::MouseEvent &e, int id) {
 	if (ds::ui::TouchMode::hasMouse(mTouchMode)) {
-		mMouseEndedEvents.incoming(MousePair(alteredMouseEvent(e), id));
+		mMouseEndedEvents.incoming(MousePair(e, id));
 	}
 }
 
@@ -797,17 +975,11 @@ ci::app::MouseEvent Engine::alteredMouseEvent(const ci::app::MouseEvent& e) cons
 	// the newer version of cinder gave access so hopefully can just wait for that if we need it.
 
 	// Transform the mouse event coordinate from window/screen space to world
-	// coordinates.  Note: We are using the actual window size here, not the
-	// mDstRect size, which may be different if the window gets automagically
-	// resized for some reason.  (For example, in fullscreen mode, or a window
-	// mode on a screen that is not big enough for the mDstRect)
-	const ci::vec2 srcOffset = mData.mSrcRect.getUpperLeft();
-
-	auto screenSize = glm::vec2( ci::app::getWindowSize() );
-	const ci::vec2 screenScale = screenSize / mData.mSrcRect.getSize();
-
-	const ci::vec2 mouseWorldPos = srcOffset + (ci::vec2(e.getX(), e.getY()) / screenScale);
-	const ci::ivec2 pos((int)mouseWorldPos.x, (int)mouseWorldPos.y);
+	// coordinates, the same way touches are.  Note: The translator uses the actual
+	// window size, not the mDstRect size, which may be different if the window gets
+	// automagically resized for some reason.  (For example, in fullscreen mode, or a
+	// window mode on a screen that is not big enough for the mDstRect)
+	const ci::ivec2 pos(mTouchTranslator.toWorldi(e.getX(), e.getY()));
 
 	return ci::app::MouseEvent(e.getWindow(),	0, pos.x, pos.y,
 												0, e.getWheelIncrement(), e.getNativeModifiers());
@@ -875,11 +1047,13 @@ bool Engine::getHideMouse() const {
 }
 
 ds::ui::Sprite* Engine::getHit(const ci::vec3& point) {
-	for (auto it=mRoots.rbegin(), end=mRoots.rend(); it!=end; ++it) {
-		ds::ui::Sprite* s = (*it)->getHit(point);
-		if (s) return s;
+	const Poco::Timestamp::TimeVal	start = mTimeTouches ? Poco::Timestamp().epochMicroseconds() : 0;
+	ds::ui::Sprite*			hit = nullptr;
+	for (auto it=mRoots.rbegin(), end=mRoots.rend(); it!=end && !hit; ++it) {
+		hit = (*it)->getHit(point);
 	}
-	return nullptr;
+	if (mTimeTouches) mTouchReplayer.addPickTime(Poco::Timestamp().epochMicroseconds() - start);
+	return hit;
 }
 
 void Engine::clearFingers( const std::vector<int> &fingers ) {
@@ -912,6 +1086,21 @@ void Engine::writeSprites(std::ostream &s) const {
 #endif
 }
 
+double Engine::getElapsedTimeSeconds() const {
+	if (mFixedDt > 0.0) return mFixedTime;
+	return ci::app::getElapsedSeconds();
+}
+
+void Engine::stepFixedClock() {
+	if (mFixedDt <= 0.0) return;
+	mFixedTime += mFixedDt;
+	mFixedTimeline->stepTo(static_cast<float>(mFixedTime));
+}
+
+bool Engine::hasNullRenderer() const {
+	return mSettings.getBoolSize("null_renderer") > 0 && mSettings.getBool("null_renderer");
+}
+
 bool Engine::isIdling() const {
 	return mIdling;
 }
@@ -922,7 +1111,7 @@ void Engine::startIdling() {
 
 void Engine::resetIdleTimeout() {
 	//DS_LOG_INFO("ResetIdleTimeout");
-	float curr = static_cast<float>(ci::app::getElapsedSeconds());
+	float curr = static_cast<float>(getElapsedTimeSeconds());
 	mLastTime = curr;
 	mLastTouchTime = curr;
 	mIdling = false;
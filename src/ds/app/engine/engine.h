@@ -13,6 +13,7 @@
 #include "ds/app/blob_registry.h"
 #include "ds/app/event_notifier.h"
 #include "ds/app/image_registry.h"
+#include "ds/app/parallel_update.h"
 #include "ds/ui/sprite/sprite.h"
 #include "ds/params/update_params.h"
 #include "ds/params/draw_params.h"
@@ -27,13 +28,18 @@
 #include "ds/data/font_list.h"
 #include "ds/data/resource_list.h"
 #include "ds/data/tuio_object.h"
+#include "ds/debug/touch_recorder.h"
+#include "ds/debug/touch_replayer.h"
 #include "ds/app/engine/engine_settings.h"
 #include "ds/ui/ip/ip_function_list.h"
 #include "ds/ui/service/pango_font_service.h"
 #include "ds/ui/sprite/sprite_engine.h"
+#include "ds/ui/touch/gesture_engine.h"
 #include "ds/ui/touch/touch_manager.h"
 #include "ds/ui/touch/touch_translator.h"
+#include "ds/ui/touch/tuio_receiver.h"
 #include "ds/ui/tween/tweenline.h"
+#include "ds/thread/gl_upload_pool.h"
 #include "ds/app/camera_utils.h"
 
 namespace ds {
@@ -64,6 +70,9 @@ public:
 	virtual ds::EventNotifier&			getChannel(const std::string&);
 	void								addChannel(const std::string &name, const std::string &description);
 	virtual ds::AutoUpdateList&			getAutoUpdateList(const int = AutoUpdateType::SERVER);
+	virtual ds::ParallelUpdate&			getParallelUpdate() { return mParallelUpdate; }
+	virtual ds::GlUploadPool&			getGlUploadPool() { return mGlUploadPool; }
+	virtual ds::ui::GestureEngine&		getGestureEngine() { return mGestureEngine; }
 	virtual ds::ImageRegistry&			getImageRegistry() { return mImageRegistry; }
 	virtual ds::ui::PangoFontService&	getPangoFontService(){ return mPangoFontService; }
 	virtual ds::ui::Tweenline&			getTweenline() { return mTweenline; }
@@ -107,6 +116,8 @@ public:
 	virtual void						setup(ds::App&);
 	void								setupTouch(ds::App&);
 
+	virtual double						getElapsedTimeSeconds() const;
+
 	bool								isIdling() const;
 	virtual void						startIdling();
 	virtual void						resetIdleTimeout();
@@ -222,13 +233,28 @@ public:
 	void														createClientRoots(std::vector<RootList::Root> newRoots);
 
 protected:
-	Engine(ds::App&, const ds::EngineSettings&, ds::EngineData&, const RootList&);
+	// A fixedDt above 0 steps time by that much every stepFixedClock() instead of following the
+	// wall clock, for the update and the tweens. Tweens get a timeline the engine owns.
+	Engine(ds::App&, const ds::EngineSettings&, ds::EngineData&, const RootList&, const double fixedDt = 0.0);
+	// With no app, so no window, GL context or app callbacks. Needs a fixedDt above 0.
+	Engine(ds::App*, const ds::EngineSettings&, ds::EngineData&, const RootList&, const double fixedDt);
+
+	// setup() for engines with no app: the screen is the src rect, and nothing touches GL.
+	void								setupWithoutWindow();
+
+	void								stepFixedClock();
+	// Only a small window, without drawing anything worth seeing. True with the null_renderer setting.
+	virtual bool						hasNullRenderer() const;
 
 	// Conveniences for the subclases
 	void								updateClient();
 	void								updateServer();
 	void								drawClient();
 	void								drawServer();
+	// Engines that own their touches call this just before drawing. With the touch:late_latch
+	// setting, moves that came in since the update are sent now, so dragged sprites draw where
+	// the fingers are. Left for the next update if a finger went down or up in the meantime.
+	void								lateLatchTouches();
 
 	/** Called from the destructor of all subclasses, so I can cleanup sprites before services go away.
 		\param clearDebug If true, will clear all the children from the debug roots too. 
@@ -237,12 +263,24 @@ protected:
 
 	/** When mouse events are ready to be handled by the touch manager. 
 		These are enforced virtual functions to be sure the engine handles mouse events.
-		Servers will send directly to the touch manager, and clients can send back to the server */
+		Servers will send directly to the touch manager, and clients can send back to the server.
+		The events are still in screen space: use alteredMouseEvent() or getTouchTranslator(). */
 	virtual void						handleMouseTouchBegin(const ci::app::MouseEvent&, int id) = 0;
 	virtual void						handleMouseTouchMoved(const ci::app::MouseEvent&, int id) = 0;
 	virtual void						handleMouseTouchEnded(const ci::app::MouseEvent&, int id) = 0;
 
+	/** Touch events normally go to the app and the touch manager. Clients don't own the touches,
+		so they take them here instead, already in world space. */
+	void								setTouchHandlers(	const std::function<void(const ds::ui::TouchEvent&)>& began,
+															const std::function<void(const ds::ui::TouchEvent&)>& moved,
+															const std::function<void(const ds::ui::TouchEvent&)>& ended);
+
+	// Screen space to world space, for touches and mouse events
+	const ds::ui::TouchTranslator&		getTouchTranslator() const	{ return mTouchTranslator; }
+
 	ui::TouchManager					mTouchManager;
+	// Declared before the roots, so their sprites can hand back gestures as they're deleted
+	ui::GestureEngine					mGestureEngine;
 
 	static const int					NumberOfNetworkThreads;
 
@@ -258,13 +296,20 @@ protected:
 private:
 	void								setTouchMode(const ds::ui::TouchMode::Enum&);
 	void								createStatsView(sprite_id_t root_id);
+	void								updateTouchTranslator();
+	// The end of setup, with the screen and roots ready. Upload threads only start with a context.
+	void								setupCommon(const bool hasContext);
 
 	friend class EngineStatsView;
 	std::vector<std::unique_ptr<EngineRoot> >
 										mRoots;
+
 	const ds::EngineSettings&			mSettings;
 	ImageRegistry						mImageRegistry;
 	ds::ui::PangoFontService			mPangoFontService;
+	const double						mFixedDt;
+	double								mFixedTime;
+	ci::TimelineRef						mFixedTimeline;
 	ds::ui::Tweenline					mTweenline;
 	// A cache of all the resources in the system
 	ResourceList						mResources;
@@ -275,12 +320,24 @@ private:
 	float								mLastTime;
 	bool								mIdling;
 	float								mLastTouchTime;
+	bool								mLateLatch;
 
 	ci::tuio::Client					mTuio;
+	// Used instead of mTuio with the "tuio:native" setting
+	ds::ui::TuioReceiver				mTuioReceiver;
+	// The "touch:record" and "touch:replay" settings
+	ds::TouchRecorder					mTouchRecorder;
+	ds::TouchReplayer					mTouchReplayer;
+	// Picks are timed for the replay on the frames it plays
+	bool								mTimeTouches;
 	// Clients that will get update() called automatically at the start
 	// of each update cycle
 	AutoUpdateList						mAutoUpdateServer;
 	AutoUpdateList						mAutoUpdateClient;
+	// Sprites and auto updates that run across threads, after the rest of the update
+	ParallelUpdate						mParallelUpdate;
+	// Texture creation and other GL work, on threads with shared contexts
+	GlUploadPool						mGlUploadPool;
 	// Quick hack to get any ol' client participating in draw
 	AutoDrawService*					mAutoDraw;
 
@@ -2,6 +2,7 @@
 
 #include "ds/app/engine/engine_client.h"
 
+#include <algorithm>
 #include "ds/app/engine/engine_io_defs.h"
 #include "ds/app/engine/engine_data.h"
 #include "ds/debug/logger.h"
@@ -25,6 +26,11 @@ char				CLIENT_STATUS_BLOB = 0;
 
 // Used for clients to send mouse and/or touch input back to server
 char				CLIENT_INPUT_BLOB = 0;
+
+// Mouse buttons arrive as ids 1 and 2 and go out as 0 and 1, touches follow them
+const int32_t		CLIENT_MOUSE_IDS = 2;
+// Keep each input datagram a reasonable size
+const size_t		MAX_INPUT_PER_SEND = 256;
 }
 
 /**
@@ -56,6 +62,12 @@ EngineClient::EngineClient(	ds::App& app, const ds::EngineSettings& settings,
 	CLIENT_STATUS_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveClientStatus(r.mDataBuffer); });
 	CLIENT_INPUT_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveClientInput(r.mDataBuffer); });
 	mReceiver.setHeaderAndCommandIds(HEADER_BLOB, COMMAND_BLOB);
+
+	// The server owns the touches, so they're gathered up and sent there
+	mInput.reserve(64);
+	setTouchHandlers(	[this](const ds::ui::TouchEvent& e) {addInput(INPUT_BEGIN, e);},
+						[this](const ds::ui::TouchEvent& e) {addInput(INPUT_MOVED, e);},
+						[this](const ds::ui::TouchEvent& e) {addInput(INPUT_ENDED, e);});
 	
 	try {
 		if (settings.getBool("server:connect", 0, true)) {
@@ -91,6 +103,7 @@ void EngineClient::setup(ds::App& app) {
 void EngineClient::update() {
 	mWorkManager.update();
 	updateClient();
+	sendInput();
 	mComputerInfo->update();
 
 	if (!mConnectionRenewed && 
@@ -289,33 +302,64 @@ void EngineClient::setState(State& s) {
 	mState = &s;
 }
 
+// The server takes client input as already in world space
 void EngineClient::handleMouseTouchBegin(const ci::app::MouseEvent& e, int id){
-	sendMouseTouch(0, e.getPos());
+	addInput(INPUT_BEGIN, id - 1, getTouchTranslator().toWorldf(static_cast<float>(e.getX()), static_cast<float>(e.getY())), Poco::Timestamp().epochMicroseconds());
 }
 
 void EngineClient::handleMouseTouchMoved(const ci::app::MouseEvent& e, int id){
-	sendMouseTouch(1, e.getPos());
+	addInput(INPUT_MOVED, id - 1, getTouchTranslator().toWorldf(static_cast<float>(e.getX()), static_cast<float>(e.getY())), Poco::Timestamp().epochMicroseconds());
 }
 
 void EngineClient::handleMouseTouchEnded(const ci::app::MouseEvent& e, int id){
-	sendMouseTouch(2, e.getPos());
+	addInput(INPUT_ENDED, id - 1, getTouchTranslator().toWorldf(static_cast<float>(e.getX()), static_cast<float>(e.getY())), Poco::Timestamp().epochMicroseconds());
 }
 
-void EngineClient::sendMouseTouch(const int phase, const ci::ivec2 pos){
-	
-	ci::vec2 worldPoint = pos;
-//	worldPoint.x = pos.x / (mData.mSrcRect.getWidth() / mData.mDstRect.getWidth());
-//	worldPoint.y = pos.y / (mData.mSrcRect.getHeight() / mData.mDstRect.getHeight());
-	
-	EngineSender::AutoSend  send(mSender);
-	ds::DataBuffer&   buf = send.mData;
-	buf.add(CLIENT_INPUT_BLOB);
-	buf.add(phase); 
-	buf.add(-1); //id
-	buf.add(worldPoint.x);
-	buf.add(worldPoint.y);
-	buf.add(ds::TERMINATOR_CHAR);
+void EngineClient::addInput(const char phase, const int32_t id, const ci::vec2& pos, const Poco::Timestamp::TimeVal time){
+	Input		input;
+	input.mPhase = phase;
+	input.mId = id;
+	input.mPos = pos;
+	input.mTime = time;
+	mInput.push_back(input);
+}
+
+void EngineClient::addInput(const char phase, const ds::ui::TouchEvent& e){
+	// Only moves are stamped when they arrive
+	const Poco::Timestamp::TimeVal	time = e.getReceivedTime() > 0 ? e.getReceivedTime() : Poco::Timestamp().epochMicroseconds();
+	for (auto it = e.getTouches().begin(), end = e.getTouches().end(); it != end; ++it) {
+		addInput(phase, static_cast<int32_t>(it->getId()) + CLIENT_MOUSE_IDS, it->getPos(), time);
+	}
+}
+
+void EngineClient::sendInput(){
+	if (mInput.empty()) return;
+	// The server can only place input from a client it has a session for
+	if (mState != &mRunningState || mSessionId < 1) {
+		mInput.clear();
+		return;
+	}
 
+	const Poco::Timestamp::TimeVal	now = Poco::Timestamp().epochMicroseconds();
+	for (size_t start = 0; start < mInput.size(); start += MAX_INPUT_PER_SEND) {
+		const size_t				count = std::min(mInput.size() - start, MAX_INPUT_PER_SEND);
+		EngineSender::AutoSend		send(mSender);
+		ds::DataBuffer&				buf = send.mData;
+		buf.add(CLIENT_INPUT_BLOB);
+		buf.add(mSessionId);
+		buf.add(static_cast<int32_t>(count));
+		for (size_t k = start; k < start + count; ++k) {
+			const Input&			input = mInput[k];
+			buf.add(input.mPhase);
+			buf.add(input.mId);
+			buf.add(input.mPos.x);
+			buf.add(input.mPos.y);
+			// Microseconds since it arrived, since the server has its own clock
+			buf.add(static_cast<int32_t>(std::max<Poco::Timestamp::TimeVal>(now - input.mTime, 0)));
+		}
+		buf.add(ds::TERMINATOR_CHAR);
+	}
+	mInput.clear();
 }
 
 /**
@@ -9,6 +9,7 @@
 #include "ds/network/udp_connection.h"
 #include "ds/thread/work_manager.h"
 #include "ds/ui/service/load_image_service.h"
+#include "ds/ui/touch/touch_event.h"
 
 namespace ds {
 
@@ -53,7 +54,10 @@ private:
 	virtual void					handleMouseTouchBegin(const ci::app::MouseEvent&, int id);
 	virtual void					handleMouseTouchMoved(const ci::app::MouseEvent&, int id);
 	virtual void					handleMouseTouchEnded(const ci::app::MouseEvent&, int id);
-	void							sendMouseTouch(const int phase, const ci::ivec2 pos);
+	// Input is gathered over the frame and sent to the server as one blob
+	void							addInput(const char phase, const int32_t id, const ci::vec2& pos, const Poco::Timestamp::TimeVal);
+	void							addInput(const char phase, const ds::ui::TouchEvent&);
+	void							sendInput();
 
 	typedef Engine inherited;
 	WorkManager						mWorkManager;
@@ -70,6 +74,14 @@ private:
 	// waiting to hear back.
 	bool							mConnectionRenewed;
 
+	struct Input {
+		char						mPhase;
+		int32_t						mId;
+		ci::vec2					mPos;
+		Poco::Timestamp::TimeVal	mTime;
+	};
+	std::vector<Input>				mInput;
+
 	// STATES
 	class State {
 	public:
@@ -24,6 +24,7 @@ void EngineClientServer::setup(ds::App& app) {
 }
 
 void EngineClientServer::draw() {
+	lateLatchTouches();
 	drawClient();
 }
 
@@ -17,6 +17,8 @@ EngineData::EngineData(const ds::cfg::Settings& engine_settings)
 	, mSwipeQueueSize(4)
 	, mSwipeMinVelocity(800.0f)
 	, mSwipeMaxTime(0.5f)
+	, mPredictionDragWeight(1.0f)
+	, mPredictionScaleRotateWeight(1.0f)
 	, mDoubleTapTime(0.35f)
 	, mFrameRate(60.0f)
 	, mIdleTimeout(300)
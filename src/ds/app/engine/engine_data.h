@@ -34,6 +34,9 @@ public:
 	int						mSwipeQueueSize;
 	float					mSwipeMinVelocity;
 	float					mSwipeMaxTime;
+	// How much of the touch manager's predicted moves each gesture uses, 0 - 1
+	float					mPredictionDragWeight;
+	float					mPredictionScaleRotateWeight;
 	float					mDoubleTapTime;
 	ci::vec2				mWorldSize;
 	float					mFrameRate;
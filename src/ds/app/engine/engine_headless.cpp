@@ -0,0 +1,187 @@
+#include "stdafx.h"
+
+#include "ds/app/engine/engine_headless.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <Poco/Timestamp.h>
+#include "ds/app/environment.h"
+#include "ds/debug/logger.h"
+#include "ds/debug/profiler.h"
+
+namespace ds {
+
+namespace {
+const double		DEFAULT_DT = 1.0 / 60.0;
+
+double				get_dt(const ds::EngineSettings& settings) {
+	const double	dt = settings.getFloat("headless:dt", 0, static_cast<float>(DEFAULT_DT));
+	return dt > 0.0 ? dt : DEFAULT_DT;
+}
+
+double				elapsed_ms(const Poco::Timestamp& start) {
+	return static_cast<double>(start.elapsed()) / 1000.0;
+}
+
+void				write_escaped(std::ostream& os, const std::string& s) {
+	for (auto it = s.begin(), end = s.end(); it != end; ++it) {
+		if (*it == '"' || *it == '\\') os << '\\' << *it;
+		else if (static_cast<unsigned char>(*it) < 0x20) os << ' ';
+		else os << *it;
+	}
+}
+
+// Mean, percentiles and max of one measurement
+void				write_stats(std::ostream& os, std::vector<double> v) {
+	if (v.empty()) {
+		os << "null";
+		return;
+	}
+	std::sort(v.begin(), v.end());
+	double			sum = 0.0;
+	for (auto it = v.begin(), end = v.end(); it != end; ++it) sum += *it;
+	const size_t	last = v.size() - 1;
+	os << "{\"mean\":" << sum / static_cast<double>(v.size())
+		<< ",\"p50\":" << v[last / 2]
+		<< ",\"p95\":" << v[(last * 95) / 100]
+		<< ",\"p99\":" << v[(last * 99) / 100]
+		<< ",\"max\":" << v[last]
+		<< ",\"total\":" << sum << "}";
+}
+
+}
+
+/**
+ * \class ds::EngineHeadless
+ */
+EngineHeadless::EngineHeadless(	const ds::EngineSettings& settings, ds::EngineData& ed,
+								const ds::RootList& roots)
+		: inherited(nullptr, settings, ed, roots, get_dt(settings))
+		, mDt(get_dt(settings))
+		, mWarmupFrames(std::max(settings.getInt("headless:warmup_frames", 0, 60), 0))
+		, mFrames(std::max(settings.getInt("headless:frames", 0, 600), 1))
+		, mSerialize(settings.getBool("headless:serialize", 0, true))
+		, mReportPath(ds::Environment::expand(settings.getText("headless:report_path", 0, "%LOCAL%/headless_report.json")))
+		, mFrame(0)
+		, mStartAllocs(0)
+		, mStartAllocBytes(0) {
+	mUpdateMs.reserve(mFrames);
+	mBytes.reserve(mFrames);
+}
+
+bool EngineHeadless::run(const std::function<void(ds::Engine&)>& buildScene) {
+	// Text only measures; async text would rasterize on the upload pool, which needs a context
+	getPangoFontService().loadFonts();
+	getPangoFontService().setAsyncText(false);
+	setupWithoutWindow();
+	if (buildScene) buildScene(*this);
+
+	DS_LOG_INFO("EngineHeadless running " << mWarmupFrames << " warmup and " << mFrames << " measured frames, report to " << mReportPath);
+	ds::Profiler&			profiler = ds::Profiler::get();
+	while (mFrame < mWarmupFrames + mFrames) {
+		profiler.frame();
+		update();
+		draw();
+	}
+	const bool				wrote = writeReport();
+	stopServices();
+	return wrote;
+}
+
+void EngineHeadless::update() {
+	if (mFrame == mWarmupFrames) startMeasuring();
+	const bool				measuring = mFrame >= mWarmupFrames;
+	++mFrame;
+
+	DS_PROFILE_SCOPE("EngineHeadless::update");
+	stepFixedClock();
+	const Poco::Timestamp	start;
+	inherited::update();
+	const size_t			bytes = mSerialize ? serialize() : 0;
+	if (!measuring) return;
+
+	mUpdateMs.push_back(elapsed_ms(start));
+	mBytes.push_back(static_cast<double>(bytes));
+}
+
+void EngineHeadless::draw() {
+	lateLatchTouches();
+	getTouchManager().getLatencyLog().drawn();
+}
+
+size_t EngineHeadless::serialize() {
+	DS_PROFILE_SCOPE("serialize");
+	mBuffer.clear();
+	// Same roots the server sends
+	const size_t			numRoots = getRootCount();
+	for (size_t i = 0; i + 1 < numRoots; ++i) {
+		if (!getRootBuilder(i).mSyncronize) continue;
+		ds::ui::Sprite&		rooty = getRootSprite(i);
+		if (rooty.isDirty()) rooty.writeTo(mBuffer);
+	}
+	return mBuffer.size();
+}
+
+void EngineHeadless::startMeasuring() {
+	ds::Profiler&			profiler = ds::Profiler::get();
+	profiler.setEnabled(true);
+	// Restart the summary, so its totals cover just the measured frames
+	profiler.setSummaryEnabled(false);
+	profiler.setSummaryEnabled(true);
+	ds::Profiler::getThreadAllocations(mStartAllocs, mStartAllocBytes);
+}
+
+bool EngineHeadless::writeReport() {
+	unsigned long long		allocs = 0, allocBytes = 0;
+	ds::Profiler::getThreadAllocations(allocs, allocBytes);
+	allocs -= mStartAllocs;
+	allocBytes -= mStartAllocBytes;
+	const double			frames = static_cast<double>(mFrames);
+
+	std::ofstream			os(mReportPath.c_str(), std::ios::out | std::ios::trunc);
+	if (!os.is_open()) {
+		DS_LOG_WARNING("EngineHeadless can't write report to " << mReportPath);
+		return false;
+	}
+	os << std::fixed << std::setprecision(4);
+	os << "{\n\"frames\":" << mFrames << ",\n\"warmup_frames\":" << mWarmupFrames
+		<< ",\n\"dt\":" << mDt << ",\n\"sprites\":" << mSprites.size();
+	os << ",\n\"update_ms\":";
+	write_stats(os, mUpdateMs);
+	os << ",\n\"serialized_bytes\":";
+	write_stats(os, mBytes);
+
+	os << ",\n\"allocations\":";
+	if (ds::Profiler::tracksAllocations()) {
+		os << "{\"count\":" << allocs << ",\"bytes\":" << allocBytes
+			<< ",\"per_frame\":" << static_cast<double>(allocs) / frames
+			<< ",\"bytes_per_frame\":" << static_cast<double>(allocBytes) / frames << "}";
+	} else {
+		os << "null";
+	}
+
+	// Main thread scopes, per measured frame
+	std::vector<ds::Profiler::Summary>	scopes;
+	ds::Profiler::get().getSummary(scopes);
+	os << ",\n\"phases\":[";
+	for (auto it = scopes.begin(), end = scopes.end(); it != end; ++it) {
+		os << (it == scopes.begin() ? "\n" : ",\n") << "{\"path\":\"";
+		write_escaped(os, it->mPath);
+		os << "\",\"depth\":" << it->mDepth
+			<< ",\"mean_ms\":" << it->mTotalMs / frames
+			<< ",\"max_ms\":" << it->mMaxMs
+			<< ",\"allocs_per_frame\":" << static_cast<double>(it->mTotalAllocs) / frames << "}";
+	}
+	os << "\n]\n}\n";
+	os.close();
+
+	if (os.fail()) {
+		DS_LOG_WARNING("EngineHeadless failed writing report to " << mReportPath);
+		return false;
+	}
+	DS_LOG_INFO("EngineHeadless wrote report to " << mReportPath);
+	return true;
+}
+
+} // namespace ds
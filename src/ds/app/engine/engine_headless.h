@@ -0,0 +1,73 @@
+#pragma once
+#ifndef DS_APP_ENGINE_ENGINEHEADLESS_H_
+#define DS_APP_ENGINE_ENGINEHEADLESS_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "ds/app/engine/engine_standalone.h"
+#include "ds/data/data_buffer.h"
+
+namespace ds {
+
+/**
+ * \class ds::EngineHeadless
+ * A standalone engine for repeatable performance runs. It has no app, so no
+ * window and no GL context: sprites update, lay out and serialize, but nothing
+ * is drawn or uploaded. Time steps by a fixed dt every frame instead of
+ * following the clock. After a warmup it measures a set number of frames and
+ * writes a JSON report.
+ *
+ * The report has update times, the main thread profiler scopes, the bytes a
+ * server would have sent, and allocations when those are tracked. Input is
+ * whatever the scene injects, and it's dispatched like the standalone engine,
+ * late latching included; the essentials Automator will drive it from a
+ * fixed seed with the "headless:automator" setting.
+ *
+ * \code
+ *   ds::EngineSettings    settings;
+ *   ds::EngineData        data(settings);
+ *   ds::EngineHeadless    engine(settings, data, ds::RootList());
+ *   engine.run([](ds::Engine& e){ e.getRootSprite().addChildPtr(new MyView(e)); });
+ * \endcode
+ */
+class EngineHeadless : public EngineStandalone {
+public:
+	EngineHeadless(const ds::EngineSettings&, ds::EngineData&, const ds::RootList&);
+
+	/// Build the scene, then run the warmup and measured frames and write the report.
+	/// Answers false if the report couldn't be written.
+	bool							run(const std::function<void(ds::Engine&)>& buildScene);
+
+	/// One fixed step. run() calls this, it's public for callers that drive their own frames.
+	virtual void					update();
+	/// Nothing is drawn, but late latched touches and the touch latency log still see the end of the frame.
+	virtual void					draw();
+
+	const std::string&				getReportPath() const		{ return mReportPath; }
+
+private:
+	typedef EngineStandalone inherited;
+
+	// Serialize the dirty sprites like the server does, answering the bytes
+	size_t							serialize();
+	void							startMeasuring();
+	bool							writeReport();
+
+	const double					mDt;
+	const int						mWarmupFrames;
+	const int						mFrames;
+	const bool						mSerialize;
+	const std::string				mReportPath;
+
+	int								mFrame;
+	ds::DataBuffer					mBuffer;
+	unsigned long long				mStartAllocs, mStartAllocBytes;
+	// Per measured frame
+	std::vector<double>				mUpdateMs;
+	std::vector<double>				mBytes;
+};
+
+} // namespace ds
+
+#endif // DS_APP_ENGINE_ENGINEHEADLESS_H_
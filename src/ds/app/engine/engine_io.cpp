@@ -5,6 +5,7 @@
 #include "ds/app/blob_reader.h"
 #include "ds/app/blob_registry.h"
 #include "ds/debug/logger.h"
+#include "ds/debug/profiler.h"
 #include "ds/util/string_util.h"
 #include "snappy.h"
 #include <cinder/Rand.h>
@@ -41,6 +42,8 @@ EngineSender::AutoSend::~AutoSend() {
 	if (!mSender.mConnection.initialized()) return;
 	if (mData.size() < 1) return;
 
+	DS_PROFILE_SCOPE("net send");
+
 	const size_t size = mData.size();
 	mSender.mRawDataBuffer.setSize(size);
 	mData.readRaw(mSender.mRawDataBuffer.data(), size);
@@ -91,6 +94,7 @@ ds::DataBuffer& EngineReceiver::getData() {
 }
 
 bool EngineReceiver::receiveBlob() {
+	DS_PROFILE_SCOPE("net receive");
 	std::string recvBuffer;
 
 	if(mUseChunker){
@@ -26,6 +26,10 @@ const char			CMD_CLIENT_STARTED = 3;
 const char			CMD_CLIENT_REQUEST_WORLD = 4;
 const char			CMD_CLIENT_RUNNING = 5;
 
+const char			INPUT_BEGIN = 0;
+const char			INPUT_MOVED = 1;
+const char			INPUT_ENDED = 2;
+
 const char			ATT_CLIENT = 1;
 const char			ATT_GLOBAL_ID = 2;
 const char			ATT_SESSION_ID = 3;
@@ -21,6 +21,11 @@ extern const char				CMD_CLIENT_REQUEST_WORLD;	// The client is requesting the e
 
 extern const char				CMD_CLIENT_RUNNING;			// A general heartbeat from the client.
 
+// Client input phases, one per touch in the client input blob
+extern const char				INPUT_BEGIN;
+extern const char				INPUT_MOVED;
+extern const char				INPUT_ENDED;
+
 // ATTRIBUTES
 extern const char				ATT_CLIENT;					// Header for a client, which might have: ATT_GLOBAL_ID, ATT_SESSION_ID
 extern const char				ATT_GLOBAL_ID;				// A string, which is a GUID
@@ -25,6 +25,24 @@ char				CLIENT_STATUS_BLOB = 0;
 char				CLIENT_INPUT_BLOB = 0;
 
 const char			TERMINATOR = 0;
+
+// Client finger ids are offset by the session, so clients can't collide with each other or the server
+const int			CLIENT_ID_SHIFT = 24;
+
+// One touch from a client input blob. Answers false if the blob ran short.
+bool				read_client_input(ds::DataBuffer& data, char& phase, int32_t& id, float& x, float& y, int32_t& age) {
+	if (!data.canRead<char>()) return false;
+	phase = data.read<char>();
+	if (!data.canRead<int32_t>()) return false;
+	id = data.read<int32_t>();
+	if (!data.canRead<float>()) return false;
+	x = data.read<float>();
+	if (!data.canRead<float>()) return false;
+	y = data.read<float>();
+	if (!data.canRead<int32_t>()) return false;
+	age = data.read<int32_t>();
+	return true;
+}
 }
 
 using namespace ci;
@@ -88,6 +106,7 @@ void AbstractEngineServer::update() {
 }
 
 void AbstractEngineServer::draw() {
+	lateLatchTouches();
 	drawServer();
 }
 
@@ -181,29 +200,35 @@ void AbstractEngineServer::receiveClientStatus(ds::DataBuffer& data) {
 }
 
 void AbstractEngineServer::receiveClientInput(ds::DataBuffer& data) {
-	if(!data.canRead<sprite_id_t>()) {
-		// Error, run to the next terminator
-		while(data.canRead<char>()) {
-			const char		cmd(data.read<char>());
-			if(cmd == ds::TERMINATOR_CHAR) return;
+	if(!data.canRead<int32_t>()) return;
+	const int32_t			sessionId(data.read<int32_t>());
+	if(!data.canRead<int32_t>()) return;
+	const int32_t			count(data.read<int32_t>());
+
+	// Runs of touches in the same phase go in as one event, keeping the client's order
+	const Poco::Timestamp::TimeVal	now = Poco::Timestamp().epochMicroseconds();
+	const uint32_t			idOffset = static_cast<uint32_t>(sessionId) << CLIENT_ID_SHIFT;
+	char					runPhase = INPUT_BEGIN;
+	Poco::Timestamp::TimeVal	runReceived = 0;
+	mClientTouches.clear();
+	for(int32_t k = 0; k < count; ++k) {
+		char				phase;
+		int32_t				id, age;
+		float				x, y;
+		if(!read_client_input(data, phase, id, x, y, age)) {
+			DS_LOG_WARNING_M("receiveClientInput blob ran short", ds::IO_LOG);
+			break;
 		}
+		if(phase != runPhase && !mClientTouches.empty()) {
+			injectClientInput(runPhase, runReceived);
+			mClientTouches.clear();
+		}
+		if(mClientTouches.empty()) runReceived = now - age;
+		runPhase = phase;
+		const ci::vec2		pos(x, y);
+		mClientTouches.push_back(ci::app::TouchEvent::Touch(pos, pos, idOffset + static_cast<uint32_t>(id), 0.0, nullptr));
 	}
-
-	const int				state(data.read<int>());
-	const int				id(data.read<int>());
-	const float				xp(data.read<float>());
-	const float				yp(data.read<float>());
-
-	std::vector<ci::app::TouchEvent::Touch> touches;
-	touches.push_back(ci::app::TouchEvent::Touch(ci::vec2(xp, yp), ci::vec2(xp, yp), id, 0.0, nullptr));
-	ds::ui::TouchEvent te = ds::ui::TouchEvent(getWindow(), touches, true);
-	if(state == 0){
-		injectTouchesBegin(te);
-	} else if(state == 1){
-		injectTouchesMoved(te);
-	} else if(state == 2){
-		injectTouchesEnded(te);
-	}
+	if(!mClientTouches.empty()) injectClientInput(runPhase, runReceived);
 
 	// Verify we're at the end
 	if(data.canRead<char>()) {
@@ -214,6 +239,18 @@ void AbstractEngineServer::receiveClientInput(ds::DataBuffer& data) {
 	}
 }
 
+void AbstractEngineServer::injectClientInput(const char phase, const Poco::Timestamp::TimeVal received) {
+	ds::ui::TouchEvent		te(getWindow(), mClientTouches, true);
+	if(phase == INPUT_BEGIN){
+		injectTouchesBegin(te);
+	} else if(phase == INPUT_MOVED){
+		te.setReceivedTime(received);
+		injectTouchesMoved(te);
+	} else if(phase == INPUT_ENDED){
+		injectTouchesEnded(te);
+	}
+}
+
 void AbstractEngineServer::onClientStartedCommand(ds::DataBuffer &data) {
 	if (!data.canRead<char>()) return;
 	char				att = data.read<char>();
@@ -254,15 +291,15 @@ void AbstractEngineServer::setState(State& s) {
 }
 
 void AbstractEngineServer::handleMouseTouchBegin(const ci::app::MouseEvent& e, int id){
-	mTouchManager.mouseTouchBegin(e, id);
+	mTouchManager.mouseTouchBegin(alteredMouseEvent(e), id);
 }
 
 void AbstractEngineServer::handleMouseTouchMoved(const ci::app::MouseEvent& e, int id){
-	mTouchManager.mouseTouchMoved(e, id);
+	mTouchManager.mouseTouchMoved(alteredMouseEvent(e), id);
 }
 
 void AbstractEngineServer::handleMouseTouchEnded(const ci::app::MouseEvent& e, int id){
-	mTouchManager.mouseTouchEnded(e, id);
+	mTouchManager.mouseTouchEnded(alteredMouseEvent(e), id);
 }
 
 /**
@@ -15,9 +15,6 @@ namespace ds {
 /**
  * \class ds::AbstractEngineServer
  * The Server engine contains all app-side behaviour, but no rendering.
- * This class is getting a little messed up because one subclass needs
- * a GlThread and one needs a GlNoThread, so abstract pretty much everything
- * but that.
  */
 class AbstractEngineServer : public Engine {
 public:
@@ -47,6 +44,7 @@ private:
 	void							receiveDeleteSprite(ds::DataBuffer&);
 	void							receiveClientStatus(ds::DataBuffer&);
 	void							receiveClientInput(ds::DataBuffer&);
+	void							injectClientInput(const char phase, const Poco::Timestamp::TimeVal received);
 	void							onClientStartedCommand(ds::DataBuffer&);
 	void							onClientRunningCommand(ds::DataBuffer&);
 
@@ -63,6 +61,9 @@ private:
 	EngineSender					mSender;
 	EngineReceiver					mReceiver;
 	ds::BlobReader					mBlobReader;
+	// Consecutive client touches in the same phase, waiting to be injected together
+	std::vector<ci::app::TouchEvent::Touch>
+									mClientTouches;
 
 	// STATES
 	class State {
@@ -16,8 +16,14 @@ namespace ds {
  * \class ds::EngineStandalone
  */
 EngineStandalone::EngineStandalone(	ds::App& app, const ds::EngineSettings& settings,
-									ds::EngineData& ed, const ds::RootList& roots)
-		: inherited(app, settings, ed, roots)
+									ds::EngineData& ed, const ds::RootList& roots, const double fixedDt)
+		: EngineStandalone(&app, settings, ed, roots, fixedDt)
+ {
+}
+
+EngineStandalone::EngineStandalone(	ds::App* app, const ds::EngineSettings& settings,
+									ds::EngineData& ed, const ds::RootList& roots, const double fixedDt)
+		: inherited(app, settings, ed, roots, fixedDt)
 		, mLoadImageService(*this, mIpFunctions)
  {
 }
@@ -49,6 +55,7 @@ void EngineStandalone::update() {
 }
 
 void EngineStandalone::draw() {
+	lateLatchTouches();
 	drawClient();
 }
 
@@ -58,15 +65,15 @@ void EngineStandalone::stopServices() {
 }
 
 void EngineStandalone::handleMouseTouchBegin(const ci::app::MouseEvent& e, int id){
-	mTouchManager.mouseTouchBegin(e, id);
+	mTouchManager.mouseTouchBegin(alteredMouseEvent(e), id);
 }
 
 void EngineStandalone::handleMouseTouchMoved(const ci::app::MouseEvent& e, int id){
-	mTouchManager.mouseTouchMoved(e, id);
+	mTouchManager.mouseTouchMoved(alteredMouseEvent(e), id);
 }
 
 void EngineStandalone::handleMouseTouchEnded(const ci::app::MouseEvent& e, int id){
-	mTouchManager.mouseTouchEnded(e, id);
+	mTouchManager.mouseTouchEnded(alteredMouseEvent(e), id);
 }
 
 } // namespace ds
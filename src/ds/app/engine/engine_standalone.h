@@ -15,7 +15,7 @@ namespace ds {
  */
 class EngineStandalone : public Engine {
 public:
-	EngineStandalone(ds::App&, const ds::EngineSettings&, ds::EngineData&, const ds::RootList&);
+	EngineStandalone(ds::App&, const ds::EngineSettings&, ds::EngineData&, const ds::RootList&, const double fixedDt = 0.0);
 	~EngineStandalone();
 
 	virtual ds::WorkManager&		getWorkManager()		{ return mWorkManager; }
@@ -34,6 +34,10 @@ public:
 	virtual int						getBytesRecieved(){ return 0; }
 	virtual int						getBytesSent(){ return 0; }
 
+protected:
+	// With no app, see Engine
+	EngineStandalone(ds::App*, const ds::EngineSettings&, ds::EngineData&, const ds::RootList&, const double fixedDt);
+
 private:
 	typedef Engine inherited;
 
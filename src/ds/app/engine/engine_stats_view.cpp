@@ -5,6 +5,8 @@
 #include "ds/app/blob_reader.h"
 #include "ds/data/data_buffer.h"
 #include "engine_data.h"
+#include <algorithm>
+#include <iomanip>
 #include <ds/debug/computer_info.h>
 
 #pragma warning(disable: 4355)
@@ -30,6 +32,13 @@ std::string			make_line(const std::string &key, const float v) {
 	return buf.str();
 }
 
+// How many event types to list, most expensive first
+const size_t		EVENT_STATS_COUNT	= 5;
+// How deep and how many profiler scopes to list, skipping any that have gone quiet
+const int			PROFILE_MAX_DEPTH	= 3;
+const size_t		PROFILE_LINE_COUNT	= 16;
+const double		PROFILE_MIN_MS		= 0.005;
+
 }
 
 /**
@@ -49,16 +58,18 @@ void EngineStatsView::installAsClient(ds::BlobRegistry& registry) {
 EngineStatsView::EngineStatsView(ds::ui::SpriteEngine &e)
 	: ds::ui::Sprite(e)
 	, mEngine((ds::Engine&)e)
-	, mEventClient(e.getNotifier(), [this](const ds::Event *e) { if(e) onAppEvent(*e); })
+	, mEventClient(e.getNotifier(), nullptr)
 	, mLT(mEngine.getEngineData().mSrcRect.x1, mEngine.getEngineData().mSrcRect.y1)
 	, mText(nullptr)
-
+	, mProfilerWasEnabled(false)
 {
 	mBlobType = BLOB_TYPE;
 
 	setDrawDebug(true);
 	hide();
 
+	mEventClient.listenToEvents<ToggleStatsRequest>([this](const ToggleStatsRequest&) { toggle(); });
+
 	mBackground = new ds::ui::Sprite(mEngine, 400.0f, 40.0f);
 	mBackground->setTransparent(false);
 	mBackground->setColor(0, 0, 0);
@@ -115,6 +126,36 @@ void EngineStatsView::updateStats(){
 			ss << "<span weight='bold'>FPS:</span> " << fpsy << std::endl;
 		}
 
+		// Event handler time since the view was shown
+		const auto&		stats = mEngine.getNotifier().getStats();
+		std::vector<std::pair<size_t, ds::EventNotifier::Stats>>	sorted(stats.begin(), stats.end());
+		std::sort(sorted.begin(), sorted.end(), [](const std::pair<size_t, ds::EventNotifier::Stats>& a, const std::pair<size_t, ds::EventNotifier::Stats>& b) {
+			return a.second.mHandlerSeconds > b.second.mHandlerSeconds; });
+		if(sorted.size() > EVENT_STATS_COUNT) sorted.resize(EVENT_STATS_COUNT);
+		for(auto it = sorted.begin(), end = sorted.end(); it != end; ++it){
+			ss << "<span weight='bold'>" << ds::event::Registry::get().getName(it->first) << ":</span> " << it->second.mCount
+				<< " events, " << (it->second.mHandlerSeconds * 1000.0) << " ms" << std::endl;
+		}
+
+		// Main thread time per frame, nested by scope
+		const ds::Profiler&	profiler = ds::Profiler::get();
+		const bool		allocs = ds::Profiler::tracksAllocations();
+		ss << std::fixed << std::setprecision(2);
+		if(allocs){
+			ss << "<span weight='bold'>Allocations per frame:</span> " << profiler.getFrameAllocations()
+				<< ", " << (profiler.getFrameAllocationBytes() / 1024.0) << " KB" << std::endl;
+		}
+		profiler.getSummary(mProfile);
+		size_t			lines = 0;
+		for(auto it = mProfile.begin(), end = mProfile.end(); it != end && lines < PROFILE_LINE_COUNT; ++it){
+			if(it->mDepth > PROFILE_MAX_DEPTH || (it->mMs < PROFILE_MIN_MS && it->mAllocs < 0.5)) continue;
+			ss << std::string(static_cast<size_t>(it->mDepth) * 4, ' ') << "<span weight='bold'>" << it->mName << ":</span> "
+				<< it->mMs << " ms";
+			if(allocs) ss << ", " << it->mAllocs << " allocs";
+			ss << std::endl;
+			++lines;
+		}
+
 		mText->setText(ss.str());
 
 		if(mBackground->getHeight() < mText->getPosition().y * 2.0f + mText->getHeight()){
@@ -123,13 +164,21 @@ void EngineStatsView::updateStats(){
 	}
 }
 
-void EngineStatsView::onAppEvent(const ds::Event &_e) {
-	if (ToggleStatsRequest::WHAT() == _e.mWhat) {
-		if(visible()){
-			hide();
-		} else {
-			show();
-		}
+void EngineStatsView::toggle() {
+	ds::EventNotifier&	notifier = mEngine.getNotifier();
+	ds::Profiler&		profiler = ds::Profiler::get();
+	if(visible()){
+		hide();
+		notifier.setStatsEnabled(false);
+		profiler.setSummaryEnabled(false);
+		profiler.setEnabled(mProfilerWasEnabled);
+	} else {
+		show();
+		notifier.clearStats();
+		notifier.setStatsEnabled(true);
+		mProfilerWasEnabled = profiler.isEnabled();
+		profiler.setEnabled(true);
+		profiler.setSummaryEnabled(true);
 	}
 }
 
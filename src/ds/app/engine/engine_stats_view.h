@@ -9,6 +9,7 @@
 #include "ds/app/blob_registry.h"
 #include "ds/app/event.h"
 #include "ds/app/event_client.h"
+#include "ds/debug/profiler.h"
 #include "ds/ui/sprite/sprite.h"
 #include "ds/ui/sprite/text.h"
 
@@ -17,7 +18,8 @@ class Engine;
 
 /**
  * \class ds::EngineStatsView
- * \brief Display basic stats.
+ * \brief Display basic stats. While it's showing, the profiler runs and its
+ * per-frame summary is listed too.
  */
 class EngineStatsView : public ds::ui::Sprite {
 public:
@@ -31,13 +33,18 @@ public:
 
 	void						updateStats();
 private:
-	void						onAppEvent(const ds::Event&);
+	void						toggle();
 	ds::Engine&					mEngine;
 	ds::EventClient				mEventClient;
 	// UI
 	ds::ui::Sprite*				mBackground;
 	ds::ui::Text*				mText;
 
+	// Whether the profiler was on before I turned it on
+	bool						mProfilerWasEnabled;
+	std::vector<ds::Profiler::Summary>
+								mProfile;
+
 	// SETTINGS
 	const ci::vec2				mLT;
 
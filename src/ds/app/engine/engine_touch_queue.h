@@ -30,6 +30,9 @@ public:
 	// Call this as new events arrive. I will handle locking
 	void					incoming(const T&);
 
+	// Answers true if events are waiting. Call while the mutex is locked.
+	bool					lockedHasIncoming() const	{ return !mIncoming.empty(); }
+
 	// When updating, first call this while the mutex is locked...
 	void					lockedUpdate();
 	// ... then call this after the lock has been released.
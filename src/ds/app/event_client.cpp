@@ -17,12 +17,12 @@ EventClient::EventClient( EventNotifier& n,
 }
 
 EventClient::~EventClient() {
-	mNotifier.mEventNotifier.removeListener(this);
-	mNotifier.mEventNotifier.removeRequestListener(this);
+	mNotifier.removeListener(this);
+	mNotifier.removeRequestListener(this);
 }
 
 void EventClient::notify(const ds::Event& e) {
-	mNotifier.mEventNotifier.notify(&e);
+	mNotifier.notify(&e);
 }
 
 void EventClient::notify(const std::string& eventName) {
@@ -33,4 +33,8 @@ void EventClient::request(ds::Event& e) {
 	mNotifier.mEventNotifier.request(e);
 }
 
+void EventClient::listenToEvents(const size_t what, const std::function<void(const ds::Event&)>& fn) {
+	mNotifier.addListener(this, what, fn);
+}
+
 } // namespace ds
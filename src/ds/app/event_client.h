@@ -3,6 +3,7 @@
 #define DS_APP_EVENTCLIENT_H
 
 #include <functional>
+#include <string>
 
 namespace ds {
 class Event;
@@ -26,10 +27,22 @@ public:
 	void			notify(const std::string& eventName);
 	void			request(ds::Event&);
 
+	// Listen for a single type of event, in addition to the notifyListener.
+	// E is a RegisteredEvent subclass.
+	template <typename E>
+	void			listenToEvents(const std::function<void(const E&)>&);
+	void			listenToEvents(const size_t what, const std::function<void(const ds::Event&)>&);
+
 private:
 	EventNotifier&	mNotifier;
 };
 
+template <typename E>
+void EventClient::listenToEvents(const std::function<void(const E&)>& fn) {
+	if (!fn) return;
+	listenToEvents(E::WHAT(), [fn](const ds::Event& e) { fn(static_cast<const E&>(e)); });
+}
+
 } // namespace ds
 
 #endif // DS_APP_EVENTCLIENT_H
@@ -2,14 +2,18 @@
 
 #include <ds/app/event_notifier.h>
 
-
+#include <algorithm>
+#include <Poco/Timestamp.h>
 
 namespace ds {
 
 /**
  * \class ds::EventNotifier
  */
-EventNotifier::EventNotifier() {
+EventNotifier::EventNotifier()
+		: mNotifyDepth(0)
+		, mNeedsCompact(false)
+		, mStatsEnabled(false) {
 }
 
 EventNotifier::~EventNotifier() {
@@ -19,12 +23,37 @@ void EventNotifier::addListener(void *id, const std::function<void(const ds::Eve
 	mEventNotifier.addListener(id, fn);
 }
 
+void EventNotifier::addListener(void *id, const size_t what, const std::function<void(const ds::Event&)>& fn) {
+	// A null id marks a removed listener
+	if (!fn || !id) return;
+	try {
+		if (mNotifyDepth > 0) {
+			mPendingAdds.push_back(std::make_pair(what, Listener(id, fn)));
+		} else {
+			mTyped[what].push_back(Listener(id, fn));
+		}
+	} catch (std::exception const&) {
+	}
+}
+
 void EventNotifier::addRequestListener(void *id, const std::function<void(ds::Event&)>& fn) {
 	mEventNotifier.addRequestListener(id, fn);
 }
 
 void EventNotifier::removeListener(void *id) {
 	mEventNotifier.removeListener(id);
+
+	mPendingAdds.erase(std::remove_if(mPendingAdds.begin(), mPendingAdds.end(),
+			[id](const std::pair<size_t, Listener>& p) { return p.second.mId == id; }), mPendingAdds.end());
+	for (auto it = mTyped.begin(), end = mTyped.end(); it != end; ++it) {
+		for (auto lit = it->second.begin(), lend = it->second.end(); lit != lend; ++lit) {
+			if (lit->mId != id) continue;
+			// Only the id, the function might be the one running right now. compact() drops it.
+			lit->mId = nullptr;
+			mNeedsCompact = true;
+		}
+	}
+	if (mNotifyDepth < 1) compact();
 }
 
 void EventNotifier::removeRequestListener(void *id) {
@@ -32,15 +61,45 @@ void EventNotifier::removeRequestListener(void *id) {
 }
 
 void EventNotifier::notify(const ds::Event& e) {
-	mEventNotifier.notify(&e);
+	notify(&e);
 }
 
 void EventNotifier::notify(const ds::Event* e) {
+	if (!mStatsEnabled || !e) {
+		if (e) notifyTyped(*e);
+		mEventNotifier.notify(e);
+		return;
+	}
+
+	const Poco::Timestamp		start;
+	notifyTyped(*e);
 	mEventNotifier.notify(e);
+	Stats&						s = mStats[e->mWhat];
+	++s.mCount;
+	s.mHandlerSeconds += static_cast<double>(start.elapsed()) / 1000000.0;
 }
 
 void EventNotifier::notify(const std::string& eventName) {
-	mEventNotifier.notify(event::Registry::get().getEventCreator(eventName)());
+	const ds::Event*			e = nullptr;
+	auto						found = mNamedEvents.find(eventName);
+	if (found != mNamedEvents.end()) {
+		e = found->second;
+	} else {
+		e = event::Registry::get().getEventCreator(eventName)();
+		mNamedEvents[eventName] = e;
+	}
+	notify(e);
+}
+
+void EventNotifier::flushDeferred() {
+	if (mDeferred.empty()) return;
+	// Events deferred while these are sent wait for the next flush.
+	mDeferredTmp.swap(mDeferred);
+	mDeferredIndex.clear();
+	for (auto it = mDeferredTmp.begin(), end = mDeferredTmp.end(); it != end; ++it) {
+		if (*it) notify(it->get());
+	}
+	mDeferredTmp.clear();
 }
 
 void EventNotifier::request(ds::Event& e) {
@@ -51,4 +110,65 @@ void EventNotifier::setOnAddListenerFn(const std::function<ds::Event*(void)> &fn
 	mEventNotifier.setOnAddListenerFn(fn);
 }
 
+void EventNotifier::setStatsEnabled(const bool on) {
+	mStatsEnabled = on;
+}
+
+void EventNotifier::clearStats() {
+	mStats.clear();
+}
+
+void EventNotifier::notifyTyped(const ds::Event& e) {
+	auto						found = mTyped.find(e.mWhat);
+	if (found == mTyped.end()) return;
+
+	// Additions are held in mPendingAdds, so the list can't grow out from under me.
+	++mNotifyDepth;
+	try {
+		ListenerList&			list = found->second;
+		for (size_t k = 0, count = list.size(); k < count; ++k) {
+			if (list[k].mId) list[k].mFn(e);
+		}
+	} catch (...) {
+		--mNotifyDepth;
+		throw;
+	}
+	if (--mNotifyDepth < 1) compact();
+}
+
+void EventNotifier::addDeferred(const std::shared_ptr<ds::Event>& e, const bool coalesce) {
+	if (!e) return;
+	try {
+		if (coalesce) {
+			auto				found = mDeferredIndex.find(e->mWhat);
+			if (found != mDeferredIndex.end()) {
+				mDeferred[found->second] = e;
+				return;
+			}
+			mDeferredIndex[e->mWhat] = mDeferred.size();
+		}
+		mDeferred.push_back(e);
+	} catch (std::exception const&) {
+	}
+}
+
+void EventNotifier::compact() {
+	if (mNeedsCompact) {
+		mNeedsCompact = false;
+		for (auto it = mTyped.begin(); it != mTyped.end(); ) {
+			ListenerList&		list = it->second;
+			list.erase(std::remove_if(list.begin(), list.end(), [](const Listener& l) { return !l.mId; }), list.end());
+			if (list.empty()) it = mTyped.erase(it);
+			else ++it;
+		}
+	}
+	if (!mPendingAdds.empty()) {
+		std::vector<std::pair<size_t, Listener>>	adds;
+		adds.swap(mPendingAdds);
+		for (auto it = adds.begin(), end = adds.end(); it != end; ++it) {
+			mTyped[it->first].push_back(it->second);
+		}
+	}
+}
+
 } // namespace ds
@@ -2,6 +2,9 @@
 #ifndef DS_APP_EVENTNOTIFIER_H
 #define DS_APP_EVENTNOTIFIER_H
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include <ds/app/event.h>
 #include <ds/util/notifier.h>
 
@@ -10,6 +13,10 @@ namespace ds {
 /**
  * \class ds::EventNotifier
  * \brief Holder for an event notifier.
+ *
+ * Listeners added with addListener() see every event. Listeners added with
+ * addListener(id, what, fn) (or EventClient::listenToEvents()) only see
+ * events of that type, so they cost nothing for everything else.
  */
 class EventNotifier {
 public:
@@ -17,7 +24,10 @@ public:
 	virtual ~EventNotifier();
 
 	void						addListener(void *id, const std::function<void(const ds::Event*)>&);
+	// Listen for a single type of event, by its what (i.e. MyEvent::WHAT()). The id can't be null.
+	void						addListener(void *id, const size_t what, const std::function<void(const ds::Event&)>&);
 	void						addRequestListener(void *id, const std::function<void(ds::Event&)>&);
+	// Removes all of the id's listeners, for all events and for single types.
 	void						removeListener(void *id);
 	void						removeRequestListener(void *id);
 
@@ -33,6 +43,14 @@ public:
 	// If the name does not match, will fail without warning in release, with a warning in debug
 	void						notify(const std::string& eventName);
 
+	// Send an event during the next update. If coalesce is true, and an event of the
+	// same type is already waiting, it's replaced with this one instead of sending both.
+	// Events must be copyable.
+	template <typename E>
+	void						notifyDeferred(const E&, const bool coalesce = true);
+	// Send all the deferred events. Called by the engine once per update.
+	void						flushDeferred();
+
 	/**
 	* Request information from the system.
 	* \param requestEvent The event to be sent as a request to the event system
@@ -42,16 +60,72 @@ public:
 	/** \brief Set an event that gets fired when a new listener is added.
 	 * DANGEROUS: The caller needs to guarantee the T* it's returning is valid
 	 * outside the scope of the fn.
-	 * \param onAddListenerFunction The function to be called when a new listener has been added 
+	 * \param onAddListenerFunction The function to be called when a new listener has been added
 	 */
 	void						setOnAddListenerFn(const std::function<ds::Event*(void)> &onAddListenerFunction);
 
+	// Count events and time their listeners, per event type. Off by default.
+	struct Stats {
+		Stats() : mCount(0), mHandlerSeconds(0.0) { }
+		size_t					mCount;
+		double					mHandlerSeconds;
+	};
+	void						setStatsEnabled(const bool);
+	bool						getStatsEnabled() const		{ return mStatsEnabled; }
+	// Keyed by event what.
+	const std::unordered_map<size_t, Stats>&
+								getStats() const			{ return mStats; }
+	void						clearStats();
+
 protected:
 	friend class EventClient;
 
 	ds::Notifier<ds::Event>    mEventNotifier;
+
+private:
+	struct Listener {
+		Listener() : mId(nullptr) { }
+		Listener(void* id, const std::function<void(const ds::Event&)>& fn) : mId(id), mFn(fn) { }
+		void*					mId;
+		std::function<void(const ds::Event&)>
+								mFn;
+	};
+	typedef std::vector<Listener>	ListenerList;
+
+	void						notifyTyped(const ds::Event&);
+	void						addDeferred(const std::shared_ptr<ds::Event>&, const bool coalesce);
+	// Apply any changes to the listeners made while notifying.
+	void						compact();
+
+	std::unordered_map<size_t, ListenerList>
+								mTyped;
+	// Listeners can be added and removed by listeners. Removals null out the id and
+	// additions are held until the outermost notify is done; compact() applies both.
+	int							mNotifyDepth;
+	bool						mNeedsCompact;
+	std::vector<std::pair<size_t, Listener>>
+								mPendingAdds;
+
+	std::vector<std::shared_ptr<ds::Event>>
+								mDeferred, mDeferredTmp;
+	// Index of the waiting event of each type, for coalescing
+	std::unordered_map<size_t, size_t>
+								mDeferredIndex;
+
+	// Events created by name. Named events carry no data, so one of each will do.
+	std::unordered_map<std::string, const ds::Event*>
+								mNamedEvents;
+
+	bool						mStatsEnabled;
+	std::unordered_map<size_t, Stats>
+								mStats;
 };
 
+template <typename E>
+void EventNotifier::notifyDeferred(const E& e, const bool coalesce) {
+	addDeferred(std::shared_ptr<ds::Event>(new E(e)), coalesce);
+}
+
 } // namespace ds
 
 #endif // DS_APP_EVENTNOTIFIER_H
@@ -0,0 +1,104 @@
+#include "stdafx.h"
+
+#include "ds/app/parallel_update.h"
+
+#include <algorithm>
+#include "ds/debug/logger.h"
+#include "ds/thread/parallel_for.h"
+#include "ds/ui/sprite/sprite.h"
+
+namespace ds {
+
+/**
+ * \class ds::ParallelUpdate
+ */
+ParallelUpdate::ParallelUpdate()
+		: mEnabled(true)
+		, mRunning(false) {
+	mSprites.reserve(32);
+}
+
+void ParallelUpdate::setEnabled(const bool on) {
+	mEnabled = on;
+}
+
+void ParallelUpdate::deferToMain(const std::function<void()>& fn) {
+	if (!fn) return;
+	Poco::Mutex::ScopedLock		l(mDeferredMutex);
+	try {
+		mDeferred.push_back(fn);
+	} catch (std::exception const&) {
+	}
+}
+
+void ParallelUpdate::run(const int count, const std::function<void(const int)>& fn) {
+	if (count < 1) return;
+	mRunning = true;
+	try {
+		ds::parallel_for(count, fn);
+	} catch (std::exception const& ex) {
+		DS_LOG_ERROR("ParallelUpdate::run() exception: " << ex.what());
+	}
+	mRunning = false;
+}
+
+void ParallelUpdate::runServer(const ds::UpdateParams& p) {
+	runSprites([&p](ds::ui::Sprite& s) { s.runUpdateServer(p, false); });
+	runDeferred();
+}
+
+void ParallelUpdate::runClient(const ds::UpdateParams& p) {
+	runSprites([&p](ds::ui::Sprite& s) { s.runUpdateClient(p); });
+	runDeferred();
+}
+
+bool ParallelUpdate::queue(ds::ui::Sprite& s) {
+	if (!mEnabled || mRunning) return false;
+	try {
+		mSprites.push_back(&s);
+		return true;
+	} catch (std::exception const&) {
+	}
+	return false;
+}
+
+void ParallelUpdate::remove(ds::ui::Sprite& s) {
+	if (mSprites.empty()) return;
+	mSprites.erase(std::remove(mSprites.begin(), mSprites.end(), &s), mSprites.end());
+}
+
+void ParallelUpdate::runSprites(const std::function<void(ds::ui::Sprite&)>& fn) {
+	if (mSprites.empty()) return;
+	for (auto it = mSprites.begin(), end = mSprites.end(); it != end; ++it) {
+		(*it)->prepareParallelUpdate(mMarked);
+	}
+	run(static_cast<int>(mSprites.size()), [this, &fn](const int index) { fn(*mSprites[index]); });
+	mSprites.clear();
+
+	// Drop the CHILD_DIRTY marks again where nothing changed, deepest first so a
+	// parent sees its children's final state. Otherwise replication would walk
+	// these sprites every frame.
+	std::sort(mMarked.begin(), mMarked.end(), [](const std::pair<int, ds::ui::Sprite*>& a, const std::pair<int, ds::ui::Sprite*>& b) {
+		return a.first > b.first;
+	});
+	for (auto it = mMarked.begin(), end = mMarked.end(); it != end; ++it) {
+		it->second->finishParallelUpdate();
+	}
+	mMarked.clear();
+}
+
+void ParallelUpdate::runDeferred() {
+	{
+		Poco::Mutex::ScopedLock		l(mDeferredMutex);
+		if (mDeferred.empty()) return;
+		mDeferredTmp.clear();
+		mDeferredTmp.swap(mDeferred);
+	}
+	// Anything deferred from in here waits for the next update.
+	for (auto it = mDeferredTmp.begin(), end = mDeferredTmp.end(); it != end; ++it) {
+		(*it)();
+	}
+	mDeferredTmp.clear();
+}
+
+} // namespace ds
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef DS_APP_PARALLELUPDATE_H_
+#define DS_APP_PARALLELUPDATE_H_
+
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <Poco/Mutex.h>
+
+namespace ds {
+class UpdateParams;
+namespace ui {
+class Sprite;
+}
+
+/**
+ * \class ds::ParallelUpdate
+ * \brief The engine's parallel update phase. Sprites that opt in with
+ * Sprite::setParallelUpdate() are set aside during the normal update, then
+ * run across threads once the rest of the tree is done. Parallel AutoUpdates
+ * are run the same way. Anything that has to happen on the main thread can
+ * be handed to deferToMain(), and runs once the parallel work is finished.
+ */
+class ParallelUpdate {
+public:
+	ParallelUpdate();
+
+	// When disabled, everything updates on the main thread as usual. Default is enabled.
+	void						setEnabled(const bool);
+	bool						isEnabled() const			{ return mEnabled; }
+	// Answer true while parallel work is running.
+	bool						isRunning() const			{ return mRunning; }
+
+	// Run fn on the main thread after the parallel work. Can be called from any
+	// thread. Outside the parallel phase, fn runs at the end of the next update.
+	void						deferToMain(const std::function<void()>&);
+
+	// Run fn(0) to fn(count - 1) across threads.
+	void						run(const int count, const std::function<void(const int)>&);
+
+	// Run the sprites set aside during this update, then everything deferred.
+	// Called by the engine, once the root sprites have been updated.
+	void						runServer(const ds::UpdateParams&);
+	void						runClient(const ds::UpdateParams&);
+
+private:
+	friend class ds::ui::Sprite;
+	// Set the sprite aside. Answers false if it should just update now.
+	bool						queue(ds::ui::Sprite&);
+	void						remove(ds::ui::Sprite&);
+
+	void						runSprites(const std::function<void(ds::ui::Sprite&)>&);
+	void						runDeferred();
+
+	bool						mEnabled;
+	std::atomic<bool>			mRunning;
+	std::vector<ds::ui::Sprite*>
+								mSprites;
+	// Sprites marked CHILD_DIRTY for the pass, with their depth
+	std::vector<std::pair<int, ds::ui::Sprite*>>
+								mMarked;
+
+	Poco::Mutex					mDeferredMutex;
+	std::vector<std::function<void()>>
+								mDeferred, mDeferredTmp;
+};
+
+} // namespace ds
+
+#endif // DS_APP_PARALLELUPDATE_H_
@@ -0,0 +1,617 @@
+#include "stdafx.h"
+
+#include "ds/debug/profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <Poco/Thread.h>
+#include "ds/debug/logger.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <chrono>
+#endif
+
+#ifdef _MSC_VER
+#define DS_PROFILER_TLS		__declspec(thread)
+#else
+#define DS_PROFILER_TLS		__thread
+#endif
+
+namespace ds {
+
+namespace {
+const size_t				DEFAULT_EVENTS_PER_THREAD = 16384;
+const size_t				MIN_EVENTS_PER_THREAD = 16;
+// How much of each frame goes into the summary's running average
+const double				SUMMARY_WEIGHT = 0.1;
+// Frames between over budget logs
+const int					ALLOC_LOG_FRAMES = 60;
+
+struct Event {
+	const char*				mName;
+	long long				mStart;
+	long long				mEnd;
+	int						mDepth;
+	unsigned long long		mAllocs;
+	unsigned long long		mAllocBytes;
+};
+
+// Counted by the operator new below. Plain data, so it's safe to touch from inside an allocation.
+struct AllocCounts {
+	unsigned long long		mCount;
+	unsigned long long		mBytes;
+};
+
+long long					now_ticks() {
+#ifdef _WIN32
+	// QPC reads the invariant TSC where there is one, without the per-core drift of raw RDTSC.
+	LARGE_INTEGER			c;
+	QueryPerformanceCounter(&c);
+	return c.QuadPart;
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+double						ticks_per_second() {
+#ifdef _WIN32
+	LARGE_INTEGER			f;
+	QueryPerformanceFrequency(&f);
+	return static_cast<double>(f.QuadPart);
+#else
+	return 1000000000.0;
+#endif
+}
+
+const double				TICKS_TO_MS = 1000.0 / ticks_per_second();
+
+void						write_escaped(std::ostream& os, const char* s) {
+	for (; s && *s; ++s) {
+		const char			c = *s;
+		if (c == '"' || c == '\\') os << '\\' << c;
+		else if (static_cast<unsigned char>(c) < 0x20) os << ' ';
+		else os << c;
+	}
+}
+
+}
+
+/**
+ * \class ds::Profiler::Buffer
+ * A ring of one thread's finished scopes. Only that thread writes, so the
+ * lock is only ever contended while a trace or summary copies it out.
+ */
+class Profiler::Buffer {
+public:
+	Buffer(const int tid, const std::string& name, const size_t size)
+		: mTid(tid)
+		, mName(name)
+		, mDepth(0)
+		, mSummaryRead(0)
+		, mEvents(std::max<size_t>(size, MIN_EVENTS_PER_THREAD))
+		, mCount(0)
+	{
+		mLock.clear();
+	}
+
+	void					add(const Event& e)
+	{
+		lock();
+		mEvents[static_cast<size_t>(mCount % mEvents.size())] = e;
+		++mCount;
+		unlock();
+	}
+
+	// Copy out everything recorded since from, oldest first. Answers where the next copy should start.
+	unsigned long long		copy(unsigned long long from, std::vector<Event>& out)
+	{
+		lock();
+		const unsigned long long	count = mCount;
+		const unsigned long long	size = mEvents.size();
+		if (count - from > size) from = count - size;
+		for (unsigned long long k = from; k < count; ++k) {
+			out.push_back(mEvents[static_cast<size_t>(k % size)]);
+		}
+		unlock();
+		return count;
+	}
+
+	const int				mTid;
+	std::string				mName;
+	// OWNING THREAD
+	int						mDepth;
+	// MAIN THREAD
+	unsigned long long		mSummaryRead;
+
+private:
+	void					lock()		{ while (mLock.test_and_set(std::memory_order_acquire)) { } }
+	void					unlock()	{ mLock.clear(std::memory_order_release); }
+
+	std::atomic_flag		mLock;
+	std::vector<Event>		mEvents;
+	unsigned long long		mCount;
+};
+
+namespace {
+Profiler*					INSTANCE = nullptr;
+DS_PROFILER_TLS Profiler::Buffer*
+							THREAD_BUFFER = nullptr;
+DS_PROFILER_TLS AllocCounts	THREAD_ALLOCS = { 0, 0 };
+std::vector<Event>			SUMMARY_EVENTS;
+}
+
+/**
+ * \class ds::Profiler
+ */
+Profiler& Profiler::get()
+{
+	if (!INSTANCE) INSTANCE = new Profiler();
+	return *INSTANCE;
+}
+
+namespace {
+// Made during static init, before there are threads to race for it.
+const Profiler&				FORCE_INSTANCE = Profiler::get();
+}
+
+Profiler::Profiler()
+	: mEnabled(false)
+	, mEventsPerThread(DEFAULT_EVENTS_PER_THREAD)
+	, mStartTicks(now_ticks())
+	, mTracePath("trace.json")
+	, mTraceAfter(0)
+	, mMainBuffer(nullptr)
+	, mSummaryEnabled(false)
+	, mAllocBudget(0)
+	, mAllocsStarted(false)
+	, mLastAllocs(0)
+	, mLastAllocBytes(0)
+	, mFrameAllocs(0.0)
+	, mFrameAllocBytes(0.0)
+	, mFramesSinceAllocLog(ALLOC_LOG_FRAMES)
+	, mOverBudgetFrames(0)
+{
+	mStack.reserve(32);
+	mNodeStack.reserve(32);
+}
+
+Profiler::~Profiler()
+{
+}
+
+void Profiler::setEnabled(const bool on)
+{
+	mEnabled.store(on);
+}
+
+bool Profiler::isEnabled() const
+{
+	return mEnabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::setEventsPerThread(const size_t n)
+{
+	mEventsPerThread.store(n);
+}
+
+void Profiler::frame()
+{
+	const bool				enabled = isEnabled();
+	if (enabled) {
+		if (!mMainBuffer) {
+			mMainBuffer = getBuffer();
+			mMainBuffer->mName = "main";
+		}
+		// The budget uses the summary to find where the allocations came from
+		if (mSummaryEnabled || mAllocBudget > 0) summarize(*mMainBuffer);
+	}
+	checkAllocations(enabled && mAllocBudget > 0);
+
+	if (enabled && mTraceAfter > 0 && --mTraceAfter == 0) writeTrace();
+}
+
+void Profiler::setTracePath(const std::string& path)
+{
+	mTracePath = path;
+}
+
+void Profiler::setTraceAfter(const int frames)
+{
+	mTraceAfter = std::max(frames, 0);
+}
+
+bool Profiler::writeTrace()
+{
+	return writeTrace(mTracePath);
+}
+
+bool Profiler::writeTrace(const std::string& path)
+{
+	std::vector<Event>		events;
+	std::ofstream			os(path.c_str(), std::ios::out | std::ios::trunc);
+	if (!os.is_open()) {
+		DS_LOG_WARNING("Profiler::writeTrace() can't open " << path);
+		return false;
+	}
+
+	const double			ticks_to_us = TICKS_TO_MS * 1000.0;
+	bool					first = true;
+	os << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+
+	Poco::Mutex::ScopedLock	l(mMutex);
+	for (auto it = mBuffers.begin(), end = mBuffers.end(); it != end; ++it) {
+		Buffer&				b = **it;
+		events.clear();
+		b.copy(0, events);
+		if (events.empty()) continue;
+
+		os << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b.mTid << ",\"args\":{\"name\":\"";
+		if (b.mName.empty()) os << "thread " << b.mTid;
+		else write_escaped(os, b.mName.c_str());
+		os << "\"}}";
+		first = false;
+
+		for (auto eit = events.begin(), eend = events.end(); eit != eend; ++eit) {
+			os << ",\n{\"name\":\"";
+			write_escaped(os, eit->mName);
+			os << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b.mTid
+				<< ",\"ts\":" << static_cast<double>(eit->mStart - mStartTicks) * ticks_to_us
+				<< ",\"dur\":" << static_cast<double>(eit->mEnd - eit->mStart) * ticks_to_us;
+			if (tracksAllocations()) {
+				os << ",\"args\":{\"allocs\":" << eit->mAllocs << ",\"bytes\":" << eit->mAllocBytes << "}";
+			}
+			os << "}";
+		}
+	}
+	os << "\n]}\n";
+	os.close();
+
+	if (os.fail()) {
+		DS_LOG_WARNING("Profiler::writeTrace() failed writing " << path);
+		return false;
+	}
+	DS_LOG_INFO("Profiler wrote trace to " << path);
+	return true;
+}
+
+void Profiler::setSummaryEnabled(const bool on)
+{
+	if (on == mSummaryEnabled) return;
+	mSummaryEnabled = on;
+	mSummary.clear();
+	// Start from now, not from whatever was recorded before
+	if (on && mMainBuffer) {
+		SUMMARY_EVENTS.clear();
+		mMainBuffer->mSummaryRead = mMainBuffer->copy(mMainBuffer->mSummaryRead, SUMMARY_EVENTS);
+		SUMMARY_EVENTS.clear();
+	}
+}
+
+void Profiler::getSummary(std::vector<Summary>& out) const
+{
+	out.clear();
+	for (auto it = mSummary.begin(), end = mSummary.end(); it != end; ++it) {
+		out.push_back(Summary());
+		const Node&			n = it->second;
+		Summary&			s = out.back();
+		s.mName = n.mName;
+		s.mPath = it->first;
+		std::replace(s.mPath.begin(), s.mPath.end(), '\x01', '/');
+		s.mDepth = n.mDepth;
+		s.mMs = n.mMs;
+		s.mAllocs = n.mAllocs;
+		s.mTotalMs = static_cast<double>(n.mTotalTicks) * TICKS_TO_MS;
+		s.mMaxMs = static_cast<double>(n.mMaxTicks) * TICKS_TO_MS;
+		s.mTotalAllocs = n.mTotalAllocs;
+	}
+}
+
+void Profiler::getThreadAllocations(unsigned long long& count, unsigned long long& bytes)
+{
+	count = THREAD_ALLOCS.mCount;
+	bytes = THREAD_ALLOCS.mBytes;
+}
+
+bool Profiler::tracksAllocations()
+{
+#ifdef DS_TRACK_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+void Profiler::setAllocationBudget(const int allocsPerFrame)
+{
+	mAllocBudget = std::max(allocsPerFrame, 0);
+}
+
+Profiler::Buffer* Profiler::getBuffer()
+{
+	if (THREAD_BUFFER) return THREAD_BUFFER;
+
+	Poco::Thread*			t = Poco::Thread::current();
+	const std::string		name(t ? t->getName() : std::string());
+	Poco::Mutex::ScopedLock	l(mMutex);
+	mBuffers.push_back(std::unique_ptr<Buffer>(new Buffer(static_cast<int>(mBuffers.size()) + 1, name, mEventsPerThread.load())));
+	THREAD_BUFFER = mBuffers.back().get();
+	return THREAD_BUFFER;
+}
+
+void Profiler::summarize(Buffer& b)
+{
+	SUMMARY_EVENTS.clear();
+	b.mSummaryRead = b.copy(b.mSummaryRead, SUMMARY_EVENTS);
+
+	// Scopes are recorded as they close, so children come before their parents. In
+	// start order, each scope's parents are the open scopes above its depth.
+	std::sort(SUMMARY_EVENTS.begin(), SUMMARY_EVENTS.end(), [](const Event& a, const Event& b) {
+		if (a.mStart != b.mStart) return a.mStart < b.mStart;
+		return a.mDepth < b.mDepth; });
+
+	for (auto it = mSummary.begin(), end = mSummary.end(); it != end; ++it) {
+		Node&				n = it->second;
+		n.mFrameTicks = 0;
+		n.mFrameAllocs = 0;
+		n.mFrameSelfAllocs = 0;
+	}
+
+	mStack.clear();
+	mNodeStack.clear();
+	for (auto it = SUMMARY_EVENTS.begin(), end = SUMMARY_EVENTS.end(); it != end; ++it) {
+		const size_t		depth = static_cast<size_t>(std::max(it->mDepth, 0));
+		if (mStack.size() > depth) {
+			mStack.resize(depth);
+			mNodeStack.resize(depth);
+		}
+		mKey.clear();
+		for (auto sit = mStack.begin(), send = mStack.end(); sit != send; ++sit) {
+			mKey.append(*sit);
+			mKey.push_back('\x01');
+		}
+		mKey.append(it->mName);
+
+		const long long		allocs = static_cast<long long>(it->mAllocs);
+		Node&				n = mSummary[mKey];
+		n.mName = it->mName;
+		n.mDepth = static_cast<int>(mStack.size());
+		n.mFrameTicks += it->mEnd - it->mStart;
+		n.mFrameAllocs += allocs;
+		n.mFrameSelfAllocs += allocs;
+		if (!mNodeStack.empty()) mNodeStack.back()->mFrameSelfAllocs -= allocs;
+		mStack.push_back(it->mName);
+		mNodeStack.push_back(&n);
+	}
+
+	// Scopes stay once they've been seen. There are only as many as there are places that mark them.
+	for (auto it = mSummary.begin(), end = mSummary.end(); it != end; ++it) {
+		Node&				n = it->second;
+		n.mMs += (static_cast<double>(n.mFrameTicks) * TICKS_TO_MS - n.mMs) * SUMMARY_WEIGHT;
+		n.mAllocs += (static_cast<double>(n.mFrameAllocs) - n.mAllocs) * SUMMARY_WEIGHT;
+		n.mTotalTicks += n.mFrameTicks;
+		n.mMaxTicks = std::max(n.mMaxTicks, n.mFrameTicks);
+		n.mTotalAllocs += n.mFrameAllocs;
+	}
+}
+
+void Profiler::checkAllocations(const bool summarized)
+{
+	if (!tracksAllocations()) return;
+	// Everything before the first frame is setup
+	if (!mAllocsStarted) {
+		mAllocsStarted = true;
+		mLastAllocs = THREAD_ALLOCS.mCount;
+		mLastAllocBytes = THREAD_ALLOCS.mBytes;
+		return;
+	}
+
+	const AllocCounts&		c = THREAD_ALLOCS;
+	const unsigned long long	allocs = c.mCount - mLastAllocs;
+	const unsigned long long	bytes = c.mBytes - mLastAllocBytes;
+	mFrameAllocs += (static_cast<double>(allocs) - mFrameAllocs) * SUMMARY_WEIGHT;
+	mFrameAllocBytes += (static_cast<double>(bytes) - mFrameAllocBytes) * SUMMARY_WEIGHT;
+
+	if (mFramesSinceAllocLog < ALLOC_LOG_FRAMES) ++mFramesSinceAllocLog;
+	if (mAllocBudget > 0 && allocs > static_cast<unsigned long long>(mAllocBudget)) {
+		++mOverBudgetFrames;
+		if (mFramesSinceAllocLog >= ALLOC_LOG_FRAMES) {
+			// Blame the scope that made the most allocations itself
+			const std::string*	worst = nullptr;
+			long long			worst_allocs = 0;
+			for (auto it = mSummary.begin(), end = mSummary.end(); it != end && summarized; ++it) {
+				if (it->second.mFrameSelfAllocs <= worst_allocs) continue;
+				worst = &it->first;
+				worst_allocs = it->second.mFrameSelfAllocs;
+			}
+			std::string			where;
+			if (worst) {
+				where = *worst;
+				std::replace(where.begin(), where.end(), '\x01', '/');
+			}
+
+			DS_LOG_WARNING("Frame allocated " << allocs << " times (" << bytes << " bytes), budget is " << mAllocBudget
+				<< ". " << mOverBudgetFrames << " frame(s) over budget since the last warning."
+				<< (worst ? " Most from " : "") << where << (summarized ? "" : " Turn the profiler on to see where."));
+			mFramesSinceAllocLog = 0;
+			mOverBudgetFrames = 0;
+		}
+	}
+	// Don't count the log
+	mLastAllocs = THREAD_ALLOCS.mCount;
+	mLastAllocBytes = THREAD_ALLOCS.mBytes;
+}
+
+/**
+ * \class ds::ProfileScope
+ */
+ProfileScope::ProfileScope(const char* name)
+	: mBuffer(nullptr)
+	, mName(name)
+	, mStart(0)
+	, mStartAllocs(0)
+	, mStartAllocBytes(0)
+{
+	Profiler&				p(Profiler::get());
+	if (!p.isEnabled()) return;
+	mBuffer = p.getBuffer();
+	++mBuffer->mDepth;
+	mStartAllocs = THREAD_ALLOCS.mCount;
+	mStartAllocBytes = THREAD_ALLOCS.mBytes;
+	mStart = now_ticks();
+}
+
+ProfileScope::~ProfileScope()
+{
+	if (!mBuffer) return;
+	Event					e;
+	e.mEnd = now_ticks();
+	e.mName = mName;
+	e.mStart = mStart;
+	e.mDepth = --mBuffer->mDepth;
+	e.mAllocs = THREAD_ALLOCS.mCount - mStartAllocs;
+	e.mAllocBytes = THREAD_ALLOCS.mBytes - mStartAllocBytes;
+	mBuffer->add(e);
+}
+
+} // namespace ds
+
+#ifdef DS_TRACK_ALLOCATIONS
+/* Global allocation hook. Replacing operator new catches every container,
+ * string and stream; malloc() calls from C libraries aren't counted.
+ * Failed allocations go through the new handler, like the library's own.
+ ******************************************************************/
+namespace {
+std::new_handler			current_new_handler() {
+#if defined(_MSC_VER) && _MSC_VER < 1900
+	// No std::get_new_handler() before VS2015
+	std::new_handler		h = std::set_new_handler(nullptr);
+	std::set_new_handler(h);
+	return h;
+#else
+	return std::get_new_handler();
+#endif
+}
+
+void						count_alloc(const size_t size) {
+	ds::AllocCounts&		c = ds::THREAD_ALLOCS;
+	++c.mCount;
+	c.mBytes += size;
+}
+
+void*						raw_alloc(const size_t size, const size_t alignment) {
+	if (alignment == 0) return std::malloc(size);
+#ifdef _WIN32
+	return _aligned_malloc(size, alignment);
+#else
+	void*					p = nullptr;
+	if (posix_memalign(&p, alignment, size) != 0) return nullptr;
+	return p;
+#endif
+}
+
+void						raw_free(void* p, const size_t alignment) {
+#ifdef _WIN32
+	if (alignment != 0) {
+		_aligned_free(p);
+		return;
+	}
+#endif
+	std::free(p);
+}
+
+// An alignment of 0 is the default, malloc's.
+void*						tracked_new(size_t size, const size_t alignment) {
+	if (size < 1) size = 1;
+	count_alloc(size);
+	while (true) {
+		void*				p = raw_alloc(size, alignment);
+		if (p) return p;
+		std::new_handler	h = current_new_handler();
+		if (!h) throw std::bad_alloc();
+		h();
+	}
+}
+
+void*						tracked_new_nothrow(const size_t size, const size_t alignment) throw() {
+	try {
+		return tracked_new(size, alignment);
+	} catch (std::bad_alloc const&) {
+	}
+	return nullptr;
+}
+}
+
+void* operator new(size_t size) {
+	return tracked_new(size, 0);
+}
+
+void* operator new[](size_t size) {
+	return tracked_new(size, 0);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw() {
+	return tracked_new_nothrow(size, 0);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw() {
+	return tracked_new_nothrow(size, 0);
+}
+
+void operator delete(void* p) throw() {
+	raw_free(p, 0);
+}
+
+void operator delete[](void* p) throw() {
+	raw_free(p, 0);
+}
+
+void operator delete(void* p, const std::nothrow_t&) throw() {
+	raw_free(p, 0);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) throw() {
+	raw_free(p, 0);
+}
+
+#ifdef __cpp_aligned_new
+/* Over-aligned types (alignas greater than the default new alignment) come
+ * through these instead, in C++17. The sized deletes fall back to these.
+ ******************************************************************/
+void* operator new(size_t size, std::align_val_t al) {
+	return tracked_new(size, static_cast<size_t>(al));
+}
+
+void* operator new[](size_t size, std::align_val_t al) {
+	return tracked_new(size, static_cast<size_t>(al));
+}
+
+void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+	return tracked_new_nothrow(size, static_cast<size_t>(al));
+}
+
+void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+	return tracked_new_nothrow(size, static_cast<size_t>(al));
+}
+
+void operator delete(void* p, std::align_val_t al) noexcept {
+	raw_free(p, static_cast<size_t>(al));
+}
+
+void operator delete[](void* p, std::align_val_t al) noexcept {
+	raw_free(p, static_cast<size_t>(al));
+}
+
+void operator delete(void* p, std::align_val_t al, const std::nothrow_t&) noexcept {
+	raw_free(p, static_cast<size_t>(al));
+}
+
+void operator delete[](void* p, std::align_val_t al, const std::nothrow_t&) noexcept {
+	raw_free(p, static_cast<size_t>(al));
+}
+#endif
+#endif
@@ -0,0 +1,163 @@
+#pragma once
+#ifndef DS_DEBUG_PROFILER_H_
+#define DS_DEBUG_PROFILER_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <Poco/Mutex.h>
+
+namespace ds {
+
+/**
+ * \class ds::Profiler
+ * \brief Times scopes on any thread into per-thread ring buffers. The buffers
+ * can be written as a Chrome trace (open it in chrome://tracing or
+ * ui.perfetto.dev), and the main thread's scopes are averaged into a
+ * per-frame summary for the stats view.
+ *
+ * Off by default, when a scope costs one flag check. Mark a scope with
+ * DS_PROFILE_SCOPE("name"); the name isn't copied, so it should be a literal.
+ *
+ * Building with DS_TRACK_ALLOCATIONS replaces the global operator new to
+ * count each thread's allocations. Scopes then carry the allocations made
+ * inside them, and every frame's main thread allocations are checked
+ * against the allocation budget.
+ */
+class Profiler {
+public:
+	static Profiler&			get();
+
+	void						setEnabled(const bool);
+	bool						isEnabled() const;
+	// How many events each thread keeps. Only applies to threads that haven't recorded anything yet.
+	void						setEventsPerThread(const size_t);
+
+	// Main thread, once at the start of every frame.
+	void						frame();
+
+	// Where writeTrace() goes by default.
+	void						setTracePath(const std::string&);
+	const std::string&			getTracePath() const		{ return mTracePath; }
+	// Write the trace once this many more frames have run. 0 cancels.
+	void						setTraceAfter(const int frames);
+	// Write everything still in the buffers. Answers false if the file couldn't be written.
+	bool						writeTrace();
+	bool						writeTrace(const std::string& path);
+
+	// Main thread. Time and allocations of each main thread scope, in tree order. The
+	// averages are per frame and recent; the totals count since the summary was enabled.
+	struct Summary {
+		Summary() : mDepth(0), mMs(0.0), mAllocs(0.0), mTotalMs(0.0), mMaxMs(0.0), mTotalAllocs(0) { }
+		std::string				mName;
+		// Names from the root scope down, separated by '/'
+		std::string				mPath;
+		int						mDepth;
+		double					mMs;
+		double					mAllocs;
+		double					mTotalMs;
+		// The most in any one frame
+		double					mMaxMs;
+		long long				mTotalAllocs;
+	};
+	void						setSummaryEnabled(const bool);
+	void						getSummary(std::vector<Summary>&) const;
+
+	// True when built with DS_TRACK_ALLOCATIONS. Otherwise allocations all read 0.
+	static bool					tracksAllocations();
+	// Log frames where the main thread allocates more than this many times. 0 turns it off.
+	void						setAllocationBudget(const int allocsPerFrame);
+	// Every allocation the calling thread has made.
+	static void					getThreadAllocations(unsigned long long& count, unsigned long long& bytes);
+	// Main thread. Average allocations per frame on the main thread.
+	double						getFrameAllocations() const	{ return mFrameAllocs; }
+	double						getFrameAllocationBytes() const	{ return mFrameAllocBytes; }
+
+	class Buffer;
+
+private:
+	friend class ProfileScope;
+	Profiler();
+	~Profiler();
+	Profiler(const Profiler&);
+	Profiler&					operator=(const Profiler&);
+
+	struct Node {
+		Node() : mName(nullptr), mDepth(0), mFrameTicks(0), mFrameAllocs(0), mFrameSelfAllocs(0), mMs(0.0), mAllocs(0.0)
+				, mTotalTicks(0), mMaxTicks(0), mTotalAllocs(0) { }
+		const char*				mName;
+		int						mDepth;
+		// This frame. Self doesn't include the scopes inside this one.
+		long long				mFrameTicks;
+		long long				mFrameAllocs;
+		long long				mFrameSelfAllocs;
+		// Averaged
+		double					mMs;
+		double					mAllocs;
+		long long				mTotalTicks;
+		long long				mMaxTicks;
+		long long				mTotalAllocs;
+	};
+
+	// The calling thread's buffer, made on first use.
+	Buffer*						getBuffer();
+	void						summarize(Buffer&);
+	// Summarized is true if the summary has this frame's scopes.
+	void						checkAllocations(const bool summarized);
+
+	std::atomic<bool>			mEnabled;
+	Poco::Mutex					mMutex;
+	// Buffers outlive their threads, so a trace can still show threads that have finished.
+	std::vector<std::unique_ptr<Buffer>>
+								mBuffers;
+	std::atomic<size_t>			mEventsPerThread;
+	const long long				mStartTicks;
+
+	// MAIN THREAD
+	std::string					mTracePath;
+	int							mTraceAfter;
+	Buffer*						mMainBuffer;
+	bool						mSummaryEnabled;
+	// Keyed by the names from the root down, joined by '\x01', so the map sorts into a tree.
+	std::map<std::string, Node>	mSummary;
+	std::string					mKey;
+	std::vector<const char*>	mStack;
+	std::vector<Node*>			mNodeStack;
+
+	int							mAllocBudget;
+	bool						mAllocsStarted;
+	unsigned long long			mLastAllocs, mLastAllocBytes;
+	double						mFrameAllocs, mFrameAllocBytes;
+	// Over budget frames are logged at most once a second or so, with a count of the ones in between.
+	int							mFramesSinceAllocLog;
+	int							mOverBudgetFrames;
+};
+
+/**
+ * \class ds::ProfileScope
+ * \brief Record the time from construction to destruction. Use DS_PROFILE_SCOPE.
+ */
+class ProfileScope {
+public:
+	explicit ProfileScope(const char* name);
+	~ProfileScope();
+
+private:
+	ProfileScope(const ProfileScope&);
+	ProfileScope&				operator=(const ProfileScope&);
+
+	Profiler::Buffer*			mBuffer;
+	const char*					mName;
+	long long					mStart;
+	unsigned long long			mStartAllocs, mStartAllocBytes;
+};
+
+} // namespace ds
+
+#define DS_PROFILE_CAT_(a, b)		a##b
+#define DS_PROFILE_CAT(a, b)		DS_PROFILE_CAT_(a, b)
+#define DS_PROFILE_SCOPE(name)		ds::ProfileScope	DS_PROFILE_CAT(ds_profile_scope_, __LINE__)(name)
+
+#endif // DS_DEBUG_PROFILER_H_
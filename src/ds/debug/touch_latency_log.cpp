@@ -0,0 +1,96 @@
+#include "stdafx.h"
+
+#include "ds/debug/touch_latency_log.h"
+
+#include <algorithm>
+#include "ds/debug/logger.h"
+
+namespace ds {
+
+namespace {
+// Microseconds between summaries
+const Poco::Timestamp::TimeDiff		SUMMARY_INTERVAL = 5 * 1000 * 1000;
+}
+
+/**
+ * \class ds::TouchLatencyLog
+ */
+TouchLatencyLog::TouchLatencyLog()
+	: mEnabled(false)
+	, mFrame(0)
+	, mMoves(0)
+	, mOldest(0)
+	, mNewest(0)
+	, mSummaryFrames(0)
+	, mSummaryTotalMs(0.0)
+	, mSummaryMaxMs(0.0)
+{
+}
+
+TouchLatencyLog::~TouchLatencyLog()
+{
+	setPath("");
+}
+
+void TouchLatencyLog::setPath(const std::string& path)
+{
+	if (mFile.is_open()) mFile.close();
+	mEnabled = false;
+	mMoves = 0;
+	if (path.empty()) return;
+
+	mFile.open(path.c_str(), std::ios::out | std::ios::trunc);
+	if (!mFile.is_open()) {
+		DS_LOG_WARNING("TouchLatencyLog can't write to " << path);
+		return;
+	}
+	mFile << "draw_us,frame,moves,oldest_ms,newest_ms\n";
+	mEnabled = true;
+	mSummaryStart.update();
+	mSummaryFrames = 0;
+	mSummaryTotalMs = 0.0;
+	mSummaryMaxMs = 0.0;
+	DS_LOG_INFO("TouchLatencyLog writing to " << path);
+}
+
+void TouchLatencyLog::dispatched(const Poco::Timestamp::TimeVal received)
+{
+	if (!mEnabled || received <= 0) return;
+	if (mMoves < 1) {
+		mOldest = mNewest = received;
+	} else {
+		mOldest = std::min(mOldest, received);
+		mNewest = std::max(mNewest, received);
+	}
+	++mMoves;
+}
+
+void TouchLatencyLog::drawn()
+{
+	if (!mEnabled) return;
+	++mFrame;
+	if (mMoves > 0) {
+		const Poco::Timestamp::TimeVal	now = Poco::Timestamp().epochMicroseconds();
+		const double					oldestMs = static_cast<double>(now - mOldest) / 1000.0;
+		const double					newestMs = static_cast<double>(now - mNewest) / 1000.0;
+		mFile << now << "," << mFrame << "," << mMoves << "," << oldestMs << "," << newestMs << "\n";
+		mMoves = 0;
+
+		++mSummaryFrames;
+		mSummaryTotalMs += oldestMs;
+		mSummaryMaxMs = std::max(mSummaryMaxMs, oldestMs);
+	}
+
+	if (mSummaryStart.elapsed() < SUMMARY_INTERVAL) return;
+	if (mSummaryFrames > 0) {
+		DS_LOG_INFO("Touch latency over " << mSummaryFrames << " frames: mean=" << mSummaryTotalMs / static_cast<double>(mSummaryFrames)
+					<< "ms max=" << mSummaryMaxMs << "ms");
+		mFile.flush();
+	}
+	mSummaryStart.update();
+	mSummaryFrames = 0;
+	mSummaryTotalMs = 0.0;
+	mSummaryMaxMs = 0.0;
+}
+
+} // namespace ds
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef DS_DEBUG_TOUCHLATENCYLOG_H_
+#define DS_DEBUG_TOUCHLATENCYLOG_H_
+
+#include <fstream>
+#include <string>
+#include <Poco/Timestamp.h>
+
+namespace ds {
+
+/**
+ * \class ds::TouchLatencyLog
+ * \brief Measures how long touch moves take from reaching the engine to the
+ * end of the frame that draws them. Each frame that drew moves is a line of
+ * CSV, and a summary is logged every few seconds. The time stops at the end
+ * of draw, before the buffer swap, so the display adds a frame or so on top.
+ *
+ * Main thread only.
+ */
+class TouchLatencyLog {
+public:
+	TouchLatencyLog();
+	~TouchLatencyLog();
+
+	// Where the CSV goes. Empty turns the log off.
+	void						setPath(const std::string&);
+	bool						isEnabled() const			{ return mEnabled; }
+
+	// A move stamped with this receive time was just sent to the sprites.
+	void						dispatched(const Poco::Timestamp::TimeVal received);
+	// A frame has finished drawing.
+	void						drawn();
+
+private:
+	TouchLatencyLog(const TouchLatencyLog&);
+	TouchLatencyLog&			operator=(const TouchLatencyLog&);
+
+	bool						mEnabled;
+	std::ofstream				mFile;
+	long long					mFrame;
+
+	// The moves dispatched since the last draw
+	int							mMoves;
+	Poco::Timestamp::TimeVal	mOldest, mNewest;
+
+	// Since the last summary
+	Poco::Timestamp				mSummaryStart;
+	int							mSummaryFrames;
+	double						mSummaryTotalMs;
+	double						mSummaryMaxMs;
+};
+
+} // namespace ds
+
+#endif // DS_DEBUG_TOUCHLATENCYLOG_H_
@@ -0,0 +1,102 @@
+#include "stdafx.h"
+
+#include "ds/debug/touch_recorder.h"
+
+#include <algorithm>
+#include "ds/debug/logger.h"
+#include "ds/ui/touch/touch_event.h"
+
+namespace ds {
+
+namespace {
+// Bytes held before writing to the file
+const size_t		FLUSH_SIZE = 64 * 1024;
+
+template <typename T>
+void				put(std::vector<char>& buf, const T& v) {
+	const char*		p = reinterpret_cast<const char*>(&v);
+	buf.insert(buf.end(), p, p + sizeof(T));
+}
+}
+
+const char*			TouchRecorder::MAGIC = "DSTOUCH";
+
+/**
+ * \class ds::TouchRecorder
+ */
+TouchRecorder::TouchRecorder()
+	: mEnabled(false)
+	, mEvents(0)
+{
+}
+
+TouchRecorder::~TouchRecorder()
+{
+	setPath("");
+}
+
+void TouchRecorder::setPath(const std::string& path)
+{
+	std::lock_guard<std::mutex>	lock(mMutex);
+	if (mFile.is_open()) {
+		flush();
+		mFile.close();
+		DS_LOG_INFO("TouchRecorder recorded " << mEvents << " events");
+	}
+	mEnabled = false;
+	mBuffer.clear();
+	mEvents = 0;
+	if (path.empty()) return;
+
+	mFile.open(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!mFile.is_open()) {
+		DS_LOG_WARNING("TouchRecorder can't write to " << path);
+		return;
+	}
+	mFile.write(MAGIC, MAGIC_SIZE);
+	mFile.put(static_cast<char>(VERSION));
+	mBuffer.reserve(FLUSH_SIZE + RECORD_SIZE);
+	mStart.update();
+	mEnabled = true;
+	DS_LOG_INFO("TouchRecorder writing to " << path);
+}
+
+void TouchRecorder::record(const Phase phase, const ds::ui::TouchEvent& e)
+{
+	if (!mEnabled) return;
+	const std::vector<ci::app::TouchEvent::Touch>&	touches = e.getTouches();
+	if (touches.empty()) return;
+
+	std::lock_guard<std::mutex>	lock(mMutex);
+	if (!mEnabled) return;
+	// Anything past what the count can hold goes in the next record
+	for (size_t first = 0; first < touches.size(); first += 0xffff) {
+		const size_t		count = std::min<size_t>(touches.size() - first, 0xffff);
+		put(mBuffer, static_cast<int64_t>(mStart.elapsed()));
+		put(mBuffer, static_cast<uint8_t>(phase));
+		put(mBuffer, static_cast<uint8_t>(e.getInWorldSpace() ? IN_WORLD_SPACE_F : 0));
+		put(mBuffer, static_cast<uint16_t>(count));
+		put(mBuffer, static_cast<int32_t>(e.getSourceFrame()));
+		for (size_t k = first; k < first + count; ++k) {
+			const ci::app::TouchEvent::Touch&	t = touches[k];
+			put(mBuffer, static_cast<int32_t>(t.getId()));
+			put(mBuffer, static_cast<float>(t.getX()));
+			put(mBuffer, static_cast<float>(t.getY()));
+		}
+		++mEvents;
+	}
+	if (mBuffer.size() >= FLUSH_SIZE) flush();
+}
+
+void TouchRecorder::flush()
+{
+	if (mBuffer.empty()) return;
+	mFile.write(mBuffer.data(), static_cast<std::streamsize>(mBuffer.size()));
+	mBuffer.clear();
+	if (mFile.fail()) {
+		DS_LOG_WARNING("TouchRecorder failed writing, recording stopped");
+		mEnabled = false;
+	}
+}
+
+} // namespace ds
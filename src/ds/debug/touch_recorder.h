@@ -0,0 +1,69 @@
+#pragma once
+#ifndef DS_DEBUG_TOUCHRECORDER_H_
+#define DS_DEBUG_TOUCHRECORDER_H_
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <Poco/Timestamp.h>
+
+namespace ds {
+namespace ui {
+class TouchEvent;
+}
+
+/**
+ * \class ds::TouchRecorder
+ * \brief Writes every touch event the engine receives to a binary log, so a
+ * session can be played back later with ds::TouchReplayer. Events are recorded
+ * as they arrive, before they're translated to world space.
+ *
+ * The file is a header and then one record per event, all little endian:
+ *   header:	"DSTOUCH" and a version byte
+ *   record:	int64 microseconds since the start, uint8 phase, uint8 flags,
+ *				uint16 touch count, int32 source frame, then per touch int32 id,
+ *				float x, float y
+ *
+ * Safe to call record() from any thread.
+ */
+class TouchRecorder {
+public:
+	enum Phase { BEGAN = 0, MOVED = 1, ENDED = 2 };
+	// Record flags
+	static const uint8_t		IN_WORLD_SPACE_F = 1 << 0;
+
+	static const char*			MAGIC;
+	static const size_t			MAGIC_SIZE = 7;
+	static const uint8_t		VERSION = 1;
+	static const size_t			RECORD_SIZE = 16;
+	static const size_t			TOUCH_SIZE = 12;
+
+	TouchRecorder();
+	~TouchRecorder();
+
+	// Where the log goes. Empty stops recording and closes the file.
+	void						setPath(const std::string&);
+	bool						isEnabled() const			{ return mEnabled; }
+
+	void						record(const Phase, const ds::ui::TouchEvent&);
+
+private:
+	TouchRecorder(const TouchRecorder&);
+	TouchRecorder&				operator=(const TouchRecorder&);
+
+	void						flush();
+
+	std::atomic<bool>			mEnabled;
+	std::mutex					mMutex;
+	std::ofstream				mFile;
+	Poco::Timestamp				mStart;
+	// Written out in chunks
+	std::vector<char>			mBuffer;
+	long long					mEvents;
+};
+
+} // namespace ds
+
+#endif // DS_DEBUG_TOUCHRECORDER_H_
@@ -0,0 +1,257 @@
+#include "stdafx.h"
+
+#include "ds/debug/touch_replayer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include "ds/debug/logger.h"
+#include "ds/debug/touch_recorder.h"
+#include "ds/ui/touch/touch_event.h"
+
+namespace ds {
+
+namespace {
+template <typename T>
+T					get(const char*& p) {
+	T				v;
+	std::memcpy(&v, p, sizeof(T));
+	p += sizeof(T);
+	return v;
+}
+
+double				to_ms(const Poco::Timestamp::TimeDiff us) {
+	return static_cast<double>(us) / 1000.0;
+}
+}
+
+/**
+ * \class ds::TouchReplayer
+ */
+TouchReplayer::TouchReplayer()
+	: mSpeed(1.0)
+	, mLoop(false)
+	, mPlaying(false)
+	, mStartTime(-1.0)
+	, mNext(0)
+	, mPassDone(false)
+	, mDownInWorldSpace(false)
+	, mFrame(0)
+	, mFrameEvents(0)
+	, mFrameTouches(0)
+	, mFramePick(0)
+	, mPassFrames(0)
+	, mPassDispatchMs(0.0)
+	, mPassMaxDispatchMs(0.0)
+	, mPassGestureMs(0.0)
+	, mPassMaxGestureMs(0.0)
+{
+}
+
+TouchReplayer::~TouchReplayer()
+{
+}
+
+void TouchReplayer::setHandlers(const Handler& began, const Handler& moved, const Handler& ended)
+{
+	mBegan = began;
+	mMoved = moved;
+	mEnded = ended;
+}
+
+bool TouchReplayer::load(const std::string& path)
+{
+	mPlaying = false;
+	mRecords.clear();
+	mPoints.clear();
+
+	std::ifstream				file(path.c_str(), std::ios::in | std::ios::binary);
+	if (!file.is_open()) {
+		DS_LOG_WARNING("TouchReplayer can't read " << path);
+		return false;
+	}
+	const std::vector<char>		data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	const size_t				headerSize = TouchRecorder::MAGIC_SIZE + 1;
+	if (data.size() < headerSize || std::memcmp(data.data(), TouchRecorder::MAGIC, TouchRecorder::MAGIC_SIZE) != 0
+			|| static_cast<uint8_t>(data[TouchRecorder::MAGIC_SIZE]) != TouchRecorder::VERSION) {
+		DS_LOG_WARNING("TouchReplayer " << path << " isn't a touch recording");
+		return false;
+	}
+
+	const char*					p = data.data() + headerSize;
+	const char*					end = data.data() + data.size();
+	while (static_cast<size_t>(end - p) >= TouchRecorder::RECORD_SIZE) {
+		Record					r;
+		r.mTime = get<int64_t>(p);
+		r.mPhase = get<uint8_t>(p);
+		r.mInWorldSpace = (get<uint8_t>(p) & TouchRecorder::IN_WORLD_SPACE_F) != 0;
+		r.mCount = get<uint16_t>(p);
+		r.mSourceFrame = get<int32_t>(p);
+		r.mFirst = mPoints.size();
+		if (static_cast<size_t>(end - p) < r.mCount * TouchRecorder::TOUCH_SIZE) break;
+		for (size_t k = 0; k < r.mCount; ++k) {
+			Point				pt;
+			pt.mId = get<int32_t>(p);
+			pt.mPos.x = get<float>(p);
+			pt.mPos.y = get<float>(p);
+			mPoints.push_back(pt);
+		}
+		if (r.mPhase > TouchRecorder::ENDED) continue;
+		mRecords.push_back(r);
+	}
+	if (p != end) DS_LOG_WARNING("TouchReplayer " << path << " ends with a partial event, it was skipped");
+	if (mRecords.empty()) {
+		DS_LOG_WARNING("TouchReplayer " << path << " has no events");
+		return false;
+	}
+
+	const double				seconds = static_cast<double>(mRecords.back().mTime) / 1000000.0;
+	DS_LOG_INFO("TouchReplayer loaded " << mRecords.size() << " events over " << seconds << "s from " << path);
+	mPlaying = true;
+	mStartTime = -1.0;
+	mNext = 0;
+	mPassDone = false;
+	return true;
+}
+
+void TouchReplayer::setSpeed(const double speed)
+{
+	mSpeed = speed > 0.0 ? speed : 1.0;
+}
+
+void TouchReplayer::setLoop(const bool loop)
+{
+	mLoop = loop;
+}
+
+void TouchReplayer::setTimingPath(const std::string& path)
+{
+	if (mTimingFile.is_open()) mTimingFile.close();
+	if (path.empty()) return;
+
+	mTimingFile.open(path.c_str(), std::ios::out | std::ios::trunc);
+	if (!mTimingFile.is_open()) {
+		DS_LOG_WARNING("TouchReplayer can't write timings to " << path);
+		return;
+	}
+	mTimingFile << "frame,events,touches,dispatch_ms,pick_ms,gesture_ms\n";
+}
+
+void TouchReplayer::update(const double now)
+{
+	if (!mPlaying) return;
+	if (mStartTime < 0.0) mStartTime = now;
+
+	const long long				due = static_cast<long long>((now - mStartTime) * mSpeed * 1000000.0);
+	while (mNext < mRecords.size() && mRecords[mNext].mTime <= due) {
+		send(mRecords[mNext++], now);
+	}
+	if (mNext < mRecords.size()) return;
+
+	endAll(now);
+	// The summary waits for this frame's timing
+	mPassDone = true;
+	if (mLoop) {
+		mStartTime = now;
+		mNext = 0;
+	} else {
+		DS_LOG_INFO("TouchReplayer finished");
+		mPlaying = false;
+	}
+}
+
+void TouchReplayer::stop()
+{
+	if (!mPlaying) return;
+	endAll(mStartTime);
+	mPlaying = false;
+}
+
+void TouchReplayer::addPickTime(const Poco::Timestamp::TimeDiff us)
+{
+	mFramePick += us;
+}
+
+void TouchReplayer::frameTiming(const Poco::Timestamp::TimeDiff dispatch, const Poco::Timestamp::TimeDiff gestures)
+{
+	++mFrame;
+	const double				dispatchMs = to_ms(dispatch);
+	const double				gestureMs = to_ms(gestures);
+	if (mTimingFile.is_open()) {
+		mTimingFile << mFrame << "," << mFrameEvents << "," << mFrameTouches << ","
+					<< dispatchMs << "," << to_ms(mFramePick) << "," << gestureMs << "\n";
+	}
+	++mPassFrames;
+	mPassDispatchMs += dispatchMs;
+	mPassMaxDispatchMs = std::max(mPassMaxDispatchMs, dispatchMs);
+	mPassGestureMs += gestureMs;
+	mPassMaxGestureMs = std::max(mPassMaxGestureMs, gestureMs);
+
+	mFrameEvents = 0;
+	mFrameTouches = 0;
+	mFramePick = 0;
+	if (mPassDone) {
+		logSummary();
+		mPassDone = false;
+	}
+}
+
+void TouchReplayer::send(const Record& r, const double now)
+{
+	mScratch.clear();
+	for (size_t k = r.mFirst, end = r.mFirst + r.mCount; k < end; ++k) {
+		const Point&			pt = mPoints[k];
+		ci::vec2				prev = pt.mPos;
+		if (r.mPhase == TouchRecorder::ENDED) {
+			mDown.erase(pt.mId);
+		} else {
+			auto				found = mDown.find(pt.mId);
+			if (found == mDown.end()) {
+				mDown[pt.mId] = pt.mPos;
+			} else {
+				prev = found->second;
+				found->second = pt.mPos;
+			}
+		}
+		mScratch.push_back(ci::app::TouchEvent::Touch(pt.mPos, prev, static_cast<uint32_t>(pt.mId), now, nullptr));
+	}
+
+	mDownInWorldSpace = r.mInWorldSpace;
+	const Handler&				h = r.mPhase == TouchRecorder::BEGAN ? mBegan : r.mPhase == TouchRecorder::MOVED ? mMoved : mEnded;
+	if (h) {
+		ds::ui::TouchEvent		e(ci::app::WindowRef(), mScratch, r.mInWorldSpace);
+		e.setSourceFrame(r.mSourceFrame);
+		h(e);
+	}
+	++mFrameEvents;
+	mFrameTouches += static_cast<int>(r.mCount);
+}
+
+void TouchReplayer::endAll(const double now)
+{
+	if (mDown.empty()) return;
+	mScratch.clear();
+	for (auto it = mDown.begin(), end = mDown.end(); it != end; ++it) {
+		mScratch.push_back(ci::app::TouchEvent::Touch(it->second, it->second, static_cast<uint32_t>(it->first), now, nullptr));
+	}
+	mDown.clear();
+	if (mEnded) mEnded(ds::ui::TouchEvent(ci::app::WindowRef(), mScratch, mDownInWorldSpace));
+}
+
+void TouchReplayer::logSummary()
+{
+	if (mPassFrames > 0) {
+		const double			frames = static_cast<double>(mPassFrames);
+		DS_LOG_INFO("TouchReplayer pass over " << mPassFrames << " frames: dispatch mean=" << mPassDispatchMs / frames
+					<< "ms max=" << mPassMaxDispatchMs << "ms, gestures mean=" << mPassGestureMs / frames
+					<< "ms max=" << mPassMaxGestureMs << "ms");
+	}
+	if (mTimingFile.is_open()) mTimingFile.flush();
+	mPassFrames = 0;
+	mPassDispatchMs = 0.0;
+	mPassMaxDispatchMs = 0.0;
+	mPassGestureMs = 0.0;
+	mPassMaxGestureMs = 0.0;
+}
+
+} // namespace ds
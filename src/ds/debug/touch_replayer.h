@@ -0,0 +1,112 @@
+#pragma once
+#ifndef DS_DEBUG_TOUCHREPLAYER_H_
+#define DS_DEBUG_TOUCHREPLAYER_H_
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cinder/Vector.h>
+#include <cinder/app/TouchEvent.h>
+#include <Poco/Timestamp.h>
+
+namespace ds {
+namespace ui {
+class TouchEvent;
+}
+
+/**
+ * \class ds::TouchReplayer
+ * \brief Plays a log written by ds::TouchRecorder back into the engine, on the
+ * engine's clock, so in the headless engine a replay steps with the fixed dt and
+ * runs the same way every time. The speed scales the clock; 2 plays a session
+ * in half the time. Positions are replayed as recorded, so play back in the same
+ * window size.
+ *
+ * While it plays it can write a line of CSV per frame with the events sent and
+ * the time the engine spent dispatching them, picking and in gestures, and it
+ * logs a summary at the end of each pass.
+ *
+ * Main thread only.
+ */
+class TouchReplayer {
+public:
+	typedef std::function<void(const ds::ui::TouchEvent&)> Handler;
+
+	TouchReplayer();
+	~TouchReplayer();
+
+	void						setHandlers(const Handler& began, const Handler& moved, const Handler& ended);
+	// Read a whole log. Playing starts on the next update().
+	bool						load(const std::string& path);
+	void						setSpeed(const double);
+	// Start over from the beginning once the log runs out
+	void						setLoop(const bool);
+	// Where the per-frame timings go. Empty turns them off.
+	void						setTimingPath(const std::string&);
+
+	bool						isPlaying() const			{ return mPlaying; }
+
+	// Send every event that's due. now is the engine's elapsed time in seconds.
+	void						update(const double now);
+	// End any fingers that are still down and stop.
+	void						stop();
+
+	// The engine's measurements for a frame that played events, in microseconds.
+	// Picks can come in a bit at a time; frameTiming() finishes the frame.
+	void						addPickTime(const Poco::Timestamp::TimeDiff);
+	void						frameTiming(const Poco::Timestamp::TimeDiff dispatch, const Poco::Timestamp::TimeDiff gestures);
+
+private:
+	TouchReplayer(const TouchReplayer&);
+	TouchReplayer&				operator=(const TouchReplayer&);
+
+	struct Record {
+		long long				mTime;
+		int						mPhase;
+		bool					mInWorldSpace;
+		int32_t					mSourceFrame;
+		size_t					mFirst;
+		size_t					mCount;
+	};
+	struct Point {
+		int32_t					mId;
+		ci::vec2				mPos;
+	};
+
+	void						send(const Record&, const double now);
+	void						endAll(const double now);
+	void						logSummary();
+
+	Handler						mBegan, mMoved, mEnded;
+	std::vector<Record>			mRecords;
+	std::vector<Point>			mPoints;
+	double						mSpeed;
+	bool						mLoop;
+
+	bool						mPlaying;
+	// Engine time of the start of this pass, or below 0 before the first update
+	double						mStartTime;
+	size_t						mNext;
+	bool						mPassDone;
+	// Where each finger that's down was last, for the previous positions and to end them on stop
+	std::unordered_map<int32_t, ci::vec2>
+								mDown;
+	bool						mDownInWorldSpace;
+	std::vector<ci::app::TouchEvent::Touch>
+								mScratch;
+
+	std::ofstream				mTimingFile;
+	long long					mFrame;
+	int							mFrameEvents, mFrameTouches;
+	Poco::Timestamp::TimeDiff	mFramePick;
+	// Over this pass
+	int							mPassFrames;
+	double						mPassDispatchMs, mPassMaxDispatchMs;
+	double						mPassGestureMs, mPassMaxGestureMs;
+};
+
+} // namespace ds
+
+#endif // DS_DEBUG_TOUCHREPLAYER_H_
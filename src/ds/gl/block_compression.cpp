@@ -0,0 +1,414 @@
+#include "stdafx.h"
+
+#include "ds/gl/block_compression.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace ds {
+namespace gl {
+
+namespace {
+
+struct Rgba {
+	int					r, g, b, a;
+};
+
+uint16_t				pack_565(const int r, const int g, const int b) {
+	const int			r5 = (r * 31 + 127) / 255,
+						g6 = (g * 63 + 127) / 255,
+						b5 = (b * 31 + 127) / 255;
+	return static_cast<uint16_t>((r5 << 11) | (g6 << 5) | b5);
+}
+
+Rgba					unpack_565(const uint16_t c) {
+	Rgba				ans;
+	const int			r5 = (c >> 11) & 0x1f,
+						g6 = (c >> 5) & 0x3f,
+						b5 = c & 0x1f;
+	ans.r = (r5 << 3) | (r5 >> 2);
+	ans.g = (g6 << 2) | (g6 >> 4);
+	ans.b = (b5 << 3) | (b5 >> 2);
+	ans.a = 255;
+	return ans;
+}
+
+// Build the 4-entry palette. In 3-color mode entry 3 is black, and transparent
+// if the format has punch-through alpha.
+void					make_color_palette(const uint16_t c0, const uint16_t c1, const bool fourColor, const bool punchThrough, Rgba* pal) {
+	pal[0] = unpack_565(c0);
+	pal[1] = unpack_565(c1);
+	if (fourColor) {
+		pal[2].r = (2 * pal[0].r + pal[1].r) / 3;
+		pal[2].g = (2 * pal[0].g + pal[1].g) / 3;
+		pal[2].b = (2 * pal[0].b + pal[1].b) / 3;
+		pal[2].a = 255;
+		pal[3].r = (pal[0].r + 2 * pal[1].r) / 3;
+		pal[3].g = (pal[0].g + 2 * pal[1].g) / 3;
+		pal[3].b = (pal[0].b + 2 * pal[1].b) / 3;
+		pal[3].a = 255;
+	} else {
+		pal[2].r = (pal[0].r + pal[1].r) / 2;
+		pal[2].g = (pal[0].g + pal[1].g) / 2;
+		pal[2].b = (pal[0].b + pal[1].b) / 2;
+		pal[2].a = 255;
+		pal[3].r = pal[3].g = pal[3].b = 0;
+		pal[3].a = punchThrough ? 0 : 255;
+	}
+}
+
+int						color_dist(const Rgba& a, const Rgba& b) {
+	const int			dr = a.r - b.r, dg = a.g - b.g, db = a.b - b.b;
+	return dr*dr + dg*dg + db*db;
+}
+
+// Range fit: project the block onto its principal axis (approximated by the
+// covariance power iteration) and use the extremes, inset slightly, as endpoints.
+void					encode_color_block(const Rgba* px, const bool allowTransparent, uint8_t* out) {
+	bool				hasTransparent = false;
+	float				mean[3] = { 0.0f, 0.0f, 0.0f };
+	int					count = 0;
+	for (int i = 0; i < 16; ++i) {
+		if (allowTransparent && px[i].a < 128) { hasTransparent = true; continue; }
+		mean[0] += px[i].r; mean[1] += px[i].g; mean[2] += px[i].b;
+		++count;
+	}
+
+	uint16_t			c0 = 0, c1 = 0;
+	if (count > 0) {
+		mean[0] /= count; mean[1] /= count; mean[2] /= count;
+		float			cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; ++i) {
+			if (allowTransparent && px[i].a < 128) continue;
+			const float	r = px[i].r - mean[0], g = px[i].g - mean[1], b = px[i].b - mean[2];
+			cov[0] += r*r; cov[1] += r*g; cov[2] += r*b;
+			cov[3] += g*g; cov[4] += g*b; cov[5] += b*b;
+		}
+		float			axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iter = 0; iter < 4; ++iter) {
+			const float	x = cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2],
+						y = cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2],
+						z = cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2];
+			const float	len = std::max(std::max(fabsf(x), fabsf(y)), fabsf(z));
+			if (len < 1e-6f) break;
+			axis[0] = x / len; axis[1] = y / len; axis[2] = z / len;
+		}
+
+		float			minD = 1e30f, maxD = -1e30f;
+		for (int i = 0; i < 16; ++i) {
+			if (allowTransparent && px[i].a < 128) continue;
+			const float	d = (px[i].r - mean[0])*axis[0] + (px[i].g - mean[1])*axis[1] + (px[i].b - mean[2])*axis[2];
+			minD = std::min(minD, d);
+			maxD = std::max(maxD, d);
+		}
+		const float		inset = (maxD - minD) / 32.0f;
+		minD += inset;
+		maxD -= inset;
+
+		const float		lenSq = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+		const float		norm = lenSq > 1e-6f ? 1.0f / lenSq : 0.0f;
+		int				hi[3], lo[3];
+		for (int k = 0; k < 3; ++k) {
+			hi[k] = std::min(255, std::max(0, static_cast<int>(mean[k] + axis[k] * maxD * norm + 0.5f)));
+			lo[k] = std::min(255, std::max(0, static_cast<int>(mean[k] + axis[k] * minD * norm + 0.5f)));
+		}
+		c0 = pack_565(hi[0], hi[1], hi[2]);
+		c1 = pack_565(lo[0], lo[1], lo[2]);
+	}
+
+	// 4-color mode needs c0 > c1, 3-color (punch-through) mode needs c0 <= c1
+	if (hasTransparent) {
+		if (c0 > c1) std::swap(c0, c1);
+	} else {
+		if (c0 < c1) std::swap(c0, c1);
+		if (c0 == c1) {
+			// Solid block: nudge an endpoint so we stay in 4-color mode
+			if (c1 > 0) --c1;
+			else ++c0;
+		}
+	}
+
+	Rgba				pal[4];
+	make_color_palette(c0, c1, c0 > c1, allowTransparent, pal);
+	uint32_t			indices = 0;
+	for (int i = 0; i < 16; ++i) {
+		int				best = 0;
+		if (hasTransparent && px[i].a < 128) {
+			best = 3;
+		} else {
+			const int	palCount = (c0 > c1) ? 4 : 3;
+			int			bestDist = color_dist(px[i], pal[0]);
+			for (int p = 1; p < palCount; ++p) {
+				const int	d = color_dist(px[i], pal[p]);
+				if (d < bestDist) { bestDist = d; best = p; }
+			}
+		}
+		indices |= static_cast<uint32_t>(best) << (i * 2);
+	}
+
+	out[0] = static_cast<uint8_t>(c0 & 0xff);
+	out[1] = static_cast<uint8_t>(c0 >> 8);
+	out[2] = static_cast<uint8_t>(c1 & 0xff);
+	out[3] = static_cast<uint8_t>(c1 >> 8);
+	out[4] = static_cast<uint8_t>(indices & 0xff);
+	out[5] = static_cast<uint8_t>((indices >> 8) & 0xff);
+	out[6] = static_cast<uint8_t>((indices >> 16) & 0xff);
+	out[7] = static_cast<uint8_t>((indices >> 24) & 0xff);
+}
+
+// BC1 picks 3- or 4-color mode from the endpoint order; the color half of BC3 is always 4-color.
+void					decode_color_block(const uint8_t* in, const bool bc1, const bool punchThrough, Rgba* px) {
+	const uint16_t		c0 = static_cast<uint16_t>(in[0] | (in[1] << 8)),
+						c1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+	const uint32_t		indices = in[4] | (in[5] << 8) | (in[6] << 16) | (static_cast<uint32_t>(in[7]) << 24);
+	Rgba				pal[4];
+	make_color_palette(c0, c1, !bc1 || c0 > c1, punchThrough, pal);
+	for (int i = 0; i < 16; ++i) {
+		px[i] = pal[(indices >> (i * 2)) & 0x3];
+	}
+}
+
+void					make_alpha_palette(const int a0, const int a1, int* pal) {
+	pal[0] = a0;
+	pal[1] = a1;
+	if (a0 > a1) {
+		for (int i = 1; i < 7; ++i) pal[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+	} else {
+		for (int i = 1; i < 5; ++i) pal[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+		pal[6] = 0;
+		pal[7] = 255;
+	}
+}
+
+void					encode_alpha_block(const Rgba* px, uint8_t* out) {
+	int					a0 = 0, a1 = 255;
+	for (int i = 0; i < 16; ++i) {
+		a0 = std::max(a0, px[i].a);
+		a1 = std::min(a1, px[i].a);
+	}
+	// Always use the 8-value mode
+	if (a0 == a1) {
+		if (a0 < 255) ++a0;
+		else --a1;
+	}
+	int					pal[8];
+	make_alpha_palette(a0, a1, pal);
+
+	uint64_t			bits = 0;
+	for (int i = 0; i < 16; ++i) {
+		int				best = 0, bestDist = 1 << 30;
+		for (int p = 0; p < 8; ++p) {
+			const int	d = abs(px[i].a - pal[p]);
+			if (d < bestDist) { bestDist = d; best = p; }
+		}
+		bits |= static_cast<uint64_t>(best) << (i * 3);
+	}
+	out[0] = static_cast<uint8_t>(a0);
+	out[1] = static_cast<uint8_t>(a1);
+	for (int i = 0; i < 6; ++i) out[2 + i] = static_cast<uint8_t>((bits >> (i * 8)) & 0xff);
+}
+
+void					decode_alpha_block(const uint8_t* in, Rgba* px) {
+	int					pal[8];
+	make_alpha_palette(in[0], in[1], pal);
+	uint64_t			bits = 0;
+	for (int i = 0; i < 6; ++i) bits |= static_cast<uint64_t>(in[2 + i]) << (i * 8);
+	for (int i = 0; i < 16; ++i) {
+		px[i].a = pal[(bits >> (i * 3)) & 0x7];
+	}
+}
+
+bool					is_supported(const GLenum format) {
+	return format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+		|| format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+// Read a surface into tightly packed RGBA, independent of the platform channel order.
+void					surface_to_rgba(const ci::Surface8u& s, std::vector<uint8_t>& out) {
+	const int			w = s.getWidth(), h = s.getHeight();
+	out.resize(static_cast<size_t>(w) * h * 4);
+	const uint8_t		inc = s.getPixelInc();
+	const int8_t		ro = s.getRedOffset(), go = s.getGreenOffset(), bo = s.getBlueOffset(), ao = s.getAlphaOffset();
+	const bool			alpha = s.hasAlpha();
+	for (int y = 0; y < h; ++y) {
+		const uint8_t*	src = s.getData() + static_cast<size_t>(y) * s.getRowBytes();
+		uint8_t*		dst = out.data() + static_cast<size_t>(y) * w * 4;
+		for (int x = 0; x < w; ++x, src += inc, dst += 4) {
+			dst[0] = src[ro];
+			dst[1] = src[go];
+			dst[2] = src[bo];
+			dst[3] = alpha ? src[ao] : 255;
+		}
+	}
+}
+
+// 2x2 box filter for the next mip level.
+void					downsample(const std::vector<uint8_t>& src, const int w, const int h, std::vector<uint8_t>& dst, int& outW, int& outH) {
+	outW = std::max(1, w / 2);
+	outH = std::max(1, h / 2);
+	dst.resize(static_cast<size_t>(outW) * outH * 4);
+	for (int y = 0; y < outH; ++y) {
+		const int		y0 = std::min(y * 2, h - 1), y1 = std::min(y * 2 + 1, h - 1);
+		for (int x = 0; x < outW; ++x) {
+			const int	x0 = std::min(x * 2, w - 1), x1 = std::min(x * 2 + 1, w - 1);
+			for (int c = 0; c < 4; ++c) {
+				const int	sum = src[(static_cast<size_t>(y0) * w + x0) * 4 + c] + src[(static_cast<size_t>(y0) * w + x1) * 4 + c]
+							+ src[(static_cast<size_t>(y1) * w + x0) * 4 + c] + src[(static_cast<size_t>(y1) * w + x1) * 4 + c];
+				dst[(static_cast<size_t>(y) * outW + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+}
+
+bool encodeBlocks(const uint8_t* rgba, const int width, const int height, const size_t rowBytes,
+				  const GLenum format, std::vector<uint8_t>& out) {
+	if (!rgba || width < 1 || height < 1 || !is_supported(format)) return false;
+
+	const bool			bc3 = (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+	const bool			punchThrough = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT);
+	const size_t		blockBytes = getBlockBytes(format);
+	const int			bw = (width + 3) / 4,
+						bh = (height + 3) / 4;
+	out.resize(static_cast<size_t>(bw) * bh * blockBytes);
+
+	Rgba				px[16];
+	uint8_t*			dst = out.data();
+	for (int by = 0; by < bh; ++by) {
+		for (int bx = 0; bx < bw; ++bx) {
+			// Gather the block, clamping at the right and bottom edges
+			for (int y = 0; y < 4; ++y) {
+				const int		sy = std::min(by * 4 + y, height - 1);
+				const uint8_t*	row = rgba + static_cast<size_t>(sy) * rowBytes;
+				for (int x = 0; x < 4; ++x) {
+					const uint8_t*	p = row + std::min(bx * 4 + x, width - 1) * 4;
+					Rgba&			c = px[y * 4 + x];
+					c.r = p[0]; c.g = p[1]; c.b = p[2]; c.a = p[3];
+				}
+			}
+			if (bc3) {
+				encode_alpha_block(px, dst);
+				encode_color_block(px, false, dst + 8);
+			} else {
+				encode_color_block(px, punchThrough, dst);
+			}
+			dst += blockBytes;
+		}
+	}
+	return true;
+}
+
+bool decodeBlocks(const uint8_t* blocks, const size_t size, const int width, const int height,
+				  const GLenum format, std::vector<uint8_t>& outRgba) {
+	if (!blocks || width < 1 || height < 1 || !is_supported(format)) return false;
+	if (size < getLevelBytes(format, width, height)) return false;
+
+	const bool			bc3 = (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+	const bool			punchThrough = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT);
+	const size_t		blockBytes = getBlockBytes(format);
+	const int			bw = (width + 3) / 4,
+						bh = (height + 3) / 4;
+	outRgba.resize(static_cast<size_t>(width) * height * 4);
+
+	Rgba				px[16];
+	const uint8_t*		src = blocks;
+	for (int by = 0; by < bh; ++by) {
+		for (int bx = 0; bx < bw; ++bx) {
+			if (bc3) {
+				decode_color_block(src + 8, false, false, px);
+				decode_alpha_block(src, px);
+			} else {
+				decode_color_block(src, true, punchThrough, px);
+			}
+			for (int y = 0; y < 4; ++y) {
+				const int		dy = by * 4 + y;
+				if (dy >= height) break;
+				for (int x = 0; x < 4; ++x) {
+					const int	dx = bx * 4 + x;
+					if (dx >= width) break;
+					uint8_t*	p = outRgba.data() + (static_cast<size_t>(dy) * width + dx) * 4;
+					const Rgba&	c = px[y * 4 + x];
+					p[0] = static_cast<uint8_t>(c.r);
+					p[1] = static_cast<uint8_t>(c.g);
+					p[2] = static_cast<uint8_t>(c.b);
+					p[3] = static_cast<uint8_t>(c.a);
+				}
+			}
+			src += blockBytes;
+		}
+	}
+	return true;
+}
+
+bool encodeSurface(const ci::Surface8u& s, const GLenum requestedFormat, const bool mipmaps, CompressedTextureData& out) {
+	out.clear();
+	if (!s.getData() || s.getWidth() < 1 || s.getHeight() < 1) return false;
+
+	GLenum				format = requestedFormat;
+	if (format == 0) format = s.hasAlpha() ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	if (!is_supported(format)) return false;
+
+	std::vector<uint8_t>	rgba, next;
+	surface_to_rgba(s, rgba);
+	int						w = s.getWidth(),
+							h = s.getHeight();
+
+	out.mInternalFormat = format;
+	out.mWidth = w;
+	out.mHeight = h;
+	while (true) {
+		out.mLevels.push_back(CompressedTextureData::Level());
+		CompressedTextureData::Level&	lvl = out.mLevels.back();
+		lvl.mWidth = w;
+		lvl.mHeight = h;
+		if (!encodeBlocks(rgba.data(), w, h, static_cast<size_t>(w) * 4, format, lvl.mData)) {
+			out.clear();
+			return false;
+		}
+		if (!mipmaps || (w == 1 && h == 1)) break;
+		downsample(rgba, w, h, next, w, h);
+		rgba.swap(next);
+	}
+	return true;
+}
+
+bool decodeSurface(const CompressedTextureData& data, const size_t level, ci::Surface8u& s) {
+	if (level >= data.mLevels.size()) return false;
+	const CompressedTextureData::Level&	lvl = data.mLevels[level];
+	std::vector<uint8_t>				rgba;
+	if (!decodeBlocks(lvl.mData.data(), lvl.mData.size(), lvl.mWidth, lvl.mHeight, data.mInternalFormat, rgba)) return false;
+
+	s = ci::Surface8u(lvl.mWidth, lvl.mHeight, true, ci::SurfaceChannelOrder::RGBA);
+	for (int y = 0; y < lvl.mHeight; ++y) {
+		memcpy(s.getData() + static_cast<size_t>(y) * s.getRowBytes(), rgba.data() + static_cast<size_t>(y) * lvl.mWidth * 4, static_cast<size_t>(lvl.mWidth) * 4);
+	}
+	return true;
+}
+
+double computePsnr(const uint8_t* a, const uint8_t* b, const size_t pixelCount, const bool includeAlpha) {
+	if (!a || !b || pixelCount < 1) return 0.0;
+	const int			channels = includeAlpha ? 4 : 3;
+	double				sum = 0.0;
+	for (size_t i = 0; i < pixelCount; ++i) {
+		for (int c = 0; c < channels; ++c) {
+			const double	d = static_cast<double>(a[i * 4 + c]) - static_cast<double>(b[i * 4 + c]);
+			sum += d * d;
+		}
+	}
+	const double		mse = sum / (static_cast<double>(pixelCount) * channels);
+	if (mse <= 0.0) return 999.0;
+	return 10.0 * log10((255.0 * 255.0) / mse);
+}
+
+double computePsnr(const ci::Surface8u& a, const ci::Surface8u& b, const bool includeAlpha) {
+	if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) return 0.0;
+	std::vector<uint8_t>	ra, rb;
+	surface_to_rgba(a, ra);
+	surface_to_rgba(b, rb);
+	return computePsnr(ra.data(), rb.data(), static_cast<size_t>(a.getWidth()) * a.getHeight(), includeAlpha);
+}
+
+} // namespace gl
+} // namespace ds
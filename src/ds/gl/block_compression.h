@@ -0,0 +1,41 @@
+#pragma once
+#ifndef DS_GL_BLOCKCOMPRESSION_H_
+#define DS_GL_BLOCKCOMPRESSION_H_
+
+#include <vector>
+#include <stdint.h>
+#include <cinder/Surface.h>
+#include "ds/gl/compressed_texture.h"
+
+namespace ds {
+namespace gl {
+
+/**
+ * CPU encoder and decoder for the BC1 (DXT1) and BC3 (DXT5) block formats.
+ * Everything here is pure CPU work so it can run on a load thread, and so the
+ * round trip can be checked without a GL context (see computePsnr()).
+ * Pixels are tightly packed RGBA8 unless a row stride is given.
+ */
+
+// Encode a single level. Format must be GL_COMPRESSED_RGBA_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT.
+bool					encodeBlocks(const uint8_t* rgba, const int width, const int height, const size_t rowBytes,
+									 const GLenum format, std::vector<uint8_t>& out);
+// Decode a single level back to tightly packed RGBA8.
+bool					decodeBlocks(const uint8_t* blocks, const size_t size, const int width, const int height,
+									 const GLenum format, std::vector<uint8_t>& outRgba);
+
+// Encode a surface, optionally with a full box-filtered mip chain. If the format is 0,
+// BC3 is chosen for surfaces with alpha and BC1 otherwise.
+bool					encodeSurface(const ci::Surface8u&, const GLenum format, const bool mipmaps, CompressedTextureData&);
+// Decode one level of a BC1/BC3 texture to an RGBA surface.
+bool					decodeSurface(const CompressedTextureData&, const size_t level, ci::Surface8u&);
+
+// Peak signal-to-noise ratio in dB over the RGB (and optionally alpha) channels.
+// Identical images answer a large finite number (999).
+double					computePsnr(const uint8_t* rgbaA, const uint8_t* rgbaB, const size_t pixelCount, const bool includeAlpha);
+double					computePsnr(const ci::Surface8u&, const ci::Surface8u&, const bool includeAlpha = false);
+
+} // namespace gl
+} // namespace ds
+
+#endif // DS_GL_BLOCKCOMPRESSION_H_
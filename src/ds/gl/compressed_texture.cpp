@@ -0,0 +1,294 @@
+#include "stdafx.h"
+
+#include "ds/gl/compressed_texture.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+#include <Poco/Path.h>
+#include <Poco/String.h>
+#include <cinder/DataSource.h>
+#include "ds/debug/logger.h"
+
+namespace ds {
+namespace gl {
+
+namespace {
+
+// DDS layout, see https://msdn.microsoft.com/en-us/library/windows/desktop/bb943982(v=vs.85).aspx
+const uint32_t				DDS_MAGIC = 0x20534444;		// "DDS "
+// Cinder reads the containers, these are only for writing DDS and reading sizes
+const size_t				DDS_HEADER_SIZE = 124;
+const size_t				DDS_DX10_HEADER_SIZE = 20;
+const uint32_t				DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000,
+							DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+const uint32_t				DDPF_FOURCC = 0x4;
+const uint32_t				DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+
+// DXGI_FORMAT values written in the DX10 extended header
+const uint32_t				DXGI_BC7_UNORM = 98, DXGI_BC7_UNORM_SRGB = 99;
+const uint32_t				D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+
+// KTX 1.1 layout, see https://www.khronos.org/opengles/sdk/tools/KTX/file_format_spec/
+const uint8_t				KTX_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+const size_t				KTX_HEADER_SIZE = 64;
+const uint32_t				KTX_ENDIAN_REF = 0x04030201;
+
+uint32_t					make_four_cc(const char a, const char b, const char c, const char d) {
+	return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+uint32_t					read_u32(const uint8_t* p, const bool swap = false) {
+	if (swap) return (p[3]<<0) | (p[2]<<8) | (p[1]<<16) | (static_cast<uint32_t>(p[0])<<24);
+	return (p[0]<<0) | (p[1]<<8) | (p[2]<<16) | (static_cast<uint32_t>(p[3])<<24);
+}
+
+void						write_u32(std::vector<uint8_t>& out, const size_t offset, const uint32_t v) {
+	out[offset+0] = static_cast<uint8_t>(v & 0xff);
+	out[offset+1] = static_cast<uint8_t>((v >> 8) & 0xff);
+	out[offset+2] = static_cast<uint8_t>((v >> 16) & 0xff);
+	out[offset+3] = static_cast<uint8_t>((v >> 24) & 0xff);
+}
+
+uint32_t					four_cc_from_format(const GLenum fmt) {
+	switch (fmt) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:	return make_four_cc('D', 'X', 'T', '1');
+		case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:	return make_four_cc('D', 'X', 'T', '3');
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:	return make_four_cc('D', 'X', 'T', '5');
+		case GL_COMPRESSED_RED_RGTC1:			return make_four_cc('A', 'T', 'I', '1');
+		case GL_COMPRESSED_RG_RGTC2:			return make_four_cc('A', 'T', 'I', '2');
+		default:								return 0;
+	}
+}
+
+}
+
+/**
+ * \class ds::gl::CompressedTextureData
+ */
+CompressedTextureData::CompressedTextureData()
+		: mInternalFormat(0)
+		, mWidth(0)
+		, mHeight(0) {
+}
+
+bool CompressedTextureData::empty() const {
+	return mLevels.empty() || mInternalFormat == 0;
+}
+
+void CompressedTextureData::clear() {
+	mInternalFormat = 0;
+	mWidth = 0;
+	mHeight = 0;
+	mLevels.clear();
+}
+
+size_t CompressedTextureData::getByteSize() const {
+	size_t				ans = 0;
+	for (auto it = mLevels.begin(), end = mLevels.end(); it != end; ++it) ans += it->mData.size();
+	return ans;
+}
+
+/**
+ * Free functions
+ */
+bool isCompressedTextureFile(const std::string& filename) {
+	try {
+		std::string		ext = Poco::Path(filename).getExtension();
+		Poco::toLowerInPlace(ext);
+		return ext == "dds" || ext == "ktx";
+	} catch (std::exception const&) {
+	}
+	return false;
+}
+
+bool isBlockCompressedFormat(const GLenum fmt) {
+	return getBlockBytes(fmt) > 0;
+}
+
+size_t getBlockBytes(const GLenum fmt) {
+	switch (fmt) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RED_RGTC1:
+		case GL_COMPRESSED_RGB8_ETC2:
+		case GL_COMPRESSED_SRGB8_ETC2:
+		case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+			return 8;
+		case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RG_RGTC2:
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+		case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+		case GL_COMPRESSED_RGBA8_ETC2_EAC:
+		case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+size_t getLevelBytes(const GLenum fmt, const int width, const int height) {
+	if (width < 1 || height < 1) return 0;
+	const size_t		bw = static_cast<size_t>((width + 3) / 4),
+						bh = static_cast<size_t>((height + 3) / 4);
+	return bw * bh * getBlockBytes(fmt);
+}
+
+std::string getCompressedFormatName(const GLenum fmt) {
+	switch (fmt) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:				return "BC1 (RGB)";
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:				return "BC1";
+		case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:				return "BC2";
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:				return "BC3";
+		case GL_COMPRESSED_RED_RGTC1:						return "BC4";
+		case GL_COMPRESSED_RG_RGTC2:						return "BC5";
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:					return "BC7";
+		case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:			return "BC7 (sRGB)";
+		case GL_COMPRESSED_RGB8_ETC2:						return "ETC2 RGB";
+		case GL_COMPRESSED_SRGB8_ETC2:						return "ETC2 RGB (sRGB)";
+		case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:	return "ETC2 RGB A1";
+		case GL_COMPRESSED_RGBA8_ETC2_EAC:					return "ETC2 RGBA";
+		case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:			return "ETC2 RGBA (sRGB)";
+		default:											return "unknown";
+	}
+}
+
+bool loadCompressedTexture(const std::string& filename, CompressedTextureData& out) {
+	out.clear();
+	if (!isCompressedTextureFile(filename)) return false;
+
+	// Cinder does the container parsing. Without a PBO the levels stay in CPU memory,
+	// so this is still safe off the GL thread.
+	ci::gl::TextureData			td;
+	try {
+		std::string				ext = Poco::Path(filename).getExtension();
+		Poco::toLowerInPlace(ext);
+		if (ext == "dds") ci::gl::parseDds(ci::loadFile(filename), &td);
+		else ci::gl::parseKtx(ci::loadFile(filename), &td);
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING("loadCompressedTexture() can't parse " << filename << " ex=" << ex.what());
+		return false;
+	}
+
+	// Only plain, block compressed 2D textures
+	const GLenum				fmt = static_cast<GLenum>(td.getInternalFormat());
+	if (!isBlockCompressedFormat(fmt) || td.getDepth() > 1 || td.getLevels().empty()) return false;
+
+	out.mInternalFormat = fmt;
+	out.mWidth = td.getWidth();
+	out.mHeight = td.getHeight();
+	for (auto it = td.getLevels().begin(), end = td.getLevels().end(); it != end; ++it) {
+		if (it->getFaces().size() != 1) {
+			out.clear();
+			return false;
+		}
+		const ci::gl::TextureData::Face&	face = it->getFaces().front();
+		const uint8_t*			src = static_cast<const uint8_t*>(td.getDataStorePtr(face.offset));
+		if (face.dataSize != getLevelBytes(fmt, it->width, it->height)) break;
+		out.mLevels.push_back(CompressedTextureData::Level());
+		CompressedTextureData::Level&	lvl = out.mLevels.back();
+		lvl.mWidth = it->width;
+		lvl.mHeight = it->height;
+		lvl.mData.assign(src, src + face.dataSize);
+	}
+	if (out.mLevels.empty()) {
+		out.clear();
+		return false;
+	}
+	return true;
+}
+
+bool readCompressedTextureSize(const std::string& filename, int& outWidth, int& outHeight) {
+	std::ifstream				file(filename, std::ios_base::binary | std::ios_base::in);
+	if (!file.is_open() || !file) return false;
+
+	uint8_t						hdr[4 + DDS_HEADER_SIZE];
+	file.read(reinterpret_cast<char*>(hdr), sizeof(hdr));
+	const size_t				len = static_cast<size_t>(file.gcount());
+	if (len >= sizeof(hdr) && read_u32(hdr) == DDS_MAGIC) {
+		outHeight = static_cast<int>(read_u32(hdr + 4 + 8));
+		outWidth = static_cast<int>(read_u32(hdr + 4 + 12));
+		return outWidth > 0 && outHeight > 0;
+	}
+	if (len >= KTX_HEADER_SIZE && memcmp(hdr, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0) {
+		const bool				swap = (read_u32(hdr + 12) != KTX_ENDIAN_REF);
+		outWidth = static_cast<int>(read_u32(hdr + 12 + 24, swap));
+		outHeight = static_cast<int>(read_u32(hdr + 12 + 28, swap));
+		return outWidth > 0 && outHeight > 0;
+	}
+	return false;
+}
+
+bool writeDds(const std::string& filename, const CompressedTextureData& data) {
+	if (data.empty()) return false;
+
+	const uint32_t				fourCC = four_cc_from_format(data.mInternalFormat);
+	uint32_t					dxgi = 0;
+	if (data.mInternalFormat == GL_COMPRESSED_RGBA_BPTC_UNORM) dxgi = DXGI_BC7_UNORM;
+	else if (data.mInternalFormat == GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM) dxgi = DXGI_BC7_UNORM_SRGB;
+	if (fourCC == 0 && dxgi == 0) {
+		DS_LOG_WARNING("writeDds() unsupported format " << getCompressedFormatName(data.mInternalFormat));
+		return false;
+	}
+
+	const size_t				headerSize = 4 + DDS_HEADER_SIZE + (dxgi != 0 ? DDS_DX10_HEADER_SIZE : 0);
+	std::vector<uint8_t>		hdr(headerSize, 0);
+	const uint32_t				mips = static_cast<uint32_t>(data.mLevels.size());
+	write_u32(hdr, 0, DDS_MAGIC);
+	write_u32(hdr, 4, static_cast<uint32_t>(DDS_HEADER_SIZE));
+	write_u32(hdr, 8, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE | (mips > 1 ? DDSD_MIPMAPCOUNT : 0));
+	write_u32(hdr, 12, static_cast<uint32_t>(data.mHeight));
+	write_u32(hdr, 16, static_cast<uint32_t>(data.mWidth));
+	write_u32(hdr, 20, static_cast<uint32_t>(data.mLevels.front().mData.size()));
+	write_u32(hdr, 28, mips);
+	// pixel format
+	write_u32(hdr, 76, 32);
+	write_u32(hdr, 80, DDPF_FOURCC);
+	write_u32(hdr, 84, dxgi != 0 ? make_four_cc('D', 'X', '1', '0') : fourCC);
+	write_u32(hdr, 108, DDSCAPS_TEXTURE | (mips > 1 ? (DDSCAPS_COMPLEX | DDSCAPS_MIPMAP) : 0));
+	if (dxgi != 0) {
+		write_u32(hdr, 128, dxgi);
+		write_u32(hdr, 132, D3D10_RESOURCE_DIMENSION_TEXTURE2D);
+		write_u32(hdr, 140, 1);
+	}
+
+	std::ofstream				file(filename, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+	if (!file.is_open() || !file) return false;
+	file.write(reinterpret_cast<const char*>(hdr.data()), hdr.size());
+	for (auto it = data.mLevels.begin(), end = data.mLevels.end(); it != end; ++it) {
+		file.write(reinterpret_cast<const char*>(it->mData.data()), it->mData.size());
+	}
+	return file.good();
+}
+
+ci::gl::TextureRef createCompressedTexture(const CompressedTextureData& data, const bool mipmaps) {
+	if (data.empty()) return nullptr;
+
+	GLuint						id = 0;
+	glGenTextures(1, &id);
+	if (id == 0) return nullptr;
+
+	const GLint					levels = mipmaps ? static_cast<GLint>(data.mLevels.size()) : 1;
+	{
+		ci::gl::ScopedTextureBind	bind(GL_TEXTURE_2D, id);
+		for (GLint i = 0; i < levels; ++i) {
+			const CompressedTextureData::Level&	lvl = data.mLevels[i];
+			glCompressedTexImage2D(GL_TEXTURE_2D, i, data.mInternalFormat, lvl.mWidth, lvl.mHeight, 0,
+								   static_cast<GLsizei>(lvl.mData.size()), lvl.mData.data());
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	// The texture takes ownership of the id, so it's disposed with the ref.
+	return ci::gl::Texture2d::create(GL_TEXTURE_2D, id, data.mWidth, data.mHeight, false);
+}
+
+} // namespace gl
+} // namespace ds
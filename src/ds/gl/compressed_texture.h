@@ -0,0 +1,111 @@
+#pragma once
+#ifndef DS_GL_COMPRESSEDTEXTURE_H_
+#define DS_GL_COMPRESSEDTEXTURE_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <cinder/gl/gl.h>
+#include <cinder/gl/Texture.h>
+
+// Not every GL loader exposes the extension formats, so supply them here.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT			0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT		0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT		0x83F2
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT		0x83F3
+#endif
+#ifndef GL_COMPRESSED_RED_RGTC1
+#define GL_COMPRESSED_RED_RGTC1					0x8DBB
+#endif
+#ifndef GL_COMPRESSED_RG_RGTC2
+#define GL_COMPRESSED_RG_RGTC2					0x8DBD
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM			0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM		0x8E8D
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2					0x9274
+#endif
+#ifndef GL_COMPRESSED_SRGB8_ETC2
+#define GL_COMPRESSED_SRGB8_ETC2				0x9275
+#endif
+#ifndef GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2	0x9276
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC			0x9278
+#endif
+#ifndef GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC
+#define GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC		0x9279
+#endif
+
+namespace ds {
+namespace gl {
+
+/**
+ * \class ds::gl::CompressedTextureData
+ * \brief The CPU-side contents of a pre-compressed texture container (DDS or KTX).
+ * Nothing in here touches GL, so containers can be parsed and encoded on a load
+ * thread. Upload the result with createCompressedTexture() on the GL thread.
+ */
+class CompressedTextureData {
+public:
+	struct Level {
+		Level() : mWidth(0), mHeight(0) { }
+		int						mWidth,
+								mHeight;
+		std::vector<uint8_t>	mData;
+	};
+
+	CompressedTextureData();
+
+	bool						empty() const;
+	void						clear();
+	// Total bytes of all mip levels, i.e. what this will cost in VRAM.
+	size_t						getByteSize() const;
+
+	GLenum						mInternalFormat;
+	int							mWidth,
+								mHeight;
+	std::vector<Level>			mLevels;
+};
+
+// Answer true if the file extension is a compressed container I can read (.dds, .ktx).
+bool							isCompressedTextureFile(const std::string& filename);
+
+// Answer true if the GL format is one of the 4x4 block formats I know about
+// (BC1-BC5, BC7, ETC2/EAC).
+bool							isBlockCompressedFormat(const GLenum internalFormat);
+// Bytes per 4x4 block for the format (8 or 16), or 0 if unsupported.
+size_t							getBlockBytes(const GLenum internalFormat);
+// Bytes for a single level of the given size.
+size_t							getLevelBytes(const GLenum internalFormat, const int width, const int height);
+// Human readable name, for logging.
+std::string						getCompressedFormatName(const GLenum internalFormat);
+
+// Read a container with cinder's DDS / KTX parsers. Safe to call from any thread.
+bool							loadCompressedTexture(const std::string& filename, CompressedTextureData&);
+// Read just enough of the header to answer the base level size.
+bool							readCompressedTextureSize(const std::string& filename, int& outWidth, int& outHeight);
+
+// Write a DDS container (DX10 header for BC7, legacy FourCC otherwise). Safe to call from any thread.
+bool							writeDds(const std::string& filename, const CompressedTextureData&);
+
+// Upload to a new texture. Must be called on a thread with a current GL context. If
+// mipmaps is false only the base level is uploaded. GL errors are left for the caller to query.
+ci::gl::TextureRef				createCompressedTexture(const CompressedTextureData&, const bool mipmaps);
+
+} // namespace gl
+} // namespace ds
+
+#endif // DS_GL_COMPRESSEDTEXTURE_H_
@@ -147,6 +147,7 @@ HttpClient::Request::Request(const void* clientId)
 	: WorkRequest(clientId)
 	, mOpt(HTTP_GET_OPT)
 {
+	setLane(LANE_IO);
 }
 
 void HttpClient::Request::run() {
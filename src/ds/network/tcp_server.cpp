@@ -75,9 +75,9 @@ namespace {
 		void		receiveFrom(Poco::Net::StreamSocket& socket) {
 			int					n = 0;
 			while ((n = socket.receiveBytes(mBuffer, sizeof(mBuffer))) > 0) {
-				const std::string	incoming(mBuffer, n);
+				std::string			incoming(mBuffer, n);
 				if (mTerminator.empty()) {
-					mReceiveQueue->push(incoming);
+					mReceiveQueue->push(std::move(incoming));
 				} else {
 					mWaiting += incoming;
 					std::vector<std::string> all;
@@ -91,7 +91,7 @@ namespace {
 					}
 					for (auto it=all.begin(), end=all.end(); it!=end; ++it) {
 						if (it->empty()) continue;
-						mReceiveQueue->push(*it);
+						mReceiveQueue->push(std::move(*it));
 					}
 				}
 			}
@@ -96,6 +96,7 @@ Client::Request::Request(const void* clientId)
 	: WorkRequest(clientId)
 	, mRunId(0)
 {
+	setLane(LANE_IO);
 	mDatabase.reserve(128);
 	mQuery.reserve(256);
 }
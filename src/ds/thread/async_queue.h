@@ -2,9 +2,10 @@
 #ifndef DS_THREAD_ASYNCQUEUE_H_
 #define DS_THREAD_ASYNCQUEUE_H_
 
+#include <atomic>
+#include <cstddef>
 #include <functional>
 #include <vector>
-#include <Poco/Mutex.h>
 
 namespace ds {
 
@@ -12,42 +13,114 @@ namespace ds {
  * \class ds::AsyncQueue
  * \brief Thread-safe utility for clients to push entries on a queue, and other clients to pull them.
  * I do no memory management, so don't use pointers.
+ *
+ * Lock-free: any number of threads can push, a single thread updates. Entries are
+ * moved, not copied, and must be default constructible. With a capacity, pushes
+ * onto a full queue are dropped and counted.
  */
 template <typename T>
 class AsyncQueue {
 public:
-	AsyncQueue();
+	// A capacity of 0 is unbounded.
+	AsyncQueue(const size_t capacity = 0);
+	~AsyncQueue();
 
-	// Push can be called from any thread
-	void					push(const T&);
+	// Push can be called from any thread. Answers false if the queue is full.
+	bool					push(const T&);
+	bool					push(T&&);
 	// Update must be called from a single main update thread (generally the UI thread).
 	// If there have been any messages added, it replies with them. Alternatively, if
 	// an update handler is provided, it runs each message on it.
 	const std::vector<T>*	update(const std::function<void(const T&)>& = nullptr);
 
+	// Diagnostics. Can be called from any thread; the answers are approximate
+	// while other threads are pushing.
+	size_t					getCapacity() const		{ return mCapacity; }
+	size_t					getDepth() const		{ return mDepth.load(std::memory_order_relaxed); }
+	// The deepest the queue has been since the last reset.
+	size_t					getHighWater() const	{ return mHighWater.load(std::memory_order_relaxed); }
+	void					resetHighWater()		{ mHighWater.store(getDepth(), std::memory_order_relaxed); }
+	// Number of pushes rejected because the queue was full.
+	size_t					getDropped() const		{ return mDropped.load(std::memory_order_relaxed); }
+
 private:
 	AsyncQueue(const AsyncQueue&);
+	AsyncQueue&				operator=(const AsyncQueue&);
+
+	struct Node {
+		Node() : mNext(nullptr) { }
+		std::atomic<Node*>	mNext;
+		T					mValue;
+	};
 
-	Poco::Mutex				mMutex;
-	std::vector<T>			mLockedQueue;
+	// Reserve a slot for a push. Answers false if full.
+	bool					reserve();
+	void					link(Node*);
+	// Take the oldest entry, if a push has finished linking it.
+	bool					pop(T&);
+
+	const size_t			mCapacity;
+	// Producers swap themselves in at the head, the consumer pops from the tail.
+	// The tail is always a dummy node whose value has already been taken.
+	std::atomic<Node*>		mHead;
+	Node*					mTail;
+	std::atomic<size_t>		mDepth,
+							mHighWater,
+							mDropped;
 	std::vector<T>			mUpdateQueue;
 };
 
 template <typename T>
-AsyncQueue<T>::AsyncQueue()
+AsyncQueue<T>::AsyncQueue(const size_t capacity)
+	: mCapacity(capacity)
+	, mHead(nullptr)
+	, mTail(new Node())
+	, mDepth(0)
+	, mHighWater(0)
+	, mDropped(0)
 {
-	mLockedQueue.reserve(16);
+	mHead.store(mTail);
 	mUpdateQueue.reserve(16);
 }
 
 template <typename T>
-void AsyncQueue<T>::push(const T& t)
+AsyncQueue<T>::~AsyncQueue()
+{
+	while (mTail) {
+		Node*				next = mTail->mNext.load(std::memory_order_relaxed);
+		delete mTail;
+		mTail = next;
+	}
+}
+
+template <typename T>
+bool AsyncQueue<T>::push(const T& t)
+{
+	if (!reserve()) return false;
+	try {
+		Node*				n = new Node();
+		n->mValue = t;
+		link(n);
+		return true;
+	} catch (std::exception const&) {
+	}
+	--mDepth;
+	return false;
+}
+
+template <typename T>
+bool AsyncQueue<T>::push(T&& t)
 {
+	if (!reserve()) return false;
 	try {
-		Poco::Mutex::ScopedLock   l(mMutex);
-		mLockedQueue.push_back(t);
+		Node*				n = new Node();
+		n->mValue = std::move(t);
+		link(n);
+		return true;
 	} catch (std::exception const&) {
 	}
+	--mDepth;
+	return false;
 }
 
 template <typename T>
@@ -55,10 +128,9 @@ const std::vector<T>* AsyncQueue<T>::update(const std::function<void(const T&)>&
 {
 	try {
 		mUpdateQueue.clear();
-		{
-			Poco::Mutex::ScopedLock   l(mMutex);
-			mUpdateQueue = mLockedQueue;
-			mLockedQueue.clear();
+		T					t;
+		while (pop(t)) {
+			mUpdateQueue.push_back(std::move(t));
 		}
 		if (mUpdateQueue.empty()) return nullptr;
 
@@ -75,6 +147,42 @@ const std::vector<T>* AsyncQueue<T>::update(const std::function<void(const T&)>&
 	return nullptr;
 }
 
+template <typename T>
+bool AsyncQueue<T>::reserve()
+{
+	const size_t			depth = ++mDepth;
+	if (mCapacity > 0 && depth > mCapacity) {
+		--mDepth;
+		++mDropped;
+		return false;
+	}
+	size_t					high = mHighWater.load(std::memory_order_relaxed);
+	while (depth > high && !mHighWater.compare_exchange_weak(high, depth, std::memory_order_relaxed)) {
+	}
+	return true;
+}
+
+template <typename T>
+void AsyncQueue<T>::link(Node* n)
+{
+	// Between the exchange and the store the list is briefly broken; the
+	// consumer just stops there and picks the rest up next update.
+	Node*					prev = mHead.exchange(n, std::memory_order_acq_rel);
+	prev->mNext.store(n, std::memory_order_release);
+}
+
+template <typename T>
+bool AsyncQueue<T>::pop(T& out)
+{
+	Node*					next = mTail->mNext.load(std::memory_order_acquire);
+	if (!next) return false;
+	out = std::move(next->mValue);
+	delete mTail;
+	mTail = next;
+	--mDepth;
+	return true;
+}
+
 } // namespace ds
 
 #endif // DS_THREAD_ASYNCQUEUE_H_
@@ -0,0 +1,356 @@
+#include "stdafx.h"
+
+#include "ds/thread/gl_upload_pool.h"
+
+#include <algorithm>
+#include <cinder/gl/Context.h>
+#include <cinder/gl/gl.h>
+#include "ds/debug/logger.h"
+
+namespace ds {
+
+namespace {
+const ds::BitMask		GLUPLOAD_LOG_M = ds::Logger::newModule("gl_upload");
+
+class CinderContext : public GlUploadContext {
+public:
+	CinderContext(const ci::gl::ContextRef& c) : mContext(c) { }
+
+	virtual void		makeCurrent() {
+		mContext->makeCurrent();
+	}
+
+	virtual void*		fence() {
+		GLsync			s = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+		return s;
+	}
+
+private:
+	ci::gl::ContextRef	mContext;
+};
+
+class CinderDevice : public GlUploadDevice {
+public:
+	virtual std::unique_ptr<GlUploadContext>
+						createContext() {
+		ci::gl::Context*	main = ci::gl::context();
+		if (!main) return nullptr;
+		ci::gl::ContextRef	c = ci::gl::Context::create(main);
+		// Creating a context can leave it current
+		main->makeCurrent();
+		if (!c) return nullptr;
+		return std::unique_ptr<GlUploadContext>(new CinderContext(c));
+	}
+
+	virtual bool		isSignaled(void* fence) {
+		// A failed wait will never pass, so let those go too.
+		return glClientWaitSync(static_cast<GLsync>(fence), 0, 0) != GL_TIMEOUT_EXPIRED;
+	}
+
+	virtual void		deleteFence(void* fence) {
+		glDeleteSync(static_cast<GLsync>(fence));
+	}
+};
+
+}
+
+/**
+ * \class ds::GlUploadPool
+ */
+GlUploadPool::GlUploadPool()
+	: mAbort(false)
+	, mStarted(0)
+{
+	mPending.reserve(16);
+	mReady.reserve(16);
+}
+
+GlUploadPool::~GlUploadPool()
+{
+	stop();
+}
+
+void GlUploadPool::setDevice(std::unique_ptr<GlUploadDevice> d)
+{
+	if (!mWorkers.empty()) {
+		DS_LOG_WARNING_M("GlUploadPool::setDevice() called while running", GLUPLOAD_LOG_M);
+		return;
+	}
+	mDevice = std::move(d);
+}
+
+void GlUploadPool::start(const int threadCount)
+{
+	if (!mWorkers.empty()) {
+		DS_LOG_WARNING_M("GlUploadPool::start() already running", GLUPLOAD_LOG_M);
+		return;
+	}
+	if (threadCount < 1) return;
+	if (!mDevice) mDevice.reset(new CinderDevice());
+
+	std::vector<std::unique_ptr<Worker>>	workers;
+	for (int k = 0; k < threadCount; ++k) {
+		std::unique_ptr<GlUploadContext>	c;
+		try {
+			c = mDevice->createContext();
+		} catch (std::exception const& ex) {
+			DS_LOG_WARNING_M("GlUploadPool::start() context error=" << ex.what(), GLUPLOAD_LOG_M);
+		}
+		if (!c) {
+			DS_LOG_WARNING_M("GlUploadPool::start() could only create " << k << " of " << threadCount << " shared contexts", GLUPLOAD_LOG_M);
+			break;
+		}
+		workers.push_back(std::unique_ptr<Worker>(new Worker(*this, std::move(c))));
+	}
+	if (workers.empty()) return;
+
+	Poco::Mutex::ScopedLock				l(mMutex);
+	mWorkers.swap(workers);
+	mAbort = false;
+	mStarted = 0;
+	for (auto it = mWorkers.begin(), end = mWorkers.end(); it != end; ++it) {
+		(*it)->mThread.setName("ds_gl_upload");
+		(*it)->mThread.start(*(it->get()));
+	}
+	// Don't let the main thread get back to drawing while the workers are making their contexts current
+	while (mStarted < static_cast<int>(mWorkers.size())) mIdleCondition.wait(mMutex);
+}
+
+void GlUploadPool::stop()
+{
+	{
+		Poco::Mutex::ScopedLock			l(mMutex);
+		if (mWorkers.empty()) return;
+		mAbort = true;
+		mCondition.broadcast();
+	}
+	for (auto it = mWorkers.begin(), end = mWorkers.end(); it != end; ++it) {
+		try {
+			if ((*it)->mThread.isRunning()) (*it)->mThread.join();
+		} catch (std::exception const&) {
+		}
+	}
+
+	std::vector<std::unique_ptr<Worker>>	workers;
+	{
+		Poco::Mutex::ScopedLock			l(mMutex);
+		workers.swap(mWorkers);
+		mAbort = false;
+		mPending.insert(mPending.end(), mDone.begin(), mDone.end());
+		mDone.clear();
+	}
+	for (auto it = mPending.begin(), end = mPending.end(); it != end; ++it) {
+		deleteFence(**it);
+	}
+	mPending.clear();
+}
+
+void GlUploadPool::upload(const void* owner, const std::function<void()>& work, const std::function<void()>& onMain)
+{
+	JobRef				j(new Job());
+	j->mOwner = owner;
+	j->mWork = work;
+	j->mOnMain = onMain;
+	send(j);
+}
+
+void GlUploadPool::uploadSerial(const void* owner, const std::function<void()>& work,
+								const std::function<void()>& onMain, const bool coalesce)
+{
+	JobRef				j(new Job());
+	j->mOwner = owner;
+	j->mSerial = true;
+	j->mCoalesce = coalesce;
+	j->mWork = work;
+	j->mOnMain = onMain;
+	send(j);
+}
+
+void GlUploadPool::cancel(const void* owner)
+{
+	{
+		Poco::Mutex::ScopedLock			l(mMutex);
+		mWaiting.erase(std::remove_if(mWaiting.begin(), mWaiting.end(),
+				[owner](const JobRef& j) { return j->mOwner == owner; }), mWaiting.end());
+		for (auto it = mRunning.begin(), end = mRunning.end(); it != end; ++it) {
+			if ((*it)->mOwner == owner) (*it)->mCancelled = true;
+		}
+		for (auto it = mDone.begin(), end = mDone.end(); it != end; ++it) {
+			if ((*it)->mOwner == owner) (*it)->mCancelled = true;
+		}
+		if (mWaiting.empty() && mRunning.empty()) mIdleCondition.broadcast();
+	}
+	for (auto it = mPending.begin(), end = mPending.end(); it != end; ++it) {
+		if ((*it)->mOwner == owner) (*it)->mCancelled = true;
+	}
+	for (auto it = mReady.begin(), end = mReady.end(); it != end; ++it) {
+		if ((*it)->mOwner == owner) (*it)->mCancelled = true;
+	}
+}
+
+void GlUploadPool::waitForIdle()
+{
+	Poco::Mutex::ScopedLock				l(mMutex);
+	while (!mWaiting.empty() || !mRunning.empty()) mIdleCondition.wait(mMutex);
+}
+
+void GlUploadPool::update()
+{
+	{
+		Poco::Mutex::ScopedLock			l(mMutex);
+		if (!mDone.empty()) {
+			mPending.insert(mPending.end(), mDone.begin(), mDone.end());
+			mDone.clear();
+		}
+	}
+	if (mPending.empty()) return;
+
+	for (auto it = mPending.begin(); it != mPending.end(); ) {
+		Job&							j = **it;
+		if (!j.mCancelled && j.mFence && !mDevice->isSignaled(j.mFence)) {
+			++it;
+			continue;
+		}
+		deleteFence(j);
+		if (!j.mCancelled) mReady.push_back(*it);
+		it = mPending.erase(it);
+	}
+
+	// Callbacks can send and cancel jobs, so they only run once the pending list is settled.
+	for (size_t k = 0; k < mReady.size(); ++k) {
+		Job&							j = *mReady[k];
+		if (j.mCancelled) continue;
+		try {
+			j.mOnMain();
+		} catch (std::exception const& ex) {
+			DS_LOG_WARNING_M("GlUploadPool::update() callback error=" << ex.what(), GLUPLOAD_LOG_M);
+		}
+	}
+	mReady.clear();
+}
+
+void GlUploadPool::send(const JobRef& j)
+{
+	{
+		Poco::Mutex::ScopedLock			l(mMutex);
+		if (!mWorkers.empty() && !mAbort) {
+			if (j->mCoalesce) {
+				for (auto it = mWaiting.rbegin(), end = mWaiting.rend(); it != end; ++it) {
+					if ((*it)->mOwner != j->mOwner || !(*it)->mSerial) continue;
+					if ((*it)->mCoalesce) {
+						*it = j;
+						return;
+					}
+					break;
+				}
+			}
+			mWaiting.push_back(j);
+			mCondition.signal();
+			return;
+		}
+	}
+
+	// No workers, so do it here
+	try {
+		if (j->mWork) j->mWork();
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING_M("GlUploadPool job error=" << ex.what(), GLUPLOAD_LOG_M);
+	}
+	if (!j->mOnMain) return;
+	Poco::Mutex::ScopedLock				l(mMutex);
+	mDone.push_back(j);
+}
+
+GlUploadPool::JobRef GlUploadPool::takeLocked()
+{
+	for (auto it = mWaiting.begin(), end = mWaiting.end(); it != end; ++it) {
+		const JobRef&					j = *it;
+		if (j->mSerial) {
+			const void*					owner = j->mOwner;
+			auto						busy = std::find_if(mRunning.begin(), mRunning.end(),
+					[owner](const JobRef& r) { return r->mSerial && r->mOwner == owner; });
+			if (busy != mRunning.end()) continue;
+		}
+		JobRef							ans(j);
+		mWaiting.erase(it);
+		mRunning.push_back(ans);
+		return ans;
+	}
+	return nullptr;
+}
+
+void GlUploadPool::finishLocked(const JobRef& j)
+{
+	mRunning.erase(std::remove(mRunning.begin(), mRunning.end(), j), mRunning.end());
+	// Cancelled jobs still go through, so their fences get deleted on the main thread.
+	if (j->mOnMain) mDone.push_back(j);
+	// Stopping workers might be waiting on this one to free up a serial job, or to run out of jobs
+	if (mAbort) mCondition.broadcast();
+	if (mWaiting.empty() && mRunning.empty()) mIdleCondition.broadcast();
+}
+
+void GlUploadPool::deleteFence(Job& j)
+{
+	if (!j.mFence) return;
+	if (mDevice) mDevice->deleteFence(j.mFence);
+	j.mFence = nullptr;
+}
+
+/**
+ * \class ds::GlUploadPool::Job
+ */
+GlUploadPool::Job::Job()
+	: mOwner(nullptr)
+	, mSerial(false)
+	, mCoalesce(false)
+	, mCancelled(false)
+	, mFence(nullptr)
+{
+}
+
+/**
+ * \class ds::GlUploadPool::Worker
+ */
+GlUploadPool::Worker::Worker(GlUploadPool& p, std::unique_ptr<GlUploadContext> c)
+	: mPool(p)
+	, mContext(std::move(c))
+{
+}
+
+void GlUploadPool::Worker::run()
+{
+	mContext->makeCurrent();
+
+	mPool.mMutex.lock();
+	++mPool.mStarted;
+	mPool.mIdleCondition.broadcast();
+	while (true) {
+		JobRef							j = mPool.takeLocked();
+		if (!j) {
+			// Anything still waiting when stopped gets run first, since
+			// clients can hand off cleanup that has to happen.
+			if (mPool.mAbort && mPool.mWaiting.empty()) break;
+			mPool.mCondition.wait(mPool.mMutex);
+			continue;
+		}
+		mPool.mMutex.unlock();
+
+		try {
+			if (j->mWork) j->mWork();
+		} catch (std::exception const& ex) {
+			DS_LOG_WARNING_M("GlUploadPool job error=" << ex.what(), GLUPLOAD_LOG_M);
+		}
+		// Only jobs with a callback need to know when the GPU is done with them
+		if (j->mOnMain) j->mFence = mContext->fence();
+
+		mPool.mMutex.lock();
+		mPool.finishLocked(j);
+	}
+	mPool.mMutex.unlock();
+
+	// The context has to go on the thread that used it
+	mContext.reset();
+}
+
+} // namespace ds
@@ -0,0 +1,152 @@
+#pragma once
+#ifndef DS_THREAD_GLUPLOADPOOL_H_
+#define DS_THREAD_GLUPLOADPOOL_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <Poco/Condition.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+
+namespace ds {
+
+/**
+ * \class ds::GlUploadContext
+ * \brief A single worker's GL context. Created on the main thread, used and
+ * destroyed on the worker.
+ */
+class GlUploadContext {
+public:
+	virtual ~GlUploadContext()			{ }
+
+	virtual void				makeCurrent() = 0;
+	// Fence everything issued so far, and flush so other contexts can see the fence.
+	virtual void*				fence() = 0;
+};
+
+/**
+ * \class ds::GlUploadDevice
+ * \brief Where the pool gets its contexts and checks its fences. The default
+ * makes contexts that share with the main cinder context; supply another to
+ * run the pool somewhere without GL.
+ */
+class GlUploadDevice {
+public:
+	virtual ~GlUploadDevice()			{ }
+
+	// Main thread. Answer a context that shares objects with the main one, or nothing.
+	virtual std::unique_ptr<GlUploadContext>
+								createContext() = 0;
+	// Main thread. Answer true once the GPU is past the fence. Must not block.
+	virtual bool				isSignaled(void* fence) = 0;
+	virtual void				deleteFence(void* fence) = 0;
+};
+
+/**
+ * \class ds::GlUploadPool
+ * \brief A few worker threads with shared GL contexts, for creating textures,
+ * uploading pixels and rendering into FBOs off the render thread. The GL work
+ * of each job is fenced, and the job's main thread callback only runs once the
+ * GPU is past the fence, so whatever it hands over is ready to draw.
+ *
+ * Jobs are tagged with an owner, so a client can cancel() its callbacks before
+ * it goes away. Serial jobs run one at a time in the order they were sent,
+ * per owner; everything else runs on whichever worker is free.
+ *
+ * Without threads (before start(), after stop(), or when no context could be
+ * made) jobs run right away on the calling thread, and their callbacks wait
+ * for the next update().
+ */
+class GlUploadPool {
+public:
+	GlUploadPool();
+	~GlUploadPool();
+
+	// Replace the default device. Only before start().
+	void						setDevice(std::unique_ptr<GlUploadDevice>);
+	// Main thread, once GL is set up. A count of 0 keeps everything on the calling thread.
+	void						start(const int threadCount);
+	// Run any jobs still waiting, then stop the threads. Callbacks that haven't run are dropped.
+	void						stop();
+	bool						isRunning() const		{ return !mWorkers.empty(); }
+
+	// Run work on a worker, then onMain on the main thread once its GL work is done.
+	// Can be called from any thread.
+	void						upload(const void* owner, const std::function<void()>& work,
+									   const std::function<void()>& onMain = nullptr);
+	// The same, but in order with the owner's other serial jobs. If coalesce is true,
+	// this replaces the owner's last coalescing job, if it hasn't started yet.
+	void						uploadSerial(const void* owner, const std::function<void()>& work,
+											 const std::function<void()>& onMain = nullptr, const bool coalesce = false);
+	// Main thread. Drop the owner's jobs that haven't started, and every callback
+	// it has coming. Jobs already running finish, but their callbacks never run.
+	void						cancel(const void* owner);
+	// Main thread. Block until every job sent so far has run.
+	void						waitForIdle();
+
+	// Main thread. Run the callbacks whose fences have passed.
+	void						update();
+
+private:
+	GlUploadPool(const GlUploadPool&);
+	GlUploadPool&				operator=(const GlUploadPool&);
+
+	struct Job {
+		Job();
+
+		const void*				mOwner;
+		bool					mSerial;
+		bool					mCoalesce;
+		bool					mCancelled;
+		std::function<void()>	mWork;
+		std::function<void()>	mOnMain;
+		void*					mFence;
+	};
+	typedef std::shared_ptr<Job>	JobRef;
+
+	class Worker : public Poco::Runnable {
+	public:
+		Worker(GlUploadPool&, std::unique_ptr<GlUploadContext>);
+
+		virtual void			run();
+
+		Poco::Thread			mThread;
+
+	private:
+		GlUploadPool&			mPool;
+		std::unique_ptr<GlUploadContext>
+								mContext;
+	};
+
+	void						send(const JobRef&);
+	// Take the first job that can run now. Answers nothing when there isn't one.
+	JobRef						takeLocked();
+	void						finishLocked(const JobRef&);
+	void						deleteFence(Job&);
+
+	std::unique_ptr<GlUploadDevice>
+								mDevice;
+	std::vector<std::unique_ptr<Worker>>
+								mWorkers;
+
+	Poco::Mutex					mMutex;
+	// Workers wait on this for jobs, everyone else on mIdleCondition
+	Poco::Condition				mCondition;
+	Poco::Condition				mIdleCondition;
+	bool						mAbort;
+	int							mStarted;
+	std::deque<JobRef>			mWaiting;
+	std::vector<JobRef>			mRunning;
+	std::vector<JobRef>			mDone;
+
+	// MAIN THREAD. Finished jobs waiting on their fences.
+	std::vector<JobRef>			mPending;
+	std::vector<JobRef>			mReady;
+};
+
+} // namespace ds
+
+#endif // DS_THREAD_GLUPLOADPOOL_H_
@@ -0,0 +1,103 @@
+#include "stdafx.h"
+
+#include "ds/thread/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <vector>
+#include <Poco/Environment.h>
+#include <Poco/Event.h>
+#include <Poco/Exception.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/ThreadPool.h>
+
+namespace ds {
+
+namespace {
+
+class ForJob {
+public:
+	ForJob(const int count, const std::function<void(const int)>& fn)
+			: mCount(count)
+			, mFn(fn)
+			, mNext(0)
+			, mOutstanding(1) {
+	}
+
+	// Pull items until there are none left.
+	void				work() {
+		try {
+			for (;;) {
+				const int	index = mNext++;
+				if (index >= mCount) return;
+				mFn(index);
+			}
+		} catch (...) {
+			Poco::Mutex::ScopedLock		l(mMutex);
+			if (!mError) mError = std::current_exception();
+			mNext = mCount;
+		}
+	}
+
+	// Answer true when the last worker is finished.
+	bool				release() {
+		return --mOutstanding == 0;
+	}
+
+	const int							mCount;
+	const std::function<void(const int)>&	mFn;
+	std::atomic<int>					mNext;
+	std::atomic<int>					mOutstanding;
+	Poco::Event							mDone;
+	Poco::Mutex							mMutex;
+	std::exception_ptr					mError;
+};
+
+class ForRunner : public Poco::Runnable {
+public:
+	ForRunner(ForJob& job) : mJob(job) {
+	}
+
+	virtual void		run() {
+		mJob.work();
+		if (mJob.release()) mJob.mDone.set();
+	}
+
+private:
+	ForJob&				mJob;
+};
+
+} // anonymous namespace
+
+void parallel_for(const int count, const std::function<void(const int)>& fn) {
+	if (count < 1 || !fn) return;
+
+	ForJob							job(count, fn);
+	std::vector<std::unique_ptr<ForRunner>>	runners;
+	if (count > 1) {
+		Poco::ThreadPool&			pool = Poco::ThreadPool::defaultPool();
+		const int					helpers = std::min(std::min(pool.available(), count - 1),
+													   static_cast<int>(Poco::Environment::processorCount()) - 1);
+		for (int k = 0; k < helpers; ++k) {
+			runners.push_back(std::unique_ptr<ForRunner>(new ForRunner(job)));
+			++job.mOutstanding;
+			try {
+				pool.start(*runners.back());
+			} catch (Poco::NoThreadAvailableException const&) {
+				--job.mOutstanding;
+				runners.pop_back();
+				break;
+			}
+		}
+	}
+
+	// Helpers reference the job, so wait for them even if this thread fails.
+	job.work();
+	if (!job.release()) job.mDone.wait();
+	if (job.mError) std::rethrow_exception(job.mError);
+}
+
+} // namespace ds
@@ -0,0 +1,22 @@
+#pragma once
+#ifndef DS_THREAD_PARALLELFOR_H_
+#define DS_THREAD_PARALLELFOR_H_
+
+#include <functional>
+
+namespace ds {
+
+/**
+ * Run fn(0) to fn(count - 1), split across the default Poco thread pool.
+ * The calling thread runs items too, and doesn't return until every item
+ * is done. Items run in no particular order. If any item throws, items that
+ * haven't started are skipped and the first exception is rethrown here.
+ *
+ * For short jobs that need to finish this frame; use the WorkManager for
+ * anything that can come back later.
+ */
+void			parallel_for(const int count, const std::function<void(const int)>& fn);
+
+} // namespace ds
+
+#endif // DS_THREAD_PARALLELFOR_H_
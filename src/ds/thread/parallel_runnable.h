@@ -33,6 +33,8 @@ public:
 	// Start a new runnable, intializing it via the handler block.
 	bool							start(const HandlerFunc& = nullptr);
 	void							setReplyHandler(const HandlerFunc& f) { mReplyHandler = f; }
+	// The work manager lane runnables go into. Defaults to WorkRequest::LANE_BACKGROUND.
+	void							setLane(const int lane) { mClient.setLane(lane); }
 
 private:
 	void							receive(std::unique_ptr<Poco::Runnable>&);
@@ -13,6 +13,7 @@ namespace ds {
 RunnableClient::RunnableClient(ui::SpriteEngine& e, const std::function<void(std::unique_ptr<Poco::Runnable>&)>& h)
 	: inherited(e)
 	, mCache(this)
+	, mLane(WorkRequest::LANE_BACKGROUND)
 	, mResultHandler(h)
 {
 }
@@ -30,9 +31,15 @@ bool RunnableClient::run(std::unique_ptr<Poco::Runnable>& payload)
 	if (!r) return false;
 
 	r.get()->mPayload = std::move(payload);
+	r.get()->setLane(mLane);
 	return mManager.sendRequest(ds::unique_dynamic_cast<WorkRequest, Request>(r));
 }
 
+void RunnableClient::setLane(const int lane)
+{
+	mLane = lane;
+}
+
 void RunnableClient::handleResult(std::unique_ptr<WorkRequest>& wr)
 {
 	std::unique_ptr<Request>		r(ds::unique_dynamic_cast<Request, WorkRequest>(wr));
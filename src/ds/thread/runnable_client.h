@@ -22,6 +22,9 @@ public:
 
 	bool						run(std::unique_ptr<Poco::Runnable>&);
 
+	// Runnables go into this lane (see WorkRequest). Defaults to LANE_BACKGROUND.
+	void						setLane(const int lane);
+
 protected:
 	virtual void				handleResult(std::unique_ptr<WorkRequest>&);
 
@@ -38,6 +41,7 @@ private:
 		void					run();
 	};
 	WorkRequestList<Request>	mCache;
+	int							mLane;
 
 	std::function<void(std::unique_ptr<Poco::Runnable>&)>
 								mResultHandler;
@@ -0,0 +1,118 @@
+#include "stdafx.h"
+
+#include "ds/thread/task.h"
+
+#include "ds/util/memory_ds.h"
+#include "ds/thread/work_manager.h"
+
+namespace ds {
+
+/**
+ * \class ds::CancelToken
+ */
+const CancelToken CancelToken::NONE(nullptr);
+
+CancelToken::CancelToken()
+	: mFlag(new std::atomic<bool>(false))
+{
+}
+
+CancelToken::CancelToken(const std::shared_ptr<std::atomic<bool>>& flag)
+	: mFlag(flag)
+{
+}
+
+void CancelToken::cancel()
+{
+	if (mFlag) mFlag->store(true);
+}
+
+bool CancelToken::isCancelled() const
+{
+	return mFlag && mFlag->load();
+}
+
+/**
+ * \class ds::TaskClient
+ */
+TaskClient::TaskClient(ui::SpriteEngine& e)
+	: inherited(e)
+	, mContext(new detail::TaskContext(mManager, this))
+{
+}
+
+TaskClient::TaskClient(WorkManager& m)
+	: inherited(m)
+	, mContext(new detail::TaskContext(mManager, this))
+{
+}
+
+void TaskClient::setLane(const int lane)
+{
+	mContext->mLane = lane;
+}
+
+void TaskClient::post(const std::function<void()>& work)
+{
+	mContext->post(work);
+}
+
+void TaskClient::postToMain(const std::function<void()>& fn)
+{
+	mContext->postToMain(fn);
+}
+
+void TaskClient::handleResult(std::unique_ptr<WorkRequest>& wr)
+{
+	std::unique_ptr<Request>		r(ds::unique_dynamic_cast<Request, WorkRequest>(wr));
+	if (!r || !r->mOnMain) return;
+	r->mOnMain();
+}
+
+/**
+ * \class ds::TaskClient::Request
+ */
+TaskClient::Request::Request(const void* clientId)
+	: WorkRequest(clientId)
+{
+}
+
+void TaskClient::Request::run()
+{
+	if (mWork) mWork();
+}
+
+namespace detail {
+
+/**
+ * \class ds::detail::TaskContext
+ */
+TaskContext::TaskContext(WorkManager& m, const void* clientId)
+	: mLane(WorkRequest::LANE_BACKGROUND)
+	, mManager(m)
+	, mClientId(clientId)
+{
+}
+
+void TaskContext::post(const std::function<void()>& work)
+{
+	if (!work) return;
+	std::unique_ptr<TaskClient::Request>	r(new TaskClient::Request(mClientId));
+	r->mWork = work;
+	r->setLane(mLane);
+	r->setReply(false);
+	mManager.sendRequest(ds::unique_dynamic_cast<WorkRequest, TaskClient::Request>(r));
+}
+
+void TaskContext::postToMain(const std::function<void()>& fn)
+{
+	if (!fn) return;
+	// Nothing to run on a worker, so it goes straight to the output
+	std::unique_ptr<TaskClient::Request>	r(new TaskClient::Request(mClientId));
+	r->mOnMain = fn;
+	mManager.sendResult(ds::unique_dynamic_cast<WorkRequest, TaskClient::Request>(r));
+}
+
+} // namespace detail
+
+} // namespace ds
@@ -0,0 +1,341 @@
+#pragma once
+#ifndef DS_THREAD_TASK_H_
+#define DS_THREAD_TASK_H_
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <Poco/Mutex.h>
+#include "ds/thread/work_client.h"
+
+namespace ds {
+class TaskClient;
+class WorkManager;
+
+/**
+ * \class ds::TaskCancelled
+ * \brief The error a task fails with when its token was cancelled before it ran.
+ */
+class TaskCancelled : public std::exception {
+public:
+	virtual const char*			what() const throw()	{ return "task cancelled"; }
+};
+
+/**
+ * \class ds::CancelToken
+ * \brief Shared flag for cancelling a chain of tasks. Copies share the flag.
+ * Cancelling doesn't interrupt a step that's already running; every step
+ * after that fails with TaskCancelled instead of running.
+ */
+class CancelToken {
+public:
+	// Never cancelled, and cancelling it does nothing. What an empty task answers.
+	static const CancelToken	NONE;
+
+	CancelToken();
+
+	void						cancel();
+	bool						isCancelled() const;
+
+private:
+	explicit CancelToken(const std::shared_ptr<std::atomic<bool>>&);
+
+	std::shared_ptr<std::atomic<bool>>
+								mFlag;
+};
+
+namespace detail {
+
+// What steps need to send more work. Outlives the client, so steps still running
+// when it's destroyed are harmless; the manager drops results for missing clients.
+class TaskContext {
+public:
+	TaskContext(WorkManager&, const void* clientId);
+
+	void						post(const std::function<void()>& work);
+	void						postToMain(const std::function<void()>& fn);
+
+	std::atomic<int>			mLane;
+
+private:
+	WorkManager&				mManager;
+	const void*					mClientId;
+};
+
+// The state a task and all its handles share. Completes exactly once, on whatever
+// thread ran the step, and then runs its continuations on that thread.
+template <typename T>
+class TaskState {
+public:
+	TaskState(const std::shared_ptr<TaskContext>& c, const CancelToken& t) : mContext(c), mToken(t), mDone(false) { }
+
+	void						succeed(const T& v) {
+		std::vector<std::function<void()>>	fns;
+		{
+			Poco::Mutex::ScopedLock			l(mMutex);
+			mValue.reset(new T(v));
+			mDone = true;
+			fns.swap(mContinuations);
+		}
+		run(fns);
+	}
+
+	void						fail(const std::exception_ptr& e) {
+		std::vector<std::function<void()>>	fns;
+		{
+			Poco::Mutex::ScopedLock			l(mMutex);
+			mError = e;
+			mDone = true;
+			fns.swap(mContinuations);
+		}
+		run(fns);
+	}
+
+	// Continuations should only hand work off, they might run on the main thread.
+	void						addContinuation(const std::function<void()>& fn) {
+		{
+			Poco::Mutex::ScopedLock			l(mMutex);
+			if (!mDone) {
+				mContinuations.push_back(fn);
+				return;
+			}
+		}
+		fn();
+	}
+
+	std::shared_ptr<TaskContext>
+								mContext;
+	CancelToken					mToken;
+	// Only read these after the task is done.
+	std::unique_ptr<T>			mValue;
+	std::exception_ptr			mError;
+
+private:
+	void						run(std::vector<std::function<void()>>& fns) {
+		for (auto it = fns.begin(), end = fns.end(); it != end; ++it) (*it)();
+	}
+
+	Poco::Mutex					mMutex;
+	bool						mDone;
+	std::vector<std::function<void()>>
+								mContinuations;
+};
+
+} // namespace detail
+
+/**
+ * \class ds::Task
+ * \brief A value being computed on the work manager's threads. Chain steps with then();
+ * each step is sent straight from the worker that finished the previous one, so a
+ * pipeline never waits on the frame loop. Call deliver() to get the final result
+ * back on the main thread. A step that throws fails the rest of the chain, and the
+ * error is handed to deliver().
+ *
+ * Steps take a const T& and must return a value; tasks of void aren't supported.
+ *
+ * Example:
+ *	mTasks.run([]() { return loadRecords(); })
+ *		.then([](const Records& r) { return decodeThumbs(r); })
+ *		.deliver([this](const Thumbs& t) { showThumbs(t); });
+ */
+template <typename T>
+class Task {
+public:
+	Task() { }
+	explicit Task(const std::shared_ptr<detail::TaskState<T>>& s) : mState(s) { }
+
+	bool						empty() const			{ return !mState; }
+	const CancelToken&			getToken() const		{ return mState ? mState->mToken : CancelToken::NONE; }
+	void						cancel() const			{ if (mState) mState->mToken.cancel(); }
+
+	// Run fn on a worker thread with my value, once I'm done. An empty task answers an empty task.
+	template <typename F>
+	Task<typename std::result_of<F(const T&)>::type>
+								then(F fn) const;
+
+	// Call onValue (or onError) on the main thread once I'm done. onError gets
+	// TaskCancelled if the chain was cancelled. Does nothing for an empty task.
+	void						deliver(const std::function<void(const T&)>& onValue,
+										const std::function<void(const std::exception_ptr&)>& onError = nullptr) const;
+
+	const std::shared_ptr<detail::TaskState<T>>&
+								getState() const		{ return mState; }
+
+private:
+	std::shared_ptr<detail::TaskState<T>>
+								mState;
+};
+
+/**
+ * \class ds::TaskClient
+ * \brief Starts tasks. Main thread deliveries for a client's tasks are dropped once
+ * the client is destroyed, so own one wherever the callbacks' captures live.
+ */
+class TaskClient : public WorkClient {
+public:
+	TaskClient(ui::SpriteEngine&);
+	TaskClient(WorkManager&);
+
+	// All of my steps run in this lane. Defaults to LANE_BACKGROUND.
+	void						setLane(const int lane);
+
+	// Start fn on a worker thread. The chain is cancelled through the token.
+	template <typename F>
+	Task<typename std::result_of<F()>::type>
+								run(F fn, const CancelToken& = CancelToken());
+
+	// A task that's done when all of the tasks are, with their values in order.
+	// Fails with the first error, if any fail. Uses the first task's token.
+	// An empty task would never be done, so any empty input fails it with std::invalid_argument.
+	template <typename T>
+	Task<std::vector<T>>		whenAll(const std::vector<Task<T>>&);
+
+	// Run work on a worker thread without coming back to the main thread.
+	void						post(const std::function<void()>& work);
+	// Run fn on the main thread, during the work manager's update.
+	void						postToMain(const std::function<void()>& fn);
+
+protected:
+	virtual void				handleResult(std::unique_ptr<WorkRequest>&);
+
+private:
+	typedef WorkClient			inherited;
+	friend class detail::TaskContext;
+
+	class Request : public WorkRequest {
+	public:
+		Request(const void* clientId);
+
+		std::function<void()>	mWork;
+		std::function<void()>	mOnMain;
+
+		virtual void			run();
+	};
+
+	std::shared_ptr<detail::TaskContext>
+								mContext;
+};
+
+/* DS::TASK impl
+ ******************************************************************/
+template <typename T>
+template <typename F>
+Task<typename std::result_of<F(const T&)>::type> Task<T>::then(F fn) const
+{
+	typedef typename std::result_of<F(const T&)>::type	R;
+	if (!mState) return Task<R>();
+	// Continuations are held by the state they wait on, so they only keep it weakly.
+	std::weak_ptr<detail::TaskState<T>>	weak(mState);
+	std::shared_ptr<detail::TaskState<R>>	next(new detail::TaskState<R>(mState->mContext, mState->mToken));
+	mState->addContinuation([weak, next, fn]() {
+		std::shared_ptr<detail::TaskState<T>>	prev(weak.lock());
+		if (!prev) return;
+		next->mContext->post([prev, next, fn]() {
+			if (prev->mError) {
+				next->fail(prev->mError);
+				return;
+			}
+			if (next->mToken.isCancelled()) {
+				next->fail(std::make_exception_ptr(TaskCancelled()));
+				return;
+			}
+			try {
+				next->succeed(fn(*prev->mValue));
+			} catch (...) {
+				next->fail(std::current_exception());
+			}
+		});
+	});
+	return Task<R>(next);
+}
+
+template <typename T>
+void Task<T>::deliver(	const std::function<void(const T&)>& onValue,
+						const std::function<void(const std::exception_ptr&)>& onError) const
+{
+	if (!mState) return;
+	std::weak_ptr<detail::TaskState<T>>	weak(mState);
+	mState->addContinuation([weak, onValue, onError]() {
+		std::shared_ptr<detail::TaskState<T>>	s(weak.lock());
+		if (!s) return;
+		s->mContext->postToMain([s, onValue, onError]() {
+			std::exception_ptr				e(s->mError);
+			if (!e && s->mToken.isCancelled()) e = std::make_exception_ptr(TaskCancelled());
+			if (e) {
+				if (onError) onError(e);
+			} else if (onValue) {
+				onValue(*s->mValue);
+			}
+		});
+	});
+}
+
+template <typename F>
+Task<typename std::result_of<F()>::type> TaskClient::run(F fn, const CancelToken& token)
+{
+	typedef typename std::result_of<F()>::type	R;
+	std::shared_ptr<detail::TaskState<R>>	s(new detail::TaskState<R>(mContext, token));
+	post([s, fn]() {
+		if (s->mToken.isCancelled()) {
+			s->fail(std::make_exception_ptr(TaskCancelled()));
+			return;
+		}
+		try {
+			s->succeed(fn());
+		} catch (...) {
+			s->fail(std::current_exception());
+		}
+	});
+	return Task<R>(s);
+}
+
+template <typename T>
+Task<std::vector<T>> TaskClient::whenAll(const std::vector<Task<T>>& tasks)
+{
+	typedef detail::TaskState<std::vector<T>>	State;
+	const CancelToken						token(tasks.empty() ? CancelToken() : tasks.front().getToken());
+	std::shared_ptr<State>					s(new State(mContext, token));
+	if (tasks.empty()) {
+		s->succeed(std::vector<T>());
+		return Task<std::vector<T>>(s);
+	}
+	for (auto it = tasks.begin(), end = tasks.end(); it != end; ++it) {
+		if (it->empty()) {
+			s->fail(std::make_exception_ptr(std::invalid_argument("TaskClient::whenAll() of an empty task")));
+			return Task<std::vector<T>>(s);
+		}
+	}
+
+	// The last one in gathers the values. Every input is done by then.
+	std::shared_ptr<std::vector<Task<T>>>	inputs(new std::vector<Task<T>>(tasks));
+	std::shared_ptr<std::atomic<size_t>>	remaining(new std::atomic<size_t>(tasks.size()));
+	for (auto it = tasks.begin(), end = tasks.end(); it != end; ++it) {
+		it->getState()->addContinuation([s, inputs, remaining]() {
+			if (--(*remaining) > 0) return;
+			try {
+				std::vector<T>				values;
+				values.reserve(inputs->size());
+				for (auto it = inputs->begin(), end = inputs->end(); it != end; ++it) {
+					const auto&				in = it->getState();
+					if (in->mError) {
+						s->fail(in->mError);
+						return;
+					}
+					values.push_back(*in->mValue);
+				}
+				s->succeed(values);
+			} catch (...) {
+				s->fail(std::current_exception());
+			}
+		});
+	}
+	return Task<std::vector<T>>(s);
+}
+
+} // namespace ds
+
+#endif // DS_THREAD_TASK_H_
@@ -16,6 +16,12 @@ WorkClient::WorkClient(ui::SpriteEngine& e)
 	mManager.addClient(*this);
 }
 
+WorkClient::WorkClient(WorkManager& m)
+	: mManager(m)
+{
+	mManager.addClient(*this);
+}
+
 WorkClient::~WorkClient()
 {
 	mManager.removeClient(*this);
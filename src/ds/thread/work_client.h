@@ -20,6 +20,8 @@ class SpriteEngine;
 class WorkClient {
 public:
 	WorkClient(ui::SpriteEngine&);
+	// For clients that live outside an engine, i.e. in tests.
+	WorkClient(WorkManager&);
 	virtual ~WorkClient();
 
 protected:
@@ -4,25 +4,36 @@
 
 #include <algorithm>
 #include <iostream>
+#include <Poco/Environment.h>
+#include "ds/debug/profiler.h"
 #include "ds/thread/work_client.h"
 
 using namespace ds;
 //using namespace std;
 
 static const std::string					WORK_THREAD_NAME("ds_work");
+static const std::string					IO_THREAD_NAME("ds_work_io");
+// Keep at least 4 threads running, because we use this for all async ops
+static const int							MIN_CPU_WORKERS = 4;
+static const int							MAX_CPU_WORKERS = 16;
+// IO requests mostly wait, so they get a fixed number of threads regardless of cores
+static const int							IO_WORKERS = 4;
+static const double							DEFAULT_UPDATE_BUDGET = 0.004;
 
 /**
  * \class ds::WorkManager
  */
 WorkManager::WorkManager()
-	: mPool(WORK_THREAD_NAME, 4, 16)		// Keep at least 4 threads running, because we use this for all async ops
-//	: mPool(WORK_THREAD_NAME, 1, 1)
-	, mLoop(*this)
+	: mOutputTmpIndex(0)
+	, mUpdateBudget(DEFAULT_UPDATE_BUDGET)
 {
 	mClient.reserve(64);
-	mInput.reserve(64);
 	mOutput.reserve(64);
 	mOutputTmp.reserve(64);
+
+	const int		cores = static_cast<int>(Poco::Environment::processorCount());
+	startGroup(mCpuGroup, std::max(MIN_CPU_WORKERS, std::min(MAX_CPU_WORKERS, cores)), WORK_THREAD_NAME);
+	startGroup(mIoGroup, IO_WORKERS, IO_THREAD_NAME);
 }
 
 WorkManager::~WorkManager()
@@ -32,18 +43,18 @@ WorkManager::~WorkManager()
 
 void WorkManager::addClient(WorkClient& c)
 {
-	Poco::Mutex::ScopedLock		l(mInputMutex);
+	Poco::Mutex::ScopedLock		l(mClientMutex);
 	try {
-		mClient.push_back(&c);
+		mClient[&c] = &c;
 	} catch (std::exception const&) {
 	}
 }
 
 void WorkManager::removeClient(WorkClient& c)
 {
-	Poco::Mutex::ScopedLock		l(mInputMutex);
+	Poco::Mutex::ScopedLock		l(mClientMutex);
 	try {
-		mClient.erase( remove( mClient.begin(), mClient.end(), &c ), mClient.end() );
+		mClient.erase(&c);
 	} catch (std::exception const&) {
 	}
 }
@@ -51,104 +62,122 @@ void WorkManager::removeClient(WorkClient& c)
 bool WorkManager::sendRequest(std::unique_ptr<WorkRequest> upR, Poco::Timestamp* sendTime)
 {
 	if (!upR.get()) return false;
-	// Push new input onto the stack
-	{
-		Poco::Mutex::ScopedLock		l(mInputMutex);
-		try {
-			upR.get()->mRequestTime = Poco::Timestamp();
-			if (sendTime) *sendTime = upR.get()->mRequestTime;
-			mInput.push_back(std::move(upR));
-		} catch (std::exception&) {
-			return false;
-		}
-	}
-	return inputAdded();
-}
 
-void WorkManager::stopManager()
-{
-	// Clear out the inputs so the threads will finish.
-	{
-		Poco::Mutex::ScopedLock		l(mInputMutex);
-		mInput.clear();
+	WorkRequest*				r = upR.get();
+	r->mRequestTime = Poco::Timestamp();
+	if (sendTime) *sendTime = r->mRequestTime;
+
+	Group&						group = getGroup(r->mLane);
+	if (group.mWorkers.empty()) return false;
+
+	// Pinned requests always go to the same worker. Requests sent from one of my own
+	// workers stay on that worker, where the data is likely still in cache. Everything
+	// else is dealt out round-robin.
+	Worker*						worker = nullptr;
+	const bool					pinned = r->mAffinity >= 0;
+	if (pinned) {
+		worker = group.mWorkers[r->mAffinity % group.mWorkers.size()].get();
+	} else {
+		worker = findCurrentWorker(group);
+		if (!worker) worker = group.mWorkers[group.mNext++ % group.mWorkers.size()].get();
 	}
 
 	try {
-		mPool.joinAll();
+		worker->push(upR);
 	} catch (std::exception&) {
+		return false;
 	}
+	group.added(*worker, pinned);
+	return true;
+}
+
+void WorkManager::stopManager()
+{
+	// Clear out the inputs so the threads will finish.
+	stopGroup(mCpuGroup);
+	stopGroup(mIoGroup);
 }
 
 void WorkManager::update()
 {
-	// To control how much processing the client does, pop off a single result
-	// in an update cycle.
-	mOutputTmp.clear();
-	{
+	DS_PROFILE_SCOPE("WorkManager::update");
+	// Only take new output once everything held over from last cycle is handled,
+	// so results still arrive in the order they finished.
+	if (mOutputTmpIndex >= mOutputTmp.size()) {
+		mOutputTmp.clear();
+		mOutputTmpIndex = 0;
 		Poco::Mutex::ScopedLock		l(mOutputMutex);
-		if (!mOutput.empty()) {
-			// I suspect there's a 1-line way to do this but haven't found it so far
-//			std::move(mOutput.begin(), mOutput.begin()+1, mOutputTmp.end());
-			std::unique_ptr<WorkRequest>	r(std::move(mOutput.front()));
-			mOutput.erase(mOutput.begin());
-			mOutputTmp.push_back(std::move(r));
-		}
+		mOutput.swap(mOutputTmp);
 	}
 	if (mOutputTmp.empty()) return;
 
-	{
-		Poco::Mutex::ScopedLock		l(mClientMutex);
-		for (auto it=mOutputTmp.begin(), end=mOutputTmp.end(); it != end; ++it) {
-			WorkRequest*			r(it->get());
-			if (!r) continue;
-			WorkClient*				client = findClientLocked(r->mClientId);
-			if (!client) continue;
-
-			client->handleResult(*it);
+	const Poco::Timestamp			start;
+	const Poco::Timestamp::TimeDiff	budget = static_cast<Poco::Timestamp::TimeDiff>(mUpdateBudget * 1000000.0);
+	Poco::Mutex::ScopedLock			l(mClientMutex);
+	while (mOutputTmpIndex < mOutputTmp.size()) {
+		std::unique_ptr<WorkRequest>&	r = mOutputTmp[mOutputTmpIndex++];
+		if (r) {
+			auto					found = mClient.find(r->mClientId);
+			if (found != mClient.end()) found->second->handleResult(r);
+			// Any requests that weren't claimed by a client are lost
+			r.reset();
 		}
+		if (budget > 0 && start.elapsed() >= budget) break;
 	}
-	// Any requests that weren't claimed by a client are lost
-	mOutputTmp.clear();
 }
 
-bool WorkManager::inputAdded()
+void WorkManager::setUpdateBudget(const double seconds)
 {
-	// Start a new thread to handle the input.  If we can't start one, no big deal,
-	// that means we've got threads running that will handle it.  And note that
-	// we always have a minimum number of threads running, so there's always someone
-	// who can handle it eventually.
-	try {
-		// This is a little ugly, but I have VS set to break on handled exceptions, which I want
-		// in general.  However, it's pretty easy to use up my thread pool, and I don't care
-		// about those warnings.  BUT, in practice, I imagine there's a remote possibility that
-		// somewhere after checking if threads are available but before calling start(), all the
-		// threads might HAVE been in use but time out, causing a thread not to get started.
-		// Granted, even if this happens it just means an input will sit there until someone
-		// else starts a thread, but still, in practice, I always want to try and create a thread.
-#ifdef _DEBUG
-		if (mPool.available() > 1) {
-			mPool.startWithPriority(Poco::Thread::PRIO_LOW, mLoop);
+	mUpdateBudget = seconds;
+}
+
+void WorkManager::startGroup(Group& g, const int count, const std::string& name)
+{
+	for (int k = 0; k < count; ++k) {
+		g.mWorkers.push_back(std::unique_ptr<Worker>(new Worker(*this, g, k)));
+	}
+	for (auto it = g.mWorkers.begin(), end = g.mWorkers.end(); it != end; ++it) {
+		Worker&					w = *(it->get());
+		w.mThread.setName(name);
+		// Stay out of the way of the render thread
+		w.mThread.setPriority(Poco::Thread::PRIO_LOW);
+		w.mThread.start(w);
+	}
+}
+
+void WorkManager::stopGroup(Group& g)
+{
+	for (auto it = g.mWorkers.begin(), end = g.mWorkers.end(); it != end; ++it) {
+		(*it)->clear();
+	}
+	g.stop();
+	for (auto it = g.mWorkers.begin(), end = g.mWorkers.end(); it != end; ++it) {
+		try {
+			if ((*it)->mThread.isRunning()) (*it)->mThread.join();
+		} catch (std::exception&) {
 		}
-#else
-		mPool.startWithPriority(Poco::Thread::PRIO_LOW, mLoop);
-#endif
-	} catch (Poco::NoThreadAvailableException&) {
-	} catch (std::exception&) {
 	}
+}
 
-	return true;
+WorkManager::Group& WorkManager::getGroup(const int lane)
+{
+	if (lane == WorkRequest::LANE_IO) return mIoGroup;
+	return mCpuGroup;
 }
 
-void WorkManager::popNextInput(RequestList& in)
+WorkManager::Worker* WorkManager::findCurrentWorker(Group& g) const
 {
-	Poco::Mutex::ScopedLock		l(mInputMutex);
-	if (!mInput.empty()) {
-		if (in.empty()) {
-			in.swap(mInput);
-		} else {
-			std::move(mInput.begin(), mInput.end(), in.begin());
-		}
+	const Poco::Thread*			current = Poco::Thread::current();
+	if (!current) return nullptr;
+	for (auto it = g.mWorkers.begin(), end = g.mWorkers.end(); it != end; ++it) {
+		if (&((*it)->mThread) == current) return it->get();
 	}
+	return nullptr;
+}
+
+void WorkManager::sendResult(std::unique_ptr<WorkRequest> r)
+{
+	addOutput(r);
 }
 
 void WorkManager::addOutput(std::unique_ptr<WorkRequest>& r)
@@ -161,85 +190,143 @@ void WorkManager::addOutput(std::unique_ptr<WorkRequest>& r)
 	}
 }
 
-WorkClient* WorkManager::findClientLocked(const void* clientId)
+/**
+ * \class ds::WorkManager::Worker
+ */
+WorkManager::Worker::Worker(WorkManager& m, Group& g, const int index)
+	: mPinned(0)
+	, mManager(m)
+	, mGroup(g)
+	, mIndex(index)
 {
-	auto it = std::find(mClient.begin(), mClient.end(), (WorkClient*)clientId);
-	if (it == mClient.end()) return nullptr;
-	return *it;
 }
 
-/**
- * \class ds::WorkManager::Loop
- */
-WorkManager::Loop::Loop(WorkManager& qm)
-	: mManager(qm)
+void WorkManager::Worker::run()
 {
+	std::unique_ptr<WorkRequest>	r;
+	while (mGroup.wait(*this)) {
+		while (findWork(r)) {
+			handleInput(r);
+			r.reset();
+		}
+	}
 }
 
-void WorkManager::Loop::run()
+void WorkManager::Worker::push(std::unique_ptr<WorkRequest>& r)
 {
-	DS_DBG_THREAD_CODE(mManager.debugThreadStarted(Poco::Thread::current()));
+	const int					lane = r->getLane();
+	Poco::Mutex::ScopedLock		l(mMutex);
+	mLanes[lane].push_back(std::move(r));
+}
 
-	// Run for as long as I have input, then let the thread die to be reclaimed.
-	RequestList						ins;
-	mManager.popNextInput(ins);
-	while (!ins.empty()) {
-		// Process
-		for (auto it=ins.begin(), end=ins.end(); it != end; ++it) {
-			handleInput(*it);
-		}
-		ins.clear();
+bool WorkManager::Worker::pop(const int lane, std::unique_ptr<WorkRequest>& out)
+{
+	Poco::Mutex::ScopedLock		l(mMutex);
+	auto&						q = mLanes[lane];
+	if (q.empty()) return false;
+	out = std::move(q.front());
+	q.pop_front();
+	return true;
+}
 
-		// Testing!  Which is not great -- should have some randomization
-		// so they're not all in sync.
-//		Poco::Thread::sleep(500);
+bool WorkManager::Worker::steal(const int lane, std::unique_ptr<WorkRequest>& out)
+{
+	Poco::Mutex::ScopedLock		l(mMutex);
+	auto&						q = mLanes[lane];
+	for (auto it = q.rbegin(), end = q.rend(); it != end; ++it) {
+		if ((*it)->getAffinity() >= 0) continue;
+		out = std::move(*it);
+		q.erase(std::next(it).base());
+		return true;
+	}
+	return false;
+}
 
-		// Continue processing if we've got input
-		mManager.popNextInput(ins);
+void WorkManager::Worker::clear()
+{
+	Poco::Mutex::ScopedLock		l(mMutex);
+	for (int lane = 0; lane < WorkRequest::LANE_COUNT; ++lane) {
+		mLanes[lane].clear();
 	}
+}
 
-	DS_DBG_THREAD_CODE(mManager.debugThreadStopped(Poco::Thread::current()));
+bool WorkManager::Worker::findWork(std::unique_ptr<WorkRequest>& out)
+{
+	// Lane by lane: my own queue, then the other workers'. Interactive work anywhere
+	// runs before any background or IO work, even my own. The first worker to steal
+	// from rotates, so thieves don't all pile onto the same victim.
+	const size_t				count = mGroup.mWorkers.size();
+	for (int lane = 0; lane < WorkRequest::LANE_COUNT && !out; ++lane) {
+		if (pop(lane, out)) break;
+		for (size_t k = 1; k < count; ++k) {
+			if (mGroup.mWorkers[(mIndex + k) % count]->steal(lane, out)) break;
+		}
+	}
+	if (!out) return false;
+	mGroup.taken(*this, out->getAffinity() >= 0);
+	return true;
 }
 
-void WorkManager::Loop::handleInput(std::unique_ptr<WorkRequest>& upR) const
+void WorkManager::Worker::handleInput(std::unique_ptr<WorkRequest>& upR) const
 {
 	WorkRequest*			r = upR.get();
 	if (!r) return;
 
-	r->run();
+	{
+		DS_PROFILE_SCOPE("WorkRequest::run");
+		r->run();
+	}
 
-  mManager.addOutput(upR);
+	if (r->getReply()) mManager.addOutput(upR);
+	else upR.reset();
 }
 
-/* QUERY-DEBUG
- ******************************************************************/
-#if QUERY_DEBUG_IS_ON
+/**
+ * \class ds::WorkManager::Group
+ */
+WorkManager::Group::Group()
+	: mNext(0)
+	, mStealable(0)
+	, mRunning(true)
+{
+}
 
-void QueryManager::debugThreadStarted(void* id)
+void WorkManager::Group::added(Worker& w, const bool pinned)
 {
-	Poco::Mutex::ScopedLock		l(mInputMutex);
-	mStatistics.mThreadId.add(id);
+	Poco::Mutex::ScopedLock		l(mMutex);
+	if (pinned) {
+		++w.mPinned;
+		// Only that worker can run it, and there's no way to wake a particular one
+		mCondition.broadcast();
+	} else {
+		++mStealable;
+		mCondition.signal();
+	}
 }
 
-void QueryManager::debugThreadStopped(void* id)
+void WorkManager::Group::taken(Worker& w, const bool pinned)
 {
-	Poco::Mutex::ScopedLock		l(mInputMutex);
-	mStatistics.mThreadId.remove(id);
+	Poco::Mutex::ScopedLock		l(mMutex);
+	if (pinned) --w.mPinned;
+	else --mStealable;
 }
 
-void QueryManager::debugGetStatistics(QueryDebug::Statistics& s)
+bool WorkManager::Group::wait(Worker& w)
 {
-	{
-		Poco::Mutex::ScopedLock		l(mInputMutex);
-		s.mInputSize = mInput.size();
-		s.mThreadId = mStatistics.mThreadId;
+	Poco::Mutex::ScopedLock		l(mMutex);
+	while (mRunning && mStealable <= 0 && w.mPinned <= 0) {
+		mCondition.wait(mMutex);
 	}
-	{
-		Poco::Mutex::ScopedLock		l(mInputMutex);
-		s.mOutputSize = mOutput.size();
-	}
-	s.mUsed = mPool.used();
-	s.mAllocated = mPool.allocated();
+	return mRunning;
 }
 
-#endif
+void WorkManager::Group::stop()
+{
+	Poco::Mutex::ScopedLock		l(mMutex);
+	mRunning = false;
+	mStealable = 0;
+	for (auto it = mWorkers.begin(), end = mWorkers.end(); it != end; ++it) {
+		(*it)->mPinned = 0;
+	}
+	mCondition.broadcast();
+}
@@ -2,11 +2,15 @@
 #ifndef DS_THREAD_WORKMANAGER_H_
 #define DS_THREAD_WORKMANAGER_H_
 
+#include <atomic>
+#include <deque>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <memory>
-#include <Poco/ThreadPool.h>
-#include "ds/thread/thread_defs.h"
+#include <Poco/Condition.h>
+#include <Poco/Mutex.h>
+#include <Poco/Thread.h>
 #include "ds/thread/work_request.h"
 
 namespace ds {
@@ -17,6 +21,10 @@ class WorkClient;
  * \brief Run a thread pool that can be continually fed WorRequests. These requests are generally
  * mediated through a WorkClient subclass, which handles the broad types of requests an app might
  * want.  Typically, the app will instantiate a WorkClient and let it take care of all the details.
+ *
+ * Each worker thread has its own queue per lane (see WorkRequest). Requests are dealt out
+ * round-robin, and a worker that runs dry steals from the others, so a burst of requests
+ * spreads across every thread. IO lane requests have their own set of workers.
  */
 class WorkManager
 {
@@ -26,12 +34,19 @@ public:
 
 	// I take ownership of the request.
 	bool							sendRequest(std::unique_ptr<WorkRequest>, Poco::Timestamp* sendTime = nullptr);
+	// Hand a request straight back to its client on the next update, without running
+	// it on a worker. Can be called from any thread. I take ownership of the request.
+	void							sendResult(std::unique_ptr<WorkRequest>);
 
-	// Called from the world engine during each update cycle, which is probably
-	// excessive, but the performance hit is nil.  This is where we handle
-	// any pending query outputs.
+	// Called from the world engine during each update cycle.  This is where we handle
+	// any pending query outputs.  Results are handed to clients until the update
+	// budget runs out; whatever is left goes first next cycle.
 	void							update();
 
+	// Seconds per update cycle to spend handing out results. At least one is always
+	// handed out. 0 or less hands out everything that's finished. Default is 0.004.
+	void							setUpdateBudget(const double seconds);
+
 	// Stop the thread pool.  Called from the destructor, if a client doesn't call it earlier.
 	void							stopManager();
 
@@ -43,17 +58,60 @@ protected:
 
 	// Thread entry
 private:
-	class Loop : public Poco::Runnable {
+	class Group;
+
+	class Worker : public Poco::Runnable {
 	public:
-		Loop(WorkManager&);
+		Worker(WorkManager&, Group&, const int index);
 
-		// needs to be reentrant, since we are passed to multiple threads
 		virtual void				run();
 
-		void						handleInput(std::unique_ptr<WorkRequest>&) const;
+		void						push(std::unique_ptr<WorkRequest>&);
+		// Take the oldest request I have in a lane.
+		bool						pop(const int lane, std::unique_ptr<WorkRequest>&);
+		// Take the newest request from the back of a lane, skipping any with an affinity.
+		bool						steal(const int lane, std::unique_ptr<WorkRequest>&);
+		void						clear();
+
+		Poco::Thread				mThread;
+		// Requests with my affinity that only I can run. Guarded by the group's mutex.
+		int							mPinned;
 
 	private:
+		void						handleInput(std::unique_ptr<WorkRequest>&) const;
+		// Find work here first, then anywhere else in my group.
+		bool						findWork(std::unique_ptr<WorkRequest>&);
+
 		WorkManager&				mManager;
+		Group&						mGroup;
+		const int					mIndex;
+		Poco::Mutex					mMutex;
+		std::deque<std::unique_ptr<WorkRequest>>
+									mLanes[WorkRequest::LANE_COUNT];
+	};
+
+	// A set of workers serving the same lanes.
+	class Group {
+	public:
+		Group();
+
+		// Bookkeeping for sleeping workers
+		void						added(Worker&, const bool pinned);
+		void						taken(Worker&, const bool pinned);
+		// Sleep until there's something this worker could run. Answers false when stopping.
+		bool						wait(Worker&);
+		void						stop();
+
+		std::vector<std::unique_ptr<Worker>>
+									mWorkers;
+		std::atomic<unsigned int>	mNext;
+
+	private:
+		Poco::Mutex					mMutex;
+		Poco::Condition				mCondition;
+		// Queued requests any worker can take
+		int							mStealable;
+		bool						mRunning;
 	};
 
 private:
@@ -63,46 +121,34 @@ private:
 	 * is always locked first.  XXX actually I think that changed.  I think there's
 	 * no nesting at the moment.
 	 */
-	// Synchronization
-	Poco::ThreadPool				mPool;
-	Loop							mLoop;
-
-	// Input
-	Poco::Mutex						mInputMutex;
-	RequestList						mInput;
+	// Input. Worker queues each have their own lock.
+	Group							mCpuGroup,
+									mIoGroup;
 
 	// Output
 	Poco::Mutex						mOutputMutex;
 	RequestList						mOutput, mOutputTmp;
+	// Position in mOutputTmp, for results held over by the budget. Main thread only.
+	size_t							mOutputTmpIndex;
+	double							mUpdateBudget;
 
-	// Clients
+	// Clients, by client ID
 	Poco::Mutex						mClientMutex;
-	std::vector<WorkClient*>		mClient;
-
-	// Call after you've added more input
-	bool							inputAdded();
+	std::unordered_map<const void*, WorkClient*>
+									mClient;
 
-	// Find the best match with database and put it in the list
-	void							popNextInput(RequestList&);
+	void							startGroup(Group&, const int count, const std::string& name);
+	void							stopGroup(Group&);
+	Group&							getGroup(const int lane);
+	// Answer the worker for this thread, if it's one of mine.
+	Worker*							findCurrentWorker(Group&) const;
 
 	// Add to the output list
 	void							addOutput(std::unique_ptr<WorkRequest>&);
 
-	// Answer the client, if it exists.  Assumes the client list is locked.
-	WorkClient*						findClientLocked(const void* clientId);
-
 public:
 	class InputFactory;
 	class OutputFactory;
-
-#ifdef DS_THREAD_DEBUG_IS_ON
-private:
-	QueryDebug::Statistics			mStatistics;	// use input mutex
-	void							debugThreadStarted(void*);
-	void							debugThreadStopped(void*);
-public:
-	void							debugGetStatistics(QueryDebug::Statistics&);
-#endif
 };
 
 } // namespace ds
@@ -9,6 +9,9 @@ namespace ds {
  */
 WorkRequest::WorkRequest(const void* clientId)
 	: mClientId(clientId)
+	, mLane(LANE_BACKGROUND)
+	, mAffinity(-1)
+	, mReply(true)
 {
 }
 
@@ -16,4 +19,15 @@ WorkRequest::~WorkRequest()
 {
 }
 
+void WorkRequest::setLane(const int lane)
+{
+	if (lane < 0 || lane >= LANE_COUNT) return;
+	mLane = lane;
+}
+
+void WorkRequest::setAffinity(const int affinity)
+{
+	mAffinity = (affinity < 0 ? -1 : affinity);
+}
+
 } // namespace ds
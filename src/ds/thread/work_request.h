@@ -13,14 +13,37 @@ namespace ds {
  */
 class WorkRequest : public Poco::Runnable {
 public:
+	// Priority lanes. Interactive work always runs before background work. IO work
+	// (network, database) runs on its own threads so blocking calls can't starve the others.
+	static const int			LANE_INTERACTIVE = 0;
+	static const int			LANE_BACKGROUND = 1;
+	static const int			LANE_IO = 2;
+	static const int			LANE_COUNT = 3;
+
 	WorkRequest(const void* clientId);
 	virtual ~WorkRequest();
 
+	void						setLane(const int lane);
+	int							getLane() const			{ return mLane; }
+
+	// Requests with the same affinity (>= 0) always run on the same worker thread,
+	// in the order they were sent. The default, -1, lets any worker take the request.
+	void						setAffinity(const int affinity);
+	int							getAffinity() const		{ return mAffinity; }
+
+	// By default every request comes back to its client on the main thread. Requests
+	// that don't need that are deleted on the worker as soon as they've run.
+	void						setReply(const bool reply)	{ mReply = reply; }
+	bool						getReply() const		{ return mReply; }
+
 protected:
 	friend class WorkManager;
 
 	const void*					mClientId;
 	Poco::Timestamp				mRequestTime;
+	int							mLane;
+	int							mAffinity;
+	bool						mReply;
 
 private:
 	WorkRequest();
@@ -46,6 +46,11 @@ const ci::gl::TextureRef ImageClient::getImage() {
 	return mGenerator->getImage();
 }
 
+const ci::gl::TextureRef ImageClient::getPreviewImage() {
+	if (!mGenerator) return nullptr;
+	return mGenerator->getPreviewImage();
+}
+
 void ImageClient::writeTo(DataBuffer& buf) const {
 	if (mGenerator) {
 		buf.add(mGenerator->getBlobType());
@@ -35,6 +35,8 @@ public:
 	bool						getMetaData(ImageMetaData&) const;
 	// Answer the generator image. If the texture is not null, then it will be valid.
 	const ci::gl::TextureRef	getImage();
+	// Answer a preview to draw while the image loads (i.e. for IMG_PROGRESSIVE_F files), or null.
+	const ci::gl::TextureRef	getPreviewImage();
 
 	void						writeTo(DataBuffer&) const;
 	bool						readFrom(DataBuffer&);
@@ -61,6 +61,11 @@ public:
 		return nullptr;
 	}
 
+	virtual const ci::gl::TextureRef	getPreviewImage() {
+		if(mTextureRef || (mFlags&ds::ui::Image::IMG_PROGRESSIVE_F) == 0) return nullptr;
+		return mToken.getPreview();
+	}
+
 	virtual void				writeTo(DataBuffer& buf) const {
 		buf.add(RES_FN_ATT);
 		buf.add(mFilename);
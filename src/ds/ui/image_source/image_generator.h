@@ -22,6 +22,8 @@ public:
 	// Answer meta data about this image.
 	virtual bool						getMetaData(ImageMetaData&) const = 0;
 	virtual const ci::gl::TextureRef	getImage() = 0;
+	// Answer a low resolution stand-in to draw until getImage() has something, if there is one.
+	virtual const ci::gl::TextureRef	getPreviewImage()		{ return nullptr; }
 
 	char								getBlobType() const;
 	virtual void						writeTo(DataBuffer&) const = 0;
@@ -1,7 +1,9 @@
 #include "stdafx.h"
 
+#include <cmath>
 #include "ds/util/string_util.h"
 #include <ds/ui/ip/functions/ip_circle_mask.h>
+#include <ds/ui/ip/ip_simd.h>
 
 namespace ds {
 namespace ui {
@@ -14,7 +16,15 @@ CircleMask::CircleMask() {
 }
 
 void CircleMask::on(const std::string& parameters, ci::Surface8u& s) const {
-	if(!s.getData()) return;
+	onRows(parameters, s, 0, s.getHeight());
+}
+
+bool CircleMask::isRowKernel() const {
+	return true;
+}
+
+void CircleMask::onRows(const std::string& parameters, ci::Surface8u& s, const int32_t top, const int32_t bottom) const {
+	if(!s.getData() || !s.hasAlpha() || s.getPixelInc() != 4) return;
 	int32_t					w = s.getWidth(), h = s.getHeight();
 	if(w < 1 || h < 1) return;
 
@@ -34,25 +44,24 @@ void CircleMask::on(const std::string& parameters, ci::Surface8u& s) const {
 
 	max = max * max; // compare the squared distance for speed
 
-	ci::Surface8u::Iter		iter = s.getIter();
-	int32_t					y = 0;
-	while(iter.line()) {
-		int32_t				x = 0;
-		while(iter.pixel()) {
-			const float		d = glm::distance2(cen, glm::vec2(static_cast<float>(x), static_cast<float>(y)));
-			float			alpha_f = 1.0f;
-			if(d > max) {
-				alpha_f = 0.0f;
-			} else if(d > max - 1.0f) {
-				alpha_f = 1.0f - (d - (max - 1.0f));
-			}
-			int32_t			a = static_cast<int32_t>(static_cast<float>(iter.a()) * alpha_f);
-			if(a < 0) a = 0;
-			else if(a > 255) a = 255;
-			iter.a() = static_cast<uint8_t>(a);
-			++x;
+	// alpha is scaled by clamp(max - d, 0, 1), where d is the squared distance from the center.
+	const int				alphaShift = s.getChannelOrder().getAlphaOffset() * 8;
+	for(int32_t y = std::max(top, 0); y < std::min(bottom, h); ++y) {
+		uint8_t*			row = s.getData() + y * s.getRowBytes();
+		const float			dy = cen.y - static_cast<float>(y);
+		const float			dy2 = dy * dy;
+
+		// Pixels well inside the circle keep their alpha, so only the
+		// spans on either side need to be touched.
+		const float			inside = max - 1.0f - dy2;
+		int32_t				left = w, right = w;
+		if(inside > 0.0f) {
+			const float		r = std::sqrt(inside);
+			left = std::max(0, static_cast<int32_t>(std::ceil(cen.x - r)) + 1);
+			right = std::max(left, std::min(w, static_cast<int32_t>(std::floor(cen.x + r))));
 		}
-		++y;
+		simd::radialAlpha(row, 0, left, alphaShift, cen.x, dy2, max);
+		simd::radialAlpha(row, right, w, alphaShift, cen.x, dy2, max);
 	}
 }
 
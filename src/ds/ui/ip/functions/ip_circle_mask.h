@@ -17,6 +17,8 @@ public:
 	CircleMask();
 		
 	virtual void				on(const std::string& parameters, ci::Surface8u&) const;
+	virtual bool				isRowKernel() const;
+	virtual void				onRows(const std::string& parameters, ci::Surface8u&, const int32_t top, const int32_t bottom) const;
 };
 
 } // namespace ip
@@ -2,10 +2,40 @@
 
 #include "ds/ui/ip/ip_function.h"
 
+#include <algorithm>
+#include "ds/thread/parallel_for.h"
+
 namespace ds {
 namespace ui {
 namespace ip {
 
+const char				CHAIN_SEPARATOR = '|';
+
+namespace {
+// Rows per band. Small enough to balance across threads, big enough
+// that each band is a decent chunk of work.
+const int32_t			BAND_ROWS = 64;
+// Below this many pixels it's not worth waking other threads.
+const int64_t			MIN_PARALLEL_PIXELS = 256 * 256;
+
+const std::string		EMPTY_SZ;
+
+std::vector<std::string>	split_parameters(const std::string& parameters, const size_t count) {
+	std::vector<std::string>	ans;
+	size_t						start = 0;
+	while (ans.size() + 1 < count) {
+		const size_t			end = parameters.find(CHAIN_SEPARATOR, start);
+		if (end == std::string::npos) break;
+		ans.push_back(parameters.substr(start, end - start));
+		start = end + 1;
+	}
+	ans.push_back(start < parameters.size() ? parameters.substr(start) : std::string());
+	ans.resize(count);
+	return ans;
+}
+
+} // anonymous namespace
+
 /**
  * \class ds::ui::ip::Function
  */
@@ -15,8 +45,15 @@ Function::Function() {
 Function::~Function() {
 }
 
+bool Function::isRowKernel() const {
+	return false;
+}
+
+void Function::onRows(const std::string&, ci::Surface8u&, const int32_t, const int32_t) const {
+}
+
 /**
- * \class ds::ui::ip::Function
+ * \class ds::ui::ip::FunctionRef
  */
 FunctionRef::FunctionRef() {
 }
@@ -38,7 +75,66 @@ void FunctionRef::clear() {
 }
 
 void FunctionRef::on(const std::string& parameters, ci::Surface8u& s) const {
-	if (mFn) mFn->on(parameters, s);
+	if (!mFn) return;
+	if (mFn->isRowKernel()) {
+		runRowKernels(std::vector<const Function*>(1, mFn.get()), std::vector<std::string>(1, parameters), s);
+	} else {
+		mFn->on(parameters, s);
+	}
+}
+
+/**
+ * \class ds::ui::ip::FunctionChain
+ */
+FunctionChain::FunctionChain(const std::vector<FunctionRef>& fns)
+		: mFunctions(fns) {
+}
+
+void FunctionChain::on(const std::string& parameters, ci::Surface8u& s) const {
+	const std::vector<std::string>	params = split_parameters(parameters, mFunctions.size());
+
+	// Runs of consecutive row kernels share one pass; anything else gets the whole surface.
+	std::vector<const Function*>	kernels;
+	std::vector<std::string>		kernelParams;
+	for (size_t k = 0; k < mFunctions.size(); ++k) {
+		const Function*				fn = mFunctions[k].getFunction().get();
+		if (!fn) continue;
+		if (fn->isRowKernel()) {
+			kernels.push_back(fn);
+			kernelParams.push_back(params[k]);
+			continue;
+		}
+		if (!kernels.empty()) {
+			runRowKernels(kernels, kernelParams, s);
+			kernels.clear();
+			kernelParams.clear();
+		}
+		fn->on(params[k], s);
+	}
+	if (!kernels.empty()) runRowKernels(kernels, kernelParams, s);
+}
+
+void runRowKernels(const std::vector<const Function*>& fns, const std::vector<std::string>& parameters, ci::Surface8u& s) {
+	if (fns.empty() || !s.getData() || s.getWidth() < 1 || s.getHeight() < 1) return;
+
+	// Every kernel runs on a band before moving on, so a chain touches each
+	// pixel while it's still in cache.
+	const int32_t				h = s.getHeight(),
+								bands = (h + BAND_ROWS - 1) / BAND_ROWS;
+	auto						band = [&fns, &parameters, &s, h](const int index) {
+		const int32_t			top = index * BAND_ROWS,
+								bottom = std::min(h, top + BAND_ROWS);
+		for (size_t k = 0; k < fns.size(); ++k) {
+			fns[k]->onRows(k < parameters.size() ? parameters[k] : EMPTY_SZ, s, top, bottom);
+		}
+	};
+
+	const int64_t				pixels = static_cast<int64_t>(s.getWidth()) * h;
+	if (pixels < MIN_PARALLEL_PIXELS) {
+		for (int32_t k = 0; k < bands; ++k) band(k);
+	} else {
+		ds::parallel_for(bands, band);
+	}
 }
 
 } // namespace ip
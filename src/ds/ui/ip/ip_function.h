@@ -2,6 +2,8 @@
 #ifndef DS_UI_IP_IPFUNCTION_H_
 #define DS_UI_IP_IPFUNCTION_H_
 
+#include <memory>
+#include <vector>
 #include <cinder/Surface.h>
 
 namespace ds {
@@ -11,15 +13,25 @@ namespace ip {
 /**
  * \class ds::ui::ip::Function
  * Abstract interface for a generic image processing functions.
+ *
+ * Functions that only touch the pixels of the rows they're given can
+ * also implement onRows() and answer true from isRowKernel(). Row kernels
+ * are split into bands across threads, and consecutive row kernels in a
+ * chain are run band by band in a single pass over the surface.
  */
 class Function {
 public:
 	virtual ~Function();
-	
+
 	// Parameters can be anything. It's up to the application to
 	// decide an appropriate format for this function.
 	virtual void				on(const std::string& parameters, ci::Surface8u&) const = 0;
 
+	virtual bool				isRowKernel() const;
+	// Process rows top (inclusive) to bottom (exclusive). Will be called
+	// concurrently with different rows of the same surface.
+	virtual void				onRows(const std::string& parameters, ci::Surface8u&, const int32_t top, const int32_t bottom) const;
+
 protected:
 	Function();
 };
@@ -35,7 +47,7 @@ public:
 	explicit FunctionRef(const std::shared_ptr<Function>&);
 	// Must supply a raw, unmanaged pointer (and you are relinquishing ownership).
 	explicit FunctionRef(Function*);
-	
+
 	bool						empty() const;
 	void						clear();
 
@@ -43,12 +55,38 @@ public:
 	// decide an appropriate format for this function.
 	void						on(const std::string& parameters, ci::Surface8u&) const;
 
+	const std::shared_ptr<Function>&
+								getFunction() const { return mFn; }
+
 private:
 	std::shared_ptr<Function>	mFn;
 };
 
+/**
+ * \class ds::ui::ip::FunctionChain
+ * Run several functions on a surface, in order, each with its own parameters.
+ * Built by FunctionList::find() for keys like "ds:circle_mask|app:tint".
+ */
+class FunctionChain : public Function {
+public:
+	FunctionChain(const std::vector<FunctionRef>&);
+
+	// Parameters are split on CHAIN_SEPARATOR, one entry per function.
+	virtual void				on(const std::string& parameters, ci::Surface8u&) const;
+
+private:
+	std::vector<FunctionRef>	mFunctions;
+};
+
+// Separates keys, and parameters, in a chain.
+extern const char				CHAIN_SEPARATOR;
+
+// Run row kernels over the whole surface, split into bands across the
+// default Poco thread pool. The calling thread works on bands too.
+void							runRowKernels(const std::vector<const Function*>&, const std::vector<std::string>& parameters, ci::Surface8u&);
+
 } // namespace ip
 } // namespace ui
 } // namespace ds
 
-#endif
\ No newline at end of file
+#endif
@@ -16,11 +16,28 @@ FunctionRef FunctionList::find(const std::string& key) const {
 	if (key.empty()) return FunctionRef();
 	if (mFunctions.empty()) return FunctionRef();
 
+	if (key.find(CHAIN_SEPARATOR) != std::string::npos) return findChain(key);
+
 	auto f = mFunctions.find(key);
 	if (f == mFunctions.end()) return FunctionRef();
 	return f->second;
 }
 
+FunctionRef FunctionList::findChain(const std::string& key) const {
+	std::vector<FunctionRef>	fns;
+	size_t						start = 0;
+	while (start <= key.size()) {
+		size_t					end = key.find(CHAIN_SEPARATOR, start);
+		if (end == std::string::npos) end = key.size();
+		// Every link has to exist, or the parameters won't line up.
+		auto					f = mFunctions.find(key.substr(start, end - start));
+		if (f == mFunctions.end()) return FunctionRef();
+		fns.push_back(f->second);
+		start = end + 1;
+	}
+	return FunctionRef(new FunctionChain(fns));
+}
+
 void FunctionList::add(const std::string& key, const FunctionRef& ref) {
 	if (ref.empty()) return;
 	mFunctions[key] = ref;
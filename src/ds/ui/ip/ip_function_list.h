@@ -16,11 +16,15 @@ class FunctionList {
 public:
 	FunctionList();
 
+	// Keys can be chained with CHAIN_SEPARATOR ("ds:circle_mask|app:tint"), in which case
+	// the functions run in order, and the parameters are split the same way.
 	FunctionRef			find(const std::string& key) const;
 
 	void				add(const std::string& key, const FunctionRef&);
 
 private:
+	FunctionRef			findChain(const std::string& key) const;
+
 	std::unordered_map<std::string, FunctionRef>
 						mFunctions;
 };
@@ -0,0 +1,165 @@
+#include "stdafx.h"
+
+#include "ds/ui/ip/ip_simd.h"
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DS_IP_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compiles AVX2 intrinsics anywhere; gcc and clang need to be told per function.
+#if defined(DS_IP_X86) && (defined(__GNUC__) || defined(__clang__))
+#define DS_IP_TARGET_AVX2 __attribute__((target("avx2")))
+#define DS_IP_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define DS_IP_TARGET_AVX2
+#define DS_IP_TARGET_SSE2
+#endif
+
+namespace ds {
+namespace ui {
+namespace ip {
+namespace simd {
+
+namespace {
+
+int					detect_level() {
+#if !defined(DS_IP_X86)
+	return LEVEL_SCALAR;
+#elif defined(_MSC_VER)
+	int				info[4];
+	__cpuid(info, 0);
+	const int		ids = info[0];
+	if (ids < 1) return LEVEL_SCALAR;
+	__cpuid(info, 1);
+	const bool		sse2 = (info[3] & (1 << 26)) != 0;
+	const bool		osxsave = (info[2] & (1 << 27)) != 0;
+	if (!sse2) return LEVEL_SCALAR;
+	if (ids < 7 || !osxsave) return LEVEL_SSE2;
+	// The OS has to save the YMM registers too
+	if ((_xgetbv(0) & 6) != 6) return LEVEL_SSE2;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0 ? LEVEL_AVX2 : LEVEL_SSE2;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return LEVEL_AVX2;
+	if (__builtin_cpu_supports("sse2")) return LEVEL_SSE2;
+	return LEVEL_SCALAR;
+#endif
+}
+
+const int			SUPPORTED_LEVEL = detect_level();
+int					MAX_LEVEL = LEVEL_AVX2;
+
+inline void			radial_alpha_pixel(uint8_t* px, const int alphaShift, const float x, const float cx, const float dy2, const float limit) {
+	const float		dx = cx - x;
+	const float		d = dx * dx + dy2;
+	const float		f = std::min(std::max(limit - d, 0.0f), 1.0f);
+	uint32_t		p;
+	memcpy(&p, px, 4);
+	const uint32_t	a = static_cast<uint32_t>(static_cast<float>((p >> alphaShift) & 0xff) * f);
+	p = (p & ~(0xffu << alphaShift)) | (a << alphaShift);
+	memcpy(px, &p, 4);
+}
+
+void				radial_alpha_scalar(uint8_t* row, int32_t x, const int32_t x1, const int alphaShift,
+										const float cx, const float dy2, const float limit) {
+	for (; x < x1; ++x) {
+		radial_alpha_pixel(row + x * 4, alphaShift, static_cast<float>(x), cx, dy2, limit);
+	}
+}
+
+#if defined(DS_IP_X86)
+DS_IP_TARGET_SSE2
+void				radial_alpha_sse2(uint8_t* row, int32_t x, const int32_t x1, const int alphaShift,
+									  const float cx, const float dy2, const float limit) {
+	const __m128i	shift = _mm_cvtsi32_si128(alphaShift);
+	const __m128i	byte = _mm_set1_epi32(0xff);
+	const __m128i	mask = _mm_sll_epi32(byte, shift);
+	const __m128	cxv = _mm_set1_ps(cx),
+					dy2v = _mm_set1_ps(dy2),
+					limitv = _mm_set1_ps(limit),
+					zero = _mm_setzero_ps(),
+					one = _mm_set1_ps(1.0f),
+					step = _mm_set1_ps(4.0f);
+	__m128			xs = _mm_setr_ps(static_cast<float>(x), static_cast<float>(x + 1), static_cast<float>(x + 2), static_cast<float>(x + 3));
+	for (; x + 4 <= x1; x += 4) {
+		const __m128	dx = _mm_sub_ps(cxv, xs);
+		const __m128	d = _mm_add_ps(_mm_mul_ps(dx, dx), dy2v);
+		const __m128	f = _mm_min_ps(_mm_max_ps(_mm_sub_ps(limitv, d), zero), one);
+		__m128i*		at = reinterpret_cast<__m128i*>(row + x * 4);
+		const __m128i	p = _mm_loadu_si128(at);
+		const __m128i	a = _mm_and_si128(_mm_srl_epi32(p, shift), byte);
+		const __m128i	na = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(a), f));
+		_mm_storeu_si128(at, _mm_or_si128(_mm_andnot_si128(mask, p), _mm_sll_epi32(na, shift)));
+		xs = _mm_add_ps(xs, step);
+	}
+	radial_alpha_scalar(row, x, x1, alphaShift, cx, dy2, limit);
+}
+
+DS_IP_TARGET_AVX2
+void				radial_alpha_avx2(uint8_t* row, int32_t x, const int32_t x1, const int alphaShift,
+									  const float cx, const float dy2, const float limit) {
+	const __m128i	shift = _mm_cvtsi32_si128(alphaShift);
+	const __m256i	byte = _mm256_set1_epi32(0xff);
+	const __m256i	mask = _mm256_sll_epi32(byte, shift);
+	const __m256	cxv = _mm256_set1_ps(cx),
+					dy2v = _mm256_set1_ps(dy2),
+					limitv = _mm256_set1_ps(limit),
+					zero = _mm256_setzero_ps(),
+					one = _mm256_set1_ps(1.0f),
+					step = _mm256_set1_ps(8.0f);
+	const float		fx = static_cast<float>(x);
+	__m256			xs = _mm256_setr_ps(fx, fx + 1.0f, fx + 2.0f, fx + 3.0f, fx + 4.0f, fx + 5.0f, fx + 6.0f, fx + 7.0f);
+	for (; x + 8 <= x1; x += 8) {
+		const __m256	dx = _mm256_sub_ps(cxv, xs);
+		const __m256	d = _mm256_add_ps(_mm256_mul_ps(dx, dx), dy2v);
+		const __m256	f = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(limitv, d), zero), one);
+		__m256i*		at = reinterpret_cast<__m256i*>(row + x * 4);
+		const __m256i	p = _mm256_loadu_si256(at);
+		const __m256i	a = _mm256_and_si256(_mm256_srl_epi32(p, shift), byte);
+		const __m256i	na = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(a), f));
+		_mm256_storeu_si256(at, _mm256_or_si256(_mm256_andnot_si256(mask, p), _mm256_sll_epi32(na, shift)));
+		xs = _mm256_add_ps(xs, step);
+	}
+	radial_alpha_scalar(row, x, x1, alphaShift, cx, dy2, limit);
+}
+#endif
+
+} // anonymous namespace
+
+int getLevel() {
+	return std::min(SUPPORTED_LEVEL, MAX_LEVEL);
+}
+
+void setMaxLevel(const int level) {
+	MAX_LEVEL = level;
+}
+
+void radialAlpha(uint8_t* row, const int32_t x0, const int32_t x1, const int alphaShift,
+				 const float cx, const float dy2, const float limit) {
+	if (!row || x1 <= x0) return;
+#if defined(DS_IP_X86)
+	const int		level = getLevel();
+	if (level >= LEVEL_AVX2) {
+		radial_alpha_avx2(row, x0, x1, alphaShift, cx, dy2, limit);
+		return;
+	}
+	if (level >= LEVEL_SSE2) {
+		radial_alpha_sse2(row, x0, x1, alphaShift, cx, dy2, limit);
+		return;
+	}
+#endif
+	radial_alpha_scalar(row, x0, x1, alphaShift, cx, dy2, limit);
+}
+
+} // namespace simd
+} // namespace ip
+} // namespace ui
+} // namespace ds
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef DS_UI_IP_IPSIMD_H_
+#define DS_UI_IP_IPSIMD_H_
+
+#include <stdint.h>
+
+namespace ds {
+namespace ui {
+namespace ip {
+
+/**
+ * Vectorized pixel kernels for ip functions. Each kernel has AVX2, SSE2
+ * and scalar versions; the best one the CPU supports is picked at runtime.
+ * All versions produce the same results.
+ */
+namespace simd {
+
+static const int			LEVEL_SCALAR = 0;
+static const int			LEVEL_SSE2 = 1;
+static const int			LEVEL_AVX2 = 2;
+
+// The best level this CPU supports, capped by setMaxLevel().
+int							getLevel();
+// Cap the level, i.e. to compare versions. Defaults to LEVEL_AVX2.
+void						setMaxLevel(const int);
+
+// For 4-byte pixels x0 to x1 (exclusive) on a row, scale alpha by
+// clamp(limit - ((cx - x)^2 + dy2), 0, 1). alphaShift is the bit offset
+// of alpha within a little-endian 32-bit pixel.
+void						radialAlpha(uint8_t* row, const int32_t x0, const int32_t x1, const int alphaShift,
+										const float cx, const float dy2, const float limit);
+
+} // namespace simd
+
+} // namespace ip
+} // namespace ui
+} // namespace ds
+
+#endif
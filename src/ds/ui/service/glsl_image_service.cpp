@@ -6,6 +6,7 @@
 #include <cinder/ImageIo.h>
 #include "ds/debug/debug_defines.h"
 #include "ds/debug/logger.h"
+#include "ds/thread/gl_upload_pool.h"
 #include "ds/ui/sprite/image.h"
 
 namespace {
@@ -113,13 +114,15 @@ void ImageToken::release() {
 /* DS::LOAD-IMAGE-SERVICE
  ******************************************************************/
 ImageService::ImageService(ds::ui::SpriteEngine& e)
-		: mEngine(e) {
+		: mEngine(e)
+		, mUploads(e.getGlUploadPool()) {
 	mInput.reserve(8);
 	mOutput.reserve(8);
 	mTmp.reserve(8);
 }
 
 ImageService::~ImageService() {
+	mUploads.cancel(this);
 	clear();
 }
 
@@ -197,28 +200,27 @@ ImageService::holder* ImageService::find(const ImageKey& key, int* index) {
 }
 
 void ImageService::renderInput() {
-	// Pop off the items I need. This design is a hold over from
-	// the original attempt to make this run in a separate thread.
+	// Pop off the items I need.
 	mTmp.clear();
 	{
 		Poco::Mutex::ScopedLock			l(mMutex);
 		mInput.swap(mTmp);
 	}
-	std::vector<op>						outs;
 	for (auto it=mTmp.begin(), end=mTmp.end(); it!=end; ++it) {
-		op&								top(*it);
-		try {
-			renderInput(top);
-			if(top.mImgRef) outs.push_back(top);
-		} catch (std::exception const&) {
-		}
+		std::shared_ptr<op>				top(new op(*it));
+		mUploads.upload(this, [top]() {
+			try {
+				renderInput(*top);
+			} catch (std::exception const&) {
+				top->mImgRef = nullptr;
+			}
+		}, [this, top]() {
+			if (!top->mImgRef) return;
+			Poco::Mutex::ScopedLock		l(mMutex);
+			mOutput.push_back(*top);
+		});
 	}
 	mTmp.clear();
-	// Push the outs to the output
-	{
-		Poco::Mutex::ScopedLock			l(mMutex);
-		mOutput.insert(mOutput.end(), outs.begin(), outs.end());
-	}
 }
 
 void ImageService::renderInput(op& input) {
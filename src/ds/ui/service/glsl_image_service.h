@@ -12,6 +12,8 @@
 #include "ds/ui/sprite/sprite_engine.h"
 
 namespace ds {
+class GlUploadPool;
+
 namespace glsl {
 class ImageService;
 
@@ -88,6 +90,7 @@ private:
 };
 
 /* \class ds::glsl::ImageService
+ * \brief Renders images with shaders, on the engine's GL upload threads.
  */
 class ImageService : public ds::EngineService {
 public:
@@ -129,11 +132,13 @@ public:
 private:
 	holder*					find(const ImageKey&, int* index = nullptr);
 
-	// NOTE:  This is running in the main thread.  I think it has to.
+	// Send everything in the input to the upload threads.
 	void					renderInput();
-	void					renderInput(op&);
+	// Runs on an upload thread.
+	static void				renderInput(op&);
 
 	ds::ui::SpriteEngine&	mEngine;
+	ds::GlUploadPool&		mUploads;
 	std::vector<holder>		mCache;
 
 	Poco::Mutex				mMutex;
@@ -0,0 +1,277 @@
+#include "stdafx.h"
+
+#include "ds/ui/service/glyph_atlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <cinder/gl/scoped.h>
+#include "ds/debug/logger.h"
+
+#include "cairo/cairo.h"
+#include "pango/pangocairo.h"
+
+namespace ds {
+namespace ui {
+
+namespace {
+// Clear pixels around each glyph, so linear filtering doesn't pick up the neighbours
+const int			PADDING = 1;
+}
+
+/**
+ * \class ds::ui::GlyphAtlas::Glyph
+ */
+GlyphAtlas::Glyph::Glyph()
+	: mSlot(0)
+{
+}
+
+/**
+ * \class ds::ui::GlyphAtlas::Page
+ */
+GlyphAtlas::Page::Page()
+	: mX(0)
+	, mY(0)
+	, mRowHeight(0)
+	, mLastUse(0)
+{
+}
+
+/**
+ * \class ds::ui::GlyphAtlas::KeyHash
+ */
+size_t GlyphAtlas::KeyHash::operator()(const Key& k) const
+{
+	size_t		h = std::hash<const void*>()(k.mFont);
+	h ^= std::hash<unsigned int>()(k.mGlyph) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	h ^= std::hash<int>()(k.mStep) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	return h;
+}
+
+/**
+ * \class ds::ui::GlyphAtlas
+ */
+GlyphAtlas::GlyphAtlas()
+	: mFillSlot(0)
+	, mPageBudget(DEFAULT_PAGE_BUDGET)
+	, mGeneration(0)
+	, mUseCount(0)
+	, mFontsDropped(false)
+{
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+	clear();
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::find(PangoFont* font, const unsigned int glyph, const float subpixel)
+{
+	if (!font || !PANGO_IS_CAIRO_FONT(font)) return nullptr;
+
+	Key						key;
+	key.mFont = font;
+	key.mGlyph = glyph;
+	key.mStep = std::min(static_cast<int>(subpixel * static_cast<float>(SUBPIXEL_STEPS)), SUBPIXEL_STEPS - 1);
+
+	auto					found = mGlyphs.find(key);
+	if (found == mGlyphs.end()) {
+		if (std::find(mFonts.begin(), mFonts.end(), font) == mFonts.end()) {
+			g_object_ref(font);
+			mFonts.push_back(font);
+		}
+		Glyph				g;
+		if (!rasterize(font, glyph, key.mStep, g)) g = Glyph();
+		found = mGlyphs.insert(std::make_pair(key, g)).first;
+		// A page was dropped for this one, which can leave fonts with nothing here
+		if (mFontsDropped) releaseUnusedFonts();
+	}
+	if (!found->second.mPage) return nullptr;
+	mPages[found->second.mSlot].mLastUse = ++mUseCount;
+	return &found->second;
+}
+
+void GlyphAtlas::clear()
+{
+	mGlyphs.clear();
+	mPages.clear();
+	mFillSlot = 0;
+	++mGeneration;
+	for (auto it = mFonts.begin(), end = mFonts.end(); it != end; ++it) {
+		g_object_unref(*it);
+	}
+	mFonts.clear();
+	mFontsDropped = false;
+}
+
+void GlyphAtlas::setPageBudget(const size_t pages)
+{
+	mPageBudget = std::max<size_t>(pages, 1);
+	if (mPages.size() > mPageBudget) clear();
+}
+
+bool GlyphAtlas::isLive(const ci::gl::TextureRef& page) const
+{
+	if (!page) return false;
+	for (auto it = mPages.begin(), end = mPages.end(); it != end; ++it) {
+		if (it->mTexture == page) return true;
+	}
+	return false;
+}
+
+bool GlyphAtlas::rasterize(PangoFont* font, const unsigned int glyph, const int step, Glyph& out)
+{
+	cairo_scaled_font_t*	scaledFont = pango_cairo_font_get_scaled_font(PANGO_CAIRO_FONT(font));
+	if (!scaledFont || cairo_scaled_font_status(scaledFont) != CAIRO_STATUS_SUCCESS) return false;
+
+	// The ink box with the pen at the step's offset, rounded out to whole pixels
+	const double			offset = static_cast<double>(step) / static_cast<double>(SUBPIXEL_STEPS);
+	cairo_glyph_t			cg;
+	cg.index = glyph;
+	cg.x = offset;
+	cg.y = 0.0;
+	cairo_text_extents_t	extents;
+	cairo_scaled_font_glyph_extents(scaledFont, &cg, 1, &extents);
+	if (extents.width <= 0.0 || extents.height <= 0.0) return false;
+
+	const int				left = static_cast<int>(std::floor(offset + extents.x_bearing)) - PADDING;
+	const int				top = static_cast<int>(std::floor(extents.y_bearing)) - PADDING;
+	const int				right = static_cast<int>(std::ceil(offset + extents.x_bearing + extents.width)) + PADDING;
+	const int				bottom = static_cast<int>(std::ceil(extents.y_bearing + extents.height)) + PADDING;
+	const int				w = right - left;
+	const int				h = bottom - top;
+	if (w > PAGE_SIZE || h > PAGE_SIZE) {
+		DS_LOG_WARNING("GlyphAtlas: glyph " << glyph << " is too big for a page (" << w << "x" << h << ")");
+		return false;
+	}
+
+	cairo_surface_t*		surface = cairo_image_surface_create(CAIRO_FORMAT_A8, w, h);
+	if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+		cairo_surface_destroy(surface);
+		return false;
+	}
+	cairo_t*				cr = cairo_create(surface);
+	cairo_set_scaled_font(cr, scaledFont);
+	cg.x = offset - static_cast<double>(left);
+	cg.y = -static_cast<double>(top);
+	cairo_show_glyphs(cr, &cg, 1);
+	cairo_destroy(cr);
+	cairo_surface_flush(surface);
+
+	// Rows are padded out to the stride, the upload wants them tight
+	const unsigned char*	pixels = cairo_image_surface_get_data(surface);
+	const int				stride = cairo_image_surface_get_stride(surface);
+	mScratch.resize(static_cast<size_t>(w * h));
+	for (int row = 0; row < h; ++row) {
+		std::copy(pixels + row * stride, pixels + row * stride + w, mScratch.begin() + row * w);
+	}
+	cairo_surface_destroy(surface);
+
+	int						x = 0, y = 0;
+	const size_t			slot = allocate(w, h, x, y);
+	const Page&				page = mPages[slot];
+	{
+		ci::gl::ScopedTextureBind	bind(page.mTexture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RED, GL_UNSIGNED_BYTE, mScratch.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	const float				size = static_cast<float>(PAGE_SIZE);
+	out.mPage = page.mTexture;
+	out.mSlot = slot;
+	out.mTexCoords = ci::Rectf(x / size, y / size, (x + w) / size, (y + h) / size);
+	out.mOffset = ci::vec2(static_cast<float>(left), static_cast<float>(top));
+	out.mSize = ci::vec2(static_cast<float>(w), static_cast<float>(h));
+	return true;
+}
+
+size_t GlyphAtlas::allocate(const int w, const int h, int& x, int& y)
+{
+	if (mFillSlot < mPages.size()) {
+		Page&				page = mPages[mFillSlot];
+		if (page.mX + w > PAGE_SIZE) {
+			page.mX = 0;
+			page.mY += page.mRowHeight;
+			page.mRowHeight = 0;
+		}
+		if (page.mY + h <= PAGE_SIZE) {
+			x = page.mX;
+			y = page.mY;
+			page.mX += w;
+			page.mRowHeight = std::max(page.mRowHeight, h);
+			return mFillSlot;
+		}
+	}
+
+	// A new page while there's budget, then the one used least recently
+	if (mPages.size() < mPageBudget) {
+		mPages.push_back(Page());
+		mFillSlot = mPages.size() - 1;
+	} else {
+		mFillSlot = 0;
+		for (size_t k = 1; k < mPages.size(); ++k) {
+			if (mPages[k].mLastUse < mPages[mFillSlot].mLastUse) mFillSlot = k;
+		}
+	}
+	replacePage(mFillSlot);
+
+	Page&					page = mPages[mFillSlot];
+	x = 0;
+	y = 0;
+	page.mX = w;
+	page.mRowHeight = h;
+	return mFillSlot;
+}
+
+void GlyphAtlas::replacePage(const size_t slot)
+{
+	Page&					page = mPages[slot];
+	if (page.mTexture) {
+		for (auto it = mGlyphs.begin(); it != mGlyphs.end(); ) {
+			if (it->second.mPage && it->second.mSlot == slot) it = mGlyphs.erase(it);
+			else ++it;
+		}
+		++mGeneration;
+		mFontsDropped = true;
+		DS_LOG_INFO("GlyphAtlas: dropped page " << slot + 1 << " of " << mPageBudget
+					<< ", raise text:glyph_atlas_pages if this happens every frame");
+	} else {
+		DS_LOG_INFO("GlyphAtlas: added page " << mPages.size() << " at " << mGlyphs.size() << " glyphs");
+	}
+
+	// Pages start clear, so the padding around each glyph is empty. Sprites still drawing
+	// from the old page keep it, so it's never drawn over.
+	std::vector<unsigned char>	empty(static_cast<size_t>(PAGE_SIZE * PAGE_SIZE), 0);
+	ci::gl::Texture::Format		format;
+	format.setInternalFormat(GL_R8);
+	format.setMagFilter(GL_LINEAR);
+	format.setMinFilter(GL_LINEAR);
+	format.setWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+	page = Page();
+	page.mTexture = ci::gl::Texture::create(empty.data(), GL_RED, PAGE_SIZE, PAGE_SIZE, format);
+	// New pages aren't the next to go
+	page.mLastUse = ++mUseCount;
+}
+
+void GlyphAtlas::releaseUnusedFonts()
+{
+	mFontsDropped = false;
+	std::unordered_set<PangoFont*>	used;
+	for (auto it = mGlyphs.begin(), end = mGlyphs.end(); it != end; ++it) {
+		used.insert(it->first.mFont);
+	}
+	for (auto it = mFonts.begin(); it != mFonts.end(); ) {
+		if (used.count(*it) > 0) {
+			++it;
+			continue;
+		}
+		g_object_unref(*it);
+		it = mFonts.erase(it);
+	}
+}
+
+} // namespace ui
+} // namespace ds
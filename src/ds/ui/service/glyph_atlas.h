@@ -0,0 +1,123 @@
+#pragma once
+#ifndef DS_UI_SERVICE_GLYPH_ATLAS_H_
+#define DS_UI_SERVICE_GLYPH_ATLAS_H_
+
+#include <unordered_map>
+#include <vector>
+#include <cinder/Rect.h>
+#include <cinder/Vector.h>
+#include <cinder/gl/Texture.h>
+
+struct _PangoFont;
+typedef struct _PangoFont PangoFont;
+
+namespace ds {
+namespace ui {
+
+/**
+* \class ds::ui::GlyphAtlas
+* \brief Glyphs rasterized once, into a few shared single channel textures, for text sprites
+* that draw as quads instead of rendering a texture each. Glyphs are keyed by pango font
+* (a face at a size), glyph id, and where the glyph starts within a pixel, in quarters.
+* Glyphs are grayscale antialiased, a shared alpha page can't hold subpixel colour.
+*
+* There are at most getPageBudget() pages. When they're full the page used least recently
+* is dropped, with its glyphs, for a new one, and the generation goes up. Sprites keep the
+* pages they draw from, so what they hold still draws; they check isLive() for their pages
+* when the generation changes and rebuild if one was dropped.
+*
+* Main thread only, it uploads as glyphs are added.
+*/
+class GlyphAtlas {
+public:
+	static const int			PAGE_SIZE = 1024;
+	static const int			SUBPIXEL_STEPS = 4;
+	static const size_t			DEFAULT_PAGE_BUDGET = 4;
+
+	struct Glyph {
+		Glyph();
+
+		ci::gl::TextureRef		mPage;
+		ci::Rectf				mTexCoords;
+		// From the pen position on the baseline to the top-left of the quad, in pixels
+		ci::vec2				mOffset;
+		ci::vec2				mSize;
+		// Where the page is in the atlas
+		size_t					mSlot;
+	};
+
+	GlyphAtlas();
+	~GlyphAtlas();
+
+	/// The glyph drawn with the pen this far (0-1) into a pixel. Rasterizes it the first time.
+	/// Answers nullptr for glyphs with no ink, like spaces, or if the glyph can't be rasterized.
+	const Glyph*				find(PangoFont*, const unsigned int glyph, const float subpixel);
+
+	/// Drop every glyph and page. Sprites hold on to the pages they draw from until they next
+	/// rebuild, so this is safe any time, but only frees memory once they have.
+	void						clear();
+
+	/// The most pages to keep, at least 1. Lowering it drops pages the next time one is needed.
+	void						setPageBudget(const size_t);
+	size_t						getPageBudget() const		{ return mPageBudget; }
+	/// Goes up whenever pages are dropped, so sprites know to check theirs
+	unsigned int				getGeneration() const		{ return mGeneration; }
+	/// Whether a page is still in the atlas, and the glyphs on it still valid
+	bool						isLive(const ci::gl::TextureRef&) const;
+
+	size_t						getGlyphCount() const		{ return mGlyphs.size(); }
+	size_t						getPageCount() const		{ return mPages.size(); }
+
+private:
+	GlyphAtlas(const GlyphAtlas&);
+	GlyphAtlas&					operator=(const GlyphAtlas&);
+
+	struct Key {
+		PangoFont*				mFont;
+		unsigned int			mGlyph;
+		int						mStep;
+
+		bool					operator==(const Key& o) const	{ return mFont == o.mFont && mGlyph == o.mGlyph && mStep == o.mStep; }
+	};
+	struct KeyHash {
+		size_t					operator()(const Key&) const;
+	};
+
+	// Rows of glyphs, filled left to right and then top to bottom
+	struct Page {
+		Page();
+
+		ci::gl::TextureRef		mTexture;
+		int						mX, mY;
+		int						mRowHeight;
+		// From mUseCount, when a glyph on this page was last found
+		unsigned long long		mLastUse;
+	};
+
+	bool						rasterize(PangoFont*, const unsigned int glyph, const int step, Glyph&);
+	// Find room for a w x h block, adding or replacing a page if need be. Answers the page's slot.
+	size_t						allocate(const int w, const int h, int& x, int& y);
+	// Drop the glyphs on a slot and give it a fresh page
+	void						replacePage(const size_t slot);
+	// Unreference fonts that no longer have glyphs
+	void						releaseUnusedFonts();
+
+	// Glyphs with no ink are kept too, with no page, so they're only measured once
+	std::unordered_map<Key, Glyph, KeyHash>
+								mGlyphs;
+	std::vector<Page>			mPages;
+	// The page being filled
+	size_t						mFillSlot;
+	size_t						mPageBudget;
+	unsigned int				mGeneration;
+	unsigned long long			mUseCount;
+	bool						mFontsDropped;
+	// Referenced while they have glyphs here, so a pointer can't be reused for another font
+	std::vector<PangoFont*>		mFonts;
+	std::vector<unsigned char>	mScratch;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_SERVICE_GLYPH_ATLAS_H_
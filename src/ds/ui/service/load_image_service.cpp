@@ -2,17 +2,52 @@
 
 #include "ds/ui/service/load_image_service.h"
 
+#include <iomanip>
+#include <sstream>
 #include <cinder/ImageIo.h>
+#include <cinder/ip/Resize.h>
 #include "ds/app/environment.h"
 #include "ds/debug/debug_defines.h"
 #include "ds/debug/logger.h"
+#include "ds/debug/profiler.h"
+#include "ds/gl/block_compression.h"
+#include "ds/thread/gl_upload_pool.h"
 #include "ds/ui/sprite/image.h"
+#include "ds/ui/sprite/sprite_engine.h"
 #include "Poco/File.h"
+#include "Poco/Path.h"
 
 namespace {
 const ds::BitMask	LOAD_IMAGE_LOG_M = ds::Logger::newModule("load_image");
 // A mask of all the image flags that impact the key.
-const int			IMAGE_FLAGS_KEY_MASK(ds::ui::Image::IMG_CACHE_F);
+const int			IMAGE_FLAGS_KEY_MASK(ds::ui::Image::IMG_CACHE_F | ds::ui::Image::IMG_COMPRESS_F | ds::ui::Image::IMG_PROGRESSIVE_F);
+
+// Where compressed variants of IMG_COMPRESS_F images are kept between runs. The name
+// hashes the source and the ip function, since the function output is what gets encoded.
+std::string			get_compressed_cache_path(const ds::ui::ImageKey& key) {
+	const size_t		h = std::hash<std::string>()(key.mFilename + "|" + key.mIpKey + "|" + key.mIpParams);
+	std::stringstream	ss;
+	ss << ds::Environment::expand("%LOCAL%/cache/%PP%/compressed/") << std::hex << std::setw(16) << std::setfill('0') << h << ".dds";
+	return ss.str();
+}
+
+// Longest side of an IMG_PROGRESSIVE_F preview
+const int			PREVIEW_SIZE = 64;
+
+// Previews are cached like compressed variants, without the extension so a temp name can keep it.
+std::string			get_preview_cache_path(const ds::ui::ImageKey& key) {
+	const size_t		h = std::hash<std::string>()(key.mFilename + "|" + key.mIpKey + "|" + key.mIpParams);
+	std::stringstream	ss;
+	ss << ds::Environment::expand("%LOCAL%/cache/%PP%/preview/") << std::hex << std::setw(16) << std::setfill('0') << h;
+	return ss.str();
+}
+
+ci::Surface8u		make_preview(const ci::Surface8u& s) {
+	const int			longest = std::max(s.getWidth(), s.getHeight());
+	if(longest <= PREVIEW_SIZE) return s.clone();
+	const ci::ivec2		size(std::max(1, s.getWidth() * PREVIEW_SIZE / longest), std::max(1, s.getHeight() * PREVIEW_SIZE / longest));
+	return ci::ip::resize(s, s.getBounds(), size);
+}
 }
 
 namespace ds {
@@ -96,6 +131,11 @@ ci::gl::TextureRef ImageToken::getImage(float& fade) {
 	return mTextureRef;
 }
 
+ci::gl::TextureRef ImageToken::getPreview() {
+	if (!mAcquired || mTextureRef) return nullptr;
+	return mSrv.getPreview(mKey);
+}
+
 const ci::gl::TextureRef ImageToken::peekImage(const std::string& filename) const {
 	return mSrv.peekImage(mKey);
 }
@@ -112,17 +152,22 @@ void ImageToken::init() {
 LoadImageService::LoadImageService(ds::ui::SpriteEngine& eng, ds::ui::ip::FunctionList& list)
 		: mFunctions(list) 
 		, mLoadThreads(eng, [](){return new ds::ui::LoadImageService::ImageLoadThread(); })
+		, mUploads(eng.getGlUploadPool())
 		, mMaxSimultaneousLoads(1)
 		, mMaxLoadTries(128)
 		, mLoadsInProgress(0)
+		, mSeenCounter(0)
 {
 
 	mLoadThreads.setReplyHandler([this](ds::ui::LoadImageService::ImageLoadThread& q){ 
 		onLoadComplete(q); 
 	});
+	// Someone's usually waiting on an image, so loads go ahead of background work
+	mLoadThreads.setLane(ds::WorkRequest::LANE_INTERACTIVE);
 }
 
 LoadImageService::~LoadImageService(){
+	mUploads.cancel(this);
 	clear();
 }
 
@@ -136,7 +181,17 @@ bool LoadImageService::acquire(const ImageKey& key, const int flags) {
 	if((!h.mTextureRef) && h.mRefs < 1) {
 		// There's no image, so push on an operation to start one
 		auto oppy = ImageOperation(key, flags, mFunctions.find(key.mIpKey));
-		mOperationsQueue.push_back(oppy);
+		if((flags&Image::IMG_PROGRESSIVE_F) != 0) {
+			// The preview jumps the line, the full image waits until nothing else is loading
+			if(!h.mPreviewRef) {
+				auto preview = oppy;
+				preview.mPreview = true;
+				mOperationsQueue.push_back(preview);
+			}
+			mBackgroundQueue.push_back(oppy);
+		} else {
+			mOperationsQueue.push_back(oppy);
+		}
 		advanceQueue();
 	}
 
@@ -152,16 +207,46 @@ void LoadImageService::advanceQueue(){
 		return;
 	}
 
-	if(mOperationsQueue.empty()) return;
-
-	auto oppy = mOperationsQueue.front();
+	ImageOperation oppy;
+	if(!mOperationsQueue.empty()) {
+		oppy = mOperationsQueue.front();
+		mOperationsQueue.erase(mOperationsQueue.begin());
+	} else if(!popBackgroundOperation(oppy)) {
+		return;
+	}
 	oppy.mNumberTries++;
-	mOperationsQueue.erase(mOperationsQueue.begin());
 
 	mLoadsInProgress++;
 	mLoadThreads.start([this, oppy](ImageLoadThread& ilt){ ilt.mOutput = oppy; });
 }
 
+bool LoadImageService::popBackgroundOperation(ImageOperation& out) {
+	// Drop loads nobody needs any more: released, or the preview load happened to decode the full image
+	for(auto it = mBackgroundQueue.begin(); it != mBackgroundQueue.end(); ) {
+		auto							found = mImageResource.find(it->mKey);
+		if(found == mImageResource.end() || found->second.mTextureRef) {
+			it = mBackgroundQueue.erase(it);
+		} else {
+			++it;
+		}
+	}
+	if(mBackgroundQueue.empty()) return false;
+
+	// Images that haven't been drawn at all keep their request order
+	auto								best = mBackgroundQueue.begin();
+	int64_t								bestSeen = -1;
+	for(auto it = mBackgroundQueue.begin(), end = mBackgroundQueue.end(); it != end; ++it) {
+		const int64_t					seen = mImageResource.find(it->mKey)->second.mLastSeen;
+		if(seen > bestSeen) {
+			best = it;
+			bestSeen = seen;
+		}
+	}
+	out = *best;
+	mBackgroundQueue.erase(best);
+	return true;
+}
+
 void LoadImageService::release(const ImageKey& key) {
 	// Note:  As far as I can tell, find() always throws an error if the map is empty.
 	// Further, I can't even seem to catch the error, so really not sure what's going on there.
@@ -191,6 +276,14 @@ ci::gl::TextureRef LoadImageService::getImage(const ImageKey& key, float& fade)
 	return h.mTextureRef;
 }
 
+ci::gl::TextureRef LoadImageService::getPreview(const ImageKey& key) {
+	if (mImageResource.empty()) return nullptr;
+	auto it = mImageResource.find(key);
+	if (it == mImageResource.end()) return nullptr;
+	it->second.mLastSeen = ++mSeenCounter;
+	return it->second.mPreviewRef;
+}
+
 const ci::gl::TextureRef LoadImageService::peekImage(const ImageKey& key) const {
 	if (mImageResource.empty()) return nullptr;
 	auto it = mImageResource.find(key);
@@ -216,14 +309,14 @@ void LoadImageService::onLoadComplete(ImageLoadThread& loadThread){
 
 	mLoadsInProgress--;
 
+	if(loadThread.mOutput.mPreview) {
+		onPreviewComplete(loadThread);
+		return;
+	}
+
 	// if something went wrong (out of memory? no file? try again)
 	if(loadThread.mError){
-		if(loadThread.mOutput.mNumberTries >= mMaxLoadTries){
-			DS_LOG_WARNING("Gave up loading image for " << loadThread.mOutput.mKey.mFilename << " after " << loadThread.mOutput.mNumberTries << " attempts.");
-			loadThread.mOutput.clear();
-		} else {
-			mOperationsQueue.push_back(loadThread.mOutput);
-		}
+		retry(loadThread.mOutput);
 		advanceQueue();
 		return;
 	}
@@ -234,39 +327,106 @@ void LoadImageService::onLoadComplete(ImageLoadThread& loadThread){
 		// This isn't an error any more, and is just fine. Really the problem is that we spent a bunch of time loading the same image twice
 		//DS_LOG_WARNING_M("Duplicate images for id=" << out.mKey.mFilename << " refs=" << h.mRefs, LOAD_IMAGE_LOG_M);
 	} else {
-		ci::gl::Texture::Format	fmt;
-		if((h.mFlags&ds::ui::Image::IMG_ENABLE_MIPMAP_F) != 0) {
-			fmt.enableMipmapping(true);
-			fmt.setMinFilter(GL_LINEAR_MIPMAP_LINEAR);
-		} 
-		h.mTextureRef = ci::gl::Texture::create(out.mSurface, fmt);
-
-		// If we ran out of memory, try again! why not!
-		if(glGetError() == GL_OUT_OF_MEMORY) {
-			if(out.mNumberTries < 2){
-				DS_LOG_ERROR_M("LoadImageService::onLoadComplete() called on filename: " << out.mKey.mFilename << " received an out of memory error. Image may be too big.", LOAD_IMAGE_LOG_M);
-			}
-			if(h.mTextureRef) h.mTextureRef = nullptr;
+		startUpload(out, out.mSurface, (h.mFlags&ds::ui::Image::IMG_ENABLE_MIPMAP_F) != 0, false, false);
+	}
+	out.clear();
 
-			if(out.mNumberTries >= mMaxLoadTries){
-				DS_LOG_WARNING("Gave up loading image for " << loadThread.mOutput.mKey.mFilename << " after " << loadThread.mOutput.mNumberTries << " attempts.");
-				loadThread.mOutput.clear();
-				out.clear();
-			} else {
-				mOperationsQueue.push_back(out);
-			}
-			advanceQueue();
-			return;
+	advanceQueue();
+}
+
+void LoadImageService::onPreviewComplete(ImageLoadThread& loadThread){
+	// A failed preview isn't retried; the full load is still queued and will report any real problem
+	ImageOperation&			out = loadThread.mOutput;
+	auto					found = mImageResource.find(out.mKey);
+	if(!loadThread.mError && found != mImageResource.end() && !found->second.mTextureRef) {
+		ImageHolder&		h = found->second;
+		if(out.mPreviewSurface.getData()) {
+			startUpload(out, out.mPreviewSurface, false, true, false);
 		}
 
-		DS_REPORT_GL_ERRORS();
+		// Making the preview meant decoding the full image, so use it
+		if(out.mSurface.getData()) {
+			startUpload(out, out.mSurface, (h.mFlags&ds::ui::Image::IMG_ENABLE_MIPMAP_F) != 0, false, true);
+		}
 	}
 	out.clear();
-	loadThread.mOutput.clear();
 
 	advanceQueue();
 }
 
+void LoadImageService::startUpload(ImageOperation& op, ci::Surface8u& surface, const bool mipmap,
+								   const bool preview, const bool fromPreview){
+	std::shared_ptr<TextureUpload>	up(new TextureUpload());
+	up->mOp = ImageOperation(op.mKey, op.mFlags, op.mIpFunction);
+	up->mOp.mNumberTries = op.mNumberTries;
+	if(surface.getData()) up->mSurface = std::move(surface);
+	else up->mCompressed = std::move(op.mCompressed);
+	up->mMipmap = mipmap;
+	up->mPreview = preview;
+	up->mFromPreview = fromPreview;
+
+	mUploads.upload(this, [up](){
+		DS_PROFILE_SCOPE("image upload");
+		if(!up->mCompressed.empty()) {
+			up->mTexture = ds::gl::createCompressedTexture(up->mCompressed, up->mMipmap);
+		} else {
+			ci::gl::Texture::Format	fmt;
+			if(up->mMipmap) {
+				fmt.enableMipmapping(true);
+				fmt.setMinFilter(GL_LINEAR_MIPMAP_LINEAR);
+			}
+			up->mTexture = ci::gl::Texture::create(up->mSurface, fmt);
+		}
+		up->mOutOfMemory = (glGetError() == GL_OUT_OF_MEMORY);
+		if(up->mOutOfMemory) up->mTexture = nullptr;
+		DS_REPORT_GL_ERRORS();
+
+		// The pixels aren't needed once they're on the GPU
+		up->mSurface = ci::Surface8u();
+		up->mCompressed.clear();
+	}, [this, up](){
+		onUploadComplete(*up);
+	});
+}
+
+void LoadImageService::onUploadComplete(TextureUpload& up){
+	// Released while it was uploading
+	auto					found = mImageResource.find(up.mOp.mKey);
+	if(found == mImageResource.end()) return;
+	// A duplicate load, or the full image beat its preview
+	ImageHolder&			h = found->second;
+	if(h.mTextureRef) return;
+
+	if(up.mPreview) {
+		h.mPreviewRef = up.mTexture;
+		return;
+	}
+
+	// If we ran out of memory, try again! why not!
+	if(up.mOutOfMemory) {
+		// The background load will try again
+		if(up.mFromPreview) return;
+		if(up.mOp.mNumberTries < 2){
+			DS_LOG_ERROR_M("LoadImageService::onUploadComplete() called on filename: " << up.mOp.mKey.mFilename << " received an out of memory error. Image may be too big.", LOAD_IMAGE_LOG_M);
+		}
+		retry(up.mOp);
+		advanceQueue();
+		return;
+	}
+
+	h.mTextureRef = up.mTexture;
+	h.mPreviewRef = nullptr;
+}
+
+void LoadImageService::retry(ImageOperation& op){
+	if(op.mNumberTries >= mMaxLoadTries){
+		DS_LOG_WARNING("Gave up loading image for " << op.mKey.mFilename << " after " << op.mNumberTries << " attempts.");
+		op.clear();
+	} else {
+		mOperationsQueue.push_back(op);
+	}
+}
+
 void LoadImageService::clear()
 {
 	mImageResource.clear();
@@ -289,7 +449,22 @@ void LoadImageService::ImageLoadThread::run(){
 		const std::string					fn = ds::Environment::expand(mOutput.mKey.mFilename);
 		const Poco::File file(fn);
 
-		if(file.exists()) {
+		if(mOutput.mPreview) {
+			// Compressed containers have no cheap preview, they just wait for the full load
+			if(file.exists() && !ds::gl::isCompressedTextureFile(fn)) runPreview(fn, alpha);
+		} else if(file.exists() && ds::gl::isCompressedTextureFile(fn)) {
+			// Pre-compressed containers go straight to the GPU, so there's nothing for a function to operate on
+			if(!mOutput.mIpFunction.empty() && mOutput.mNumberTries < 2) {
+				DS_LOG_WARNING_M("LoadImageService::ImageLoadThread::run() ignoring image function on compressed file: " << mOutput.mKey.mFilename, LOAD_IMAGE_LOG_M);
+			}
+			if(ds::gl::loadCompressedTexture(fn, mOutput.mCompressed)) {
+				mError = false;
+			} else if(mOutput.mNumberTries < 2) {
+				DS_LOG_WARNING_M("LoadImageService::ImageLoadThread::run() unsupported compressed file: " << mOutput.mKey.mFilename, LOAD_IMAGE_LOG_M);
+			}
+		} else if(file.exists() && (mOutput.mFlags&ds::ui::Image::IMG_COMPRESS_F) != 0) {
+			runCompressed(fn, alpha);
+		} else if(file.exists()) {
 			mOutput.mSurface = ci::Surface8u(ci::loadImage(fn), ci::SurfaceConstraintsDefault(), alpha);
 			if(mOutput.mSurface.getData()) {
 				mOutput.mIpFunction.on(mOutput.mKey.mIpParams, mOutput.mSurface);
@@ -302,6 +477,8 @@ void LoadImageService::ImageLoadThread::run(){
 			mError = true;
 		}
 	} catch(std::exception const& ex) {
+		// Remote images don't get previews
+		if(mOutput.mPreview) return;
 
 		try{
 			// If there's a function, then require this image have an alpha channel, because
@@ -336,6 +513,74 @@ void LoadImageService::ImageLoadThread::run(){
 	}
 }
 
+void LoadImageService::ImageLoadThread::runCompressed(const std::string& fn, const boost::tribool& alpha){
+	// Use the cached variant if it's at least as new as the source
+	const std::string			cachePath = get_compressed_cache_path(mOutput.mKey);
+	try {
+		const Poco::File		cacheFile(cachePath);
+		if(cacheFile.exists() && cacheFile.getLastModified() >= Poco::File(fn).getLastModified()
+		   && ds::gl::loadCompressedTexture(cachePath, mOutput.mCompressed)) {
+			mError = false;
+			return;
+		}
+	} catch(std::exception const&) {
+	}
+
+	mOutput.mSurface = ci::Surface8u(ci::loadImage(fn), ci::SurfaceConstraintsDefault(), alpha);
+	if(!mOutput.mSurface.getData()) return;
+	mOutput.mIpFunction.on(mOutput.mKey.mIpParams, mOutput.mSurface);
+	mError = false;
+
+	// Always encode the full mip chain so the cached file serves both mipmapped and plain requests.
+	// If encoding fails the surface is still there and gets uploaded uncompressed.
+	if(!ds::gl::encodeSurface(mOutput.mSurface, 0, true, mOutput.mCompressed)) return;
+	mOutput.mSurface = ci::Surface8u();
+
+	try {
+		Poco::File(Poco::Path(cachePath).parent()).createDirectories();
+		// Write to the side and swap in, so a reader never sees a partial file
+		const std::string		tmpPath = cachePath + ".tmp";
+		if(ds::gl::writeDds(tmpPath, mOutput.mCompressed)) {
+			Poco::File(tmpPath).renameTo(cachePath);
+		}
+	} catch(std::exception const& ex) {
+		DS_LOG_WARNING_M("LoadImageService::ImageLoadThread::runCompressed() could not cache " << cachePath << " ex=" << ex.what(), LOAD_IMAGE_LOG_M);
+	}
+}
+
+void LoadImageService::ImageLoadThread::runPreview(const std::string& fn, const boost::tribool& alpha){
+	const std::string			cachePath = get_preview_cache_path(mOutput.mKey) + ".png";
+	try {
+		const Poco::File		cacheFile(cachePath);
+		if(cacheFile.exists() && cacheFile.getLastModified() >= Poco::File(fn).getLastModified()) {
+			mOutput.mPreviewSurface = ci::Surface8u(ci::loadImage(cachePath), ci::SurfaceConstraintsDefault(), alpha);
+			if(mOutput.mPreviewSurface.getData()) {
+				mError = false;
+				return;
+			}
+		}
+	} catch(std::exception const&) {
+	}
+
+	// First time for this image: decode it once, hand back the full surface, and cache a preview for next run.
+	mOutput.mSurface = ci::Surface8u(ci::loadImage(fn), ci::SurfaceConstraintsDefault(), alpha);
+	if(!mOutput.mSurface.getData()) return;
+	mOutput.mIpFunction.on(mOutput.mKey.mIpParams, mOutput.mSurface);
+	mOutput.mPreviewSurface = make_preview(mOutput.mSurface);
+	mError = false;
+
+	// Compressed images still take the compressed path in the background load
+	if((mOutput.mFlags&ds::ui::Image::IMG_COMPRESS_F) != 0) mOutput.mSurface = ci::Surface8u();
+
+	try {
+		Poco::File(Poco::Path(cachePath).parent()).createDirectories();
+		const std::string		tmpPath = get_preview_cache_path(mOutput.mKey) + ".tmp.png";
+		ci::writeImage(tmpPath, mOutput.mPreviewSurface);
+		Poco::File(tmpPath).renameTo(cachePath);
+	} catch(std::exception const& ex) {
+		DS_LOG_WARNING_M("LoadImageService::ImageLoadThread::runPreview() could not cache " << cachePath << " ex=" << ex.what(), LOAD_IMAGE_LOG_M);
+	}
+}
 
 /**
  * \class ds::ui::LoadImageService::holder
@@ -343,7 +588,18 @@ void LoadImageService::ImageLoadThread::run(){
 LoadImageService::ImageHolder::ImageHolder()
 		: mRefs(0)
 		, mError(false)
-		, mFlags(0) {
+		, mFlags(0)
+		, mLastSeen(0) {
+}
+
+/**
+ * \class ds::ui::LoadImageService::TextureUpload
+ */
+LoadImageService::TextureUpload::TextureUpload()
+		: mMipmap(false)
+		, mPreview(false)
+		, mFromPreview(false)
+		, mOutOfMemory(false) {
 }
 
 /**
@@ -352,6 +608,7 @@ LoadImageService::ImageHolder::ImageHolder()
 LoadImageService::ImageOperation::ImageOperation()
 		: mFlags(0)
 		, mNumberTries(0)
+		, mPreview(false)
 {
 }
 
@@ -364,15 +621,19 @@ LoadImageService::ImageOperation::ImageOperation(const ImageKey& key, const int
 		, mFlags(flags)
 		, mIpFunction(fn)
 		, mNumberTries(0)
+		, mPreview(false)
 {
 }
 
 void LoadImageService::ImageOperation::clear() {
 	mKey.clear();
 	mSurface = ci::Surface8u();
+	mCompressed.clear();
 	mFlags = 0;
 	mIpFunction.clear();
 	mNumberTries = 0;
+	mPreview = false;
+	mPreviewSurface = ci::Surface8u();
 }
 
 } // namespace ui
@@ -4,14 +4,18 @@
 
 #include <unordered_map>
 #include <vector>
+#include <boost/logic/tribool.hpp>
 #include <cinder/Surface.h>
 #include <cinder/gl/Texture.h>
 #include "ds/app/engine/engine_service.h"
+#include "ds/gl/compressed_texture.h"
 #include "ds/ui/ip/ip_function_list.h"
 
 #include "ds/thread/parallel_runnable.h"
 
 namespace ds {
+class GlUploadPool;
+
 namespace ui {
 class LoadImageService;
 
@@ -81,6 +85,9 @@ public:
 	void					release();
 
 	ci::gl::TextureRef		getImage(float& fade);
+	/// For IMG_PROGRESSIVE_F images, a small preview to show until getImage() has
+	/// something. Calling this marks the image as on screen, so its full load goes sooner.
+	ci::gl::TextureRef		getPreview();
 
 	/// No refs are acquired, no image is loaded -- if it exists, answer it
 	const ci::gl::TextureRef	peekImage(const std::string& filename) const;
@@ -97,7 +104,8 @@ private:
 
 /**
  * \class ds::ui::LoadImageService
- * \brief Manage and load images.
+ * \brief Manage and load images. Files are decoded on the work manager's
+ * threads, and turned into textures on the engine's GL upload threads.
  */
 class LoadImageService  {
 public:
@@ -109,6 +117,7 @@ public:
 	void						release(const ImageKey& key);
 
 	ci::gl::TextureRef			getImage(const ImageKey&, float& fade);
+	ci::gl::TextureRef			getPreview(const ImageKey&);
 	// No refs are acquired, no image is loaded -- if it exists, answer it
 	const ci::gl::TextureRef	peekImage(const ImageKey&) const;
 	// Answer true if the token exists (though the image might not be loaded), supplying the flags if you like
@@ -123,8 +132,12 @@ private:
 
 		int						mRefs;
 		ci::gl::TextureRef		mTextureRef;
+		// Progressive images only, dropped once the full texture arrives
+		ci::gl::TextureRef		mPreviewRef;
 		bool					mError;
 		int						mFlags;
+		// When the preview was last asked for, to load on-screen images first
+		int64_t					mLastSeen;
 	};
 
 	// an op for loading images
@@ -137,9 +150,33 @@ private:
 
 		ImageKey				mKey;
 		ci::Surface8u			mSurface;
+		// Filled instead of mSurface for DDS/KTX files and IMG_COMPRESS_F images
+		ds::gl::CompressedTextureData
+								mCompressed;
 		int						mFlags;
 		ds::ui::ip::FunctionRef	mIpFunction;
 		int						mNumberTries;
+		// Preview operations fill mPreviewSurface, and mSurface too if they had to decode the full image
+		bool					mPreview;
+		ci::Surface8u			mPreviewSurface;
+	};
+
+	// Pixels on their way to becoming a texture
+	struct TextureUpload {
+		TextureUpload();
+
+		// Everything but the pixels, to retry with
+		ImageOperation			mOp;
+		ci::Surface8u			mSurface;
+		ds::gl::CompressedTextureData
+								mCompressed;
+		bool					mMipmap;
+		// A preview becomes mPreviewRef. A full image that came along with a
+		// preview isn't retried, since its background load is still queued.
+		bool					mPreview;
+		bool					mFromPreview;
+		ci::gl::TextureRef		mTexture;
+		bool					mOutOfMemory;
 	};
 
 	class ImageLoadThread : public Poco::Runnable {
@@ -149,6 +186,12 @@ private:
 			virtual void						run();
 			ImageOperation						mOutput;
 			bool								mError;
+
+		private:
+			// Load from the compressed cache, or decode and encode a new variant
+			void								runCompressed(const std::string& fn, const boost::tribool& alpha);
+			// Load from the preview cache, or decode the full image and make a new preview
+			void								runPreview(const std::string& fn, const boost::tribool& alpha);
 	};
 
 // ImageLoadService Private members ------------------------------------
@@ -159,14 +202,27 @@ private:
 	std::unordered_map<ImageKey, ImageHolder>	mImageResource;
 
 	void										onLoadComplete(ImageLoadThread& loadThread);
+	void										onPreviewComplete(ImageLoadThread& loadThread);
+	// Takes the surface's pixels, or the op's compressed data if the surface is empty
+	void										startUpload(ImageOperation&, ci::Surface8u&, const bool mipmap,
+															const bool preview, const bool fromPreview);
+	void										onUploadComplete(TextureUpload&);
+	// Log, and retry the op unless it has run out of tries
+	void										retry(ImageOperation&);
 	void										advanceQueue();
+	// Take the next full load of a progressive image, most recently seen first
+	bool										popBackgroundOperation(ImageOperation&);
 	int											mLoadsInProgress;
 	const int									mMaxSimultaneousLoads;
 	const int									mMaxLoadTries;
 
 	std::vector<ImageOperation>					mOperationsQueue;
+	// Full loads for IMG_PROGRESSIVE_F images, which only run when mOperationsQueue is empty
+	std::vector<ImageOperation>					mBackgroundQueue;
+	int64_t										mSeenCounter;
 
 	ds::ParallelRunnable<ImageLoadThread>		mLoadThreads;
+	ds::GlUploadPool&							mUploads;
 };
 
 } // namespace ui
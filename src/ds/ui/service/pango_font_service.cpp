@@ -21,6 +21,8 @@ namespace ui {
 
 PangoFontService::PangoFontService(ds::ui::SpriteEngine& eng)
 	: mFontMap(nullptr)
+	, mAsyncText(false)
+	, mUseGlyphAtlas(false)
 {
 	DS_LOG_INFO_M("Initializing Pango version " << PANGO_VERSION_STRING, PANGO_FONT_LOG_M);
 	std::cout << "Initializing Pango version " << PANGO_VERSION_STRING << std::endl;
@@ -37,6 +39,17 @@ PangoFontService::PangoFontService(ds::ui::SpriteEngine& eng)
 	}
 }
 
+PangoFontService::~PangoFontService(){
+	std::lock_guard<std::mutex> lock(mContextMutex);
+	for(auto it : mThreadFonts){
+		for(auto context : it.second.mFreeContexts){
+			g_object_unref(context);
+		}
+		if(it.second.mFontMap) g_object_unref(it.second.mFontMap);
+	}
+	mThreadFonts.clear();
+}
+
 void PangoFontService::loadFonts(){
 	DS_LOG_INFO("Creating pango font map...");
 
@@ -179,6 +192,74 @@ PangoFontMap* PangoFontService::getPangoFontMap(){
 	return mFontMap;
 }
 
+PangoContext* PangoFontService::acquireContext(){
+	PangoFontMap* fontMap = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mContextMutex);
+		ThreadFonts& fonts = mThreadFonts[std::this_thread::get_id()];
+		if(!fonts.mFreeContexts.empty()){
+			PangoContext* context = fonts.mFreeContexts.back();
+			fonts.mFreeContexts.pop_back();
+			return context;
+		}
+
+		// The main thread's map is off limits here, this thread gets a map of its own. It sees
+		// the same fonts, fontconfig's current config is shared and fontconfig locks itself.
+		if(!fonts.mFontMap){
+			fonts.mFontMap = pango_cairo_font_map_new();
+			if(!fonts.mFontMap){
+				DS_LOG_WARNING_M("Cannot create a pango font map for a worker.", PANGO_FONT_LOG_M);
+				return nullptr;
+			}
+		}
+		fontMap = fonts.mFontMap;
+	}
+
+	// Only this thread uses its map, so no lock
+	PangoContext* context = pango_font_map_create_context(fontMap);
+	if(!context){
+		DS_LOG_WARNING_M("Cannot create a pango font context for a worker.", PANGO_FONT_LOG_M);
+		return nullptr;
+	}
+
+	// Match the options in Text::measurePangoText(), so async text looks the same
+	cairo_font_options_t* options = cairo_font_options_create();
+	cairo_font_options_set_antialias(options, CAIRO_ANTIALIAS_SUBPIXEL);
+	cairo_font_options_set_hint_style(options, CAIRO_HINT_STYLE_DEFAULT);
+	cairo_font_options_set_hint_metrics(options, CAIRO_HINT_METRICS_ON);
+	cairo_font_options_set_subpixel_order(options, CAIRO_SUBPIXEL_ORDER_RGB);
+	pango_cairo_context_set_font_options(context, options);
+	cairo_font_options_destroy(options);
+
+	return context;
+}
+
+void PangoFontService::releaseContext(PangoContext* context){
+	if(!context) return;
+	std::lock_guard<std::mutex> lock(mContextMutex);
+	mThreadFonts[std::this_thread::get_id()].mFreeContexts.push_back(context);
+}
+
+void PangoFontService::setAsyncText(const bool async){
+	mAsyncText = async;
+}
+
+bool PangoFontService::getAsyncText() const {
+	return mAsyncText;
+}
+
+GlyphAtlas& PangoFontService::getGlyphAtlas(){
+	return mGlyphAtlas;
+}
+
+void PangoFontService::setUseGlyphAtlas(const bool use){
+	mUseGlyphAtlas = use;
+}
+
+bool PangoFontService::getUseGlyphAtlas() const {
+	return mUseGlyphAtlas;
+}
+
 void PangoFontService::setTextSuffix(const std::wstring& suffix){
 	mTextSuffix = suffix;
 }
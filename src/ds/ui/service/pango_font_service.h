@@ -3,12 +3,17 @@
 #define DS_UI_SERVICE_PANGO_FONT_SERVICE_H_
 
 #include "ds/app/engine/engine_service.h"
+#include "ds/ui/service/glyph_atlas.h"
 
 #include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 struct _PangoFontMap;
+struct _PangoContext;
 typedef struct _PangoFontMap PangoFontMap;
+typedef struct _PangoContext PangoContext;
 
 namespace ds {
 namespace ui {
@@ -43,6 +48,7 @@ private:
 public:
 
 	PangoFontService(ds::ui::SpriteEngine& eng);
+	~PangoFontService();
 
 	/// Clears previously-loaded fonts and reloads the fonts installed in Windows
 	void										loadFonts();
@@ -63,6 +69,23 @@ public:
 	/// For creating pango contexts. Check for nullptr before using
 	PangoFontMap*								getPangoFontMap();
 
+	/// A context for a worker thread, with the same font options text sprites use. Pango font maps
+	/// aren't thread safe, so each calling thread gets its own map, and never the main thread's.
+	/// Contexts are pooled per thread, so hand it back with releaseContext() on the same thread
+	/// when done. Any thread, check for nullptr.
+	PangoContext*								acquireContext();
+	void										releaseContext(PangoContext*);
+
+	/// When on, text sprites lay out and rasterize on the GL upload threads ("text:async" setting)
+	void										setAsyncText(const bool);
+	bool										getAsyncText() const;
+
+	/// Glyphs shared by text sprites that draw from the atlas. Main thread only.
+	GlyphAtlas&									getGlyphAtlas();
+	/// Whether new text sprites draw from the glyph atlas ("text:glyph_atlas" setting)
+	void										setUseGlyphAtlas(const bool);
+	bool										getUseGlyphAtlas() const;
+
 	/// A really hacky way to fix some font rendering clipping issues.
 	/// If your text is rendering ok, no need to mess with this.
 	void										setTextSuffix(const std::wstring& suffix);
@@ -73,6 +96,18 @@ private:
 	std::map<std::string, DsPangoFontFamily>	mLoadedFamilies;
 	std::map<std::string, DsPangoFontFace>		mLoadedFonts;
 	std::wstring								mTextSuffix;
+	bool										mAsyncText;
+	bool										mUseGlyphAtlas;
+	GlyphAtlas									mGlyphAtlas;
+
+	// A font map and its free contexts for each thread that's asked for one
+	struct ThreadFonts {
+		ThreadFonts() : mFontMap(nullptr) { }
+		PangoFontMap*							mFontMap;
+		std::vector<PangoContext*>				mFreeContexts;
+	};
+	std::mutex									mContextMutex;
+	std::map<std::thread::id, ThreadFonts>		mThreadFonts;
 };
 
 } // namespace ui
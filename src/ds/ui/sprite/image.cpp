@@ -202,7 +202,11 @@ void Image::onUpdateClient(const UpdateParams& up){
 }
 
 void Image::drawLocalClient(){
-	if (!inBounds() || !isLoaded()) return;
+	if (!inBounds()) return;
+	if (!isLoaded()) {
+		drawPreview();
+		return;
+	}
 
 	if (auto tex = mImageSource.getImage())
 	{
@@ -219,6 +223,20 @@ void Image::drawLocalClient(){
 	}
 }
 
+void Image::drawPreview(){
+	// Stretched over the size from the image meta data until the real texture shows up
+	auto tex = mImageSource.getPreviewImage();
+	if (!tex || getWidth() < 1.0f || getHeight() < 1.0f) return;
+
+	tex->bind();
+	if (getPerspective()) {
+		ci::gl::drawSolidRect(ci::Rectf(0.0f, getHeight(), getWidth(), 0.0f));
+	} else {
+		ci::gl::drawSolidRect(ci::Rectf(0.0f, 0.0f, getWidth(), getHeight()));
+	}
+	tex->unbind();
+}
+
 void Image::setSizeAll( float width, float height, float depth ){
 	setScale( width / getWidth(), height / getHeight() );
 }
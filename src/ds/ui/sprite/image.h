@@ -26,6 +26,13 @@ public:
 	static const int			IMG_PRELOAD_F = (1<<1);
 	// Enable mipmapping. This only applies to an image source, so being here is weird.
 	static const int			IMG_ENABLE_MIPMAP_F = (1<<2);
+	// Upload as a GPU-compressed texture (BC1, or BC3 with alpha). The compressed variant is
+	// encoded in the background on first load and kept in the derived-image cache.
+	// DDS and KTX files are always uploaded compressed, regardless of this flag.
+	static const int			IMG_COMPRESS_F = (1<<3);
+	// Show a small preview (kept in the derived-image cache) right away, and load the
+	// full image in the background, images that are on screen first.
+	static const int			IMG_PROGRESSIVE_F = (1<<4);
 
 	
 	static Image&				makeImage(SpriteEngine&, const std::string& filename, Sprite* parent = nullptr);
@@ -87,6 +94,7 @@ private:
 	typedef Sprite				inherited;
 
 	void						setStatus(const int);
+	void						drawPreview();
 	void						doOnImageLoaded();
 	void						doOnImageUnloaded();
 
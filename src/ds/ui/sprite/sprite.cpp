@@ -14,11 +14,13 @@
 #include "ds/math/math_func.h"
 #include "ds/math/random.h"
 #include "ds/ui/sprite/sprite_engine.h"
+#include "ds/ui/touch/gesture_engine.h"
 #include "ds/ui/tween/tweenline.h"
 #include "ds/util/string_util.h"
 #include "util/clip_plane.h"
 #include "ds/params/draw_params.h"
 
+#include <cfloat>
 #include <Poco/Debugger.h>
 #include "cinder/ImageIo.h"
 #include <cinder/Ray.h>
@@ -80,6 +82,26 @@ const int			ROTATE_TOUCHES_F = (1 << 7);
 const int			DRAW_DEBUG_F		= (1<<8);
 
 const ds::BitMask	SPRITE_LOG = ds::Logger::newModule("sprite");
+
+// Whether the line through origin along dir crosses the box. Either side of the
+// origin counts, the same as the quad test.
+bool				ray_hits_box(const ci::vec3& origin, const ci::vec3& dir, const ci::vec3& lo, const ci::vec3& hi) {
+	// Nothing under it to hit
+	if(lo.x > hi.x) return false;
+	float			tMin = -FLT_MAX, tMax = FLT_MAX;
+	for(int axis = 0; axis < 3; ++axis) {
+		if(dir[axis] == 0.0f) {
+			if(origin[axis] < lo[axis] || origin[axis] > hi[axis]) return false;
+			continue;
+		}
+		const float	t0 = (lo[axis] - origin[axis]) / dir[axis];
+		const float	t1 = (hi[axis] - origin[axis]) / dir[axis];
+		tMin = std::max(tMin, std::min(t0, t1));
+		tMax = std::min(tMax, std::max(t0, t1));
+		if(tMin > tMax) return false;
+	}
+	return true;
+}
 }
 
 void Sprite::installAsServer(ds::BlobRegistry& registry) {
@@ -105,7 +127,7 @@ Sprite::Sprite(SpriteEngine& engine, float width /*= 0.0f*/, float height /*= 0.
 	, mParent(nullptr)
 	, mWidth(width)
 	, mHeight(height)
-	, mTouchProcess(engine, *this)
+	, mTouchProcess(nullptr)
 	, mSpriteShader(Environment::getAppFolder("data/shaders"), "base")
 	, mIdleTimer(engine)
 	, mLastWidth(width)
@@ -123,7 +145,7 @@ Sprite::Sprite(SpriteEngine& engine, const ds::sprite_id_t id, const bool perspe
 	, mEngine(engine)
 	, mId(ds::EMPTY_SPRITE_ID)
 	, mParent(nullptr)
-	, mTouchProcess(engine, *this)
+	, mTouchProcess(nullptr)
 	, mSpriteShader(Environment::getAppFolder("data/shaders"), "base")
 	, mIdleTimer(engine)
 	, mLastWidth(0)
@@ -144,11 +166,14 @@ void Sprite::init(const ds::sprite_id_t id) {
 	mRotationOrderZYX = false;
 	mScale = ci::vec3(1.0f, 1.0f, 1.0f);
 	mUpdateTransform = true;
+	mPickBoundsDirty = true;
+	mPickSize = ci::vec2(0.0f, 0.0f);
 	mParent = nullptr;
 	mOpacity = 1.0f;
 	mColor = ci::Color(1.0f, 1.0f, 1.0f);
 	mMultiTouchEnabled = false;
 	mCheckBounds = false;
+	mParallelUpdate = false;
 	mBoundsNeedChecking = true;
 	mInBounds = true;
 	mDepth = 1.0f;
@@ -202,6 +227,8 @@ Sprite::~Sprite() {
 	cancelDelayedCall();
 
 	mEngine.removeFromDragDestinationList(this);
+	if(mParallelUpdate) mEngine.getParallelUpdate().remove(*this);
+	if(mTouchProcess) mEngine.getGestureEngine().release(*mTouchProcess);
 
 	// We only want to request a delete for the sprite at the head of a tree,
 	const sprite_id_t	id = mId;
@@ -223,22 +250,39 @@ Sprite::~Sprite() {
 }
 
 void Sprite::updateClient(const UpdateParams &p) {
+	if(mParallelUpdate && mEngine.getParallelUpdate().queue(*this)) {
+		return;
+	}
+
+	runUpdateClient(p);
+}
+
+void Sprite::updateServer(const UpdateParams &p) {
+	if(mParallelUpdate && mEngine.getParallelUpdate().queue(*this)) {
+		return;
+	}
+
+	runUpdateServer(p, true);
+}
+
+void Sprite::runUpdateClient(const UpdateParams &p) {
 	mIdleTimer.update();
 
 	if(mCheckBounds) {
 		updateCheckBounds();
 	}
 
+	// Children of a parallel sprite update inline, on the same thread.
+	const bool inParallel = mEngine.getParallelUpdate().isRunning();
 	for(auto it = mChildren.begin(), it2 = mChildren.end(); it != it2; ++it) {
-		(*it)->updateClient(p);
+		if(inParallel) (*it)->runUpdateClient(p);
+		else (*it)->updateClient(p);
 	}
 
 	onUpdateClient(p);
 }
 
-void Sprite::updateServer(const UpdateParams &p) {
-	mTouchProcess.update(p);
-
+void Sprite::runUpdateServer(const UpdateParams &p, const bool onMainThread) {
 	mIdleTimer.update();
 
 	if(mCheckBounds) {
@@ -246,12 +290,44 @@ void Sprite::updateServer(const UpdateParams &p) {
 	}
 
 	for(auto it = mChildren.begin(), it2 = mChildren.end(); it != it2; ++it) {
-		(*it)->updateServer(p);
+		if(onMainThread) (*it)->updateServer(p);
+		else (*it)->runUpdateServer(p, false);
 	}
 
 	onUpdateServer(p);
 }
 
+void Sprite::prepareParallelUpdate(std::vector<std::pair<int, Sprite*>>& marked) {
+	// Transforms are built lazily, so build the parents' now, before several
+	// threads try to at once for their bounds checks.
+	buildGlobalTransform();
+	// Marking a sprite dirty walks up its parents until one is already marked.
+	// Stop that walk here, so it never leaves the subtree.
+	int depth = 0;
+	for(Sprite* s = mParent; s; s = s->mParent) ++depth;
+	for(Sprite* s = this; s && !(s->mDirty&CHILD_DIRTY); s = s->mParent, --depth) {
+		s->mDirty |= CHILD_DIRTY;
+		marked.push_back(std::make_pair(depth, s));
+	}
+}
+
+void Sprite::finishParallelUpdate() {
+	for(auto it = mChildren.begin(), end = mChildren.end(); it != end; ++it) {
+		if(!(*it)->mDirty.isEmpty()) return;
+	}
+	mDirty &= ~CHILD_DIRTY;
+}
+
+void Sprite::setParallelUpdate(const bool parallel) {
+	if(mParallelUpdate == parallel) return;
+	if(!parallel) mEngine.getParallelUpdate().remove(*this);
+	mParallelUpdate = parallel;
+}
+
+bool Sprite::getParallelUpdate() const {
+	return mParallelUpdate;
+}
+
 void Sprite::drawClient(const ci::mat4 &trans, const DrawParams &drawParams) {
 	if ((mSpriteFlags&VISIBLE_F) == 0) {
 		return;
@@ -663,6 +739,7 @@ void Sprite::addChild(Sprite &child){
 
 	mChildren.push_back(&child);
 	child.setParent(this);
+	markPickBoundsDirty();
 	child.setPerspective(mPerspective);
 	child.setDrawSorted(getDrawSorted());
 	child.setUseDepthBuffer(mUseDepthBuffer);
@@ -678,6 +755,7 @@ void Sprite::removeChild(Sprite &child){
 
 	auto found = std::find(mChildren.begin(), mChildren.end(), &child);
 	if(found != mChildren.end()) mChildren.erase(found);
+	markPickBoundsDirty();
 	if(child.getParent() == this) {
 		child.setParent(nullptr);
 		child.setPerspective(false);
@@ -903,7 +981,7 @@ float Sprite::getHeight() const {
 }
 
 void Sprite::enable(bool flag) {
-	mTouchProcess.clearTouches();
+	if(mTouchProcess) mTouchProcess->clearTouches();
 	setFlag(ENABLED_F, flag, FLAGS_DIRTY, mSpriteFlags);
 }
 
@@ -1042,38 +1120,113 @@ Sprite* Sprite::getPerspectiveHit(CameraPick& pick) {
 	if(!visible())
 		return nullptr;
 
-	ci::vec3 hitWorldPos;
-	static float hitZ;
-
-	// Collect hit candidates from children first, before considering this sprite
-	makeSortedChildren();
-	typedef std::pair<ds::ui::Sprite*, float> HitCandidate;
-	std::vector<HitCandidate> candidates;
-	for (auto it = mSortedTmp.rbegin(), it2 = mSortedTmp.rend(); it != it2; ++it) {
-		Sprite* hit = (*it)->getPerspectiveHit(pick);
-		if (hit) {
-			candidates.push_back(std::make_pair(hit, hitZ));
-				//std::cout << "Found pick candidate: " << hit->getParent()->localToGlobal(hit->getPosition()).z << " " << hit->getId() << std::endl;
-				//return hit;
+	updatePickBounds();
+
+	// The ray goes down the tree in each sprite's own space. Points and directions
+	// are transformed separately, so the distance along it stays the world distance.
+	ci::vec3 origin = pick.getPickRay().getOrigin();
+	ci::vec3 dir = pick.getPickRay().getDirection();
+	if(mParent) {
+		mParent->buildGlobalTransform();
+		origin = ci::vec3(mParent->mInverseGlobalTransform * ci::vec4(origin, 1.0f));
+		dir = ci::vec3(mParent->mInverseGlobalTransform * ci::vec4(dir, 0.0f));
+	}
+
+	float depth = 0.0f;
+	return findPerspectiveHit(pick, origin, dir, depth);
+}
+
+Sprite* Sprite::findPerspectiveHit(const CameraPick& pick, const ci::vec3& parentOrigin, const ci::vec3& parentDir, float& depth) {
+	if(!visible())
+		return nullptr;
+
+	const ci::vec3 origin(mInverseTransform * ci::vec4(parentOrigin, 1.0f));
+	const ci::vec3 dir(mInverseTransform * ci::vec4(parentDir, 0.0f));
+	if(!ray_hits_box(origin, dir, mPickBoundsMin, mPickBoundsMax))
+		return nullptr;
+
+	// Children first. The nearest child hit wins, and beats me even if I'm nearer.
+	Sprite* best = nullptr;
+	float bestDepth = 0.0f;
+	float bestZ = 0.0f;
+	for(auto it = mChildren.rbegin(), it2 = mChildren.rend(); it != it2; ++it) {
+		Sprite* child = *it;
+		float childDepth = 0.0f;
+		Sprite* hit = child->findPerspectiveHit(pick, origin, dir, childDepth);
+		if(!hit) continue;
+		// Ties go to the child furthest forward
+		if(!best || childDepth < bestDepth || (childDepth == bestDepth && child->mPosition.z > bestZ)) {
+			best = hit;
+			bestDepth = childDepth;
+			bestZ = child->mPosition.z;
 		}
 	}
+	if(best) {
+		depth = bestDepth;
+		return best;
+	}
 
-	// Return the child hit candidate with the nearest hitZ (closest to camera)
-	auto nearestCandidate = std::min_element(candidates.begin(), candidates.end(),
-		[](const HitCandidate &lhs, const HitCandidate& rhs) {
-		return lhs.second < rhs.second;
-	});
-	if (nearestCandidate != candidates.end()) {
-		hitZ = nearestCandidate->second;
-		return nearestCandidate->first;
+	// My own quad is the z = 0 plane from 0,0 to my size
+	if(!isEnabled() || mScale.x * mPickSize.x <= 0.0f || mScale.y * mPickSize.y <= 0.0f || dir.z == 0.0f)
+		return nullptr;
+	const float rayDist = -origin.z / dir.z;
+	const ci::vec3 pt = origin + dir * rayDist;
+	if(pt.x < std::min(0.0f, mPickSize.x) || pt.x > std::max(0.0f, mPickSize.x)
+		|| pt.y < std::min(0.0f, mPickSize.y) || pt.y > std::max(0.0f, mPickSize.y))
+		return nullptr;
+
+	depth = pick.calcHitDepth(pick.getPickRay().calcPosition(rayDist));
+	return this;
+}
+
+void Sprite::markPickBoundsDirty() {
+	// A clean sprite never has a dirty child, so stop at the first one that's already dirty
+	for(Sprite* s = this; s && !s->mPickBoundsDirty; s = s->mParent) {
+		s->mPickBoundsDirty = true;
 	}
+}
 
-	if (pick.testHitSprite(this, hitWorldPos)) {
-		hitZ = pick.calcHitDepth(hitWorldPos);
-		return this;
+void Sprite::updatePickBounds() const {
+	if(!mPickBoundsDirty)
+		return;
+	// Cleared first, so anything that changes while I'm measuring leaves me dirty for next time
+	mPickBoundsDirty = false;
+
+	// Text measures itself here, which can resize it, so size before the transform
+	mPickSize = ci::vec2(getWidth(), getHeight());
+	buildTransform();
+
+	ci::vec3 lo(FLT_MAX, FLT_MAX, FLT_MAX);
+	ci::vec3 hi(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	if(mScale.x * mPickSize.x > 0.0f && mScale.y * mPickSize.y > 0.0f) {
+		lo = glm::min(ci::vec3(0.0f), ci::vec3(mPickSize, 0.0f));
+		hi = glm::max(ci::vec3(0.0f), ci::vec3(mPickSize, 0.0f));
 	}
 
-	return nullptr;
+	for(auto it = mChildren.begin(), it2 = mChildren.end(); it != it2; ++it) {
+		const Sprite* child = *it;
+		child->updatePickBounds();
+		if(child->mPickBoundsMin.x > child->mPickBoundsMax.x)
+			continue;
+		// The child's box, moved into my space
+		const ci::vec3& a = child->mPickBoundsMin;
+		const ci::vec3& b = child->mPickBoundsMax;
+		for(int corner = 0; corner < 8; ++corner) {
+			const ci::vec4 p(corner & 1 ? b.x : a.x, corner & 2 ? b.y : a.y, corner & 4 ? b.z : a.z, 1.0f);
+			const ci::vec3 q(child->mTransformation * p);
+			lo = glm::min(lo, q);
+			hi = glm::max(hi, q);
+		}
+	}
+
+	if(lo.x <= hi.x) {
+		// A little slack, so rays that just graze a flat box aren't lost to rounding
+		const ci::vec3 pad = (hi - lo) * 0.0001f + ci::vec3(0.0001f);
+		lo -= pad;
+		hi += pad;
+	}
+	mPickBoundsMin = lo;
+	mPickBoundsMax = hi;
 }
 
 void Sprite::setProcessTouchCallback(const std::function<void(Sprite *, const TouchInfo &)> &func){
@@ -1081,7 +1234,7 @@ void Sprite::setProcessTouchCallback(const std::function<void(Sprite *, const To
 }
 
 void Sprite::processTouchInfo(const TouchInfo &touchInfo) {
-	mTouchProcess.processTouchInfo(touchInfo);
+	mEngine.getGestureEngine().process(*this, touchInfo);
 }
 
 void Sprite::move(const ci::vec3 &delta) {
@@ -1772,6 +1925,7 @@ void Sprite::computeClippingBounds(){
 
 void Sprite::dimensionalStateChanged(){
 	markClippingDirty();
+	markPickBoundsDirty();
 	if (mLastWidth != mWidth || mLastHeight != mHeight) {
 		mLastWidth = mWidth;
 		mLastHeight = mHeight;
@@ -1931,7 +2085,7 @@ void Sprite::setSwipeCallback( const std::function<void (Sprite *, const ci::vec
 }
 
 bool Sprite::hasTouches() const {
-	return mTouchProcess.hasTouches();
+	return mTouchProcess && mTouchProcess->hasTouches();
 }
 
 void Sprite::passTouchToSprite( Sprite *destinationSprite, const TouchInfo &touchInfo ) {
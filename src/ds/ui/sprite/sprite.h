@@ -37,10 +37,12 @@ class DrawParams;
 class Engine;
 class EngineRoot;
 class Event;
+class ParallelUpdate;
 class UpdateParams;
 
 namespace ui {
 	struct DragDestinationInfo;
+	class GestureEngine;
 	struct TapInfo;
 	struct TouchInfo;
 
@@ -112,6 +114,15 @@ namespace ui {
 		\param updateParams UpdateParams containing some conveniences such as delta time.		*/
 		virtual void			onUpdateServer(const ds::UpdateParams& updateParams){}
 
+		/** Update this sprite and its children on a worker thread, alongside other sprites that do the same,
+			after the rest of the tree has updated. Only turn this on if onUpdateServer() / onUpdateClient()
+			for the whole subtree change nothing outside of it: anything else (adding or removing sprites
+			elsewhere, sending events, using services) has to go through ParallelUpdate::deferToMain().
+			Touch processing still happens on the main thread. Default is false.
+			\param parallel If true, the subtree may update on another thread.		*/
+		void					setParallelUpdate(const bool parallel);
+		bool					getParallelUpdate() const;
+
 		/** Draw function for when this app is set to be a client.
 			In most cases, you'll want to override drawLocalClient() to do custom drawing, as this function handles drawing for children as well.
 			\param transformMatrix The transform matrix of the parent.
@@ -524,6 +535,9 @@ namespace ui {
 
 		/** Recursively checks the Sprite hierarchy list for an enabled, visible sprite with a scale > 0.0 and any size for touch picking.
 			This is for Perspective Sprites. Ortho Sprites use getHit()
+			Each sprite caches the bounds of itself and everything under it, so subtrees the ray misses are skipped.
+			Once the bounds are current (the first pick after a change brings them up to date) a pick only reads,
+			so picks for several fingers can run on different threads as long as nothing is changing the sprites.
 			\param pick Some parameters for perspective picking.
 			\return The Sprite that is the best candidate for touch picking. Can return nullptr if there was no valid pick.*/
 		Sprite*					getPerspectiveHit(CameraPick& pick);
@@ -689,6 +703,7 @@ namespace ui {
 		bool					mExportWithXml;
 
 	protected:
+		friend class        GestureEngine;
 		friend class        TouchManager;
 		friend class        TouchProcess;
 		friend class		ds::gl::ClipPlaneState;
@@ -711,6 +726,19 @@ namespace ui {
 		void				updateCheckBounds() const;
 		bool				checkBounds() const;
 
+		// My size or transform changed, so my pick bounds and my parents' need rebuilding.
+		// Subclasses that size themselves lazily call this when their size is about to change.
+		void				markPickBoundsDirty();
+
+		// The body of updateServer() and updateClient(), minus handing off to the parallel update.
+		void				runUpdateServer(const ds::UpdateParams&, const bool onMainThread);
+		void				runUpdateClient(const ds::UpdateParams&);
+		// Set up anything outside the subtree it might touch while updating in parallel.
+		// Adds the sprites I marked CHILD_DIRTY, with their depth in the tree.
+		void				prepareParallelUpdate(std::vector<std::pair<int, Sprite*>>& marked);
+		// Undo a CHILD_DIRTY from prepareParallelUpdate() if none of my children changed.
+		void				finishParallelUpdate();
+
 		// Once the sprite has passed the getHit() sprite bounds, this is a second
 		// stage that allows the sprite itself to determine if the point is interior,
 		// in the case that the sprite has transparency or other special rules.
@@ -825,6 +853,11 @@ namespace ui {
 		// a lot more efficient, only running the sort when Z changes.
 		std::vector<Sprite*>	mSortedTmp;
 
+		// Perspective picking. My size, and a box around me and everything under me, in my own space.
+		mutable bool			mPickBoundsDirty;
+		mutable ci::vec2		mPickSize;
+		mutable ci::vec3		mPickBoundsMin, mPickBoundsMax;
+
 		// Class-unique key for this type.  Subclasses can replace.
 		char					mBlobType;
 		DirtyState				mDirty;
@@ -840,10 +873,12 @@ namespace ui {
 		BitMask				mMultiTouchConstraints;
 		bool				mTouchScaleSizeMode;
 
-		// All touch processing happens in the process touch class
-		TouchProcess		mTouchProcess;
+		// All touch processing happens in the process touch class. It's borrowed
+		// from the engine's GestureEngine while I'm being touched, and null otherwise.
+		TouchProcess*		mTouchProcess;
 
 		bool				mCheckBounds;
+		bool				mParallelUpdate;
 		Sprite*				mDragDestination;
 		IdleTimer			mIdleTimer;
 		bool				mUseDepthBuffer;
@@ -862,6 +897,7 @@ namespace ui {
 
 		friend class ds::Engine;
 		friend class ds::EngineRoot;
+		friend class ds::ParallelUpdate;
 		// Disable copy constructor; sprites are managed by their parent and
 		// must be allocated
 		Sprite(const Sprite&);
@@ -875,6 +911,10 @@ namespace ui {
 		void				dimensionalStateChanged();
 		// Applies to all children, too.
 		void				markClippingDirty();
+		// Rebuild the pick bounds of any dirty sprites under me.
+		void				updatePickBounds() const;
+		// The perspective pick for a ray in my parent's space. Only reads, so it's safe across threads.
+		Sprite*				findPerspectiveHit(const CameraPick&, const ci::vec3& origin, const ci::vec3& dir, float& depth);
 		// Store all children in mSortedTmp by z order.
 		// XXX Need to optimize this so only built when needed.
 		void				makeSortedChildren();
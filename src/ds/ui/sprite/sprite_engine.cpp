@@ -72,6 +72,16 @@ float SpriteEngine::getSwipeMaxTime() const
 	return mData.mSwipeMaxTime;
 }
 
+float SpriteEngine::getPredictionDragWeight() const
+{
+	return mData.mPredictionDragWeight;
+}
+
+float SpriteEngine::getPredictionScaleRotateWeight() const
+{
+	return mData.mPredictionScaleRotateWeight;
+}
+
 float SpriteEngine::getDoubleTapTime() const
 {
 	return mData.mDoubleTapTime;
@@ -19,7 +19,9 @@ class EngineData;
 class EngineService;
 class EventNotifier;
 class FontList;
+class GlUploadPool;
 class ImageRegistry;
+class ParallelUpdate;
 class PerspCameraParams;
 class ResourceList;
 class WorkManager;
@@ -32,6 +34,7 @@ class Settings;
 class TuioObject;
 
 namespace ui {
+class GestureEngine;
 class LoadImageService;
 class PangoFontService;
 class Sprite;
@@ -59,6 +62,9 @@ public:
 	virtual const ds::ColorList&	getColors() const = 0;
 	virtual const ds::FontList&		getFonts() const = 0;
 	virtual ds::AutoUpdateList&		getAutoUpdateList(const int = AutoUpdateType::SERVER) = 0;
+	virtual ds::ParallelUpdate&		getParallelUpdate() = 0;
+	virtual ds::GlUploadPool&		getGlUploadPool() = 0;
+	virtual GestureEngine&			getGestureEngine() = 0;
 	virtual LoadImageService&		getLoadImageService() = 0;
 	virtual PangoFontService&		getPangoFontService() = 0;
 	virtual ds::ImageRegistry&		getImageRegistry() = 0;
@@ -102,6 +108,8 @@ public:
 	unsigned						getSwipeQueueSize() const;
 	float							getSwipeMinVelocity() const;
 	float							getSwipeMaxTime() const;
+	float							getPredictionDragWeight() const;
+	float							getPredictionScaleRotateWeight() const;
 	float							getDoubleTapTime() const;
 	const ci::Rectf&				getSrcRect() const;
 	const ci::Rectf&				getDstRect() const;
@@ -129,7 +137,8 @@ public:
 	void							removeFromDragDestinationList(Sprite *sprite);
 	Sprite*							getDragDestinationSprite(const ci::vec3 &globalPoint, Sprite *draggingSprite);
 
-	double							getElapsedTimeSeconds() const;
+	// Seconds since the app started. Engines stepping a fixed time answer simulated time.
+	virtual double					getElapsedTimeSeconds() const;
 
 	int								getIdleTimeout() const;
 	void							setIdleTimeout(int idleTimeout);
@@ -7,7 +7,9 @@
 #include "pango/pangocairo.h"
 
 #include <pango/pango-font.h>
+#include <cmath>
 #include <regex>
+#include <cinder/TriMesh.h>
 
 #if CAIRO_HAS_WIN32_SURFACE
 #include <cairo-win32.h>
@@ -18,7 +20,9 @@
 #include "ds/app/blob_registry.h"
 #include "ds/data/data_buffer.h"
 #include "ds/debug/logger.h"
+#include "ds/thread/gl_upload_pool.h"
 #include "ds/ui/sprite/sprite_engine.h"
+#include "ds/ui/service/glyph_atlas.h"
 #include "ds/ui/service/pango_font_service.h"
 #include "ds/util/string_util.h"
 
@@ -70,6 +74,26 @@ const std::string vertShader =
 "}\n";
 
 std::string shaderNameOpaccy = "pango_text_opacity";
+
+// Glyph atlas pages only hold coverage, the colour is set for each batch
+const std::string glyphFrag =
+"uniform sampler2D	tex0;\n"
+"uniform bool		useTexture;\n"
+"uniform bool       preMultiply;\n"
+"in vec4			Color;\n"
+"in vec2			TexCoord0;\n"
+"out vec4			oColor;\n"
+"void main()\n"
+"{\n"
+"    oColor = Color;\n"
+"    if (useTexture) {\n"
+"        oColor.a *= texture2D( tex0, TexCoord0 ).r;\n"
+"    }\n"
+"    if (preMultiply)\n"
+"        oColor.rgb *= oColor.a;\n"
+"}\n";
+
+std::string shaderNameGlyph = "pango_text_glyph";
 }
 
 namespace ds {
@@ -86,8 +110,239 @@ const DirtyState&	LAYOUT_DIRTY = INTERNAL_C_DIRTY;
 const char			FONTNAME_ATT = 80;
 const char			TEXT_ATT = 81;
 const char			LAYOUT_ATT = 82;
+
+// Pango doesn't support HTML-esque line-break tags, so find break marks and replace
+// with newlines, e.g. <br>, <BR>, <br />, <BR />. Answers whether there's probably markup:
+// it's faster to use pango_layout_set_text than pango_layout_set_markup if there's no
+// markup to bother with. Be pretty liberal, there's more harm in false-postives than false-negatives
+bool processText(const std::wstring& text, const std::wstring& suffix, std::wstring& processed) {
+	std::regex e("<br\\s?/?>", std::regex_constants::icase);
+	processed = ds::wstr_from_utf8(std::regex_replace(ds::utf8_from_wstr(text), e, "\n")) + suffix;
+	return ((processed.find(L"<") != std::wstring::npos) && (processed.find(L">") != std::wstring::npos));
+}
+
+PangoFontDescription* createFontDescription(const std::string& font, const float textSize) {
+	PangoFontDescription* description = pango_font_description_from_string(font.c_str());// +" " + std::to_string(mTextSize)).c_str());
+	pango_font_description_set_absolute_size(description, (double)(textSize * 1.333333333f) * PANGO_SCALE);
+	//	pango_font_description_set_weight(fontDescription, static_cast<PangoWeight>(mDefaultTextWeight));
+	//	pango_font_description_set_style(mFontDescription, PANGO_STYLE_ITALIC);// mDefaultTextItalicsEnabled ? PANGO_STYLE_ITALIC : PANGO_STYLE_NORMAL);
+	//	pango_font_description_set_variant(fontDescription, mDefaultTextSmallCapsEnabled ? PANGO_VARIANT_SMALL_CAPS : PANGO_VARIANT_NORMAL);
+	return description;
+}
+
+// Lays out the text and answers the pixel size. hadMarkup is whether the layout last had markup.
+void layoutText(PangoLayout* layout, const std::wstring& processed, const bool hasMarkup, const bool hadMarkup,
+				const float resizeLimitWidth, const float resizeLimitHeight, const Alignment::Enum alignment,
+				const WrapMode wrapMode, const EllipsizeMode ellipsizeMode, const float textSize, const float leading,
+				int& pixelWidth, int& pixelHeight) {
+	pango_layout_set_width(layout, (int)resizeLimitWidth * PANGO_SCALE);
+	pango_layout_set_height(layout, (int)resizeLimitHeight * PANGO_SCALE);
+
+	// Pango separates alignment and justification... I prefer a simpler API here to handling certain edge cases.
+	if(alignment == Alignment::kJustify) {
+		pango_layout_set_justify(layout, true);
+		pango_layout_set_alignment(layout, PANGO_ALIGN_LEFT);
+	} else {
+		PangoAlignment aligny = PANGO_ALIGN_LEFT;
+		if(alignment == Alignment::kCenter){
+			aligny = PANGO_ALIGN_CENTER;
+		} else if(alignment == Alignment::kRight){
+			aligny = PANGO_ALIGN_RIGHT;
+		} else if(alignment == Alignment::kJustify){ // handled above, but just to be safe
+			aligny = PANGO_ALIGN_LEFT;
+		}
+
+		pango_layout_set_justify(layout, false);
+		pango_layout_set_alignment(layout, aligny);
+	}
+
+	if(wrapMode == WrapMode::kWrapModeChar){
+		pango_layout_set_wrap(layout, PANGO_WRAP_CHAR);
+	} else if(wrapMode == WrapMode::kWrapModeWord){
+		pango_layout_set_wrap(layout, PANGO_WRAP_WORD);
+	} else {
+		pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
+	}
+
+	PangoEllipsizeMode elipsizeMode = PANGO_ELLIPSIZE_NONE;
+	if(ellipsizeMode == EllipsizeMode::kEllipsizeEnd){
+		elipsizeMode = PANGO_ELLIPSIZE_END;
+	} else if(ellipsizeMode == EllipsizeMode::kEllipsizeMiddle){
+		elipsizeMode = PANGO_ELLIPSIZE_MIDDLE;
+	} else if(ellipsizeMode == EllipsizeMode::kEllipsizeStart){
+		elipsizeMode = PANGO_ELLIPSIZE_START;
+	}
+
+	pango_layout_set_ellipsize(layout, elipsizeMode);
+	pango_layout_set_spacing(layout, (int)(textSize * (leading - 1.0f)) * PANGO_SCALE);
+
+	// Set text, use the fastest method depending on what we found in the text
+	int newPixelWidth = 0;
+	int newPixelHeight = 0;
+	if(hasMarkup){// || true) {
+		pango_layout_set_markup(layout, ds::utf8_from_wstr(processed).c_str(), -1);
+		// check the pixel size, if it's empty, then we can try again without markup
+		pango_layout_get_pixel_size(layout, &newPixelWidth, &newPixelHeight);
+	}
+
+	if(!hasMarkup || newPixelWidth < 1) {
+		if(hadMarkup){
+			pango_layout_set_markup(layout, ds::utf8_from_wstr(processed).c_str(), -1);
+		}
+		pango_layout_set_text(layout, ds::utf8_from_wstr(processed).c_str(), -1);
+	}
+
+	// use this instead: pango_layout_get_pixel_extents
+	PangoRectangle inkRect;
+	PangoRectangle extentRect;
+	pango_layout_get_pixel_extents(layout, &inkRect, &extentRect);
+
+	// TODO: output a warning, and / or do a better job detecting and fixing issues or something
+	if((extentRect.width == 0 || extentRect.height == 0) && !processed.empty()){
+		DS_LOG_WARNING("No size detected for pango text size. Font not detected or invalid markup are likely causes. Text: " << ds::utf8_from_wstr(processed));
+	}
+
+	/*
+	std::cout << ds::utf8_from_wstr(processed) << std::endl;
+	std::cout << "Ink rect: " << inkRect.x << " " << inkRect.y << " " << inkRect.width << " " << inkRect.height << std::endl;
+	std::cout << "Ext rect: " << extentRect.x << " " << extentRect.y << " " << extentRect.width << " " << extentRect.height << std::endl;
+	std::cout << "Pixel size: " << newPixelWidth << " " << newPixelHeight << std::endl;
+	*/
+
+	pixelWidth = extentRect.width+(extentRect.x*2.0f);
+	pixelHeight = extentRect.height+(extentRect.y*2.0f);
+}
+
+// Renders the layout into a new texture of the given size. Answers nothing if cairo fails.
+ci::gl::TextureRef rasterizeText(PangoLayout* layout, const ci::Color& color, const int width, const int height) {
+	// Create appropriately sized cairo surface
+	const bool grayscale = false; // Not really supported
+	_cairo_format cairoFormat = grayscale ? CAIRO_FORMAT_A8 : CAIRO_FORMAT_ARGB32;
+
+#if CAIRO_HAS_WIN32_SURFACE
+	cairo_surface_t* cairoSurface = cairo_win32_surface_create_with_dib(cairoFormat, width, height);
+#else
+	cairo_surface_t* cairoSurface = cairo_image_surface_create(cairoFormat, width, height);
+#endif
+	auto cairoSurfaceStatus = cairo_surface_status(cairoSurface);
+	if(CAIRO_STATUS_SUCCESS != cairoSurfaceStatus) {
+		DS_LOG_WARNING("Error creating Cairo surface. Status:" << cairoSurfaceStatus << " w:" << width << " h:" << height << " text:" << pango_layout_get_text(layout));
+		cairo_surface_destroy(cairoSurface);
+		return nullptr;
+	}
+
+	/* create our cairo context object that tracks state. */
+	cairo_t* cairoContext = cairo_create(cairoSurface);
+	auto cairoStatus = cairo_status(cairoContext);
+	if(CAIRO_STATUS_SUCCESS != cairoStatus){
+		if(CAIRO_STATUS_NO_MEMORY == cairoStatus) {
+			DS_LOG_WARNING("Out of memory, error creating Cairo context");
+		} else {
+			DS_LOG_WARNING("Error creating Cairo context " << cairoStatus);
+		}
+		cairo_destroy(cairoContext);
+		cairo_surface_destroy(cairoSurface);
+		return nullptr;
+	}
+
+	// Draw the text into the buffer
+	cairo_set_source_rgb(cairoContext, color.r, color.g, color.b);//, getDrawOpacity());
+	pango_cairo_update_layout(cairoContext, layout);
+	pango_cairo_show_layout(cairoContext, layout);
+
+	//	cairo_surface_write_to_png(cairoSurface, "test_font.png");
+
+	// Copy it out to a texture
+#ifdef CAIRO_HAS_WIN32_SURFACE
+	unsigned char *pixels = cairo_image_surface_get_data(cairo_win32_surface_get_image(cairoSurface));
+#else
+	unsigned char *pixels = cairo_image_surface_get_data(cairoSurface);
+#endif
+
+	ci::gl::Texture::Format format;
+	format.setMagFilter(GL_LINEAR);
+	format.setMinFilter(GL_LINEAR);
+	ci::gl::TextureRef texture = ci::gl::Texture::create(pixels, GL_BGRA, width, height, format);
+	texture->setTopDown(true);
+
+	cairo_destroy(cairoContext);
+	cairo_surface_destroy(cairoSurface);
+	return texture;
 }
 
+// The colour from foreground markup on the run, if there is any
+ci::Color getRunColor(PangoLayoutRun* run, const ci::Color& textColor) {
+	for(GSList* it = run->item->analysis.extra_attrs; it; it = it->next){
+		PangoAttribute* attr = static_cast<PangoAttribute*>(it->data);
+		if(attr->klass->type == PANGO_ATTR_FOREGROUND){
+			const PangoColor& c = reinterpret_cast<PangoAttrColor*>(attr)->color;
+			return ci::Color(c.red / 65535.0f, c.green / 65535.0f, c.blue / 65535.0f);
+		}
+	}
+	return textColor;
+}
+}
+
+/**
+ * \class ds::ui::Text::RenderJob
+ * Lays out and rasterizes a copy of the text on a GL upload thread.
+ */
+struct Text::RenderJob {
+	RenderJob() : mTextSize(0.0f), mResizeLimitWidth(-1.0f), mResizeLimitHeight(-1.0f), mAlignment(Alignment::kLeft)
+				, mWrapMode(WrapMode::kWrapModeWordChar), mEllipsizeMode(EllipsizeMode::kEllipsizeNone), mLeading(1.0f)
+				, mWrapped(false), mNumberOfLines(0), mPixelWidth(0), mPixelHeight(0) { }
+
+	bool					sameInput(const RenderJob& o) const {
+		return mText == o.mText && mSuffix == o.mSuffix && mFont == o.mFont && mTextSize == o.mTextSize
+			&& mResizeLimitWidth == o.mResizeLimitWidth && mResizeLimitHeight == o.mResizeLimitHeight
+			&& mAlignment == o.mAlignment && mWrapMode == o.mWrapMode && mEllipsizeMode == o.mEllipsizeMode
+			&& mLeading == o.mLeading && mColor == o.mColor;
+	}
+
+	void					run(PangoFontService& fonts) {
+		PangoContext*			context = fonts.acquireContext();
+		if(!context) return;
+
+		PangoLayout*			layout = pango_layout_new(context);
+		PangoFontDescription*	description = createFontDescription(mFont, mTextSize);
+		pango_layout_set_font_description(layout, description);
+
+		std::wstring			processed;
+		const bool				hasMarkup = processText(mText, mSuffix, processed);
+		layoutText(layout, processed, hasMarkup, false, mResizeLimitWidth, mResizeLimitHeight, mAlignment,
+				   mWrapMode, mEllipsizeMode, mTextSize, mLeading, mPixelWidth, mPixelHeight);
+		mWrapped = pango_layout_is_wrapped(layout) != FALSE;
+		mNumberOfLines = pango_layout_get_line_count(layout);
+
+		const int				extraTextureSize = (int)mTextSize;
+		mTexture = rasterizeText(layout, mColor, mPixelWidth + extraTextureSize, mPixelHeight + extraTextureSize);
+
+		pango_font_description_free(description);
+		g_object_unref(layout);
+		fonts.releaseContext(context);
+	}
+
+	// Copied from the sprite, the job never touches it
+	std::wstring			mText;
+	std::wstring			mSuffix;
+	std::string				mFont;
+	float					mTextSize;
+	float					mResizeLimitWidth,
+							mResizeLimitHeight;
+	Alignment::Enum			mAlignment;
+	WrapMode				mWrapMode;
+	EllipsizeMode			mEllipsizeMode;
+	float					mLeading;
+	ci::Color				mColor;
+
+	// The results
+	bool					mWrapped;
+	int						mNumberOfLines;
+	int						mPixelWidth,
+							mPixelHeight;
+	ci::gl::TextureRef		mTexture;
+};
+
 void Text::installAsServer(ds::BlobRegistry& registry)
 {
 	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); });
@@ -107,6 +362,9 @@ Text::Text(ds::ui::SpriteEngine& eng)
 	, mNeedsMeasuring(false)
 	, mNeedsTextRender(false)
 	, mNeedsFontOptionUpdate(false)
+	, mLayoutStale(false)
+	, mUseGlyphAtlas(false)
+	, mGlyphAtlasGeneration(0)
 	, mProbablyHasMarkup(false)
 	, mTextFont("Sans")
 	, mTextSize(120.0)
@@ -127,19 +385,14 @@ Text::Text(ds::ui::SpriteEngine& eng)
 	, mFontDescription(nullptr)
 	, mPangoContext(nullptr)
 	, mPangoLayout(nullptr)
-	, mCairoSurface(nullptr)
-	, mCairoContext(nullptr)
 	, mCairoFontOptions(nullptr)
-
-#ifdef CAIRO_HAS_WIN32_SURFACE
-	, mCairoWinImageSurface(nullptr)
-#endif
 {
 	mBlobType = BLOB_TYPE;
 
 	setUseShaderTexture(true);
 	mSpriteShader.setShaders(vertShader, opacityFrag, shaderNameOpaccy);
 	mSpriteShader.loadShaders();
+	setUseGlyphAtlas(mEngine.getPangoFontService().getUseGlyphAtlas());
 
 	if(!mEngine.getPangoFontService().getPangoFontMap()) {
 		DS_LOG_WARNING("Cannot create the pango font map, nothing will render for this pango text sprite.");
@@ -175,11 +428,7 @@ Text::Text(ds::ui::SpriteEngine& eng)
 }
 
 Text::~Text() {
-	// This causes crash on windows
-	if(mCairoContext) {
-		cairo_destroy(mCairoContext);
-		mCairoContext = nullptr;
-	}
+	mEngine.getGlUploadPool().cancel(this);
 
 	if(mFontDescription) {
 		pango_font_description_free(mFontDescription);
@@ -191,21 +440,6 @@ Text::~Text() {
 		mCairoFontOptions = nullptr;
 	}
 
-#ifdef CAIRO_HAS_WIN32_SURFACE
-	if(mCairoWinImageSurface) {
-		//cairo_surface_destroy(mCairoWinImageSurface);
-		mCairoWinImageSurface = nullptr;
-	}
-	if(mCairoSurface != nullptr) {
-		cairo_surface_destroy(mCairoSurface);
-	}
-#else
-	// Crashes windows...
-	if(mCairoSurface != nullptr) {
-		cairo_surface_destroy(mCairoSurface);
-	}
-#endif
-
 	g_object_unref(mPangoContext); // this one crashes Windows?
 	g_object_unref(mPangoLayout);
 }
@@ -227,6 +461,7 @@ void Text::setText(std::wstring text) {
 		mText = text;
 		mNeedsMarkupDetection = true;
 		mNeedsMeasuring = true;
+		markPickBoundsDirty();
 		mNeedsTextRender = true;
 
 		markAsDirty(TEXT_DIRTY);
@@ -237,6 +472,29 @@ const ci::gl::TextureRef Text::getTexture() {
 	return mTexture;
 }
 
+void Text::setUseGlyphAtlas(const bool use) {
+	if(mUseGlyphAtlas == use) return;
+
+	mUseGlyphAtlas = use;
+	if(mUseGlyphAtlas){
+		mSpriteShader.setShaders(vertShader, glyphFrag, shaderNameGlyph);
+		mTexture = nullptr;
+		mRenderBatch = nullptr;
+		// Any async job still out is dropped when it finishes
+		mRenderJob = nullptr;
+	} else {
+		mSpriteShader.setShaders(vertShader, opacityFrag, shaderNameOpaccy);
+		mGlyphBatches.clear();
+	}
+	mSpriteShader.loadShaders();
+	mNeedsTextRender = true;
+	mNeedsBatchUpdate = true;
+}
+
+bool Text::getUseGlyphAtlas() const {
+	return mUseGlyphAtlas;
+}
+
 void Text::setTextStyle(std::string font, float size, ci::ColorA color, TextWeight weight,	Alignment::Enum alignment) {
 	setFont(font);
 	setFontSize(size);
@@ -254,6 +512,7 @@ void Text::setDefaultTextWeight(TextWeight weight) {
 		mDefaultTextWeight = weight;
 		mNeedsFontUpdate = true;
 		mNeedsMeasuring = true;
+		markPickBoundsDirty();
 		mNeedsTextRender = true;
 
 		markAsDirty(FONT_DIRTY);
@@ -268,6 +527,7 @@ void Text::setAlignment(Alignment::Enum alignment) {
 	if(mTextAlignment != alignment) {
 		mTextAlignment = alignment;
 		mNeedsMeasuring = true;
+		markPickBoundsDirty();
 		mNeedsTextRender = true;
 		
 		markAsDirty(FONT_DIRTY);
@@ -282,6 +542,7 @@ Text& Text::setLeading(const float leading) {
 	if(mLeading != leading) {
 		mLeading = leading;
 		mNeedsMeasuring = true;
+		markPickBoundsDirty();
 		mNeedsTextRender = true;
 
 		markAsDirty(FONT_DIRTY);
@@ -310,6 +571,8 @@ Text& Text::setResizeLimit(const float maxWidth, const float maxHeight) {
 			mResizeLimitHeight = -1.0f;
 		}
 		mNeedsMeasuring = true;
+		markPickBoundsDirty();
+		mNeedsTextRender = true;
 
 		markAsDirty(LAYOUT_DIRTY);
 	}
@@ -335,6 +598,8 @@ void Text::setDefaultTextSmallCapsEnabled(bool value) {
 		mDefaultTextSmallCapsEnabled = value;
 		mNeedsFontUpdate = true;
 		mNeedsMeasuring = true;
+		markPickBoundsDirty();
+		mNeedsTextRender = true;
 
 		markAsDirty(FONT_DIRTY);
 	}
@@ -349,6 +614,8 @@ void Text::setDefaultTextItalicsEnabled(bool value) {
 		mDefaultTextItalicsEnabled = value;
 		mNeedsFontUpdate = true;
 		mNeedsMeasuring = true;
+		markPickBoundsDirty();
+		mNeedsTextRender = true;
 
 		markAsDirty(FONT_DIRTY);
 	}
@@ -359,6 +626,8 @@ void Text::setFontSize(float size) {
 		mTextSize = size;
 		mNeedsFontUpdate = true;
 		mNeedsMeasuring = true;
+		markPickBoundsDirty();
+		mNeedsTextRender = true;
 
 		markAsDirty(FONT_DIRTY);
 	}
@@ -384,6 +653,8 @@ Text& Text::setFont(const std::string& font, const float fontSize) {
 		mTextSize = fontSize;
 		mNeedsFontUpdate = true;
 		mNeedsMeasuring = true;
+		markPickBoundsDirty();
+		mNeedsTextRender = true;
 
 		markAsDirty(FONT_DIRTY);
 
@@ -419,6 +690,8 @@ void Text::setEllipsizeMode(EllipsizeMode theMode){
 
 	mEllipsizeMode = theMode;
 	mNeedsMeasuring = true;
+	markPickBoundsDirty();
+	mNeedsTextRender = true;
 	markAsDirty(LAYOUT_DIRTY);
 }
 
@@ -431,6 +704,8 @@ void Text::setWrapMode(WrapMode theMode){
 
 	mWrapMode = theMode;
 	mNeedsMeasuring = true;
+	markPickBoundsDirty();
+	mNeedsTextRender = true;
 	markAsDirty(LAYOUT_DIRTY);
 }
 
@@ -439,6 +714,10 @@ WrapMode Text::getWrapMode(){
 }
 
 void Text::onBuildRenderBatch(){
+	if(mUseGlyphAtlas){
+		buildGlyphBatches();
+		return;
+	}
 
 
 	float preWidth = 0.0f;
@@ -475,6 +754,16 @@ void Text::onBuildRenderBatch(){
 }
 
 void Text::drawLocalClient(){
+	if(mUseGlyphAtlas){
+		if(mText.empty()) return;
+		for(auto it = mGlyphBatches.begin(), end = mGlyphBatches.end(); it != end; ++it){
+			ci::gl::color(mColor.r * it->mColor.r, mColor.g * it->mColor.g, mColor.b * it->mColor.b, mDrawOpacity);
+			ci::gl::ScopedTextureBind scopedTexture(it->mPage);
+			it->mBatch->draw();
+		}
+		return;
+	}
+
 	if(mTexture && !mText.empty()){
 
 		ci::gl::color(mColor.r, mColor.g, mColor.b, mDrawOpacity);
@@ -554,15 +843,74 @@ int Text::getNumberOfLines(){
 
 
 void Text::onUpdateClient(const UpdateParams&){
-	measurePangoText();
+	updateLayout();
+	checkGlyphPages();
 }
 
 void Text::onUpdateServer(const UpdateParams&){
-	measurePangoText();
+	updateLayout();
+	checkGlyphPages();
+}
+
+void Text::updateLayout(){
+	// Empty text is only a resize, so it always happens here. Glyph
+	// atlas text only needs the layout, which is cheap next to a raster.
+	if(!mEngine.getPangoFontService().getAsyncText() || mText.empty() || mUseGlyphAtlas){
+		measurePangoText();
+		return;
+	}
+
+	// Every change flags a render, and the last job is checked so a synchronous
+	// measure in between doesn't send the same work again.
+	if(!mNeedsTextRender) return;
+	mNeedsTextRender = false;
+
+	std::shared_ptr<RenderJob>	job(new RenderJob());
+	job->mText = mText;
+	job->mSuffix = mEngine.getPangoFontService().getTextSuffix();
+	job->mFont = mTextFont;
+	job->mTextSize = mTextSize;
+	job->mResizeLimitWidth = mResizeLimitWidth;
+	job->mResizeLimitHeight = mResizeLimitHeight;
+	job->mAlignment = mTextAlignment;
+	job->mWrapMode = mWrapMode;
+	job->mEllipsizeMode = mEllipsizeMode;
+	job->mLeading = mLeading;
+	job->mColor = mTextColor;
+	if(mRenderJob && mRenderJob->sameInput(*job)) return;
+
+	// Coalesced, so a label that changes every frame only keeps the newest job waiting
+	mRenderJob = job;
+	PangoFontService*			fonts = &mEngine.getPangoFontService();
+	mEngine.getGlUploadPool().uploadSerial(this, [job, fonts](){ job->run(*fonts); },
+										   [this, job](){ finishRenderJob(job); }, true);
+}
+
+void Text::finishRenderJob(const std::shared_ptr<RenderJob>& job){
+	// A newer job is on its way
+	if(job != mRenderJob) return;
+
+	mTexture = job->mTexture;
+	job->mTexture = nullptr;
+	mNeedsBatchUpdate = true;
+
+	// If the text has changed since the job went out, only the texture is worth keeping
+	if(mNeedsTextRender) return;
+
+	mWrappedText = job->mWrapped;
+	mNumberOfLines = job->mNumberOfLines;
+	mPixelWidth = job->mPixelWidth;
+	mPixelHeight = job->mPixelHeight;
+	if(mNeedsMeasuring){
+		// My own layout is still behind, it catches up if anyone asks about characters
+		mNeedsMeasuring = false;
+		mLayoutStale = true;
+	}
+	setSize((float)mPixelWidth, (float)mPixelHeight);
 }
 
 bool Text::measurePangoText() {
-	if(mNeedsFontUpdate || mNeedsMeasuring || mNeedsTextRender || mNeedsMarkupDetection) {
+	if(mNeedsFontUpdate || mNeedsMeasuring || mNeedsTextRender || mNeedsMarkupDetection || mLayoutStale) {
 
 		if(mText.empty()){
 			if(mWidth > 0.0f || mWidth > 0.0f){
@@ -570,6 +918,7 @@ bool Text::measurePangoText() {
 			}
 			mNeedsMarkupDetection = false;
 			mNeedsMeasuring = false;
+			mLayoutStale = false;
 			mNeedsBatchUpdate = true;
 			return false;
 		}
@@ -578,20 +927,7 @@ bool Text::measurePangoText() {
 		bool hadMarkup = mProbablyHasMarkup;
 
 		if(mNeedsMarkupDetection) {
-
-			// Pango doesn't support HTML-esque line-break tags, so
-			// find break marks and replace with newlines, e.g. <br>, <BR>, <br />, <BR />
-			// TODO
-			std::regex e("<br\\s?/?>", std::regex_constants::icase);
-			mProcessedText = ds::wstr_from_utf8(std::regex_replace(ds::utf8_from_wstr(mText), e, "\n")) + mEngine.getPangoFontService().getTextSuffix();
-			//mProcessedText = mText + mEngine.getPangoFontService().getTextSuffix();
-
-			// Let's also decide and flag if there's markup in this string
-			// Faster to use pango_layout_set_text than pango_layout_set_markup later on if
-			// there's no markup to bother with.
-			// Be pretty liberal, there's more harm in false-postives than false-negatives
-			mProbablyHasMarkup = ((mProcessedText.find(L"<") != std::wstring::npos) && (mProcessedText.find(L">") != std::wstring::npos));
-
+			mProbablyHasMarkup = processText(mText, mEngine.getPangoFontService().getTextSuffix(), mProcessedText);
 			mNeedsMarkupDetection = false;
 		}
 
@@ -614,11 +950,7 @@ bool Text::measurePangoText() {
 				pango_font_description_free(mFontDescription);
 			}
 
-			mFontDescription = pango_font_description_from_string(mTextFont.c_str());// +" " + std::to_string(mTextSize)).c_str());
-			pango_font_description_set_absolute_size(mFontDescription, (double)(mTextSize * 1.333333333f) * PANGO_SCALE);
-			//	pango_font_description_set_weight(fontDescription, static_cast<PangoWeight>(mDefaultTextWeight));
-			//	pango_font_description_set_style(mFontDescription, PANGO_STYLE_ITALIC);// mDefaultTextItalicsEnabled ? PANGO_STYLE_ITALIC : PANGO_STYLE_NORMAL);
-			//	pango_font_description_set_variant(fontDescription, mDefaultTextSmallCapsEnabled ? PANGO_VARIANT_SMALL_CAPS : PANGO_VARIANT_NORMAL);
+			mFontDescription = createFontDescription(mTextFont, mTextSize);
 			pango_layout_set_font_description(mPangoLayout, mFontDescription);
 			pango_font_map_load_font(mEngine.getPangoFontService().getPangoFontMap(), mPangoContext, mFontDescription);
 
@@ -629,94 +961,17 @@ bool Text::measurePangoText() {
 
 
 		// If the text or the bounds change
-		if(mNeedsMeasuring) {
-
-			const int lastPixelWidth = mPixelWidth;
-			const int lastPixelHeight = mPixelHeight;
-
-			pango_layout_set_width(mPangoLayout, (int)mResizeLimitWidth * PANGO_SCALE);
-			pango_layout_set_height(mPangoLayout, (int)mResizeLimitHeight * PANGO_SCALE);
-
-			// Pango separates alignment and justification... I prefer a simpler API here to handling certain edge cases.
-			if(mTextAlignment == Alignment::kJustify) {
-				pango_layout_set_justify(mPangoLayout, true);
-				pango_layout_set_alignment(mPangoLayout, PANGO_ALIGN_LEFT);
-			} else {
-				PangoAlignment aligny = PANGO_ALIGN_LEFT;
-				if(mTextAlignment == Alignment::kCenter){
-					aligny = PANGO_ALIGN_CENTER;
-				} else if(mTextAlignment == Alignment::kRight){
-					aligny = PANGO_ALIGN_RIGHT;
-				} else if(mTextAlignment == Alignment::kJustify){ // handled above, but just to be safe
-					aligny = PANGO_ALIGN_LEFT;
-				}
-
-				pango_layout_set_justify(mPangoLayout, false);
-				pango_layout_set_alignment(mPangoLayout, aligny);
-			}
-
-			if(mWrapMode == WrapMode::kWrapModeChar){
-				pango_layout_set_wrap(mPangoLayout, PANGO_WRAP_CHAR);
-			} else if(mWrapMode == WrapMode::kWrapModeWord){
-				pango_layout_set_wrap(mPangoLayout, PANGO_WRAP_WORD);
-			} else {
-				pango_layout_set_wrap(mPangoLayout, PANGO_WRAP_WORD_CHAR);
-			}
-
-			PangoEllipsizeMode elipsizeMode = PANGO_ELLIPSIZE_NONE;
-			if(mEllipsizeMode == EllipsizeMode::kEllipsizeEnd){
-				elipsizeMode = PANGO_ELLIPSIZE_END;
-			} else if(mEllipsizeMode == EllipsizeMode::kEllipsizeMiddle){
-				elipsizeMode = PANGO_ELLIPSIZE_MIDDLE;
-			} else if(mEllipsizeMode == EllipsizeMode::kEllipsizeStart){
-				elipsizeMode = PANGO_ELLIPSIZE_START;
-			}
-
-			pango_layout_set_ellipsize(mPangoLayout, elipsizeMode);
-			pango_layout_set_spacing(mPangoLayout, (int)(mTextSize * (mLeading - 1.0f)) * PANGO_SCALE);
-
-			// Set text, use the fastest method depending on what we found in the text
-			int newPixelWidth = 0;
-			int newPixelHeight = 0;
-			if(mProbablyHasMarkup){// || true) {
-				pango_layout_set_markup(mPangoLayout, ds::utf8_from_wstr(mProcessedText).c_str(), -1);
-				// check the pixel size, if it's empty, then we can try again without markup
-				pango_layout_get_pixel_size(mPangoLayout, &newPixelWidth, &newPixelHeight);
-			}
-
-			if(!mProbablyHasMarkup || newPixelWidth < 1) {
-				if(hadMarkup){
-					pango_layout_set_markup(mPangoLayout, ds::utf8_from_wstr(mProcessedText).c_str(), -1);
-				}
-				pango_layout_set_text(mPangoLayout, ds::utf8_from_wstr(mProcessedText).c_str(), -1);
-			}
+		if(mNeedsMeasuring || mLayoutStale) {
+			layoutText(mPangoLayout, mProcessedText, mProbablyHasMarkup, hadMarkup, mResizeLimitWidth, mResizeLimitHeight,
+					   mTextAlignment, mWrapMode, mEllipsizeMode, mTextSize, mLeading, mPixelWidth, mPixelHeight);
 
 			mWrappedText = pango_layout_is_wrapped(mPangoLayout) != FALSE;
 			mNumberOfLines = pango_layout_get_line_count(mPangoLayout);
 
-			// use this instead: pango_layout_get_pixel_extents
-			PangoRectangle inkRect;
-			PangoRectangle extentRect;
-			pango_layout_get_pixel_extents(mPangoLayout, &inkRect, &extentRect);
-
-			// TODO: output a warning, and / or do a better job detecting and fixing issues or something
-			if((extentRect.width == 0 || extentRect.height == 0) && !mText.empty()){
-				DS_LOG_WARNING("No size detected for pango text size. Font not detected or invalid markup are likely causes. Text: " << getTextAsString());
-			}
-
-			/*
-			std::cout << getTextAsString() << std::endl;
-			std::cout << "Ink rect: " << inkRect.x << " " << inkRect.y << " " << inkRect.width << " " << inkRect.height << std::endl;
-			std::cout << "Ext rect: " << extentRect.x << " " << extentRect.y << " " << extentRect.width << " " << extentRect.height << std::endl;
-			std::cout << "Pixel size: " << newPixelWidth << " " << newPixelHeight << std::endl;
-			*/
-
-			mPixelWidth = extentRect.width+(extentRect.x*2.0f);
-			mPixelHeight = extentRect.height+(extentRect.y*2.0f);
-
 			setSize((float)mPixelWidth, (float)mPixelHeight);
 
 			mNeedsMeasuring = false;
+			mLayoutStale = false;
 		}
 
 		mNeedsBatchUpdate = true;
@@ -727,6 +982,8 @@ bool Text::measurePangoText() {
 }
 
 void Text::renderPangoText(){
+	// Async text gets its textures from render jobs, and glyph atlas text has none
+	if(!mNeedsTextRender || mEngine.getPangoFontService().getAsyncText() || mUseGlyphAtlas) return;
 
 	/// HACK
 	/// Some fonts clip some descenders and characters at the end of the text
@@ -736,100 +993,103 @@ void Text::renderPangoText(){
 	/// The official APIs from Pango are simply reporting less pixel size than they draw into. (shrug)
 	int extraTextureSize = (int)mTextSize;
 
-	if(mNeedsTextRender) {
-		// Create appropriately sized cairo surface
-		const bool grayscale = false; // Not really supported
-		_cairo_format cairoFormat = grayscale ? CAIRO_FORMAT_A8 : CAIRO_FORMAT_ARGB32;
-
-
-		// clean up any existing surfaces
-		if(mCairoSurface) {
-			cairo_surface_destroy(mCairoSurface);
-			mCairoSurface = nullptr;
-#if CAIRO_HAS_WIN32_SURFACE
-			mCairoWinImageSurface = nullptr;
-#endif
-		}
-
-#if CAIRO_HAS_WIN32_SURFACE
-		mCairoSurface = cairo_win32_surface_create_with_dib(cairoFormat, mPixelWidth + extraTextureSize, mPixelHeight + extraTextureSize);
-#else
-		mCairoSurface = cairo_image_surface_create(cairoFormat, mPixelWidth + extraTextureSize, mPixelHeight + extraTextureSize);
-#endif
-		auto cairoSurfaceStatus = cairo_surface_status(mCairoSurface);
-		if(CAIRO_STATUS_SUCCESS != cairoSurfaceStatus) {
-			DS_LOG_WARNING("Error creating Cairo surface. Status:" << cairoSurfaceStatus << " w:" << mPixelWidth + extraTextureSize << " h:" << mPixelHeight + extraTextureSize << " text:" << ds::utf8_from_wstr(mText));
-			// make sure we don't render garbage
-			if(mTexture){
-				mTexture = nullptr;
-			}
-			return;
-		}
-
-
-		if(mCairoSurface){
-			// Create context
-			/* create our cairo context object that tracks state. */
-			if(mCairoContext) {
-				cairo_destroy(mCairoContext);
-				mCairoContext = nullptr;
-			}
-			mCairoContext = cairo_create(mCairoSurface);
-
-			auto cairoStatus = cairo_status(mCairoContext);
-
-			if(CAIRO_STATUS_NO_MEMORY == cairoStatus) {
-				DS_LOG_WARNING("Out of memory, error creating Cairo context");
+	// make sure we don't render garbage
+	mTexture = rasterizeText(mPangoLayout, mTextColor, mPixelWidth + extraTextureSize, mPixelHeight + extraTextureSize);
+	if(mTexture){
+		mNeedsTextRender = false;
+	}
+}
 
-				return;
+void Text::buildGlyphBatches(){
+	mGlyphBatches.clear();
+	mNeedsTextRender = false;
+	if(!mPangoLayout || mText.empty()) return;
+
+	// Taken before adding glyphs, so a page dropped while building is caught by the next check
+	GlyphAtlas&					atlas = mEngine.getPangoFontService().getGlyphAtlas();
+	mGlyphAtlasGeneration = atlas.getGeneration();
+	// Perspective sprites are y-up
+	const bool					flip = getPerspective();
+	const float					height = static_cast<float>(mPixelHeight);
+	std::vector<ci::TriMesh>	meshes;
+
+	PangoLayoutIter*			iter = pango_layout_get_iter(mPangoLayout);
+	do {
+		PangoLayoutRun*			run = pango_layout_iter_get_run_readonly(iter);
+		// The end of a line
+		if(!run) continue;
+
+		PangoRectangle			logical;
+		pango_layout_iter_get_run_extents(iter, nullptr, &logical);
+		const int				baseline = pango_layout_iter_get_baseline(iter);
+		const ci::Color			color = getRunColor(run, mTextColor);
+		int						x = logical.x;
+		for(int i = 0; i < run->glyphs->num_glyphs; ++i){
+			const PangoGlyphInfo&	info = run->glyphs->glyphs[i];
+			const float			penX = (float)(x + info.geometry.x_offset) / (float)PANGO_SCALE;
+			const float			penY = std::floor((float)(baseline + info.geometry.y_offset) / (float)PANGO_SCALE + 0.5f);
+			x += info.geometry.width;
+			if(info.glyph == PANGO_GLYPH_EMPTY || (info.glyph & PANGO_GLYPH_UNKNOWN_FLAG)) continue;
+
+			// Whole pixels here, the atlas has the glyph drawn at the fraction
+			const float			pixelX = std::floor(penX);
+			const GlyphAtlas::Glyph*	glyph = atlas.find(run->item->analysis.font, info.glyph, penX - pixelX);
+			if(!glyph) continue;
+
+			size_t				b = 0;
+			while(b < mGlyphBatches.size() && (mGlyphBatches[b].mPage != glyph->mPage || mGlyphBatches[b].mColor != color)) ++b;
+			if(b == mGlyphBatches.size()){
+				GlyphBatch		batch;
+				batch.mPage = glyph->mPage;
+				batch.mColor = color;
+				mGlyphBatches.push_back(batch);
+				meshes.push_back(ci::TriMesh(ci::TriMesh::Format().positions(2).texCoords0(2)));
 			}
 
-			if(CAIRO_STATUS_SUCCESS != cairoStatus){
-				DS_LOG_WARNING("Error creating Cairo context " << cairoStatus);
-				return;
+			ci::TriMesh&		mesh = meshes[b];
+			const uint32_t		first = static_cast<uint32_t>(mesh.getNumVertices());
+			const ci::Rectf&	tex = glyph->mTexCoords;
+			const float			left = pixelX + glyph->mOffset.x;
+			const float			right = left + glyph->mSize.x;
+			float				top = penY + glyph->mOffset.y;
+			float				bottom = top + glyph->mSize.y;
+			if(flip){
+				top = height - top;
+				bottom = height - bottom;
 			}
+			mesh.appendPosition(ci::vec2(left, top));
+			mesh.appendTexCoord0(ci::vec2(tex.x1, tex.y1));
+			mesh.appendPosition(ci::vec2(right, top));
+			mesh.appendTexCoord0(ci::vec2(tex.x2, tex.y1));
+			mesh.appendPosition(ci::vec2(right, bottom));
+			mesh.appendTexCoord0(ci::vec2(tex.x2, tex.y2));
+			mesh.appendPosition(ci::vec2(left, bottom));
+			mesh.appendTexCoord0(ci::vec2(tex.x1, tex.y2));
+			mesh.appendTriangle(first, first + 1, first + 2);
+			mesh.appendTriangle(first, first + 2, first + 3);
 		}
+	} while(pango_layout_iter_next_run(iter));
+	pango_layout_iter_free(iter);
 
-		if(mCairoContext) {
-
-			// Draw the text into the buffer
-			cairo_set_source_rgb(mCairoContext, mTextColor.r, mTextColor.g, mTextColor.b);//, getDrawOpacity());
-			pango_cairo_update_layout(mCairoContext, mPangoLayout);
-			pango_cairo_show_layout(mCairoContext, mPangoLayout);
-
-			//	cairo_surface_write_to_png(cairoSurface, "test_font.png");
-
-			// Copy it out to a texture
-#ifdef CAIRO_HAS_WIN32_SURFACE
-			mCairoWinImageSurface = cairo_win32_surface_get_image(mCairoSurface);
-			unsigned char *pixels = cairo_image_surface_get_data(mCairoWinImageSurface);
-#else
-			unsigned char *pixels = cairo_image_surface_get_data(mCairoSurface);
-#endif
+	for(size_t b = 0; b < mGlyphBatches.size(); ++b){
+		mGlyphBatches[b].mBatch = ci::gl::Batch::create(meshes[b], mSpriteShader.getShader());
+	}
+}
 
-			ci::gl::Texture::Format format;
-			format.setMagFilter(GL_LINEAR);
-			format.setMinFilter(GL_LINEAR);
-			mTexture = ci::gl::Texture::create(pixels, GL_BGRA, mPixelWidth + extraTextureSize, mPixelHeight + extraTextureSize, format);
-			mTexture->setTopDown(true);
-			mNeedsTextRender = false;
-
-			/* */
-			if(mCairoContext) {
-				cairo_destroy(mCairoContext);
-				mCairoContext = nullptr;
-			}
+void Text::checkGlyphPages(){
+	if(!mUseGlyphAtlas || mGlyphBatches.empty()) return;
 
-			if(mCairoSurface) {
-				cairo_surface_destroy(mCairoSurface);
-				mCairoSurface = nullptr;
-#ifdef CAIRO_HAS_WIN32_SURFACE
-				mCairoWinImageSurface = nullptr;
-#endif
-			}
+	// Dropped pages still draw, the batches hold on to them, but they're memory the atlas
+	// can't have back until this sprite lets go.
+	const GlyphAtlas&			atlas = mEngine.getPangoFontService().getGlyphAtlas();
+	if(mGlyphAtlasGeneration == atlas.getGeneration()) return;
+	mGlyphAtlasGeneration = atlas.getGeneration();
+	for(auto it = mGlyphBatches.begin(), end = mGlyphBatches.end(); it != end; ++it){
+		if(!atlas.isLive(it->mPage)){
+			mNeedsBatchUpdate = true;
+			return;
 		}
-
-	} 
+	}
 }
 
 void Text::writeAttributesTo(ds::DataBuffer& buf){
@@ -2,6 +2,8 @@
 #ifndef DS_UI_SPRITE_TEXT_SPRITE
 #define DS_UI_SPRITE_TEXT_SPRITE
 
+#include <memory>
+#include <vector>
 #include "ds/ui/sprite/sprite.h"
 #include "ds/ui/sprite/text_defs.h"
 #include <cinder/gl/Texture.h>
@@ -11,14 +13,10 @@
 struct 			_PangoContext;
 struct 			_PangoLayout;
 struct 			_PangoFontDescription;
-struct 			_cairo_surface;
-struct 			_cairo;
 struct 			_cairo_font_options;
 typedef struct	_PangoContext PangoContext;
 typedef struct 	_PangoLayout PangoLayout;
 typedef struct 	_PangoFontDescription PangoFontDescription;
-typedef struct 	_cairo_surface cairo_surface_t;
-typedef struct 	_cairo cairo_t;
 typedef struct 	_cairo_font_options cairo_font_options_t;
 
 namespace ds {
@@ -60,6 +58,13 @@ namespace ui {
 				<small> smaller
 				<tt> monospace font
 				<u> underline
+*
+*	With the "text:async" setting, layout and rasterizing happen on the GL upload threads, and a sprite keeps
+*	its previous texture until the new one arrives. Its size updates with the texture, unless something asks
+*	for it sooner: getWidth(), getHeight() and the character queries still lay out right away on the main thread.
+*
+*	With setUseGlyphAtlas() (or the "text:glyph_atlas" setting) the text is drawn as quads from glyphs shared by
+*	every text sprite, so changing it doesn't allocate a texture. See GlyphAtlas for the trade-offs.
 */
 
 class Text : public ds::ui::Sprite {
@@ -168,8 +173,15 @@ public:
 
 	/// Text is rendered into this texture
 	/// Note: this texture has pre-multiplied alpha
+	/// Answers nothing when drawing from the glyph atlas
 	const ci::gl::TextureRef	getTexture();
 
+	/// Draw from the engine's shared glyph atlas instead of rendering a texture for this sprite.
+	/// Underline, strikethrough and background markup aren't drawn in this mode.
+	/// Defaults to the "text:glyph_atlas" setting, and isn't sent to clients.
+	void						setUseGlyphAtlas(const bool);
+	bool						getUseGlyphAtlas() const;
+
 
 	virtual void				writeAttributesTo(ds::DataBuffer&);
 	virtual void				readAttributeFrom(const char attributeId, ds::DataBuffer&);
@@ -190,6 +202,16 @@ protected:
 	void renderPangoText();
 
 private:
+	struct RenderJob;
+
+	// Measures, or with async text sends a render job if anything changed
+	void						updateLayout();
+	void						finishRenderJob(const std::shared_ptr<RenderJob>&);
+	// Glyph atlas mode, turns the layout into quads
+	void						buildGlyphBatches();
+	// Glyph atlas mode, rebuilds if the atlas dropped a page the batches draw from
+	void						checkGlyphPages();
+
 	ci::gl::TextureRef			mTexture;
 
 	std::string					mCfgName;
@@ -222,6 +244,8 @@ private:
 	bool 						mNeedsTextRender;
 	bool 						mNeedsFontOptionUpdate;
 	bool 						mNeedsMarkupDetection;
+	// A render job measured for me, but mPangoLayout hasn't been updated
+	bool						mLayoutStale;
 
 	// simply stored to check for change across renders
 	int 						mPixelWidth;
@@ -231,13 +255,21 @@ private:
 	PangoContext*				mPangoContext;
 	PangoLayout*				mPangoLayout;
 	PangoFontDescription*		mFontDescription;
-	cairo_surface_t*			mCairoSurface;
-	cairo_t*					mCairoContext;
 	cairo_font_options_t*		mCairoFontOptions;
 
-#ifdef WIN32
-	cairo_surface_t*			mCairoWinImageSurface;
-#endif
+	// The last job sent, async text only
+	std::shared_ptr<RenderJob>	mRenderJob;
+
+	// Glyph atlas mode draws one batch for each atlas page and colour in the text
+	struct GlyphBatch {
+		ci::gl::TextureRef		mPage;
+		ci::Color				mColor;
+		ci::gl::BatchRef		mBatch;
+	};
+	bool						mUseGlyphAtlas;
+	std::vector<GlyphBatch>		mGlyphBatches;
+	// The atlas generation the batches were built in
+	unsigned int				mGlyphAtlasGeneration;
 };
 }
 } // namespace kp::pango
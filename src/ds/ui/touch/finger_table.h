@@ -0,0 +1,151 @@
+#pragma once
+#ifndef DS_UI_TOUCH_FINGERTABLE_H_
+#define DS_UI_TOUCH_FINGERTABLE_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace ds {
+namespace ui {
+
+/**
+ * \class ds::ui::FingerTable
+ * \brief A fixed number of records keyed by finger id, for the fingers that are down.
+ * Records are found through an open addressed hash of slot indices that's never more
+ * than half full, so a lookup is a probe or two. Freed slots go on a free list and the
+ * slots in use are kept in a packed list, so nothing scans the whole table and nothing
+ * is allocated once it's made.
+ *
+ * Ids can be anything but -1, which marks an empty hash entry. Records are reused as
+ * they are, clear them on add().
+ */
+template <typename T>
+class FingerTable {
+public:
+	FingerTable(const size_t capacity);
+
+	T*						find(const int id);
+	const T*				find(const int id) const;
+	// The record for id, which is added if it isn't there. Answers nullptr if the table is full.
+	T*						add(const int id);
+	void					remove(const int id);
+
+	size_t					getCapacity() const				{ return mRecords.size(); }
+	// The records in use, in no order. Adding or removing moves them around.
+	size_t					size() const					{ return mActive.size(); }
+	T&						getActive(const size_t i)		{ return mRecords[mActive[i]]; }
+	const T&				getActive(const size_t i) const	{ return mRecords[mActive[i]]; }
+
+private:
+	// The entry for id, or the empty entry where it would go
+	size_t					findHash(const int id) const;
+	size_t					home(const int id) const;
+
+	std::vector<T>			mRecords;
+	std::vector<int>		mFree;
+	std::vector<int>		mActive;
+	// Where each slot is in mActive
+	std::vector<int>		mActiveIndex;
+	// A power of two at least twice the capacity. -1 is empty.
+	std::vector<int>		mHashIds, mHashSlots;
+};
+
+template <typename T>
+FingerTable<T>::FingerTable(const size_t capacity)
+	: mRecords(capacity)
+	, mActiveIndex(capacity, -1)
+{
+	size_t					hashSize = 2;
+	while (hashSize < capacity * 2) hashSize *= 2;
+	mHashIds.assign(hashSize, -1);
+	mHashSlots.assign(hashSize, -1);
+
+	mFree.reserve(capacity);
+	for (size_t i = capacity; i > 0; --i) mFree.push_back(static_cast<int>(i - 1));
+	mActive.reserve(capacity);
+}
+
+template <typename T>
+T* FingerTable<T>::find(const int id)
+{
+	if (id == -1) return nullptr;
+	const size_t			h = findHash(id);
+	return mHashIds[h] == id ? &mRecords[mHashSlots[h]] : nullptr;
+}
+
+template <typename T>
+const T* FingerTable<T>::find(const int id) const
+{
+	if (id == -1) return nullptr;
+	const size_t			h = findHash(id);
+	return mHashIds[h] == id ? &mRecords[mHashSlots[h]] : nullptr;
+}
+
+template <typename T>
+T* FingerTable<T>::add(const int id)
+{
+	if (id == -1) return nullptr;
+	const size_t			h = findHash(id);
+	if (mHashIds[h] == id) return &mRecords[mHashSlots[h]];
+	if (mFree.empty()) return nullptr;
+
+	const int				slot = mFree.back();
+	mFree.pop_back();
+	mHashIds[h] = id;
+	mHashSlots[h] = slot;
+	mActiveIndex[slot] = static_cast<int>(mActive.size());
+	mActive.push_back(slot);
+	return &mRecords[slot];
+}
+
+template <typename T>
+void FingerTable<T>::remove(const int id)
+{
+	if (id == -1) return;
+	size_t					h = findHash(id);
+	if (mHashIds[h] != id) return;
+
+	const int				slot = mHashSlots[h];
+	const int				last = mActive.back();
+	mActive[mActiveIndex[slot]] = last;
+	mActiveIndex[last] = mActiveIndex[slot];
+	mActive.pop_back();
+	mActiveIndex[slot] = -1;
+	mFree.push_back(slot);
+
+	// Pull back any later entries that can now sit closer to their home,
+	// so every probe still stops at the first empty entry.
+	const size_t			mask = mHashIds.size() - 1;
+	mHashIds[h] = -1;
+	for (size_t i = (h + 1) & mask; mHashIds[i] != -1; i = (i + 1) & mask) {
+		const size_t		at = home(mHashIds[i]);
+		// Move it if its home isn't in (h, i], going around the end
+		const bool			stay = (h < i) ? (at > h && at <= i) : (at > h || at <= i);
+		if (stay) continue;
+		mHashIds[h] = mHashIds[i];
+		mHashSlots[h] = mHashSlots[i];
+		mHashIds[i] = -1;
+		h = i;
+	}
+}
+
+template <typename T>
+size_t FingerTable<T>::findHash(const int id) const
+{
+	// Never more than half full, so there's always an empty entry to stop on
+	const size_t			mask = mHashIds.size() - 1;
+	size_t					i = home(id);
+	while (mHashIds[i] != -1 && mHashIds[i] != id) i = (i + 1) & mask;
+	return i;
+}
+
+template <typename T>
+size_t FingerTable<T>::home(const int id) const
+{
+	return static_cast<size_t>(static_cast<unsigned>(id) * 2654435761u) & (mHashIds.size() - 1);
+}
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_TOUCH_FINGERTABLE_H_
@@ -0,0 +1,118 @@
+#include "stdafx.h"
+
+#include "ds/ui/touch/gesture_engine.h"
+
+#include "ds/params/update_params.h"
+#include "ds/ui/sprite/sprite.h"
+#include "ds/ui/touch/touch_process.h"
+
+namespace ds {
+namespace ui {
+
+/**
+ * \class ds::ui::GestureEngine
+ */
+GestureEngine::GestureEngine(SpriteEngine& engine)
+	: mEngine(engine)
+	, mTimed(false)
+	, mDepth(0)
+	, mTime(0)
+{
+}
+
+GestureEngine::~GestureEngine() {
+	// Sprites normally hand their process back when they're deleted, but don't
+	// leave any pointing into the pool if one outlives it.
+	for (auto it = mActive.begin(), end = mActive.end(); it != end; ++it) {
+		TouchProcess*		p = *it;
+		if (p && p->mSprite) p->mSprite->mTouchProcess = nullptr;
+	}
+}
+
+void GestureEngine::process(Sprite& sprite, const TouchInfo& ti) {
+	if (!sprite.mTouchProcess) {
+		if (!sprite.visible() || !sprite.isEnabled()) return;
+		acquire(sprite);
+	}
+	if (!mTimed || mDepth > 0) {
+		sprite.mTouchProcess->processTouchInfo(ti);
+		return;
+	}
+	const Poco::Timestamp	start;
+	++mDepth;
+	sprite.mTouchProcess->processTouchInfo(ti);
+	--mDepth;
+	mTime += start.elapsed();
+}
+
+TouchProcess& GestureEngine::acquire(Sprite& sprite) {
+	TouchProcess*			p = nullptr;
+	if (mFree.empty()) {
+		mProcesses.push_back(std::unique_ptr<TouchProcess>(new TouchProcess(mEngine)));
+		p = mProcesses.back().get();
+	} else {
+		p = mFree.back();
+		mFree.pop_back();
+	}
+	p->bind(&sprite);
+	p->mActiveIndex = mActive.size();
+	mActive.push_back(p);
+	sprite.mTouchProcess = p;
+	return *p;
+}
+
+void GestureEngine::release(TouchProcess& p) {
+	if (p.mActiveIndex >= mActive.size() || mActive[p.mActiveIndex] != &p) return;
+	mActive[p.mActiveIndex] = nullptr;
+	p.clearTouches();
+	recycle(p);
+}
+
+void GestureEngine::update(const ds::UpdateParams& params) {
+	if (mActive.empty()) return;
+	const Poco::Timestamp	start;
+
+	// By index, since a callback can touch a new sprite and grow the list
+	const size_t			count = mActive.size();
+	for (size_t k = 0; k < count; ++k) {
+		if (mActive[k]) mActive[k]->update(params);
+	}
+
+	size_t					dst = 0;
+	for (size_t k = 0, end = mActive.size(); k < end; ++k) {
+		TouchProcess*		p = mActive[k];
+		if (!p) continue;
+		if (p->isIdle()) {
+			recycle(*p);
+			continue;
+		}
+		p->mActiveIndex = dst;
+		mActive[dst++] = p;
+	}
+	mActive.resize(dst);
+	if (mTimed) mTime += start.elapsed();
+}
+
+size_t GestureEngine::getActiveCount() const {
+	return mActive.size();
+}
+
+void GestureEngine::setTimed(const bool timed) {
+	mTimed = timed;
+	mTime = 0;
+}
+
+Poco::Timestamp::TimeDiff GestureEngine::takeTime() {
+	const Poco::Timestamp::TimeDiff	t = mTime;
+	mTime = 0;
+	return t;
+}
+
+void GestureEngine::recycle(TouchProcess& p) {
+	if (p.mSprite) p.mSprite->mTouchProcess = nullptr;
+	p.bind(nullptr);
+	mFree.push_back(&p);
+}
+
+} // namespace ui
+} // namespace ds
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef DS_UI_TOUCH_GESTUREENGINE_H_
+#define DS_UI_TOUCH_GESTUREENGINE_H_
+
+#include <memory>
+#include <vector>
+#include <Poco/Timestamp.h>
+
+namespace ds {
+class UpdateParams;
+
+namespace ui {
+class Sprite;
+class SpriteEngine;
+struct TouchInfo;
+class TouchProcess;
+
+/**
+ * \class ds::ui::GestureEngine
+ * \brief Owns the gesture recognizers. A sprite borrows a TouchProcess when it's first
+ * touched and gives it back once its fingers are up and no tap is pending, so untouched
+ * sprites carry no gesture state and the per-frame gesture work is one pass over the
+ * sprites actually being touched, instead of a walk of the whole tree.
+ *
+ * Main thread only.
+ */
+class GestureEngine {
+public:
+	GestureEngine(SpriteEngine&);
+	~GestureEngine();
+
+	// Run a touch through the sprite's recognizer, lending it one if needed.
+	void								process(Sprite&, const TouchInfo&);
+
+	TouchProcess&						acquire(Sprite&);
+	// Give back early, i.e. the sprite is going away. Its fingers are cleared.
+	void								release(TouchProcess&);
+
+	// Run the active recognizers (pending taps and the like), then return the idle ones.
+	void								update(const ds::UpdateParams&);
+
+	size_t								getActiveCount() const;
+
+	// Add up the time spent recognizing, for the touch replay timings.
+	void								setTimed(const bool);
+	// The time since the last call, in microseconds
+	Poco::Timestamp::TimeDiff			takeTime();
+
+private:
+	GestureEngine(const GestureEngine&);
+	GestureEngine&						operator=(const GestureEngine&);
+
+	void								recycle(TouchProcess&);
+
+	SpriteEngine&						mEngine;
+	std::vector<std::unique_ptr<TouchProcess>>
+										mProcesses;
+	// Released entries are nulled and compacted out at the end of update(), so
+	// a sprite can be deleted from inside a gesture callback.
+	std::vector<TouchProcess*>			mActive;
+	std::vector<TouchProcess*>			mFree;
+
+	bool								mTimed;
+	// Callbacks can pass a touch on to another sprite; only the outer call is timed
+	int									mDepth;
+	Poco::Timestamp::TimeDiff			mTime;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_TOUCH_GESTUREENGINE_H_
@@ -0,0 +1,121 @@
+#include "stdafx.h"
+
+#include "ds/ui/touch/gesture_recognizers.h"
+
+#include <cmath>
+
+namespace ds {
+namespace ui {
+
+// Swipes are measured in steps of a frame at 60 fps
+static const float		SWIPE_FRAME = 1.0f / 60.0f;
+
+/**
+ * \class ds::ui::SwipeRecognizer
+ */
+void SwipeRecognizer::clear() {
+	mQueue.clear();
+}
+
+void SwipeRecognizer::add(const ci::vec3& globalPoint, const float time, const size_t queueSize) {
+	SwipeQueueEvent		swipeEvent;
+	swipeEvent.mCurrentGlobalPoint = globalPoint;
+	swipeEvent.mTimeStamp = time;
+	mQueue.push_back(swipeEvent);
+	if (mQueue.size() > queueSize) {
+		mQueue.pop_front();
+	}
+}
+
+bool SwipeRecognizer::happened(	const float now, const size_t queueSize, const float minVelocity,
+								const float maxTime, ci::vec3& swipe) const {
+	swipe = ci::vec3();
+	if (mQueue.size() < queueSize || mQueue.size() < 2) {
+		return false;
+	}
+
+	const SwipeQueueEvent&	oldest = mQueue.front();
+	const SwipeQueueEvent&	newest = mQueue.back();
+	const float				dt = newest.mTimeStamp - oldest.mTimeStamp;
+	if (dt > 0.0f) {
+		swipe = (newest.mCurrentGlobalPoint - oldest.mCurrentGlobalPoint) * (SWIPE_FRAME / dt);
+	} else {
+		swipe = (newest.mCurrentGlobalPoint - oldest.mCurrentGlobalPoint) / static_cast<float>(mQueue.size() - 1);
+	}
+
+	const float			averageDistance = glm::length(swipe);
+	return averageDistance >= minVelocity * SWIPE_FRAME && (now - mQueue.front().mTimeStamp) < maxTime;
+}
+
+/**
+ * \class ds::ui::TapRecognizer
+ */
+TapRecognizer::TapRecognizer() {
+	clear();
+}
+
+void TapRecognizer::clear() {
+	mTappable = false;
+	mWaiting = false;
+	mFirstTapTime = 0.0f;
+	mFirstTapPos = ci::vec3();
+}
+
+bool TapRecognizer::follow(const TouchInfo& ti, const size_t fingersDown, const float minDistance) {
+	if (!mTappable) return false;
+	if (fingersDown > 1 || ti.mPassedTouch
+			|| (ti.mPhase == TouchInfo::Moved && glm::distance(ti.mCurrentGlobalPoint, ti.mStartPoint) > minDistance)) {
+		mTappable = false;
+	}
+	return mTappable;
+}
+
+TapRecognizer::Event TapRecognizer::up(const ci::vec3& globalPoint, const float now, const bool waitForDouble) {
+	if (!waitForDouble) {
+		mWaiting = false;
+		return TAP;
+	}
+	if (mWaiting) {
+		mWaiting = false;
+		return DOUBLE_TAP;
+	}
+	mFirstTapPos = globalPoint;
+	mFirstTapTime = now;
+	mWaiting = true;
+	return NONE;
+}
+
+TapRecognizer::Event TapRecognizer::update(const float now, const float doubleTapTime, ci::vec3& globalPoint) {
+	if (!mWaiting || now - mFirstTapTime <= doubleTapTime) return NONE;
+	mWaiting = false;
+	globalPoint = mFirstTapPos;
+	return TAP;
+}
+
+/**
+ * \class ds::ui::Pinch
+ */
+Pinch::Pinch() {
+	clear();
+}
+
+void Pinch::clear() {
+	mStartDistance = 0.0f;
+	mCurrentDistance = 0.0f;
+	mScale = 1.0f;
+	mAngle = 0.0f;
+}
+
+void Pinch::measure(const ci::vec3& start0, const ci::vec3& start1,
+					const ci::vec3& current0, const ci::vec3& current1, const float minDistance) {
+	mStartDistance = glm::distance(start0, start1);
+	if (mStartDistance < minDistance) mStartDistance = minDistance;
+	mCurrentDistance = glm::distance(current0, current1);
+	if (mCurrentDistance < minDistance) mCurrentDistance = minDistance;
+
+	mScale = mCurrentDistance / mStartDistance;
+	mAngle = std::atan2(start1.y - start0.y, start1.x - start0.x) - std::atan2(current1.y - current0.y, current1.x - current0.x);
+}
+
+} // namespace ui
+} // namespace ds
@@ -0,0 +1,109 @@
+#pragma once
+#ifndef DS_UI_TOUCH_GESTURERECOGNIZERS_H_
+#define DS_UI_TOUCH_GESTURERECOGNIZERS_H_
+
+#include <deque>
+#include <cinder/Vector.h>
+#include "ds/ui/touch/touch_info.h"
+
+/**
+ * The gesture math TouchProcess runs for a sprite, with no sprite involved: each
+ * recognizer takes touches and times and answers what it saw, and TouchProcess
+ * applies that to its sprite. That keeps them testable on recorded input.
+ */
+namespace ds {
+namespace ui {
+
+struct SwipeQueueEvent {
+	ci::vec3 mCurrentGlobalPoint;
+	float     mTimeStamp;
+};
+
+/**
+ * \class ds::ui::SwipeRecognizer
+ * \brief The last few positions of the finger that started a gesture, and whether
+ * it was moving fast enough when it lifted to count as a swipe.
+ */
+class SwipeRecognizer {
+public:
+	void					clear();
+	// Keeps the newest queueSize points
+	void					add(const ci::vec3& globalPoint, const float time, const size_t queueSize);
+	// True if the queue is full, the step a 60 fps frame is at least minVelocity
+	// (pixels a second, at 60 fps) and the oldest point is less than maxTime before
+	// now. The step is measured over the points' times, so it doesn't matter how
+	// many came in each frame; points that all share a time use the mean step.
+	// The step goes in swipe either way.
+	bool					happened(	const float now, const size_t queueSize, const float minVelocity,
+										const float maxTime, ci::vec3& swipe) const;
+
+private:
+	std::deque<SwipeQueueEvent>	mQueue;
+};
+
+/**
+ * \class ds::ui::TapRecognizer
+ * \brief Taps and double taps for one sprite. A touch stays a possible tap until a
+ * second finger lands, it's passed on, or it moves too far. With double taps on,
+ * the first tap waits for a second one, and update() answers it as a single tap
+ * once the wait is over.
+ */
+class TapRecognizer {
+public:
+	enum Event {
+		NONE,
+		TAP,
+		DOUBLE_TAP
+	};
+
+	TapRecognizer();
+
+	void					clear();
+
+	// The first finger is down
+	void					begin()							{ mTappable = true; }
+	// This touch can't be a tap any more. A first tap that's waiting still counts.
+	void					cancel()						{ mTappable = false; }
+	bool					isTappable() const				{ return mTappable; }
+	// A first tap is waiting to see if there's a second
+	bool					isWaiting() const				{ return mWaiting; }
+
+	// Follow a touch after begin(), fingersDown is the count before this touch. Answers
+	// false, and cancels, if it's no longer a tap.
+	bool					follow(const TouchInfo&, const size_t fingersDown, const float minDistance);
+	// The finger lifted while tappable. waitForDouble holds the first tap back.
+	Event					up(const ci::vec3& globalPoint, const float now, const bool waitForDouble);
+	// Answers TAP, with where it was, once a waiting tap has waited past doubleTapTime.
+	Event					update(const float now, const float doubleTapTime, ci::vec3& globalPoint);
+
+private:
+	bool					mTappable;
+	bool					mWaiting;
+	float					mFirstTapTime;
+	ci::vec3				mFirstTapPos;
+};
+
+/**
+ * \class ds::ui::Pinch
+ * \brief How far two fingers have spread and turned since they went down.
+ * Distances under the minimum count as the minimum, so close fingers don't
+ * blow the scale up.
+ */
+struct Pinch {
+	Pinch();
+
+	void					clear();
+	void					measure(const ci::vec3& start0, const ci::vec3& start1,
+									const ci::vec3& current0, const ci::vec3& current1, const float minDistance);
+
+	float					mStartDistance;
+	float					mCurrentDistance;
+	float					mScale;
+	// Radians, from where the fingers are now back to where they started
+	float					mAngle;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_TOUCH_GESTURERECOGNIZERS_H_
@@ -38,6 +38,10 @@ void RotationTranslator::move(TouchInfo &ti, const ci::vec3 &previous_global_pt)
 	pt = ti.mStartPoint + glm::vec3(m * glm::vec4(pt, 1.0f));
 	ti.mCurrentGlobalPoint = pt;
 	ti.mDeltaPoint = ti.mCurrentGlobalPoint - previous_global_pt;
+	for (int i = 0; i < ti.mSampleCount && i < TouchInfo::MAX_SAMPLES; ++i) {
+		ci::vec3&			s = ti.mSamples[i].mPoint;
+		s = ti.mStartPoint + glm::vec3(m * glm::vec4(s - ti.mStartPoint, 1.0f));
+	}
 }
 
 void RotationTranslator::up(TouchInfo &ti) {
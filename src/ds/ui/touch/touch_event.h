@@ -3,6 +3,7 @@
 #define DS_UI_TOUCH_TOUCH_EVENT
 
 #include <cinder/app/TouchEvent.h>
+#include <Poco/Timestamp.h>
 
 namespace ds {
 namespace ui {
@@ -13,11 +14,11 @@ namespace ui {
 */
 class TouchEvent : public ci::app::TouchEvent {
 public:
-	TouchEvent(): mInWorldSpace(false){};
+	TouchEvent(): mInWorldSpace(false), mReceivedTime(0), mSourceFrame(0){};
 	TouchEvent(ci::app::TouchEvent& cinderEvent)
-		: ci::app::TouchEvent(cinderEvent), mInWorldSpace(false){}
+		: ci::app::TouchEvent(cinderEvent), mInWorldSpace(false), mReceivedTime(0), mSourceFrame(0){}
 	TouchEvent(ci::app::WindowRef win, const std::vector<ci::app::TouchEvent::Touch> &touches, const bool inWorldSpace = false)
-		: ci::app::TouchEvent(win, touches), mInWorldSpace(inWorldSpace){}
+		: ci::app::TouchEvent(win, touches), mInWorldSpace(inWorldSpace), mReceivedTime(0), mSourceFrame(0){}
 
 	/// If this touch event is known to be in world space co-ordinates already
 	const bool			getInWorldSpace() const {	return mInWorldSpace;	}
@@ -25,9 +26,18 @@ public:
 	/// If a piece of the system is sure that the touch event co-ordinates are in world space and require no further translation
 	void				setInWorldSpace(const bool inWorldSpace){ mInWorldSpace = inWorldSpace; }
 
+	/// When the engine got this event, in Poco::Timestamp microseconds. 0 if it wasn't stamped.
+	Poco::Timestamp::TimeVal	getReceivedTime() const { return mReceivedTime; }
+	void				setReceivedTime(const Poco::Timestamp::TimeVal t){ mReceivedTime = t; }
+
+	/// The frame id from the device (the TUIO frame sequence), or 0 if it didn't send one
+	int32_t				getSourceFrame() const { return mSourceFrame; }
+	void				setSourceFrame(const int32_t f){ mSourceFrame = f; }
 
 private:
 	bool				mInWorldSpace;
+	Poco::Timestamp::TimeVal	mReceivedTime;
+	int32_t				mSourceFrame;
 };
 
 } // namespace ui
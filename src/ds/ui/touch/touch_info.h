@@ -24,6 +24,9 @@ struct TouchInfo
 	ci::vec3	mStartPoint;
 	ci::vec3	mCurrentGlobalPoint;
 	ci::vec3	mDeltaPoint;
+	// Where the finger should be by the time this frame shows, relative to
+	// mCurrentGlobalPoint. Zero unless the touch manager is predicting.
+	ci::vec3	mPredictionOffset;
 	Sprite*		mPickedSprite;
 	bool		mActive;
 	float		mStartDistance;
@@ -33,6 +36,18 @@ struct TouchInfo
 
 	// This touch is being removed from it's previous owner if true
 	bool		mPassedTouch;
+
+	// Moves are dispatched once a frame per finger. For a Moved touch, these are the
+	// raw points (world space, before smoothing) that came in since the last one,
+	// oldest first, with their input times in seconds. Only the newest MAX_SAMPLES
+	// are kept. Added and Removed touches have none.
+	static const int	MAX_SAMPLES = 8;
+	struct Sample {
+		ci::vec3	mPoint;
+		double		mTime;
+	};
+	Sample		mSamples[MAX_SAMPLES];
+	int			mSampleCount;
 };
 
 } // namespace ui
@@ -2,6 +2,7 @@
 
 #include "touch_manager.h"
 
+#include <algorithm>
 #include <cinder/System.h>
 
 #include "ds/app/engine/engine.h"
@@ -34,6 +35,11 @@ TouchManager::TouchManager(Engine &engine, const TouchMode::Enum &mode)
 		, mSmoothEnabled(true)
 		, mFramesToSmooth(8)
 		, mVerboseLogging(false)
+		, mCoalesceMoves(true)
+		, mPredictSeconds(0.0f)
+		, mPredictMaxDistance(0.0f)
+		, mPredictAcceleration(0.0f)
+		, mFingers(MAX_FINGERS)
 {
 }
 
@@ -57,7 +63,9 @@ void TouchManager::touchesBegin(const ds::ui::TouchEvent &event) {
 		}
 
 		if(shouldDiscardTouch(touchPos)){
-			mDiscardTouchMap[fingerId] = true;
+			Finger* finger = findFinger(fingerId);
+			if(!finger) finger = addFinger(fingerId);
+			if(finger) finger->mDiscarded = true;
 
 			if(mVerboseLogging){
 				DS_LOG_INFO_M("Touch DISCARDED as out of bounds " << touchIt->getId() << " bounds: " << mTouchFilterRect, TOUCH_MANAGER_LOG);
@@ -85,27 +93,39 @@ void TouchManager::mouseTouchBegin(const ci::app::MouseEvent &event, int id){
 }
 
 void TouchManager::inputBegin(const int fingerId, const ci::vec2& touchPos){
-	mDiscardTouchMap[fingerId] = false;
+	Finger* finger = findFinger(fingerId);
+	if(finger){
+		dispatchMove(*finger);
+	} else {
+		finger = addFinger(fingerId);
+		if(!finger){
+			DS_LOG_WARNING_M("TouchManager can't track more than " << MAX_FINGERS << " fingers, ignoring finger " << fingerId, TOUCH_MANAGER_LOG);
+			return;
+		}
+	}
+	finger->mDiscarded = false;
 
 	ci::vec3 globalPoint = ci::vec3(touchPos, 0.0f);
 
 	TouchInfo touchInfo;
 	touchInfo.mCurrentGlobalPoint = globalPoint;
 	touchInfo.mFingerId = fingerId;
-	touchInfo.mStartPoint = mTouchStartPoint[touchInfo.mFingerId] = touchInfo.mCurrentGlobalPoint;
-	mTouchPreviousPoint[fingerId] = globalPoint;
+	touchInfo.mStartPoint = finger->mStartPoint = touchInfo.mCurrentGlobalPoint;
+	finger->mPreviousPoint = globalPoint;
 	touchInfo.mDeltaPoint = ci::vec3();
+	touchInfo.mPredictionOffset = ci::vec3();
+	touchInfo.mSampleCount = 0;
 
 	// Catch a case where two "touch added" calls get processed for the same fingerID
 	// WITHOUT a released in the middle. This would case the previous sprite to be left with an erroneous finger
 	// So we fake remove it before adding the new one
-	if(mFingerDispatcher[touchInfo.mFingerId]) {
+	if(finger->mSprite) {
 		DS_LOG_WARNING("Double touch added on the same finger Id: " << touchInfo.mFingerId << ", removing previous sprite tracking.");
-		touchInfo.mPickedSprite = mFingerDispatcher[touchInfo.mFingerId];
+		touchInfo.mPickedSprite = finger->mSprite;
 		touchInfo.mPhase = TouchInfo::Removed; // fake removed
 		touchInfo.mPassedTouch = true; // passed touch flag indicates that this info shouldn't be used to trigger buttons, etc. implementation up to each sprite
-		mFingerDispatcher[touchInfo.mFingerId]->processTouchInfo(touchInfo);
-		mFingerDispatcher[touchInfo.mFingerId] = nullptr;
+		finger->mSprite = nullptr;
+		touchInfo.mPickedSprite->processTouchInfo(touchInfo);
 
 		if(mEngine.getTouchInfoPipeCallback()){
 			mEngine.getTouchInfoPipeCallback()(touchInfo);
@@ -122,13 +142,15 @@ void TouchManager::inputBegin(const int fingerId, const ci::vec2& touchPos){
 	touchInfo.mPickedSprite = currentSprite;
 	mRotationTranslator.down(touchInfo);
 
+	finger->mSmoothStart = 0;
+	finger->mSmoothCount = 0;
+	finger->mHistoryCount = 0;
 	if(mSmoothEnabled){
-		mTouchSmoothPoints[fingerId].clear();
-		mTouchSmoothPoints[fingerId].push_back(touchInfo.mCurrentGlobalPoint);
+		finger->smooth(touchInfo.mCurrentGlobalPoint, mFramesToSmooth);
 	}
 
 	if(currentSprite) {
-		mFingerDispatcher[touchInfo.mFingerId] = currentSprite;
+		finger->mSprite = currentSprite;
 		currentSprite->processTouchInfo(touchInfo);
 	}
 
@@ -143,7 +165,8 @@ void TouchManager::touchesMoved(const ds::ui::TouchEvent &event) {
 	for (auto touchIt = event.getTouches().begin(); touchIt != event.getTouches().end(); ++touchIt) {
 		int fingerId = touchIt->getId() + MOUSE_RESERVED_IDS;
 
-		if(mDiscardTouchMap[fingerId]){
+		const Finger* finger = findFinger(fingerId);
+		if(!finger || finger->mDiscarded){
 			continue;
 		}
 
@@ -156,7 +179,7 @@ void TouchManager::touchesMoved(const ds::ui::TouchEvent &event) {
 			DS_LOG_INFO_M("Touch moved, id:" << touchIt->getId() << " pos:" << touchIt->getPos() << " translated pos:" << touchPos << " time:" << touchIt->getTime(), TOUCH_MANAGER_LOG);
 		}
 
-		inputMoved(fingerId, touchPos);
+		inputMoved(fingerId, touchPos, touchIt->getTime(), event.getReceivedTime());
 	}
 }
 
@@ -167,54 +190,73 @@ void TouchManager::mouseTouchMoved(const ci::app::MouseEvent &event, int id){
 		DS_LOG_INFO_M("Mouse input moved, id:" << id << " pos:" << event.getPos() << " translated pos:" << globalPos, TOUCH_MANAGER_LOG);
 	}
 
-	inputMoved(id, globalPos);
+	inputMoved(id, globalPos, mEngine.getElapsedTimeSeconds());
 }
 
-void TouchManager::inputMoved(const int fingerId, const ci::vec2& touchPos){
+void TouchManager::inputMoved(const int fingerId, const ci::vec2& touchPos, const double time, const Poco::Timestamp::TimeVal received){
+	Finger* finger = findFinger(fingerId);
+	if(!finger || finger->mDiscarded) return;
 
-	ci::vec3 globalPoint = ci::vec3(touchPos, 0.0f);
+	if(mCoalesceMoves){
+		finger->addPendingMove(touchPos, time, received);
+		return;
+	}
+
+	TouchInfo::Sample sample;
+	sample.mPoint = ci::vec3(touchPos, 0.0f);
+	sample.mTime = time;
+	sendMove(*finger, &sample, 1, received);
+}
+
+void TouchManager::dispatchMoves(){
+	// Sending never adds or removes fingers, so the list holds still
+	for(size_t i = 0, count = mFingers.size(); i < count; ++i){
+		dispatchMove(mFingers.getActive(i));
+	}
+}
+
+void TouchManager::dispatchMove(Finger& finger){
+	if(finger.mPendingCount < 1) return;
+	const int count = finger.mPendingCount;
+	finger.mPendingCount = 0;
+	sendMove(finger, finger.mPending, count, finger.mPendingReceived);
+}
+
+void TouchManager::sendMove(Finger& finger, const TouchInfo::Sample* samples, const int count, const Poco::Timestamp::TimeVal received){
+
+	ci::vec3 globalPoint = samples[count - 1].mPoint;
 
 	if(mSmoothEnabled){
-		mTouchSmoothPoints[fingerId].push_back(globalPoint);
-		if(mTouchSmoothPoints[fingerId].size() > mFramesToSmooth){
-			mTouchSmoothPoints[fingerId].erase(mTouchSmoothPoints[fingerId].begin());
-		}
-		std::vector<ci::vec3> deltas;
-		for(int i = 1; i < mTouchSmoothPoints[fingerId].size(); i++){
-			deltas.push_back(mTouchSmoothPoints[fingerId][i] - mTouchSmoothPoints[fingerId][i - 1]);
-		}
-		float xcomp(0.0f);
-		float ycomp(0.0f);
-		for(int i = 0; i < deltas.size(); i++){
-			xcomp += deltas[i].x;
-			ycomp += deltas[i].y;
-		}
-		xcomp /= deltas.size();
-		ycomp /= deltas.size();
-		globalPoint = mTouchPreviousPoint[fingerId] + ci::vec3(xcomp, ycomp, 0.0f);
+		globalPoint = finger.mPreviousPoint + finger.smooth(globalPoint, mFramesToSmooth);
 	}
 
+	finger.addHistory(samples, count);
+	mLatencyLog.dispatched(received);
+
 	TouchInfo touchInfo;
 	touchInfo.mCurrentGlobalPoint = globalPoint;
-	touchInfo.mFingerId = fingerId;
-	touchInfo.mStartPoint = mTouchStartPoint[touchInfo.mFingerId];
-	touchInfo.mDeltaPoint = globalPoint - mTouchPreviousPoint[touchInfo.mFingerId];
+	touchInfo.mFingerId = finger.mId;
+	touchInfo.mStartPoint = finger.mStartPoint;
+	touchInfo.mDeltaPoint = globalPoint - finger.mPreviousPoint;
 	touchInfo.mPhase = TouchInfo::Moved;
 	touchInfo.mPassedTouch = false;
-	touchInfo.mPickedSprite = mFingerDispatcher[touchInfo.mFingerId];
+	touchInfo.mPickedSprite = finger.mSprite;
+	touchInfo.mPredictionOffset = mPredictSeconds > 0.0f ? finger.predict(mPredictSeconds, mPredictAcceleration, mPredictMaxDistance) : ci::vec3();
+	std::copy(samples, samples + count, touchInfo.mSamples);
+	touchInfo.mSampleCount = count;
 
 	if(mCapture){
 		mCapture->touchMoved(touchInfo);
 	}
 
-	mRotationTranslator.move(touchInfo, mTouchPreviousPoint[touchInfo.mFingerId]);
+	mRotationTranslator.move(touchInfo, finger.mPreviousPoint);
 
 
-	if(mFingerDispatcher[touchInfo.mFingerId]) {
-		mFingerDispatcher[touchInfo.mFingerId]->processTouchInfo(touchInfo);
+	if(finger.mSprite) {
+		finger.mSprite->processTouchInfo(touchInfo);
 	}
 
-	mTouchPreviousPoint[touchInfo.mFingerId] = globalPoint;
+	finger.mPreviousPoint = globalPoint;
 
 	if(mEngine.getTouchInfoPipeCallback()){
 		mEngine.getTouchInfoPipeCallback()(touchInfo);
@@ -225,7 +267,12 @@ void TouchManager::touchesEnded(const ds::ui::TouchEvent &event) {
 	for (auto touchIt = event.getTouches().begin(); touchIt != event.getTouches().end(); ++touchIt) {
 		int fingerId = touchIt->getId() + MOUSE_RESERVED_IDS;
 
-		if(mDiscardTouchMap[fingerId]){
+		const Finger* finger = findFinger(fingerId);
+		if(!finger){
+			continue;
+		}
+		if(finger->mDiscarded){
+			removeFinger(fingerId);
 			continue;
 		}
 
@@ -253,33 +300,40 @@ void TouchManager::mouseTouchEnded(const ci::app::MouseEvent &event, int id){
 }
 
 void TouchManager::inputEnded(const int fingerId, const ci::vec2& touchPos){
+	Finger* finger = findFinger(fingerId);
+	if(!finger) return;
+	if(finger->mDiscarded){
+		removeFinger(fingerId);
+		return;
+	}
+	dispatchMove(*finger);
+
 	ci::vec3 globalPoint = ci::vec3(touchPos, 0.0f);
 
 	if(mSmoothEnabled){
 		//ignore the smoothing for the end frame and just use the previous point
-		globalPoint = mTouchPreviousPoint[fingerId];
+		globalPoint = finger->mPreviousPoint;
 	}
 
 	TouchInfo touchInfo;
 	touchInfo.mCurrentGlobalPoint = globalPoint;
 	touchInfo.mFingerId = fingerId;
-	touchInfo.mStartPoint = mTouchStartPoint[touchInfo.mFingerId];
-	touchInfo.mDeltaPoint = globalPoint - mTouchPreviousPoint[touchInfo.mFingerId];
+	touchInfo.mStartPoint = finger->mStartPoint;
+	touchInfo.mDeltaPoint = globalPoint - finger->mPreviousPoint;
 	touchInfo.mPhase = TouchInfo::Removed;
 	touchInfo.mPassedTouch = false;
 	touchInfo.mPickedSprite = nullptr;
+	touchInfo.mPredictionOffset = ci::vec3();
+	touchInfo.mSampleCount = 0;
 
 	mRotationTranslator.up(touchInfo);
 
-	if(mFingerDispatcher[touchInfo.mFingerId]) {
-		mFingerDispatcher[touchInfo.mFingerId]->processTouchInfo(touchInfo);
-		mFingerDispatcher[touchInfo.mFingerId] = nullptr;
+	Sprite* sprite = finger->mSprite;
+	removeFinger(fingerId);
+	if(sprite) {
+		sprite->processTouchInfo(touchInfo);
 	}
 
-	mTouchStartPoint.erase(touchInfo.mFingerId);
-	mTouchPreviousPoint.erase(touchInfo.mFingerId);
-	mFingerDispatcher.erase(touchInfo.mFingerId);
-
 	if(mCapture) mCapture->touchEnd(touchInfo);
 
 	if(mEngine.getTouchInfoPipeCallback()){
@@ -290,20 +344,11 @@ void TouchManager::inputEnded(const int fingerId, const ci::vec2& touchPos){
 void TouchManager::clearFingers( const std::vector<int> &fingers ){
 	for ( auto i = fingers.begin(), e = fingers.end(); i != e; ++i )
 	{
-		auto dispatcher = mFingerDispatcher.find(*i);
-		if ( dispatcher != mFingerDispatcher.end() )
-			mFingerDispatcher.erase(dispatcher);
-
-		// Testing disabling this part of the clearing.
-		// If you disable a sprite during a touch phase, keeping these points around allows 
-		// the touch capture drawing to still work correctly, but the sprite won't recieve anything
-// 		auto startPoint = mTouchStartPoint.find(*i);
-// 		if ( startPoint != mTouchStartPoint.end() )
-// 			mTouchStartPoint.erase(startPoint);
-// 
-// 		auto prevPoint = mTouchPreviousPoint.find(*i);
-// 		if ( prevPoint != mTouchPreviousPoint.end() )
-// 			mTouchPreviousPoint.erase(prevPoint);
+		// Only the sprite is cleared. If you disable a sprite during a touch phase, keeping the
+		// points around allows the touch capture drawing to still work correctly, but the sprite
+		// won't recieve anything
+		Finger* finger = findFinger(*i);
+		if ( finger ) finger->mSprite = nullptr;
 	}
 }
 
@@ -312,11 +357,20 @@ void TouchManager::setSpriteForFinger( const int fingerId, ui::Sprite* theSprite
 		return;
 	}
 	
-	mFingerDispatcher[fingerId] = theSprite;
+	Finger* finger = findFinger(fingerId);
+	if (finger) finger->mSprite = theSprite;
 }
 
 Sprite* TouchManager::getSpriteForFinger( const int fingerId ){
-	return mFingerDispatcher[fingerId];
+	Finger* finger = findFinger(fingerId);
+	return finger ? finger->mSprite : nullptr;
+}
+
+bool TouchManager::getPreviousTouchPoint(const int fingerId, ci::vec3& outPoint) const {
+	const Finger* finger = findFinger(fingerId);
+	if (!finger || finger->mDiscarded) return false;
+	outPoint = finger->mPreviousPoint;
+	return true;
 }
 
 Sprite* TouchManager::getHit(const ci::vec3 &point) {
@@ -340,8 +394,10 @@ bool TouchManager::shouldDiscardTouch(const ci::vec2& p) {
 	}
 
 	if(!output && mEngine.getMinTouchDistance() > 0.0f){
-		for(auto it = mTouchPreviousPoint.begin(); it != mTouchPreviousPoint.end(); ++it){
-			if(glm::distance(ci::vec2(it->second), p) < mEngine.getMinTouchDistance()){// 	it->second.xy().distance(p) < mEngine.getMinTouchDistance()){
+		for(size_t i = 0, count = mFingers.size(); i < count; ++i){
+			const Finger& finger = mFingers.getActive(i);
+			if(finger.mDiscarded) continue;
+			if(glm::distance(ci::vec2(finger.mPreviousPoint), p) < mEngine.getMinTouchDistance()){
 				output = true;
 				break;
 			}
@@ -361,7 +417,18 @@ void TouchManager::setTouchSmoothing(const bool doSmoothing){
 }
 
 void TouchManager::setTouchSmoothFrames(const int smoothFrames){
-	mFramesToSmooth = smoothFrames;
+	mFramesToSmooth = std::min(std::max(smoothFrames, 1), static_cast<int>(MAX_SMOOTH_FRAMES));
+}
+
+void TouchManager::setPrediction(const float ms, const float maxDistance, const float acceleration){
+	mPredictSeconds = std::max(ms, 0.0f) / 1000.0f;
+	mPredictMaxDistance = std::max(maxDistance, 0.0f);
+	mPredictAcceleration = std::max(acceleration, 0.0f);
+}
+
+void TouchManager::setCoalesceMoves(const bool coalesce){
+	if(!coalesce) dispatchMoves();
+	mCoalesceMoves = coalesce;
 }
 
 void TouchManager::setVerboseLogging(const bool verbosity){
@@ -380,6 +447,115 @@ void TouchManager::overrideTouchTranslation(ci::vec2& inOutPoint){
 	inOutPoint.y = (inOutPoint.y / ci::app::getWindowHeight()) * mTouchDimensions.y + mTouchOffset.y;
 }
 
+TouchManager::Finger* TouchManager::findFinger(const int fingerId){
+	return mFingers.find(fingerId);
+}
+
+const TouchManager::Finger* TouchManager::findFinger(const int fingerId) const {
+	return mFingers.find(fingerId);
+}
+
+TouchManager::Finger* TouchManager::addFinger(const int fingerId){
+	Finger* finger = mFingers.find(fingerId);
+	if(finger) return finger;
+	finger = mFingers.add(fingerId);
+	if(finger) finger->clear(fingerId);
+	return finger;
+}
+
+void TouchManager::removeFinger(const int fingerId){
+	Finger* finger = mFingers.find(fingerId);
+	if(!finger) return;
+	finger->clear(-1);
+	mFingers.remove(fingerId);
+}
+
+/**
+ * \class ds::ui::TouchManager::Finger
+ */
+TouchManager::Finger::Finger()
+{
+	clear(-1);
+}
+
+void TouchManager::Finger::clear(const int id){
+	mId = id;
+	mDiscarded = false;
+	mSprite = nullptr;
+	mStartPoint = ci::vec3();
+	mPreviousPoint = ci::vec3();
+	mSmoothStart = 0;
+	mSmoothCount = 0;
+	mPendingCount = 0;
+	mPendingReceived = 0;
+	mHistoryCount = 0;
+}
+
+void TouchManager::Finger::addPendingMove(const ci::vec2& globalPos, const double time, const Poco::Timestamp::TimeVal received){
+	if(mPendingCount < 1) mPendingReceived = received;
+	// Keep the newest ones
+	if(mPendingCount >= TouchInfo::MAX_SAMPLES){
+		std::copy(mPending + 1, mPending + mPendingCount, mPending);
+		mPendingCount = TouchInfo::MAX_SAMPLES - 1;
+	}
+	mPending[mPendingCount].mPoint = ci::vec3(globalPos, 0.0f);
+	mPending[mPendingCount].mTime = time;
+	++mPendingCount;
+}
+
+void TouchManager::Finger::addHistory(const TouchInfo::Sample* samples, const int count){
+	for(int i = 0; i < count; ++i){
+		if(mHistoryCount >= PREDICT_SAMPLES){
+			std::copy(mHistory + 1, mHistory + mHistoryCount, mHistory);
+			mHistoryCount = PREDICT_SAMPLES - 1;
+		}
+		mHistory[mHistoryCount++] = samples[i];
+	}
+}
+
+ci::vec3 TouchManager::Finger::predict(const float seconds, const float acceleration, const float maxDistance) const {
+	if(mHistoryCount < 2) return ci::vec3();
+
+	// Velocity over the newer half of the samples, and the older half for the acceleration
+	const TouchInfo::Sample& oldest = mHistory[0];
+	const TouchInfo::Sample& middle = mHistory[(mHistoryCount - 1) / 2];
+	const TouchInfo::Sample& newest = mHistory[mHistoryCount - 1];
+	const double newDt = newest.mTime - middle.mTime;
+	if(newDt <= 0.0) return ci::vec3();
+	const ci::vec3 velocity = (newest.mPoint - middle.mPoint) / static_cast<float>(newDt);
+	ci::vec3 offset = velocity * seconds;
+
+	const double oldDt = middle.mTime - oldest.mTime;
+	if(acceleration > 0.0f && oldDt > 0.0){
+		const ci::vec3 oldVelocity = (middle.mPoint - oldest.mPoint) / static_cast<float>(oldDt);
+		const ci::vec3 accel = (velocity - oldVelocity) / static_cast<float>((newest.mTime - oldest.mTime) * 0.5);
+		offset += accel * (0.5f * seconds * seconds * acceleration);
+	}
+	offset.z = 0.0f;
+
+	const float length = glm::length(offset);
+	if(maxDistance > 0.0f && length > maxDistance){
+		offset *= maxDistance / length;
+	}
+	return offset;
+}
+
+ci::vec3 TouchManager::Finger::smooth(const ci::vec3& globalPoint, const int frames){
+	// Drop the oldest past the window, which can shrink while a finger's down
+	while(mSmoothCount >= frames){
+		mSmoothStart = (mSmoothStart + 1) % MAX_SMOOTH_FRAMES;
+		--mSmoothCount;
+	}
+	mSmoothPoints[(mSmoothStart + mSmoothCount) % MAX_SMOOTH_FRAMES] = globalPoint;
+	++mSmoothCount;
+	if(mSmoothCount < 2) return ci::vec3();
+
+	// The deltas between neighbours sum to the newest less the oldest
+	const ci::vec3& oldest = mSmoothPoints[mSmoothStart];
+	const float n = static_cast<float>(mSmoothCount - 1);
+	return ci::vec3((globalPoint.x - oldest.x) / n, (globalPoint.y - oldest.y) / n, 0.0f);
+}
+
 
 } // namespace ui
 } // namespace ds
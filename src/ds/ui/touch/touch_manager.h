@@ -2,14 +2,16 @@
 #ifndef DS_UI_TOUCH_MANAGER_H
 #define DS_UI_TOUCH_MANAGER_H
 
-#include <map>
+#include <vector>
 #include <memory>
 #include <cinder/app/TouchEvent.h>
 #include <cinder/app/MouseEvent.h>
 #include <cinder/Color.h>
 #include <cinder/Rect.h>
 #include "touch_mode.h"
+#include "finger_table.h"
 #include "touch_info.h"
+#include "ds/debug/touch_latency_log.h"
 
 namespace ds {
 class Engine;
@@ -43,6 +45,9 @@ public:
 	void									touchesMoved(const ds::ui::TouchEvent&);
 	void									touchesEnded(const ds::ui::TouchEvent&);
 
+	// Once a frame, after the input events. Sends each finger's latest move, if it moved.
+	void									dispatchMoves();
+
 	void									clearFingers(const std::vector<int> &fingers);
 
 	void									setSpriteForFinger(const int fingerId, ui::Sprite* theSprite);
@@ -67,13 +72,28 @@ public:
 
 	void									setCapture(Capture*);
 
-	std::map<int, ci::vec3>&				getPreviousTouchPoints(){ return mTouchPreviousPoint; }
+	// Answers false if the finger isn't down.
+	bool									getPreviousTouchPoint(const int fingerId, ci::vec3& outPoint) const;
 
 	void									setTouchSmoothing(const bool doSmoothing);
 	const bool								getTouchSmoothing(){ return mSmoothEnabled; }
 
+	// Clamped to MAX_SMOOTH_FRAMES
 	void									setTouchSmoothFrames(const int smoothFrames);
 
+	// When on (the default), moves are held until dispatchMoves(), so each finger
+	// moves at most once a frame. When off, every move is sent as it arrives.
+	void									setCoalesceMoves(const bool);
+	bool									getCoalesceMoves() const { return mCoalesceMoves; }
+
+	// Moves carry a guess at where each finger will be ms milliseconds on, in
+	// TouchInfo::mPredictionOffset, from its velocity over the last few samples.
+	// Acceleration weights in the change in velocity (0 is straight line). The
+	// offset is never longer than maxDistance. 0 ms turns it off.
+	void									setPrediction(const float ms, const float maxDistance, const float acceleration);
+
+	TouchLatencyLog&						getLatencyLog() { return mLatencyLog; }
+
 private:
 	// Utility to get the hit sprite in either the orthogonal or perspective root sprites
 	Sprite* 								getHit(const ci::vec3 &point);
@@ -82,10 +102,57 @@ private:
 	ci::vec2								translateMousePoint(const ci::ivec2);
 
 	void									inputBegin(const int fingerId, const ci::vec2& globalPos);
-	void									inputMoved(const int fingerId, const ci::vec2& globalPos);
+	void									inputMoved(const int fingerId, const ci::vec2& globalPos, const double time,
+													   const Poco::Timestamp::TimeVal received = 0);
 	void									inputEnded(const int fingerId, const ci::vec2& globalPos);
 
-	std::map<int, std::vector<ci::vec3>>	mTouchSmoothPoints;
+	static const int						MAX_FINGERS = 256;
+	static const int						MAX_SMOOTH_FRAMES = 32;
+	static const int						PREDICT_SAMPLES = 5;
+
+	// Everything known about one finger that's down
+	struct Finger {
+		Finger();
+		void								clear(const int id);
+		void								addPendingMove(const ci::vec2& globalPos, const double time, const Poco::Timestamp::TimeVal received);
+		void								addHistory(const TouchInfo::Sample* samples, const int count);
+		ci::vec3							predict(const float seconds, const float acceleration, const float maxDistance) const;
+		// Add a point to the smoothing ring and answer the average move across it
+		ci::vec3							smooth(const ci::vec3& globalPoint, const int frames);
+
+		int									mId;
+		// Down outside the filter; the rest of its events are ignored
+		bool								mDiscarded;
+		ui::Sprite*							mSprite;
+		ci::vec3							mStartPoint;
+		ci::vec3							mPreviousPoint;
+		ci::vec3							mSmoothPoints[MAX_SMOOTH_FRAMES];
+		int									mSmoothStart, mSmoothCount;
+		// The moves made since it was last dispatched
+		TouchInfo::Sample					mPending[TouchInfo::MAX_SAMPLES];
+		int									mPendingCount;
+		// When the oldest held move got to the engine
+		Poco::Timestamp::TimeVal			mPendingReceived;
+		// The newest raw samples, oldest first, for prediction
+		TouchInfo::Sample					mHistory[PREDICT_SAMPLES];
+		int									mHistoryCount;
+	};
+
+	Finger*									findFinger(const int fingerId);
+	const Finger*							findFinger(const int fingerId) const;
+	// A cleared finger. Answers nullptr if the table is full
+	Finger*									addFinger(const int fingerId);
+	void									removeFinger(const int fingerId);
+
+	// Send a finger's held move now, so it can't arrive after a begin or end
+	void									dispatchMove(Finger&);
+	void									sendMove(Finger&, const TouchInfo::Sample* samples, const int count, const Poco::Timestamp::TimeVal received);
+
+	bool									mCoalesceMoves;
+	float									mPredictSeconds;
+	float									mPredictMaxDistance;
+	float									mPredictAcceleration;
+	TouchLatencyLog							mLatencyLog;
 	bool									mSmoothEnabled;
 	int										mFramesToSmooth;
 
@@ -93,10 +160,8 @@ private:
 
 	Engine&									mEngine;
 
-	std::map<int, ui::Sprite*>				mFingerDispatcher;
-	std::map<int, ci::vec3>					mTouchStartPoint;
-	std::map<int, ci::vec3>					mTouchPreviousPoint;
-	std::map<int, bool>						mDiscardTouchMap;
+	// The fingers that are down, MAX_FINGERS of them
+	FingerTable<Finger>						mFingers;
 
 	ci::vec2								mTouchDimensions;
 	ci::vec2								mTouchOffset;
@@ -1,6 +1,8 @@
 #include "stdafx.h"
 
 #include "touch_process.h"
+
+#include <algorithm>
 #include "ds/math/math_defs.h"
 #include "ds/ui/sprite/sprite.h"
 #include "multi_touch_constraints.h"
@@ -12,25 +14,41 @@ using namespace ci;
 namespace ds {
 namespace ui {
 
-TouchProcess::TouchProcess( SpriteEngine &engine, Sprite &sprite )
+TouchProcess::TouchProcess( SpriteEngine &engine )
   : mSpriteEngine(engine)
-  , mSprite(sprite)
-  , mTappable(false)
-  , mOneTap(false)
+  , mSprite(nullptr)
+  , mActiveIndex(0)
 {
-	mFingers.clear();
+	bind(nullptr);
 }
 
 TouchProcess::~TouchProcess()
 {
-	clearTouches();
+}
+
+void TouchProcess::bind( Sprite* sprite )
+{
+	mSprite = sprite;
+	mFingers.clear();
+	mFingerIndex.clear();
+	mSwipe.clear();
+	mPinch.clear();
+	mTap.clear();
+	mTapInfo.mState = TapInfo::Null;
+	mTapInfo.mCount = 0;
+	mLastUpdateTime = static_cast<float>(mSpriteEngine.getElapsedTimeSeconds());
+}
+
+bool TouchProcess::isIdle() const
+{
+	return mFingers.empty() && !mTap.isWaiting();
 }
 
 void TouchProcess::clearTouches(){
 
 	std::vector<int> fingers;
 	for(auto i = mFingers.begin(), e = mFingers.end(); i != e; ++i){
-		fingers.push_back(i->first);
+		fingers.push_back(i->mFingerId);
 	}
 	mSpriteEngine.clearFingers(fingers);
 
@@ -40,112 +58,108 @@ void TouchProcess::clearTouches(){
 
 bool TouchProcess::processTouchInfo( const TouchInfo &touchInfo )
 {
-	if (!mSprite.visible() || !mSprite.isEnabled())
+	if (!mSprite->visible() || !mSprite->isEnabled())
 		return false;
 
-	mSprite.userInputReceived();
+	mSprite->userInputReceived();
 
 	processTap(touchInfo);
 	processTapInfo(touchInfo);
 
 	if (TouchInfo::Added == touchInfo.mPhase) {
-		mFingers[touchInfo.mFingerId] = touchInfo;
+		TouchInfo* existing = findFinger(touchInfo.mFingerId);
+		if (existing) *existing = touchInfo;
+		else mFingers.push_back(touchInfo);
 		mFingerIndex.push_back(touchInfo.mFingerId);
 
 		if (mFingers.size() == 1) {
-			mSwipeQueue.clear();
+			mSwipe.clear();
 			mSwipeFingerId = touchInfo.mFingerId;
-			addToSwipeQueue(touchInfo.mCurrentGlobalPoint, 0);
-			mStartAnchor = mSprite.getCenter();
+			mSwipe.add(touchInfo.mCurrentGlobalPoint, mLastUpdateTime, mSpriteEngine.getSwipeQueueSize());
+			mStartAnchor = mSprite->getCenter();
 		}
 
 		initializeTouchPoints();
 		sendTouchInfo(touchInfo);
 		updateDragDestination(touchInfo);
 
-		if (!mSprite.multiTouchEnabled())
+		if (!mSprite->multiTouchEnabled())
 			return true;
 	} else if (TouchInfo::Moved == touchInfo.mPhase) {
 		if (mFingers.empty())
 			return false;
 
-		auto found = mFingers.find(touchInfo.mFingerId);
-		if (found == mFingers.end())
+		TouchInfo* found = findFinger(touchInfo.mFingerId);
+		if (!found)
 			return false;
-		found->second.mCurrentGlobalPoint = touchInfo.mCurrentGlobalPoint;
+		found->mCurrentGlobalPoint = touchInfo.mCurrentGlobalPoint;
+		found->mPredictionOffset = touchInfo.mPredictionOffset;
 
 		if (mSwipeFingerId == touchInfo.mFingerId)
-			addToSwipeQueue(touchInfo.mCurrentGlobalPoint, 0);
+			addSwipeSamples(touchInfo);
 
 
-		auto foundControl0 = mFingers.find(mControlFingerIndexes[0]);
-		auto foundControl1 = mFingers.find(mControlFingerIndexes[1]);
-		const bool			found_0 = foundControl0 != mFingers.end(),
-							found_1 = foundControl1 != mFingers.end();
+		const TouchInfo*	foundControl0 = findFinger(mControlFingerIndexes[0]);
+		const TouchInfo*	foundControl1 = findFinger(mControlFingerIndexes[1]);
+		const bool			found_0 = foundControl0 != nullptr,
+							found_1 = foundControl1 != nullptr;
 		// the logic here is: 
 			// is the sprite multitouch enabled?
 			// does the first finger exists? is this finger the first finger?
 			// or does the second finger exist and is this finger the second finger?
 			// Basically, is this one of the first two fingers? Otherwise we don't care
-		if (mSprite.multiTouchEnabled() 
-			&& ( (found_0 && touchInfo.mFingerId == foundControl0->second.mFingerId) 
-				|| ( found_1 && touchInfo.mFingerId == foundControl1->second.mFingerId) 
+			// Everything below measures from the first finger, so it has to be there.
+		if (mSprite->multiTouchEnabled() && found_0
+			&& ( touchInfo.mFingerId == foundControl0->mFingerId
+				|| ( found_1 && touchInfo.mFingerId == foundControl1->mFingerId) 
 			)) {
 			ci::mat4 parentTransform;
 
-			Sprite *currentParent = mSprite.getParent();
+			Sprite *currentParent = mSprite->getParent();
 			while (currentParent) {
 				parentTransform = currentParent->getInverseTransform() * parentTransform;
 				currentParent = currentParent->getParent();
 			}
 
-			vec3 fingerStart0 = foundControl0->second.mStartPoint;
-			vec3 fingerCurrent0 = foundControl0->second.mCurrentGlobalPoint;
+			// Predicted moves are weighted separately for dragging and for scaling / rotating
+			const float dragPrediction = mSpriteEngine.getPredictionDragWeight();
+			const float multiPrediction = mSpriteEngine.getPredictionScaleRotateWeight();
+
+			vec3 fingerStart0 = foundControl0->mStartPoint;
+			vec3 fingerCurrent0 = foundControl0->mCurrentGlobalPoint + foundControl0->mPredictionOffset * dragPrediction;
 			glm::vec3 fingerPositionOffset = glm::vec3(parentTransform * glm::vec4(fingerCurrent0.x, fingerCurrent0.y, 0.0f, 1.0f) - parentTransform * glm::vec4(fingerStart0.x, fingerStart0.y, 0.0f, 1.0f));
 
 			if (mFingers.size() > 1 && found_0 && found_1) {
-				vec3 fingerStart1 = foundControl1->second.mStartPoint;
-				vec3 fingerCurrent1 = foundControl1->second.mCurrentGlobalPoint;
-
-				mStartDistance = glm::distance(fingerStart0, fingerStart1);
-				if (mStartDistance < mSpriteEngine.getMinTouchDistance()){
-					mStartDistance = mSpriteEngine.getMinTouchDistance();
-				}
-
-				mCurrentDistance = glm::distance(fingerCurrent0, fingerCurrent1);
-				if (mCurrentDistance < mSpriteEngine.getMinTouchDistance()){
-					mCurrentDistance = mSpriteEngine.getMinTouchDistance();
-				}
+				vec3 fingerStart1 = foundControl1->mStartPoint;
+				vec3 fingerCurrent1 = foundControl1->mCurrentGlobalPoint + foundControl1->mPredictionOffset * multiPrediction;
+				fingerCurrent0 = foundControl0->mCurrentGlobalPoint + foundControl0->mPredictionOffset * multiPrediction;
 
-				mCurrentScale = mCurrentDistance / mStartDistance;
+				mPinch.measure(fingerStart0, fingerStart1, fingerCurrent0, fingerCurrent1, mSpriteEngine.getMinTouchDistance());
 
-				mCurrentAngle = atan2(fingerStart1.y - fingerStart0.y, fingerStart1.x - fingerStart0.x) -
-					atan2(fingerCurrent1.y - fingerCurrent0.y, fingerCurrent1.x - fingerCurrent0.x);
-
-				if (mSprite.hasMultiTouchConstraint(MULTITOUCH_CAN_SCALE)) {
-					if(mSprite.mTouchScaleSizeMode){
-						mSprite.setSize(mStartWidth * mCurrentScale, mStartHeight * mCurrentScale);
+				if (mSprite->hasMultiTouchConstraint(MULTITOUCH_CAN_SCALE)) {
+					if(mSprite->mTouchScaleSizeMode){
+						mSprite->setSize(mStartWidth * mPinch.mScale, mStartHeight * mPinch.mScale);
 					} else {
-						mSprite.setScale(mStartScale*mCurrentScale);
+						mSprite->setScale(mStartScale*mPinch.mScale);
 					}
 				}
 
-				if (mSprite.hasMultiTouchConstraint(MULTITOUCH_CAN_ROTATE)) {
-					mSprite.setRotation(mStartRotation.z - mCurrentAngle * math::RADIAN2DEGREE);
+				if (mSprite->hasMultiTouchConstraint(MULTITOUCH_CAN_ROTATE)) {
+					mSprite->setRotation(mStartRotation.z - mPinch.mAngle * math::RADIAN2DEGREE);
 				}
 			}
 
-			if (mSprite.mMultiTouchConstraints != ds::ui::MULTITOUCH_INFO_ONLY && touchInfo.mFingerId == foundControl0->second.mFingerId) {
+			if (mSprite->mMultiTouchConstraints != ds::ui::MULTITOUCH_INFO_ONLY && touchInfo.mFingerId == foundControl0->mFingerId) {
 				vec3 offset(0.0f, 0.0f, 0.0f);
 
-				if (!mTappable && mSprite.hasMultiTouchConstraint(MULTITOUCH_CAN_POSITION_X)) {
+				if (!mTap.isTappable() && mSprite->hasMultiTouchConstraint(MULTITOUCH_CAN_POSITION_X)) {
 					offset.x = fingerPositionOffset.x;
 				}
 				
-				if (!mTappable && mSprite.hasMultiTouchConstraint(MULTITOUCH_CAN_POSITION_Y)) {
+				if (!mTap.isTappable() && mSprite->hasMultiTouchConstraint(MULTITOUCH_CAN_POSITION_Y)) {
 					offset.y = fingerPositionOffset.y;
 				}
-				mSprite.setPosition(mStartPosition + offset);
+				mSprite->setPosition(mStartPosition + offset);
 			}
 		}
 
@@ -156,14 +170,14 @@ bool TouchProcess::processTouchInfo( const TouchInfo &touchInfo )
 		sendTouchInfo(touchInfo);
 		updateDragDestination(touchInfo);
 
-		auto found = mFingers.find(touchInfo.mFingerId);
-		if (found != mFingers.end()){
-			mFingers.erase(found);
+		TouchInfo* found = findFinger(touchInfo.mFingerId);
+		if (found){
+			mFingers.erase(mFingers.begin() + (found - mFingers.data()));
 		}
 
 		mFingerIndex.remove(touchInfo.mFingerId);
 
-		if (!mSprite.multiTouchEnabled()){
+		if (!mSprite->multiTouchEnabled()){
 			return true;
 		}
 
@@ -173,23 +187,40 @@ bool TouchProcess::processTouchInfo( const TouchInfo &touchInfo )
 			initializeTouchPoints();
 		}
 
-		if (mFingers.empty() && swipeHappened()) {
-			mSprite.swipe(mSwipeVector);
+		ci::vec3 swipe;
+		if (mFingers.empty() && mSwipe.happened(mLastUpdateTime, mSpriteEngine.getSwipeQueueSize(), mSpriteEngine.getSwipeMinVelocity(),
+												 mSpriteEngine.getSwipeMaxTime(), swipe)) {
+			mSprite->swipe(swipe);
 		}
 	}
 
 	return true;
 }
 
+void TouchProcess::addSwipeSamples( const TouchInfo &touchInfo )
+{
+	const size_t	queueSize = mSpriteEngine.getSwipeQueueSize();
+	const int		count = std::min(touchInfo.mSampleCount, static_cast<int>(TouchInfo::MAX_SAMPLES));
+	if (count < 1) {
+		mSwipe.add(touchInfo.mCurrentGlobalPoint, mLastUpdateTime, queueSize);
+		return;
+	}
+	// Input times aren't on the update clock, so each sample keeps its age relative to the newest
+	const double	newest = touchInfo.mSamples[count - 1].mTime;
+	for (int i = 0; i < count; ++i) {
+		const TouchInfo::Sample&	s = touchInfo.mSamples[i];
+		mSwipe.add(s.mPoint, mLastUpdateTime - static_cast<float>(newest - s.mTime), queueSize);
+	}
+}
+
 void TouchProcess::update( const UpdateParams &updateParams )
 {
 	mLastUpdateTime = updateParams.getElapsedTime();
-	if (!mSprite.visible() || !mSprite.isEnabled() || !mOneTap || !mSprite.hasDoubleTap())
+	if (!mSprite->visible() || !mSprite->isEnabled() || !mTap.isWaiting() || !mSprite->hasDoubleTap())
 		return;
-	if (mLastUpdateTime - mDoubleTapTime > mSpriteEngine.getDoubleTapTime()) {
-		mSprite.tap(mFirstTapPos);
-		mOneTap = false;
-		mDoubleTapTime = mLastUpdateTime;
+	ci::vec3 tapPos;
+	if (mTap.update(mLastUpdateTime, mSpriteEngine.getDoubleTapTime(), tapPos) == TapRecognizer::TAP) {
+		mSprite->tap(tapPos);
 	}
 }
 
@@ -200,10 +231,10 @@ bool TouchProcess::hasTouches() const {
 void TouchProcess::sendTouchInfo( const TouchInfo &touchInfo )
 {
 	TouchInfo t = touchInfo;
-	t.mCurrentAngle = mCurrentAngle;
-	t.mCurrentScale = mCurrentScale;
-	t.mCurrentDistance = mCurrentDistance;
-	t.mStartDistance = mStartDistance;
+	t.mCurrentAngle = mPinch.mAngle;
+	t.mCurrentScale = mPinch.mScale;
+	t.mCurrentDistance = mPinch.mCurrentDistance;
+	t.mStartDistance = mPinch.mStartDistance;
 	t.mNumberFingers = static_cast<int>(mFingers.size());
 	t.mPassedTouch = touchInfo.mPassedTouch;
 
@@ -212,47 +243,49 @@ void TouchProcess::sendTouchInfo( const TouchInfo &touchInfo )
 
 	t.mFingerIndex = getFingerIndex(touchInfo.mFingerId);
 
-	auto found = mFingers.find(touchInfo.mFingerId);
-	if (found != mFingers.end()){
-	t.mActive = found->second.mActive;
+	const TouchInfo* found = findFinger(touchInfo.mFingerId);
+	if (found){
+	t.mActive = found->mActive;
 	}
 
-	mSprite.processTouchInfoCallback(t);
+	mSprite->processTouchInfoCallback(t);
 }
 
 void TouchProcess::initializeFirstTouch()
 {
-	mFingers[mControlFingerIndexes[0]].mActive = true;
-	mFingers[mControlFingerIndexes[0]].mStartPoint = mFingers[mControlFingerIndexes[0]].mCurrentGlobalPoint;
-	mMultiTouchAnchor = mSprite.globalToLocal(mFingers[mControlFingerIndexes[0]].mStartPoint);
-	if (mSprite.getWidth() != 0.0f)	mMultiTouchAnchor.x /= mSprite.getWidth();
-	if (mSprite.getHeight() != 0.0f) mMultiTouchAnchor.y /= mSprite.getHeight();
-	if (mSprite.getDepth() != 0.0f) mMultiTouchAnchor.z /= mSprite.getDepth();
-	mStartAnchor = mSprite.getCenter();
+	TouchInfo* control = findFinger(mControlFingerIndexes[0]);
+	if (!control) return;
+	control->mActive = true;
+	control->mStartPoint = control->mCurrentGlobalPoint;
+	mMultiTouchAnchor = mSprite->globalToLocal(control->mStartPoint);
+	if (mSprite->getWidth() != 0.0f)	mMultiTouchAnchor.x /= mSprite->getWidth();
+	if (mSprite->getHeight() != 0.0f) mMultiTouchAnchor.y /= mSprite->getHeight();
+	if (mSprite->getDepth() != 0.0f) mMultiTouchAnchor.z /= mSprite->getDepth();
+	mStartAnchor = mSprite->getCenter();
 
 	vec3 positionOffset = mMultiTouchAnchor - mStartAnchor;
-	positionOffset.x *= mSprite.getWidth();
-	positionOffset.y *= mSprite.getHeight();
-	positionOffset.x *= mSprite.getScale().x;
-	positionOffset.y *= mSprite.getScale().y;
-	glm::mat4 rotationMatrix = glm::rotate(mSprite.getRotation().z * math::DEGREE2RADIAN, glm::vec3(0.0f, 0.0f, 1.0f));
+	positionOffset.x *= mSprite->getWidth();
+	positionOffset.y *= mSprite->getHeight();
+	positionOffset.x *= mSprite->getScale().x;
+	positionOffset.y *= mSprite->getScale().y;
+	glm::mat4 rotationMatrix = glm::rotate(mSprite->getRotation().z * math::DEGREE2RADIAN, glm::vec3(0.0f, 0.0f, 1.0f));
 	positionOffset = glm::vec3(rotationMatrix * glm::vec4(positionOffset, 1.0f));
-	if (mSprite.mMultiTouchConstraints != ds::ui::MULTITOUCH_INFO_ONLY) {
-		mSprite.setCenter(mMultiTouchAnchor);
-		mSprite.move(positionOffset);
+	if (mSprite->mMultiTouchConstraints != ds::ui::MULTITOUCH_INFO_ONLY) {
+		mSprite->setCenter(mMultiTouchAnchor);
+		mSprite->move(positionOffset);
 	}
 
-	mStartPosition = mSprite.getPosition();
+	mStartPosition = mSprite->getPosition();
 }
 
 void TouchProcess::initializeTouchPoints()
 {
-	if (!mSprite.multiTouchEnabled()){
+	if (!mSprite->multiTouchEnabled()){
 		return;
 	}
 
 	if (mFingers.size() == 1) {
-		mControlFingerIndexes[0] = mFingers.begin()->first;
+		mControlFingerIndexes[0] = mFingers.front().mFingerId;
 		resetTouchAnchor();
 		initializeFirstTouch();
 		return;
@@ -263,15 +296,15 @@ void TouchProcess::initializeTouchPoints()
 
 	for ( auto it = mFingers.begin(), it2 = mFingers.end(); it != it2; ++it )
 	{
-		it->second.mActive = false;
+		it->mActive = false;
 		for ( auto itt = mFingers.begin(), itt2 = mFingers.end(); itt != itt2; ++itt )
 		{
 			if (it == itt)
 				continue;
-			float newDistance = glm::distance(itt->second.mCurrentGlobalPoint, it->second.mCurrentGlobalPoint);
+			float newDistance = glm::distance(itt->mCurrentGlobalPoint, it->mCurrentGlobalPoint);
 			if (newDistance > potentialFarthestDistance) {
-				potentialFarthestIndexes[0] = itt->first;
-				potentialFarthestIndexes[1] = it->first;
+				potentialFarthestIndexes[0] = itt->mFingerId;
+				potentialFarthestIndexes[1] = it->mFingerId;
 				potentialFarthestDistance = newDistance;
 			}
 		}
@@ -287,77 +320,50 @@ void TouchProcess::initializeTouchPoints()
 
 	initializeFirstTouch();
 
-	mFingers[mControlFingerIndexes[1]].mActive = true;
-	mFingers[mControlFingerIndexes[1]].mStartPoint = mFingers[mControlFingerIndexes[1]].mCurrentGlobalPoint;
-	mStartPosition = mSprite.getPosition();
-	mStartRotation = mSprite.getRotation();
-	mStartScale    = mSprite.getScale();
-	mStartWidth    = mSprite.getWidth();
-	mStartHeight   = mSprite.getHeight();
+	TouchInfo* control = findFinger(mControlFingerIndexes[1]);
+	if (control) {
+		control->mActive = true;
+		control->mStartPoint = control->mCurrentGlobalPoint;
+	}
+	mStartPosition = mSprite->getPosition();
+	mStartRotation = mSprite->getRotation();
+	mStartScale    = mSprite->getScale();
+	mStartWidth    = mSprite->getWidth();
+	mStartHeight   = mSprite->getHeight();
 }
 
 void TouchProcess::resetTouchAnchor()
 {
-	if (!mSprite.multiTouchEnabled()){
+	if (!mSprite->multiTouchEnabled()){
 		return;
 	}
 
-	vec3 positionOffset = mStartAnchor - mSprite.getCenter();
-	positionOffset.x *= mSprite.getWidth();
-	positionOffset.y *= mSprite.getHeight();
-	positionOffset.x *= mSprite.getScale().x;
-	positionOffset.y *= mSprite.getScale().y;
-	glm::mat4 rotationMatrix = glm::rotate(mSprite.getRotation().z * math::DEGREE2RADIAN, glm::vec3(0.0f, 0.0f, 1.0f));
+	vec3 positionOffset = mStartAnchor - mSprite->getCenter();
+	positionOffset.x *= mSprite->getWidth();
+	positionOffset.y *= mSprite->getHeight();
+	positionOffset.x *= mSprite->getScale().x;
+	positionOffset.y *= mSprite->getScale().y;
+	glm::mat4 rotationMatrix = glm::rotate(mSprite->getRotation().z * math::DEGREE2RADIAN, glm::vec3(0.0f, 0.0f, 1.0f));
 	positionOffset = glm::vec3(rotationMatrix * glm::vec4(positionOffset, 1.0f));
-	if (mSprite.mMultiTouchConstraints != ds::ui::MULTITOUCH_INFO_ONLY) {
-		mSprite.setCenter(mStartAnchor);
-		mSprite.move(positionOffset);
-	}
-}
-
-void TouchProcess::addToSwipeQueue( const vec3 &currentPoint, int queueNum )
-{
-	SwipeQueueEvent swipeEvent;
-	swipeEvent.mCurrentGlobalPoint = currentPoint;
-	swipeEvent.mTimeStamp = mLastUpdateTime;
-	mSwipeQueue.push_back(swipeEvent);
-	if (mSwipeQueue.size() > mSpriteEngine.getSwipeQueueSize()){
-		mSwipeQueue.pop_front();
-	}
-}
-
-bool TouchProcess::swipeHappened()
-{
-	mSwipeVector = vec3();
-
-	if (mSwipeQueue.size() < mSpriteEngine.getSwipeQueueSize()){
-		return false;
+	if (mSprite->mMultiTouchConstraints != ds::ui::MULTITOUCH_INFO_ONLY) {
+		mSprite->setCenter(mStartAnchor);
+		mSprite->move(positionOffset);
 	}
-
-	for ( auto it = mSwipeQueue.begin(), it2 = mSwipeQueue.end(); it != it2 - 1; ++it ) {
-		mSwipeVector += (it+1)->mCurrentGlobalPoint - it->mCurrentGlobalPoint;
-	}
-
-	mSwipeVector /= static_cast<float>(mSwipeQueue.size() - 1);
-	float averageDistance = glm::distance(mSwipeVector, glm::vec3());
-
-	return (averageDistance >= mSpriteEngine.getSwipeMinVelocity() * 0.016f && (mLastUpdateTime - mSwipeQueue.front().mTimeStamp) < mSpriteEngine.getSwipeMaxTime());
 }
 
 void TouchProcess::updateDragDestination( const TouchInfo &touchInfo ) {
 	if (mFingers.empty()) return;
-	auto found = mFingers.find(touchInfo.mFingerId);
-	if (found == mFingers.end()){
+	if (!findFinger(touchInfo.mFingerId)){
 		return;
 	}
 
-	Sprite *dragDestinationSprite = mSpriteEngine.getDragDestinationSprite(touchInfo.mCurrentGlobalPoint, &mSprite);
-	DragDestinationInfo dragInfo = {touchInfo.mCurrentGlobalPoint, DragDestinationInfo::Null, &mSprite};
-	ds::ui::Sprite* curDragDestination = mSprite.getDragDestination();
+	Sprite *dragDestinationSprite = mSpriteEngine.getDragDestinationSprite(touchInfo.mCurrentGlobalPoint, mSprite);
+	DragDestinationInfo dragInfo = {touchInfo.mCurrentGlobalPoint, DragDestinationInfo::Null, mSprite};
+	ds::ui::Sprite* curDragDestination = mSprite->getDragDestination();
 
 	if(!curDragDestination && dragDestinationSprite) {
 		dragInfo.mPhase = DragDestinationInfo::Entered;
-		mSprite.setDragDestination(dragDestinationSprite);
+		mSprite->setDragDestination(dragDestinationSprite);
 	} else if(curDragDestination && curDragDestination == dragDestinationSprite) {
 		dragInfo.mPhase = DragDestinationInfo::Updated;
 	} else if (curDragDestination && curDragDestination != dragDestinationSprite) {
@@ -369,56 +375,47 @@ void TouchProcess::updateDragDestination( const TouchInfo &touchInfo ) {
 	}
 
 	if(dragInfo.mPhase != DragDestinationInfo::Null){
-		mSprite.dragDestination(mSprite.getDragDestination(), dragInfo);
-		if(mSprite.getDragDestination()){
-			mSprite.getDragDestination()->dragDestination(mSprite.getDragDestination(), dragInfo);
+		mSprite->dragDestination(mSprite->getDragDestination(), dragInfo);
+		if(mSprite->getDragDestination()){
+			mSprite->getDragDestination()->dragDestination(mSprite->getDragDestination(), dragInfo);
 		}
 	}
 
 	if (dragInfo.mPhase == DragDestinationInfo::Released || dragInfo.mPhase == DragDestinationInfo::Exited || dragInfo.mPhase == DragDestinationInfo::Null) {
-		mSprite.setDragDestination(nullptr);
+		mSprite->setDragDestination(nullptr);
 	}
 }
 
 void TouchProcess::processTap( const TouchInfo &touchInfo )
 {
-	if (mSprite.hasTapInfo()) return;
-	if (!mSprite.hasTap() && !mSprite.hasDoubleTap()) {
-		mTappable = false;
+	if (mSprite->hasTapInfo()) return;
+	if (!mSprite->hasTap() && !mSprite->hasDoubleTap()) {
+		mTap.cancel();
 		return;
 	}
 
 	if (touchInfo.mPhase == TouchInfo::Added && mFingers.empty()) {
-		mTappable = true;
-	} else if (mTappable) {
-		if(mFingers.size() > 1 || touchInfo.mPassedTouch || (touchInfo.mPhase == TouchInfo::Moved && glm::distance(touchInfo.mCurrentGlobalPoint, touchInfo.mStartPoint) > mSpriteEngine.getMinTapDistance())) {
-			mTappable = false;
-		} else if (touchInfo.mPhase == TouchInfo::Removed) {
-
-			if (mSprite.hasTap() && !mSprite.hasDoubleTap()) {
-				mSprite.tap(touchInfo.mCurrentGlobalPoint);
-				mOneTap = false;
-			} else if (mOneTap) {
-				mSprite.doubleTap(touchInfo.mCurrentGlobalPoint);
-				mOneTap = false;
-			} else {
-				mFirstTapPos = touchInfo.mCurrentGlobalPoint;
-				mOneTap = true;
-				mDoubleTapTime = mLastUpdateTime;
-			}
+		mTap.begin();
+	} else if (mTap.follow(touchInfo, mFingers.size(), mSpriteEngine.getMinTapDistance())
+			&& touchInfo.mPhase == TouchInfo::Removed) {
+		const TapRecognizer::Event tap = mTap.up(touchInfo.mCurrentGlobalPoint, mLastUpdateTime, mSprite->hasDoubleTap());
+		if (tap == TapRecognizer::TAP) {
+			mSprite->tap(touchInfo.mCurrentGlobalPoint);
+		} else if (tap == TapRecognizer::DOUBLE_TAP) {
+			mSprite->doubleTap(touchInfo.mCurrentGlobalPoint);
+		}
 
-			if (mFingers.size() == 1){
-				mTappable = false;
-			}
+		if (mFingers.size() == 1){
+			mTap.cancel();
 		}
 	}
 }
 
 void TouchProcess::processTapInfo( const TouchInfo &touchInfo )
 {
-	if (mSprite.hasTap() || mSprite.hasDoubleTap()) return;
-	if (!mSprite.hasTapInfo()) {
-		mTappable = false;
+	if (mSprite->hasTap() || mSprite->hasDoubleTap()) return;
+	if (!mSprite->hasTapInfo()) {
+		mTap.cancel();
 		return;
 	}
 
@@ -426,27 +423,21 @@ void TouchProcess::processTapInfo( const TouchInfo &touchInfo )
 	// need it right now and wasn't planning on needing to do this
 	// at all.
 	if (touchInfo.mPhase == TouchInfo::Added && mFingers.empty()) {
-		mTappable = true;
+		mTap.begin();
 		sendTapInfo(TapInfo::Waiting, 0);
-	} else if (mTappable) {
+	} else if (mTap.isTappable()) {
 		// User cancelled at some point
 		if (mTapInfo.mState == TapInfo::Done) {
-			mTappable = false;
+			mTap.cancel();
 			return;
 		}
-		if(mFingers.size() > 1 || touchInfo.mPassedTouch || (touchInfo.mPhase == TouchInfo::Moved && glm::distance(touchInfo.mCurrentGlobalPoint, touchInfo.mStartPoint) > mSpriteEngine.getMinTapDistance())) {
-			mTappable = false;
+		if (!mTap.follow(touchInfo, mFingers.size(), mSpriteEngine.getMinTapDistance())) {
 			sendTapInfo(TapInfo::Done, 0);
 		} else if (touchInfo.mPhase == TouchInfo::Removed) {
-			if (mSprite.hasTapInfo()) {
 			sendTapInfo(TapInfo::Tapped, 1, touchInfo.mCurrentGlobalPoint);
-			mTappable = false;
+			mTap.cancel();
 			mTapInfo.mCount = 0;
 			mTapInfo.mState = TapInfo::Done;
-			}
-
-			if (mFingers.size() == 1)
-			mTappable = false;
 		}
 	}
 }
@@ -456,11 +447,19 @@ void TouchProcess::sendTapInfo(const TapInfo::State s, const int count, const ci
 	mTapInfo.mState = s;
 	mTapInfo.mCount = count;
 	mTapInfo.mCurrentGlobalPoint = pt;
-	if (!mSprite.tapInfo(mTapInfo)) {
+	if (!mSprite->tapInfo(mTapInfo)) {
 		mTapInfo.mState = TapInfo::Done;
 	}
 }
 
+TouchInfo* TouchProcess::findFinger( const int id )
+{
+	for (auto it = mFingers.begin(), end = mFingers.end(); it != end; ++it) {
+		if (it->mFingerId == id) return &(*it);
+	}
+	return nullptr;
+}
+
 int TouchProcess::getFingerIndex( int id )
 {
 	int i = 0;
@@ -2,27 +2,29 @@
 #ifndef DS_UI_TOUCH_PROCESS_H
 #define DS_UI_TOUCH_PROCESS_H
 
-#include <map>
-#include <deque>
+#include <vector>
 #include <list>
 #include "touch_info.h"
+#include "ds/ui/touch/gesture_recognizers.h"
 #include "ds/params/update_params.h"
 #include "ds/ui/touch/tap_info.h"
 #include "cinder/Vector.h"
 
 namespace ds {
 namespace ui {
+class GestureEngine;
 class Sprite;
 class SpriteEngine;
 
-struct SwipeQueueEvent {
-	ci::vec3 mCurrentGlobalPoint;
-	float     mTimeStamp;
-};
-
+/**
+ * \class ds::ui::TouchProcess
+ * \brief The gesture state for one touched sprite: taps, swipes, drags, scale and
+ * rotate. Sprites don't own one; the GestureEngine lends it out while they're touched.
+ * The recognizing itself is in gesture_recognizers.h, this applies it to the sprite.
+ */
 class TouchProcess {
 public:
-	TouchProcess(SpriteEngine &, Sprite &sprite);
+	TouchProcess(SpriteEngine &);
 	~TouchProcess();
 
 	bool					processTouchInfo(const TouchInfo &touchInfo);
@@ -32,26 +34,37 @@ public:
 
 	void					clearTouches();
 
+	// Start over for a new sprite, or nullptr when going back to the pool
+	void					bind(Sprite*);
+	Sprite*					getSprite() const { return mSprite; }
+	// No fingers down and no tap waiting to see if it's a double
+	bool					isIdle() const;
+
 private:
+	friend class GestureEngine;
+
 	void					sendTouchInfo(const TouchInfo &touchInfo);
 	void					initializeFirstTouch();
 	void					initializeTouchPoints();
 	void					resetTouchAnchor();
-    
-	void					addToSwipeQueue(const ci::vec3 &currentPoint, int queueNum);
-	bool					swipeHappened();
 
 	void					updateDragDestination(const TouchInfo &touchInfo);
 	int						getFingerIndex(int id);
+	TouchInfo*				findFinger(const int id);
 
+	// Every raw point of a move, at its input time, so a swipe doesn't depend on the frame rate
+	void					addSwipeSamples(const TouchInfo &touchInfo);
 	void					processTap(const TouchInfo &touchInfo);
 	void					processTapInfo(const TouchInfo &touchInfo);
 	void					sendTapInfo(const TapInfo::State, const int count, const ci::vec3& pt = ci::vec3(-1.0f, -1.0f, -1.0f));
 
 	SpriteEngine&			mSpriteEngine;
-	Sprite&					mSprite;
+	Sprite*					mSprite;
+	// Where I am in the gesture engine's active list
+	size_t					mActiveIndex;
 
-	std::map<int, TouchInfo> mFingers;
+	// Few fingers land on one sprite, so a search is quicker than a tree and doesn't allocate per touch
+	std::vector<TouchInfo>	mFingers;
 	std::list<int>			mFingerIndex;
 
 	// the fingerIndexes of the current 2 control fingers
@@ -71,25 +84,15 @@ private:
 	float					mStartWidth;
 	float					mStartHeight;
 
-	// These 4 variables are for calculating touch deltas.
-	float					mStartDistance;
-	float					mCurrentDistance;
-	float					mCurrentScale;
-	float					mCurrentAngle;
+	// The scale and rotation between the two control fingers
+	Pinch					mPinch;
 
-	ci::vec3				mSwipeVector;
+	// The finger that started the gesture, which is the one that can swipe
 	int						mSwipeFingerId;
+	SwipeRecognizer			mSwipe;
 
-	// the last few touch events and their time, for calculating swipes
-	std::deque<SwipeQueueEvent> mSwipeQueue;
-
-	// is the current finger action potentially a tap? If it is, the sprite won't move.
-	bool					mTappable;
-
-	// used to track for double taps
-	bool					mOneTap;
-	float					mDoubleTapTime;
-	ci::vec3				mFirstTapPos;
+	// While the current touch could be a tap, the sprite won't move
+	TapRecognizer			mTap;
 
 	TapInfo					mTapInfo;
 
@@ -50,7 +50,10 @@ ds::ui::TouchEvent TouchTranslator::toWorldSpace(const ds::ui::TouchEvent& touch
 			(void*)it->getNative()));
 	}
 
-	return ds::ui::TouchEvent(touchEvent.getWindow(), touches, touchEvent.getInWorldSpace());
+	ds::ui::TouchEvent	worldEvent(touchEvent.getWindow(), touches, touchEvent.getInWorldSpace());
+	worldEvent.setReceivedTime(touchEvent.getReceivedTime());
+	worldEvent.setSourceFrame(touchEvent.getSourceFrame());
+	return worldEvent;
 }
 
 void TouchTranslator::setTranslation(const float x, const float y) {
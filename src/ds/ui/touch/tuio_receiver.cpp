@@ -0,0 +1,390 @@
+#include "stdafx.h"
+
+#include "ds/ui/touch/tuio_receiver.h"
+
+#include <cstring>
+#include <cinder/app/App.h>
+#include <Poco/Exception.h>
+#include "ds/debug/logger.h"
+
+namespace ds {
+namespace ui {
+
+namespace {
+// Largest UDP payload
+const size_t		MAX_PACKET_SIZE = 65536;
+// Past this a source's new cursors are dropped
+const size_t		MAX_CURSORS = 64;
+const size_t		MAX_SOURCES = 16;
+// Sources past the first get their session ids shifted up by this much
+const int			SOURCE_ID_SHIFT = 24;
+// How often the thread wakes up to check if it should stop, in microseconds
+const long			RECEIVE_TIMEOUT = 100 * 1000;
+
+int32_t				read_int32(const char* p) {
+	const unsigned char*	u = reinterpret_cast<const unsigned char*>(p);
+	return static_cast<int32_t>((static_cast<uint32_t>(u[0]) << 24) | (static_cast<uint32_t>(u[1]) << 16)
+								| (static_cast<uint32_t>(u[2]) << 8) | static_cast<uint32_t>(u[3]));
+}
+
+float				read_float(const char* p) {
+	const int32_t	i = read_int32(p);
+	float			f;
+	memcpy(&f, &i, sizeof(f));
+	return f;
+}
+
+// Answer the end of the OSC string at p, padded to 4 bytes, or nullptr if it runs past end.
+const char*			skip_string(const char* p, const char* end) {
+	const char*		zero = static_cast<const char*>(memchr(p, 0, end - p));
+	if (!zero) return nullptr;
+	const size_t	size = ((zero - p) + 4) & ~static_cast<size_t>(3);
+	return (size <= static_cast<size_t>(end - p)) ? p + size : nullptr;
+}
+
+/**
+ * OscArgs
+ * Reads the arguments of a message where they sit in the packet. A read
+ * fails if the type is wrong or the data runs out.
+ */
+class OscArgs {
+public:
+	OscArgs(const char* types, const char* data, const char* end)
+		: mTypes(types), mData(data), mEnd(end) {
+	}
+
+	bool			read(int32_t& v) {
+		if (*mTypes != 'i' || mEnd - mData < 4) return false;
+		v = read_int32(mData);
+		return advance(4);
+	}
+
+	bool			read(float& v) {
+		if (*mTypes != 'f' || mEnd - mData < 4) return false;
+		v = read_float(mData);
+		return advance(4);
+	}
+
+	// The string stays in the packet
+	bool			read(const char*& v) {
+		if (*mTypes != 's') return false;
+		const char*	next = skip_string(mData, mEnd);
+		if (!next) return false;
+		v = mData;
+		return advance(next - mData);
+	}
+
+private:
+	bool			advance(const ptrdiff_t size) {
+		mData += size;
+		++mTypes;
+		return true;
+	}
+
+	const char*		mTypes;
+	const char*		mData;
+	const char*		mEnd;
+};
+
+// Keep the latest set for each cursor, so a frame that never finishes can't grow the list.
+void				add_set(std::vector<TuioReceiver::Cursor>& sets, const TuioReceiver::Cursor& c) {
+	for (auto it = sets.begin(), end = sets.end(); it != end; ++it) {
+		if (it->mSessionId == c.mSessionId) {
+			*it = c;
+			return;
+		}
+	}
+	if (sets.size() < MAX_CURSORS) sets.push_back(c);
+}
+
+bool				is_alive(const std::vector<int32_t>& alive, const int32_t id) {
+	for (auto it = alive.begin(), end = alive.end(); it != end; ++it) {
+		if (*it == id) return true;
+	}
+	return false;
+}
+
+}
+
+/**
+ * \class ds::ui::TuioReceiver
+ */
+TuioReceiver::Stats::Stats()
+	: mPackets(0)
+	, mFrames(0)
+	, mTouches(0)
+	, mBusyMicros(0) {
+}
+
+TuioReceiver::Source::Source()
+	: mIdOffset(0)
+	, mPreviousFrame(-1)
+	, mFrame(-1)
+	, mHasAlive(false) {
+	mCursors.reserve(MAX_CURSORS);
+	mSets.reserve(MAX_CURSORS);
+	mAlive.reserve(MAX_CURSORS);
+}
+
+TuioReceiver::TuioReceiver()
+	: mScale(1.0f, 1.0f)
+	, mPastFrameThreshold(10)
+	, mStart(Poco::Timestamp().epochMicroseconds())
+	, mStop(false)
+	, mBuffer(MAX_PACKET_SIZE)
+	, mPackets(0)
+	, mFrames(0)
+	, mTouches(0)
+	, mBusyMicros(0) {
+	mSources.reserve(MAX_SOURCES);
+	mBeganTouches.reserve(MAX_CURSORS);
+	mMovedTouches.reserve(MAX_CURSORS);
+	mEndedTouches.reserve(MAX_CURSORS);
+}
+
+TuioReceiver::~TuioReceiver() {
+	stop();
+}
+
+void TuioReceiver::setHandlers(const Handler& began, const Handler& moved, const Handler& ended) {
+	mBegan = began;
+	mMoved = moved;
+	mEnded = ended;
+}
+
+void TuioReceiver::setScale(const ci::vec2& scale) {
+	std::lock_guard<std::mutex>		lock(mScaleMutex);
+	mScale = scale;
+}
+
+void TuioReceiver::setPastFrameThreshold(const int32_t threshold) {
+	mPastFrameThreshold = threshold;
+}
+
+bool TuioReceiver::start(const int port) {
+	stop();
+	try {
+		mSocket = Poco::Net::DatagramSocket();
+		mSocket.bind(Poco::Net::SocketAddress(Poco::Net::IPAddress(), static_cast<Poco::UInt16>(port)), true);
+		mSocket.setReceiveTimeout(Poco::Timespan(0, RECEIVE_TIMEOUT));
+	} catch (std::exception& ex) {
+		DS_LOG_WARNING("TuioReceiver can't listen on port " << port << ": " << ex.what());
+		return false;
+	}
+
+	mSources.clear();
+	mPackets = 0;
+	mFrames = 0;
+	mTouches = 0;
+	mBusyMicros = 0;
+	mStop = false;
+	mThread.setName("ds_tuio");
+	mThread.setPriority(Poco::Thread::PRIO_HIGH);
+	mThread.start(*this);
+	return true;
+}
+
+void TuioReceiver::stop() {
+	if (!mThread.isRunning()) return;
+
+	mStop = true;
+	mThread.join();
+	try {
+		mSocket.close();
+	} catch (std::exception&) {
+	}
+
+	const Stats		stats = getStats();
+	if (stats.mFrames > 0) {
+		DS_LOG_INFO("TuioReceiver stopped after " << stats.mPackets << " packets, " << stats.mFrames << " frames and "
+					<< stats.mTouches << " touches, " << static_cast<double>(stats.mBusyMicros) / static_cast<double>(stats.mPackets)
+					<< "us per packet");
+	}
+}
+
+bool TuioReceiver::isRunning() const {
+	return mThread.isRunning();
+}
+
+TuioReceiver::Stats TuioReceiver::getStats() const {
+	Stats			s;
+	s.mPackets = mPackets;
+	s.mFrames = mFrames;
+	s.mTouches = mTouches;
+	s.mBusyMicros = mBusyMicros;
+	return s;
+}
+
+void TuioReceiver::run() {
+	bool			warned = false;
+	while (!mStop) {
+		try {
+			Poco::Net::SocketAddress	from;
+			const int	size = mSocket.receiveFrom(mBuffer.data(), static_cast<int>(mBuffer.size()), from);
+			if (size > 0) receive(mBuffer.data(), static_cast<size_t>(size), from, Poco::Timestamp().epochMicroseconds());
+		} catch (Poco::TimeoutException&) {
+		} catch (std::exception& ex) {
+			// Windows reports unreachable senders on the next receive, so keep going
+			if (!warned) DS_LOG_WARNING("TuioReceiver receive error: " << ex.what());
+			warned = true;
+		}
+	}
+}
+
+void TuioReceiver::receive(	const char* data, const size_t size,
+							const Poco::Net::SocketAddress& from,
+							const Poco::Timestamp::TimeVal received) {
+	Source*			source = findSource(from);
+	if (!source) return;
+
+	const Poco::Timestamp	start;
+	parsePacket(data, data + size, *source, received);
+	++mPackets;
+	mBusyMicros += start.elapsed();
+}
+
+TuioReceiver::Source* TuioReceiver::findSource(const Poco::Net::SocketAddress& address) {
+	for (auto it = mSources.begin(), end = mSources.end(); it != end; ++it) {
+		if (it->mAddress.host() == address.host()) return &(*it);
+	}
+	if (mSources.size() >= MAX_SOURCES) return nullptr;
+
+	mSources.push_back(Source());
+	Source&			s = mSources.back();
+	s.mAddress = address;
+	s.mIdOffset = static_cast<uint32_t>(mSources.size() - 1) << SOURCE_ID_SHIFT;
+	return &s;
+}
+
+void TuioReceiver::parsePacket(const char* data, const char* end, Source& source, const Poco::Timestamp::TimeVal received) {
+	if (end - data < 8) return;
+	if (memcmp(data, "#bundle\0", 8) != 0) {
+		parseMessage(data, end, source, received);
+		return;
+	}
+
+	// Skip the tag and the time tag, then each element is a size and a packet
+	const char*		p = data + 16;
+	while (end - p >= 4) {
+		const int32_t	size = read_int32(p);
+		p += 4;
+		if (size < 0 || size > end - p) return;
+		parsePacket(p, p + size, source, received);
+		p += size;
+	}
+}
+
+void TuioReceiver::parseMessage(const char* data, const char* end, Source& source, const Poco::Timestamp::TimeVal received) {
+	const char*		address = data;
+	const char*		types = skip_string(address, end);
+	if (!types || *types != ',') return;
+	const char*		args = skip_string(types, end);
+	if (!args) return;
+	OscArgs			r(types + 1, args, end);
+
+	if (strcmp(address, "/tuio/2Dcur") == 0) {
+		const char*	command = nullptr;
+		if (!r.read(command)) return;
+
+		if (strcmp(command, "set") == 0) {
+			Cursor	c;
+			if (!r.read(c.mSessionId) || !r.read(c.mPos.x) || !r.read(c.mPos.y)) return;
+			add_set(source.mSets, c);
+		} else if (strcmp(command, "alive") == 0) {
+			source.mAlive.clear();
+			source.mHasAlive = true;
+			int32_t	id;
+			while (r.read(id)) source.mAlive.push_back(id);
+		} else if (strcmp(command, "fseq") == 0) {
+			int32_t	frame;
+			if (r.read(frame)) endFrame(source, frame, received);
+		}
+	} else if (strcmp(address, "/tuio2/frm") == 0) {
+		int32_t		frame;
+		if (r.read(frame)) source.mFrame = frame;
+	} else if (strcmp(address, "/tuio2/ptr") == 0) {
+		// s_id, tu_id, c_id, x, y, then angle and more that aren't needed
+		Cursor		c;
+		int32_t		ignored;
+		if (!r.read(c.mSessionId) || !r.read(ignored) || !r.read(ignored) || !r.read(c.mPos.x) || !r.read(c.mPos.y)) return;
+		add_set(source.mSets, c);
+	} else if (strcmp(address, "/tuio2/alv") == 0) {
+		source.mAlive.clear();
+		source.mHasAlive = true;
+		int32_t		id;
+		while (r.read(id)) source.mAlive.push_back(id);
+		endFrame(source, source.mFrame, received);
+	}
+}
+
+void TuioReceiver::endFrame(Source& source, const int32_t frame, const Poco::Timestamp::TimeVal received) {
+	// UDP can deliver frames from the past; skip those unless the source looks to have restarted.
+	// A frame of -1 is an update without a new time, and always goes through.
+	const int32_t	dframe = frame - source.mPreviousFrame;
+	if (frame == -1 || dframe > 0 || dframe < -mPastFrameThreshold) {
+		ci::vec2		scale;
+		{
+			std::lock_guard<std::mutex>	lock(mScaleMutex);
+			scale = mScale;
+		}
+		// Touch times only get compared with each other, so they count from when this was made
+		const double	time = static_cast<double>((received > 0 ? received : Poco::Timestamp().epochMicroseconds()) - mStart) / 1000000.0;
+
+		mBeganTouches.clear();
+		mMovedTouches.clear();
+		mEndedTouches.clear();
+		for (auto it = source.mSets.begin(), end = source.mSets.end(); it != end; ++it) {
+			const ci::vec2		pos = it->mPos * scale;
+			const uint32_t		id = source.mIdOffset + static_cast<uint32_t>(it->mSessionId);
+			Cursor*				cursor = nullptr;
+			for (auto cit = source.mCursors.begin(), cend = source.mCursors.end(); cit != cend; ++cit) {
+				if (cit->mSessionId == it->mSessionId) {
+					cursor = &(*cit);
+					break;
+				}
+			}
+			if (cursor) {
+				mMovedTouches.push_back(ci::app::TouchEvent::Touch(pos, cursor->mPos * scale, id, time, nullptr));
+				cursor->mPos = it->mPos;
+			} else if (source.mCursors.size() < MAX_CURSORS) {
+				source.mCursors.push_back(*it);
+				mBeganTouches.push_back(ci::app::TouchEvent::Touch(pos, pos, id, time, nullptr));
+			}
+		}
+
+		if (source.mHasAlive) {
+			for (size_t k = source.mCursors.size(); k > 0; --k) {
+				const Cursor&	c = source.mCursors[k - 1];
+				if (is_alive(source.mAlive, c.mSessionId)) continue;
+				const ci::vec2	pos = c.mPos * scale;
+				mEndedTouches.push_back(ci::app::TouchEvent::Touch(pos, pos, source.mIdOffset + static_cast<uint32_t>(c.mSessionId), time, nullptr));
+				source.mCursors[k - 1] = source.mCursors.back();
+				source.mCursors.pop_back();
+			}
+		}
+
+		send(mBegan, mBeganTouches, frame, received);
+		send(mMoved, mMovedTouches, frame, received);
+		send(mEnded, mEndedTouches, frame, received);
+		++mFrames;
+		mTouches += static_cast<long long>(mBeganTouches.size() + mMovedTouches.size() + mEndedTouches.size());
+
+		if (frame != -1) source.mPreviousFrame = frame;
+	}
+
+	source.mSets.clear();
+	source.mAlive.clear();
+	source.mHasAlive = false;
+}
+
+void TuioReceiver::send(const Handler& h, const std::vector<ci::app::TouchEvent::Touch>& touches,
+						const int32_t frame, const Poco::Timestamp::TimeVal received) {
+	if (touches.empty() || !h) return;
+	ds::ui::TouchEvent		e(ci::app::WindowRef(), touches);
+	e.setReceivedTime(received);
+	e.setSourceFrame(frame);
+	h(e);
+}
+
+} // namespace ui
+} // namespace ds
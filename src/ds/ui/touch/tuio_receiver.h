@@ -0,0 +1,124 @@
+#pragma once
+#ifndef DS_UI_TOUCH_TUIORECEIVER_H_
+#define DS_UI_TOUCH_TUIORECEIVER_H_
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <cinder/Vector.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Net/DatagramSocket.h>
+#include <Poco/Net/SocketAddress.h>
+#include "ds/ui/touch/touch_event.h"
+
+namespace ds {
+namespace ui {
+
+/**
+ * \class ds::ui::TuioReceiver
+ * \brief Receives TUIO 1.1 (/tuio/2Dcur) and TUIO 2.0 (/tuio2/ptr) cursors on its
+ * own thread, in place of the cinder TUIO client. Bundles are read straight out of
+ * the receive buffer, the cursors for each source are a flat list, and every frame
+ * goes to the handlers as at most one began, moved and ended event. Events are in
+ * window pixels and carry the receive time and the TUIO frame id. Touch times are
+ * seconds from when the receiver was made, so it doesn't need a running app.
+ *
+ * Only cursors are handled, apps that need TUIO objects stay on the cinder client.
+ */
+class TuioReceiver : public Poco::Runnable {
+public:
+	typedef std::function<void(const ds::ui::TouchEvent&)> Handler;
+
+	struct Stats {
+		Stats();
+		long long					mPackets;
+		long long					mFrames;
+		long long					mTouches;
+		// Time spent parsing and handing off, in microseconds
+		long long					mBusyMicros;
+	};
+
+	TuioReceiver();
+	~TuioReceiver();
+
+	// Set before start(), the handlers are called on the receive thread.
+	void							setHandlers(const Handler& began, const Handler& moved, const Handler& ended);
+	// TUIO positions are 0-1, and get multiplied by this (the window size).
+	void							setScale(const ci::vec2&);
+	// How far a frame id can go backwards before the source is taken to have restarted.
+	void							setPastFrameThreshold(const int32_t);
+
+	bool							start(const int port);
+	void							stop();
+	bool							isRunning() const;
+
+	// Handle one datagram. The thread calls this as packets arrive; it's public so
+	// recorded packets can be played through without a socket.
+	void							receive(const char* data, const size_t size,
+											const Poco::Net::SocketAddress& from,
+											const Poco::Timestamp::TimeVal received);
+
+	// Counts since start()
+	Stats							getStats() const;
+
+	virtual void					run();
+
+	struct Cursor {
+		int32_t						mSessionId;
+		ci::vec2					mPos;
+	};
+
+private:
+	TuioReceiver(const TuioReceiver&);
+	TuioReceiver&					operator=(const TuioReceiver&);
+
+	struct Source {
+		Source();
+
+		Poco::Net::SocketAddress	mAddress;
+		// Added to the session ids, so sources can't collide
+		uint32_t					mIdOffset;
+		int32_t						mPreviousFrame;
+		std::vector<Cursor>			mCursors;
+
+		// The frame being assembled. TUIO 1.1 ends it with fseq, 2.0 with alv.
+		int32_t						mFrame;
+		std::vector<Cursor>			mSets;
+		std::vector<int32_t>		mAlive;
+		bool						mHasAlive;
+	};
+
+	Source*							findSource(const Poco::Net::SocketAddress&);
+	void							parsePacket(const char* data, const char* end, Source&, const Poco::Timestamp::TimeVal);
+	void							parseMessage(const char* data, const char* end, Source&, const Poco::Timestamp::TimeVal);
+	void							endFrame(Source&, const int32_t frame, const Poco::Timestamp::TimeVal);
+	void							send(	const Handler&, const std::vector<ci::app::TouchEvent::Touch>&,
+											const int32_t frame, const Poco::Timestamp::TimeVal);
+
+	Handler							mBegan, mMoved, mEnded;
+	std::mutex						mScaleMutex;
+	ci::vec2						mScale;
+	int32_t							mPastFrameThreshold;
+	// Touch times are seconds since this
+	const Poco::Timestamp::TimeVal	mStart;
+
+	Poco::Net::DatagramSocket		mSocket;
+	Poco::Thread					mThread;
+	std::atomic<bool>				mStop;
+	std::vector<char>				mBuffer;
+
+	std::vector<Source>				mSources;
+	// Scratch for each frame's events
+	std::vector<ci::app::TouchEvent::Touch>
+									mBeganTouches, mMovedTouches, mEndedTouches;
+
+	std::atomic<long long>			mPackets, mFrames, mTouches, mBusyMicros;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_TOUCH_TUIORECEIVER_H_
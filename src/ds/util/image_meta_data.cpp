@@ -2,19 +2,27 @@
 
 #include "image_meta_data.h"
 
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string.h>
 #include <unordered_map>
 #include <cinder/ImageIo.h>
 #include <cinder/Surface.h>
 #include <Poco/File.h>
+#include <Poco/Mutex.h>
 #include <Poco/Path.h>
 #include <Poco/String.h>
+#include <Poco/URI.h>
+#include <Poco/Net/HTTPClientSession.h>
+#include <Poco/Net/HTTPRequest.h>
+#include <Poco/Net/HTTPResponse.h>
 #include "ds/app/environment.h"
 #include "ds/debug/logger.h"
-#include "ds/storage/persistent_cache.h"
 #include "ds/util/file_meta_data.h"
 #include "ds/debug/debug_defines.h"
-
-#include "ds/util/exif_reader.h"
+#include "ds/gl/compressed_texture.h"
 
 namespace ds {
 
@@ -23,67 +31,266 @@ namespace {
 // Should have universal formats somewhere
 const int					FORMAT_UNKNOWN = 0;
 const int					FORMAT_PNG = 1;
+const int					FORMAT_COMPRESSED = 2;
+const int					FORMAT_JPEG = 3;
+const int					FORMAT_GIF = 4;
+const int					FORMAT_BMP = 5;
+const int					FORMAT_TIFF = 6;
+const int					FORMAT_WEBP = 7;
+const int					FORMAT_PSD = 8;
+
+// Enough to identify any of the formats, and to hold the whole header for most of them
+const size_t				HEADER_SIZE = 32;
+// Sanity limit on image dimensions, there's some bad headers out there
+const uint32_t				MAX_DIMENSION = 65535;
+// Fetched from the start of a url image. Holds the header of everything but JPEGs
+// with a lot of metadata ahead of the frame, which fall back to a full download.
+const size_t				URL_PROBE_SIZE = 16 * 1024;
+const long					URL_PROBE_TIMEOUT_SECONDS = 5;
+
+// Persisted cache file
+const std::string			CACHE_FILE_SZ("%LOCAL%/cache/%PP%/image_meta_data.txt");
+const std::string			CACHE_HEADER_SZ("ds_image_meta_data 1");
+
+uint32_t					big_endian_bytes_to_native( const char* bytes ) {
+	const unsigned char* data = (unsigned char*)bytes;
+	return (data[3]<<0) | (data[2]<<8) | (data[1]<<16) | (data[0]<<24);
+}
+
+uint32_t					little_endian_bytes_to_native( const char* bytes ) {
+	const unsigned char* data = (unsigned char*)bytes;
+	return (data[0]<<0) | (data[1]<<8) | (data[2]<<16) | (data[3]<<24);
+}
+
+uint16_t					big_endian_short( const char* bytes ) {
+	const unsigned char* data = (unsigned char*)bytes;
+	return static_cast<uint16_t>((data[0]<<8) | data[1]);
+}
+
+uint16_t					little_endian_short( const char* bytes ) {
+	const unsigned char* data = (unsigned char*)bytes;
+	return static_cast<uint16_t>(data[0] | (data[1]<<8));
+}
 
-// Storage object
-const std::string			PATH_SZ("q");
-const std::string			WIDTH_SZ("w");
-const std::string			HEIGHT_SZ("h");
-const std::string			TIMESTAMP_SZ("ts");
+// Identify the format from the file signature, falling back to the extension
+int							get_format(const std::string& filename, const char* header, const size_t headerSize) {
+	if (headerSize >= 8 && memcmp(header, "\x89PNG\r\n\x1a\n", 8) == 0) return FORMAT_PNG;
+	if (headerSize >= 3 && memcmp(header, "\xff\xd8\xff", 3) == 0) return FORMAT_JPEG;
+	if (headerSize >= 6 && (memcmp(header, "GIF87a", 6) == 0 || memcmp(header, "GIF89a", 6) == 0)) return FORMAT_GIF;
+	if (headerSize >= 2 && memcmp(header, "BM", 2) == 0) return FORMAT_BMP;
+	if (headerSize >= 4 && (memcmp(header, "II*\0", 4) == 0 || memcmp(header, "MM\0*", 4) == 0)) return FORMAT_TIFF;
+	if (headerSize >= 12 && memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WEBP", 4) == 0) return FORMAT_WEBP;
+	if (headerSize >= 4 && memcmp(header, "8BPS", 4) == 0) return FORMAT_PSD;
 
-int							get_format(const std::string& filename) {
 	const Poco::Path		path(filename);
 	std::string				ext = path.getExtension();
 	Poco::toLowerInPlace(ext);
-	if (ext == "png") return FORMAT_PNG;
+	if (ext == "dds" || ext == "ktx") return FORMAT_COMPRESSED;
 	return FORMAT_UNKNOWN;
 }
 
-uint32_t					big_endian_bytes_to_native( const char* bytes ) {
-	const unsigned char* data = (unsigned char*)bytes;
-	return (data[3]<<0) | (data[2]<<8) | (data[1]<<16) | (data[0]<<24);
+bool						set_size(const uint32_t width, const uint32_t height, ci::vec2& outSize) {
+	if (width < 1 || width > MAX_DIMENSION || height < 1 || height > MAX_DIMENSION) return false;
+	outSize.x = static_cast<float>(width);
+	outSize.y = static_cast<float>(height);
+	return true;
 }
 
-bool						get_format_png(const std::string& filename, ci::vec2& outSize) {
-	std::ifstream file(filename, std::ios_base::binary | std::ios_base::in);
-	if (!file.is_open() || !file) return false;
+bool						get_format_png(const char* header, const size_t headerSize, ci::vec2& outSize) {
+	// Signature, then the IHDR chunk length and type, then width and height
+	if (headerSize < 24 || memcmp(header + 12, "IHDR", 4) != 0) return false;
+	return set_size(big_endian_bytes_to_native(header + 16), big_endian_bytes_to_native(header + 20), outSize);
+}
 
-	// Skip PNG file signature
-	file.seekg(8, std::ios_base::cur);
+bool						get_format_gif(const char* header, const size_t headerSize, ci::vec2& outSize) {
+	if (headerSize < 10) return false;
+	return set_size(little_endian_short(header + 6), little_endian_short(header + 8), outSize);
+}
 
-	// First chunk: IHDR image header
-	// Skip Chunk Length
-	file.seekg(4, std::ios_base::cur);
-	// Skip Chunk Type
-	file.seekg(4, std::ios_base::cur);
+bool						get_format_bmp(const char* header, const size_t headerSize, ci::vec2& outSize) {
+	if (headerSize < 26) return false;
+	// OS/2 1.x headers store 16 bit sizes, everything later 32 bit signed
+	if (little_endian_bytes_to_native(header + 14) == 12) {
+		return set_size(little_endian_short(header + 18), little_endian_short(header + 20), outSize);
+	}
+	const int32_t			width = static_cast<int32_t>(little_endian_bytes_to_native(header + 18));
+	const int32_t			height = static_cast<int32_t>(little_endian_bytes_to_native(header + 22));
+	// Negative height means the rows are stored top down
+	return set_size(static_cast<uint32_t>(width), static_cast<uint32_t>(height < 0 ? -height : height), outSize);
+}
 
-	char widthBytes[4];
-	char heightBytes[4];
-	file.read(widthBytes, 4);
-	file.read(heightBytes, 4);
+bool						get_format_psd(const char* header, const size_t headerSize, ci::vec2& outSize) {
+	if (headerSize < 22) return false;
+	return set_size(big_endian_bytes_to_native(header + 18), big_endian_bytes_to_native(header + 14), outSize);
+}
 
-	// PNG format stores as big endian, convert to native endianness
-	uint32_t width = big_endian_bytes_to_native(widthBytes);
-	uint32_t height = big_endian_bytes_to_native(heightBytes);
+bool						get_format_webp(const char* header, const size_t headerSize, ci::vec2& outSize) {
+	if (headerSize < 30) return false;
+	const unsigned char*	data = (const unsigned char*)header;
+	// Lossy: frame tag, start code, then 14 bit sizes
+	if (memcmp(header + 12, "VP8 ", 4) == 0) {
+		if (data[23] != 0x9d || data[24] != 0x01 || data[25] != 0x2a) return false;
+		return set_size(little_endian_short(header + 26) & 0x3fff, little_endian_short(header + 28) & 0x3fff, outSize);
+	}
+	// Lossless: signature byte, then 14 bits each of width-1 and height-1
+	if (memcmp(header + 12, "VP8L", 4) == 0) {
+		if (data[20] != 0x2f) return false;
+		const uint32_t		bits = little_endian_bytes_to_native(header + 21);
+		return set_size((bits & 0x3fff) + 1, ((bits >> 14) & 0x3fff) + 1, outSize);
+	}
+	// Extended: 24 bit canvas width-1 and height-1
+	if (memcmp(header + 12, "VP8X", 4) == 0) {
+		const uint32_t		w = data[24] | (data[25] << 8) | (data[26] << 16);
+		const uint32_t		h = data[27] | (data[28] << 8) | (data[29] << 16);
+		return set_size(w + 1, h + 1, outSize);
+	}
+	return false;
+}
 
-	// check to make sure we correctly read the size. There's some bad png's out there
-	if(width < 1 || width > 20000 || height < 1 || height > 20000){
-		return false;
+// Walk the markers to the first start-of-frame. Only segment headers are read.
+bool						get_format_jpeg(std::istream& file, ci::vec2& outSize) {
+	char					buf[9];
+	file.seekg(2, std::ios_base::beg);
+	while (file.read(buf, 2)) {
+		if ((unsigned char)buf[0] != 0xff) return false;
+		const unsigned char	marker = (unsigned char)buf[1];
+		// Fill bytes
+		if (marker == 0xff) {
+			file.seekg(-1, std::ios_base::cur);
+			continue;
+		}
+		// Markers without a length
+		if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7)) continue;
+		if (marker == 0xd9 || marker == 0xda) return false;
+
+		if (!file.read(buf, 2)) return false;
+		const uint16_t		length = big_endian_short(buf);
+		if (length < 2) return false;
+
+		// SOF0-SOF15, minus DHT, JPG and DAC
+		if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) {
+			if (!file.read(buf, 5)) return false;
+			return set_size(big_endian_short(buf + 3), big_endian_short(buf + 1), outSize);
+		}
+		file.seekg(length - 2, std::ios_base::cur);
 	}
+	return false;
+}
 
-	outSize.x = static_cast<float>(width);
-	outSize.y = static_cast<float>(height);
-	return true;
+// Find the width and height tags in the first IFD.
+bool						get_format_tiff(std::istream& file, const char* header, ci::vec2& outSize) {
+	const bool				le = header[0] == 'I';
+	auto					u16 = [le](const char* b) { return le ? little_endian_short(b) : big_endian_short(b); };
+	auto					u32 = [le](const char* b) { return le ? little_endian_bytes_to_native(b) : big_endian_bytes_to_native(b); };
+
+	char					buf[12];
+	file.seekg(u32(header + 4), std::ios_base::beg);
+	if (!file.read(buf, 2)) return false;
+	const uint16_t			count = u16(buf);
+	uint32_t				width = 0, height = 0;
+	for (uint16_t i = 0; i < count && (width == 0 || height == 0); ++i) {
+		if (!file.read(buf, 12)) return false;
+		const uint16_t		tag = u16(buf);
+		const uint16_t		type = u16(buf + 2);
+		// SHORT or LONG
+		const uint32_t		value = (type == 3 ? u16(buf + 8) : (type == 4 ? u32(buf + 8) : 0));
+		if (tag == 256) width = value;
+		else if (tag == 257) height = value;
+	}
+	return set_size(width, height, outSize);
+}
+
+// Answer the size from the start of an image, without decoding any pixels. The filename
+// is only for the extension. Compressed textures are read from disk, so they answer false.
+bool						probe_image_stream(const std::string& filename, std::istream& file, ci::vec2& outSize, int& outFormat) {
+	char					header[HEADER_SIZE];
+	file.read(header, HEADER_SIZE);
+	const size_t			headerSize = static_cast<size_t>(file.gcount());
+	file.clear();
+
+	outFormat = get_format(filename, header, headerSize);
+	switch (outFormat) {
+	case FORMAT_PNG:		return get_format_png(header, headerSize, outSize);
+	case FORMAT_JPEG:		return get_format_jpeg(file, outSize);
+	case FORMAT_GIF:		return get_format_gif(header, headerSize, outSize);
+	case FORMAT_BMP:		return get_format_bmp(header, headerSize, outSize);
+	case FORMAT_TIFF:		return get_format_tiff(file, header, outSize);
+	case FORMAT_WEBP:		return get_format_webp(header, headerSize, outSize);
+	case FORMAT_PSD:		return get_format_psd(header, headerSize, outSize);
+	default:				return false;
+	}
+}
+
+// Answer the size from the file header, without decoding any pixels.
+bool						probe_image_header(const std::string& filename, ci::vec2& outSize) {
+	std::ifstream			file(filename, std::ios_base::binary | std::ios_base::in);
+	if (!file.is_open() || !file) return false;
+
+	int						format = FORMAT_UNKNOWN;
+	if (probe_image_stream(filename, file, outSize, format)) return true;
+	if (format != FORMAT_COMPRESSED) return false;
+
+	int						w = 0, h = 0;
+	file.close();
+	if (!ds::gl::readCompressedTextureSize(filename, w, h)) return false;
+	return set_size(static_cast<uint32_t>(w), static_cast<uint32_t>(h), outSize);
+}
+
+// Answer the size from the first URL_PROBE_SIZE bytes of an http url, asked for with a
+// range request. There's no SSL session here, so https urls answer false.
+bool						probe_url_header(const std::string& url, ci::vec2& outSize) {
+	const Poco::URI			uri(url);
+	if (Poco::toLower(uri.getScheme()) != "http") return false;
+
+	Poco::Net::HTTPClientSession	s;
+	// Host and port separately, see HttpClient
+	s.setHost(uri.getHost());
+	s.setPort(uri.getPort());
+	s.setTimeout(Poco::Timespan(URL_PROBE_TIMEOUT_SECONDS, 0));
+	std::string				path(uri.getPathAndQuery());
+	if (path.empty()) path = "/";
+
+	Poco::Net::HTTPRequest	request(Poco::Net::HTTPRequest::HTTP_GET, path, Poco::Net::HTTPMessage::HTTP_1_1);
+	request.set("Range", "bytes=0-" + std::to_string(URL_PROBE_SIZE - 1));
+	s.sendRequest(request);
+	Poco::Net::HTTPResponse	response;
+	std::istream&			rs = s.receiveResponse(response);
+	// A server that ignores the range sends the whole image; only the start is read either way
+	if (response.getStatus() != Poco::Net::HTTPResponse::HTTP_PARTIAL_CONTENT
+			&& response.getStatus() != Poco::Net::HTTPResponse::HTTP_OK) {
+		return false;
+	}
+	std::string				data(URL_PROBE_SIZE, '\0');
+	rs.read(&data[0], static_cast<std::streamsize>(data.size()));
+	data.resize(static_cast<size_t>(rs.gcount()));
+	// Drop the connection instead of draining the rest of a full response
+	s.reset();
+
+	std::istringstream		stream(data);
+	int						format = FORMAT_UNKNOWN;
+	return probe_image_stream(uri.getPath(), stream, outSize, format);
 }
 
 // A horrible fallback when no meta info has been supplied about the image size.
-void						super_slow_image_atts(const std::string& filename, ci::vec2& outSize) {
+void						super_slow_image_atts(const std::string& filename, const bool webMode, ci::vec2& outSize) {
 	try {
 		if (filename.empty()) return;
+
+		if(webMode){
+			DS_LOG_WARNING_M("ImageFileAtts Going to download image synchronously; this will affect performance, url: " << filename, GENERAL_LOG);
+			auto s = ci::Surface8u(ci::loadImage(ci::loadUrl(filename)));
+			if(s.getData()) {
+				outSize = ci::vec2(static_cast<float>(s.getWidth()), static_cast<float>(s.getHeight()));
+			} else {
+				DS_LOG_WARNING_M("super_slow_image_atts: url could not be loaded, url: " << filename, GENERAL_LOG);
+				outSize = ci::vec2();
+			}
+			return;
+		}
+
 		// Just load the image to get the dimensions -- this will incur what is
 		// unnecessarily overhead in one situation (I am in client/server mode),
 		// but is otherwise the right thing to do.
-		const Poco::File file(filename);
-
 		if(!ds::safeFileExistsCheck(filename)){
 			DS_LOG_WARNING_M("ImageFileAtts: image file does not exist, filename: " << filename, GENERAL_LOG);
 			return;
@@ -99,32 +306,15 @@ void						super_slow_image_atts(const std::string& filename, ci::vec2& outSize)
 			outSize = ci::vec2();
 		}
 	} catch (std::exception const& ex) {
-		bool errored = true;
-
-		// try to load it from the web
-		try{
-			auto s = ci::Surface8u(ci::loadImage(ci::loadUrl(filename)));
-			if(s.getData()) {
-				outSize = ci::vec2(static_cast<float>(s.getWidth()), static_cast<float>(s.getHeight()));
-				errored = false;
-			} else {
-				DS_LOG_WARNING_M("super_slow_image_atts: file could not be loaded, filename: " << filename, GENERAL_LOG);
-				outSize = ci::vec2();
-			}
-		} catch(std::exception const& extwo){
-			DS_LOG_WARNING_M("ImageMetaData error loading file from url (" << filename << ") = " << extwo.what(), GENERAL_LOG);
-		}
-
-		if(errored){
-			DS_LOG_WARNING_M("ImageMetaData error loading file (" << filename << ") = " << ex.what(), GENERAL_LOG);
-		}
+		DS_LOG_WARNING_M("ImageMetaData error loading file (" << filename << ") = " << ex.what(), GENERAL_LOG);
 	}
 }
 
 }
 
-// Store a cache of parsed files.  We should have this cache to a database, but for now, just have
-// it generate at each run.
+// Store a cache of parsed files. The cache is split into shards, each with its own lock, so
+// layout code on several threads doesn't serialize on one mutex. It's loaded from disk on
+// first use and written back at exit, so sizes survive between runs.
 namespace {
 class ImageAtts {
 public:
@@ -140,17 +330,24 @@ public:
 
 class ImageAttsCache {
 public:
-	ImageAttsCache() {
+	ImageAttsCache()
+			: mDirty(false) {
+	}
+
+	~ImageAttsCache() {
+		save();
 	}
 
 	void				add(const std::string& filePath, const ci::vec2 size){
+		load();
 		if(size.x> 0 && size.y > 0){
 			try{
+				const std::string	expanded_fn = ds::Environment::expand(filePath);
 				ImageAtts atts(size);
-				if(ds::safeFileExistsCheck(filePath, false)) {
-					const auto file = Poco::File(filePath);
+				if(ds::safeFileExistsCheck(expanded_fn, false)) {
+					const auto file = Poco::File(expanded_fn);
 					atts.mLastModified = file.getLastModified();
-					mCache[filePath] = atts;
+					put(expanded_fn, atts);
 				} else {
 					DS_LOG_WARNING_M("ImageAttsCache::add : File does not exist when finding metadata: " << filePath, GENERAL_LOG);
 				}
@@ -162,7 +359,8 @@ public:
 
 	ci::vec2			getSize(const std::string& fn) {
 		// If I've got a cached item and the modified dates match, use that.
-		// Note: for the actual path, use the expanded fn.
+		// Note: the cache is keyed by the expanded fn, so it's stable between runs.
+		load();
 
 		std::string	expanded_fn;
 		bool webMode = false;
@@ -174,14 +372,13 @@ public:
 		}
 
 		try {
-			auto f = mCache.find(fn);
-			
-			if(f != mCache.end()){
+			ImageAtts		cached;
+			if(find(expanded_fn, cached)){
 				// we hope that the remote image hasn't changed since we grabbed it's size.
 				if(webMode){
-					return f->second.mSize;
-				} else if(f->second.mLastModified == Poco::File(expanded_fn).getLastModified()) {
-					return f->second.mSize;
+					return cached.mSize;
+				} else if(cached.mLastModified == Poco::File(expanded_fn).getLastModified()) {
+					return cached.mSize;
 				}
 			}
 		} catch (std::exception const&) {
@@ -189,11 +386,11 @@ public:
 
 		try {
 			// Generate the cache:
-			ImageAtts		atts = generate(expanded_fn);
+			ImageAtts		atts = generate(expanded_fn, webMode);
 			if (atts.mSize.x > 0.0f && atts.mSize.y > 0.0f) {
 				// calling anything on an invalid file throws an exception, and web stuff is invalid
 				if(!webMode) atts.mLastModified = Poco::File(expanded_fn).getLastModified();
-				mCache[fn] = atts;
+				put(expanded_fn, atts);
 				return atts.mSize;
 			}
 		} catch (std::exception const&) {
@@ -202,7 +399,97 @@ public:
 	}
 
 private:
-	ImageAtts			generate(const std::string& fn) const {
+	static const size_t	SHARD_COUNT = 16;
+
+	struct Shard {
+		Poco::Mutex									mMutex;
+		std::unordered_map<std::string, ImageAtts>	mCache;
+	};
+
+	Shard&				shardFor(const std::string& fn) {
+		return mShards[std::hash<std::string>()(fn) % SHARD_COUNT];
+	}
+
+	bool				find(const std::string& fn, ImageAtts& out) {
+		Shard&						shard = shardFor(fn);
+		Poco::Mutex::ScopedLock		l(shard.mMutex);
+		auto						f = shard.mCache.find(fn);
+		if(f == shard.mCache.end()) return false;
+		out = f->second;
+		return true;
+	}
+
+	void				put(const std::string& fn, const ImageAtts& atts) {
+		{
+			Shard&					shard = shardFor(fn);
+			Poco::Mutex::ScopedLock	l(shard.mMutex);
+			shard.mCache[fn] = atts;
+		}
+		mDirty.store(true);
+	}
+
+	// Read the persisted cache the first time through. After that this costs a flag check,
+	// so lookups only ever lock their own shard.
+	void				load() {
+		std::call_once(mLoadOnce, [this]() { readFile(); });
+	}
+
+	// Entries are validated against the file's modified time on lookup, so stale ones are harmless.
+	void				readFile() {
+		try {
+			mFilename = ds::Environment::expand(CACHE_FILE_SZ);
+			std::ifstream			file(mFilename);
+			if(!file.is_open()) return;
+
+			std::string				line;
+			if(!std::getline(file, line) || line != CACHE_HEADER_SZ) return;
+			while(std::getline(file, line)) {
+				std::istringstream	buf(line);
+				float				w = 0.0f, h = 0.0f;
+				Poco::Int64			ts = 0;
+				std::string			fn;
+				if(!(buf >> w >> h >> ts)) continue;
+				buf.get();
+				std::getline(buf, fn);
+				if(fn.empty() || w <= 0.0f || h <= 0.0f) continue;
+
+				ImageAtts			atts(ci::vec2(w, h));
+				atts.mLastModified = Poco::Timestamp(ts);
+				Shard&				shard = shardFor(fn);
+				Poco::Mutex::ScopedLock	sl(shard.mMutex);
+				shard.mCache[fn] = atts;
+			}
+		} catch (std::exception const&) {
+		}
+	}
+
+	// Write to a temp file and swap it in, so a crash mid-write can't leave a partial cache.
+	void				save() {
+		Poco::Mutex::ScopedLock		l(mFileMutex);
+		if(mFilename.empty() || !mDirty.exchange(false)) return;
+
+		try {
+			Poco::File(Poco::Path(mFilename).parent()).createDirectories();
+			const std::string		tmp = mFilename + ".tmp";
+			{
+				std::ofstream		file(tmp, std::ios_base::out | std::ios_base::trunc);
+				if(!file.is_open()) return;
+				file << CACHE_HEADER_SZ << "\n";
+				for(size_t k = 0; k < SHARD_COUNT; ++k) {
+					Poco::Mutex::ScopedLock	sl(mShards[k].mMutex);
+					for(auto it = mShards[k].mCache.begin(), end = mShards[k].mCache.end(); it != end; ++it) {
+						file << it->second.mSize.x << " " << it->second.mSize.y << " "
+							 << it->second.mLastModified.epochMicroseconds() << " " << it->first << "\n";
+					}
+				}
+				if(!file.good()) return;
+			}
+			Poco::File(tmp).renameTo(mFilename);
+		} catch (std::exception const&) {
+		}
+	}
+
+	ImageAtts			generate(const std::string& fn, const bool webMode) const {
 		// 1. Look for meta data encoded in file name
 		try {
 			FileMetaData		meta(fn);
@@ -214,31 +501,29 @@ private:
 		} catch (std::exception const&) {
 		}
 
-		// 2. Probe known file formats
+		// 2. Probe the header of known file formats. For urls, only the start is downloaded.
 		try {
 			ImageAtts			atts;
-			const int			format = get_format(fn);
-			if (format == FORMAT_PNG && get_format_png(fn, atts.mSize)) {
+			if (webMode ? probe_url_header(fn, atts.mSize) : probe_image_header(fn, atts.mSize)) {
 				return atts;
 			}
 		} catch (std::exception const& e) {
 			DS_LOG_WARNING_M("ImageFileAtts() error=" << e.what(), GENERAL_LOG);
 		}
 
-		// 3. let's see if there's exif data
-		int outW = 0;
-		int outH = 0;
-		if(ds::ExifHelper::getImageSize(fn, outW, outH)){
-			return ImageAtts(ci::vec2(static_cast<float>(outW), static_cast<float>(outH)));
-		}
-
-		// 4. Load the whole damn image in and get that.
+		// 3. Load the whole damn image in and get that.
 		ImageAtts			atts;
-		super_slow_image_atts(fn, atts.mSize);
+		super_slow_image_atts(fn, webMode, atts.mSize);
 		return atts;
 	}
 
-	std::unordered_map<std::string, ImageAtts>	mCache;
+	Shard				mShards[SHARD_COUNT];
+	std::once_flag		mLoadOnce;
+	// Only serializes saves, the cache itself is guarded by the shards
+	Poco::Mutex			mFileMutex;
+	// Written once, inside mLoadOnce
+	std::string			mFilename;
+	std::atomic<bool>	mDirty;
 };
 
 ImageAttsCache			CACHE;
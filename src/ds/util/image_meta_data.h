@@ -10,7 +10,9 @@ namespace ds {
 /**
  * \class ds::ImageMetaData
  * \brief Read meta data for image files.
- * NOTE: This can be VERY slow, if the image needs to be loaded.
+ * JPEG, PNG, GIF, BMP, TIFF, WebP, PSD, DDS and KTX sizes are read from the file header.
+ * Results are cached (and persisted between runs), and it's safe to use from any thread.
+ * NOTE: This can be VERY slow for other formats, if the image needs to be loaded.
  */
 class ImageMetaData {
 public:
@@ -0,0 +1,88 @@
+#include "ds/debug/profiler.h"
+
+#include <new>
+#include <stdint.h>
+#include "ds_test.h"
+
+/**
+ * The replacement operator new from a DS_TRACK_ALLOCATIONS build: every form
+ * is counted, over-aligned types get their alignment, and failures go through
+ * the new handler before throwing.
+ */
+
+namespace {
+
+int						HANDLER_CALLS = 0;
+
+// Gives up on the second call, so the allocation throws
+void					giving_up_handler() {
+	if (++HANDLER_CALLS >= 2) std::set_new_handler(nullptr);
+}
+
+unsigned long long		thread_allocs() {
+	unsigned long long	count = 0, bytes = 0;
+	ds::Profiler::getThreadAllocations(count, bytes);
+	return count;
+}
+
+#ifdef __cpp_aligned_new
+struct alignas(128) Wide {
+	char				mData[128];
+};
+#endif
+
+}
+
+int main() {
+	DS_CHECK(ds::Profiler::tracksAllocations());
+
+	// volatile so the compiler can't elide the allocations
+	int* volatile			single = nullptr;
+	int* volatile			array = nullptr;
+	unsigned long long		before = thread_allocs();
+	single = new int(1);
+	array = new int[16];
+	int* volatile			quiet = new (std::nothrow) int(2);
+	DS_CHECK_EQ(thread_allocs() - before, 3u);
+	delete single;
+	delete[] array;
+	delete quiet;
+
+#ifdef __cpp_aligned_new
+	before = thread_allocs();
+	Wide* volatile			wide = new Wide();
+	Wide* volatile			wides = new Wide[4];
+	Wide* volatile			quietWide = new (std::nothrow) Wide();
+	DS_CHECK_EQ(thread_allocs() - before, 3u);
+	DS_CHECK(reinterpret_cast<uintptr_t>(wide) % 128 == 0);
+	DS_CHECK(reinterpret_cast<uintptr_t>(wides) % 128 == 0);
+	DS_CHECK(reinterpret_cast<uintptr_t>(quietWide) % 128 == 0);
+	delete wide;
+	delete[] wides;
+	delete quietWide;
+#else
+	std::cout << "no aligned new in this language mode, skipping the align_val_t forms" << std::endl;
+#endif
+
+	// An allocation that can't succeed runs the handler until it gives up
+	volatile size_t			huge = static_cast<size_t>(-1) / 2;
+	bool					threw = false;
+	std::set_new_handler(giving_up_handler);
+	try {
+		char* volatile		p = new char[huge];
+		delete[] p;
+	} catch (std::bad_alloc const&) {
+		threw = true;
+	}
+	DS_CHECK(threw);
+	DS_CHECK_EQ(HANDLER_CALLS, 2);
+
+	// The nothrow form runs it too, then answers null
+	HANDLER_CALLS = 0;
+	std::set_new_handler(giving_up_handler);
+	char* volatile			none = new (std::nothrow) char[huge];
+	DS_CHECK(none == nullptr);
+	DS_CHECK_EQ(HANDLER_CALLS, 2);
+
+	return ds::test::result("allocation_tracking_test");
+}
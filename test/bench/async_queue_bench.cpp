@@ -0,0 +1,124 @@
+#include "ds/thread/async_queue.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ds_test.h"
+#include "bench/bench.h"
+
+/**
+ * 8 producer threads pushing into one queue while the main thread updates,
+ * against the mutex and copied vector AsyncQueue used to be. Checks every
+ * entry arrives once, in order per producer, and that a bounded queue
+ * accounts for every push it drops.
+ */
+
+namespace {
+
+const int					PRODUCERS = 8;
+const int					PER_PRODUCER = 250000;
+const int					REPS = 3;
+
+// Producer in the high byte, sequence in the rest
+int							make_entry(const int producer, const int seq) { return (producer << 24) | seq; }
+
+// The previous implementation: push and update share a mutex, and update copies the vector
+class LockedQueue {
+public:
+	bool					push(const int& t) {
+		std::lock_guard<std::mutex>	l(mMutex);
+		mLockedQueue.push_back(t);
+		return true;
+	}
+	const std::vector<int>*	update() {
+		{
+			std::lock_guard<std::mutex>	l(mMutex);
+			mUpdateQueue = mLockedQueue;
+			mLockedQueue.clear();
+		}
+		return mUpdateQueue.empty() ? nullptr : &mUpdateQueue;
+	}
+
+private:
+	std::mutex				mMutex;
+	std::vector<int>		mLockedQueue, mUpdateQueue;
+};
+
+// Answers the number of entries received. Fills next with the next expected sequence per producer.
+template <typename Q>
+size_t						contend(Q& q, std::vector<int>& next, bool& ordered) {
+	std::atomic<int>		finished(0);
+	std::vector<std::thread>	threads;
+	for (int p = 0; p < PRODUCERS; ++p) {
+		threads.push_back(std::thread([&q, &finished, p]() {
+			for (int k = 0; k < PER_PRODUCER; ++k) q.push(make_entry(p, k));
+			++finished;
+		}));
+	}
+
+	next.assign(PRODUCERS, 0);
+	ordered = true;
+	size_t					received = 0;
+	auto					drain = [&]() {
+		const std::vector<int>*	entries = q.update();
+		if (!entries) return;
+		for (auto it = entries->begin(), end = entries->end(); it != end; ++it) {
+			const int		p = *it >> 24, seq = *it & 0xffffff;
+			if (p < 0 || p >= PRODUCERS || seq < next[p]) {
+				ordered = false;
+				continue;
+			}
+			next[p] = seq + 1;
+		}
+		received += entries->size();
+	};
+	while (finished.load() < PRODUCERS) drain();
+	for (auto it = threads.begin(), end = threads.end(); it != end; ++it) it->join();
+	drain();
+	return received;
+}
+
+}
+
+int main() {
+	const size_t				total = static_cast<size_t>(PRODUCERS) * PER_PRODUCER;
+	std::vector<int>			next;
+	bool						ordered = false;
+
+	size_t						received = 0;
+	ds::test::print_ms("8 producers, mutex + copied vector", ds::test::best_ms(REPS, [&]() {
+		LockedQueue				q;
+		received = contend(q, next, ordered);
+	}));
+	DS_CHECK_EQ(received, total);
+
+	size_t						highWater = 0, depth = 1;
+	ds::test::print_ms("8 producers, lock-free AsyncQueue", ds::test::best_ms(REPS, [&]() {
+		ds::AsyncQueue<int>		q;
+		received = contend(q, next, ordered);
+		highWater = q.getHighWater();
+		depth = q.getDepth();
+	}));
+	std::cout << "  high water " << highWater << std::endl;
+	DS_CHECK_EQ(received, total);
+	DS_CHECK(ordered);
+	for (int p = 0; p < PRODUCERS; ++p) DS_CHECK_EQ(next[p], PER_PRODUCER);
+	DS_CHECK_EQ(depth, 0u);
+	DS_CHECK(highWater > 0 && highWater <= total);
+
+	// Bounded: whatever didn't fit is dropped and counted, the rest still arrives in order
+	size_t						dropped = 0;
+	ds::test::print_ms("8 producers, AsyncQueue bounded to 1024", ds::test::best_ms(REPS, [&]() {
+		ds::AsyncQueue<int>		q(1024);
+		received = contend(q, next, ordered);
+		dropped = q.getDropped();
+		highWater = q.getHighWater();
+	}));
+	std::cout << "  received " << received << ", dropped " << dropped << std::endl;
+	DS_CHECK_EQ(received + dropped, total);
+	DS_CHECK(ordered);
+	DS_CHECK(highWater <= 1024u);
+
+	return ds::test::result("async_queue_bench");
+}
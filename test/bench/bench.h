@@ -0,0 +1,39 @@
+#pragma once
+#ifndef DS_TEST_BENCH_BENCH_H_
+#define DS_TEST_BENCH_BENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/**
+ * Timing helpers for the programs under test/bench/. Each run reports the
+ * best of a few repetitions, which is the least noisy number on a busy machine.
+ */
+namespace ds {
+namespace test {
+
+// Milliseconds for the fastest of reps calls to fn.
+template <typename Fn>
+double					best_ms(const int reps, Fn fn) {
+	double				best = 0.0;
+	for (int i = 0; i < reps; ++i) {
+		const auto		start = std::chrono::steady_clock::now();
+		fn();
+		const double	ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		best = (i == 0 ? ms : std::min(best, ms));
+	}
+	return best;
+}
+
+inline void				print_ms(const std::string& label, const double ms) {
+	std::cout << std::left << std::setw(48) << label << std::right << std::fixed << std::setprecision(3)
+			  << std::setw(10) << ms << " ms" << std::endl;
+}
+
+} // namespace test
+} // namespace ds
+
+#endif // DS_TEST_BENCH_BENCH_H_
@@ -0,0 +1,69 @@
+#pragma once
+#ifndef DS_TEST_BENCH_HEADLESSRUN_H_
+#define DS_TEST_BENCH_HEADLESSRUN_H_
+
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <Poco/Path.h>
+#include "ds/app/engine/engine_data.h"
+#include "ds/app/engine/engine_headless.h"
+#include "ds/app/engine/engine_settings.h"
+
+/**
+ * Runs a scene through an EngineHeadless for the programs under test/bench/.
+ * The report goes to the temp folder, and comes back as text.
+ */
+namespace ds {
+namespace test {
+
+const double			HEADLESS_DT = 1.0 / 60.0;
+
+// Build the scene in a fresh engine and run it. check gets the engine before it's
+// destroyed, and configure gets the settings before the engine is made. Answers the
+// report, or an empty string if the run failed.
+inline std::string		run_headless(	const std::string& name, const int warmupFrames, const int frames,
+										const std::function<void(ds::Engine&)>& build,
+										const std::function<void(ds::Engine&)>& check,
+										const std::function<void(ds::cfg::Settings::Editor&)>& configure = nullptr) {
+	Poco::Path			path(Poco::Path::temp());
+	path.setFileName("ds_headless_" + name + ".json");
+
+	ds::EngineSettings	settings;
+	ds::cfg::Settings::Editor(settings)
+		.setFloat("headless:dt", static_cast<float>(HEADLESS_DT))
+		.setInt("headless:warmup_frames", warmupFrames)
+		.setInt("headless:frames", frames)
+		.setText("headless:report_path", path.toString())
+		.setSize("world_dimensions", ci::vec2(1920.0f, 1080.0f))
+		.setText("console:show", "false");
+	if (configure) {
+		ds::cfg::Settings::Editor	editor(settings);
+		configure(editor);
+	}
+	ds::EngineData		data(settings);
+	ds::EngineHeadless	engine(settings, data, ds::RootList());
+	if (!engine.run(build)) return std::string();
+	if (check) check(engine);
+
+	std::ifstream		is(path.toString().c_str());
+	std::stringstream	ss;
+	ss << is.rdbuf();
+	return ss.str();
+}
+
+// The number after the first key that follows after, or -1 if it isn't there.
+// Good enough for the flat reports EngineHeadless writes.
+inline double			report_value(const std::string& report, const std::string& after, const std::string& key) {
+	size_t				at = report.find(after);
+	if (at == std::string::npos) return -1.0;
+	at = report.find("\"" + key + "\":", at);
+	if (at == std::string::npos) return -1.0;
+	return std::stod(report.substr(at + key.size() + 3));
+}
+
+} // namespace test
+} // namespace ds
+
+#endif // DS_TEST_BENCH_HEADLESSRUN_H_
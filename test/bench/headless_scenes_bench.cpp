@@ -0,0 +1,196 @@
+#include "ds/app/engine/engine_headless.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include "ds/ui/layout/layout_sprite.h"
+#include "ds/ui/sprite/text.h"
+#include "ds_test.h"
+#include "bench/bench.h"
+#include "bench/headless_run.h"
+
+/**
+ * EngineHeadless through three scenes, with no window and no GL: a 10k sprite
+ * grid that moves every frame, a deep layout that reflows every frame, and a
+ * scroll list that recycles its rows. Prints the mean update from each report,
+ * and checks each scene ended where the fixed clock says it should.
+ */
+
+namespace {
+
+const int					WARMUP_FRAMES = 30;
+const int					FRAMES = 300;
+
+// Moves sideways on a sine of the engine time
+class GridCell : public ds::ui::Sprite {
+public:
+	GridCell(ds::ui::SpriteEngine& e, const float x, const float y, const float phase)
+			: ds::ui::Sprite(e, 12.0f, 12.0f), mX(x), mY(y), mPhase(phase) {
+		setTransparent(false);
+		setColor(ci::Color(0.2f, 0.5f, phase / 10.0f));
+		setPosition(x, y);
+	}
+
+	float					expectedX(const float t) const	{ return mX + 3.0f * std::sin(t + mPhase); }
+
+protected:
+	virtual void			onUpdateServer(const ds::UpdateParams& p) {
+		setPosition(expectedX(p.getElapsedTime()), mY);
+	}
+
+private:
+	const float				mX, mY, mPhase;
+};
+
+// A vertical layout that changes its first leaf every frame and lays itself out again
+class ReflowLayout : public ds::ui::LayoutSprite {
+public:
+	ReflowLayout(ds::ui::SpriteEngine& e) : ds::ui::LayoutSprite(e), mFrame(0), mLeaf(nullptr) { }
+
+	int						mFrame;
+	ds::ui::Sprite*			mLeaf;
+
+protected:
+	virtual void			onUpdateServer(const ds::UpdateParams&) {
+		++mFrame;
+		if (mLeaf) mLeaf->mLayoutSize = ci::vec2(200.0f, 10.0f + static_cast<float>(mFrame % 10));
+		runLayout();
+	}
+};
+
+// Rows in a clipped viewport, scrolled at a fixed speed. Rows that leave the top move to the bottom.
+class ScrollList : public ds::ui::Sprite {
+public:
+	static const int		ITEMS = 5000;
+	static const int		ROWS = 15;
+	static const float		ROW_HEIGHT;
+	static const float		SPEED;
+
+	ScrollList(ds::ui::SpriteEngine& e) : ds::ui::Sprite(e, 600.0f, ROW_HEIGHT * (ROWS - 1)), mContent(nullptr), mFirst(0) {
+		setClipping(true);
+		mContent = addChildPtr(new ds::ui::Sprite(e));
+		for (int i = 0; i < ROWS; ++i) {
+			ds::ui::Sprite*	row = mContent->addChildPtr(new ds::ui::Sprite(e, 600.0f, ROW_HEIGHT));
+			row->setTransparent(false);
+			ds::ui::Text*	label = row->addChildPtr(new ds::ui::Text(e));
+			label->setTextStyle("Sans", 20.0f, ci::Color::white());
+			label->setPosition(10.0f, 10.0f);
+			mRows.push_back(row);
+			mLabels.push_back(label);
+			fill(i, i);
+		}
+	}
+
+	float					getScroll() const					{ return -mContent->getPosition().y; }
+	int						getFirst() const					{ return mFirst; }
+	// Rows are contiguous from the first item, and each shows its item
+	bool					rowsInOrder() const {
+		for (int i = 0; i < ROWS; ++i) {
+			const int		slot = (mFirst + i) % ROWS;
+			const int		item = (mFirst + i) % ITEMS;
+			if (std::abs(mRows[slot]->getPosition().y - (mFirst + i) * ROW_HEIGHT) > 0.01f) return false;
+			if (mLabels[slot]->getTextAsString() != label(item)) return false;
+		}
+		return true;
+	}
+
+protected:
+	virtual void			onUpdateServer(const ds::UpdateParams& p) {
+		mContent->setPosition(0.0f, -SPEED * p.getElapsedTime());
+		while ((mFirst + 1) * ROW_HEIGHT <= getScroll()) {
+			fill(mFirst % ROWS, mFirst + ROWS);
+			++mFirst;
+		}
+	}
+
+private:
+	static std::string		label(const int item)				{ return "Row " + std::to_string(item); }
+
+	void					fill(const int slot, const int index) {
+		mRows[slot]->setPosition(0.0f, index * ROW_HEIGHT);
+		mRows[slot]->setColor(index % 2 ? ci::Color(0.2f, 0.2f, 0.2f) : ci::Color(0.3f, 0.3f, 0.3f));
+		mLabels[slot]->setText(label(index % ITEMS));
+	}
+
+	ds::ui::Sprite*			mContent;
+	std::vector<ds::ui::Sprite*>	mRows;
+	std::vector<ds::ui::Text*>		mLabels;
+	int						mFirst;
+};
+
+const float					ScrollList::ROW_HEIGHT = 60.0f;
+const float					ScrollList::SPEED = 600.0f;
+
+// Runs one scene in a fresh engine, then hands the engine to check
+void						run_scene(const std::string& name, const std::function<void(ds::Engine&)>& build,
+									  const std::function<void(ds::Engine&)>& check) {
+	const std::string		report = ds::test::run_headless(name, WARMUP_FRAMES, FRAMES, build, check);
+	DS_CHECK(!report.empty());
+	const double			ms = ds::test::report_value(report, "\"update_ms\"", "mean");
+	DS_CHECK(ms >= 0.0);
+	ds::test::print_ms(name + " mean update", ms);
+}
+
+}
+
+int main() {
+	// The last update ran at this time
+	const float				end = static_cast<float>(ds::test::HEADLESS_DT * (WARMUP_FRAMES + FRAMES));
+
+	std::vector<GridCell*>	cells;
+	run_scene("grid_10k", [&cells](ds::Engine& e) {
+		ds::ui::Sprite&		root = e.getRootSprite();
+		for (int y = 0; y < 100; ++y) {
+			for (int x = 0; x < 100; ++x) {
+				cells.push_back(root.addChildPtr(new GridCell(e, 20.0f + x * 16.0f, 20.0f + y * 10.0f, (x + y) * 0.1f)));
+			}
+		}
+	}, [&cells, end](ds::Engine&) {
+		DS_CHECK_EQ(cells.size(), static_cast<size_t>(10000));
+		size_t				wrong = 0;
+		for (auto it = cells.begin(), stop = cells.end(); it != stop; ++it) {
+			if (std::abs((*it)->getPosition().x - (*it)->expectedX(end)) > 0.01f) ++wrong;
+		}
+		DS_CHECK_EQ(wrong, static_cast<size_t>(0));
+	});
+
+	// 12 levels, each a title, a body and the next level down
+	ReflowLayout*			top = nullptr;
+	run_scene("deep_layout", [&top](ds::Engine& e) {
+		top = e.getRootSprite().addChildPtr(new ReflowLayout(e));
+		ds::ui::LayoutSprite*	level = top;
+		for (int depth = 0; depth < 12; ++depth) {
+			level->setLayoutType(depth % 2 ? ds::ui::LayoutSprite::kLayoutHFlow : ds::ui::LayoutSprite::kLayoutVFlow);
+			level->setShrinkToChildren(ds::ui::LayoutSprite::kShrinkBoth);
+			level->setSpacing(4.0f);
+			ds::ui::Sprite*	leaf = level->addChildPtr(new ds::ui::Sprite(e));
+			leaf->mLayoutSize = ci::vec2(200.0f, 10.0f);
+			if (!top->mLeaf) top->mLeaf = leaf;
+			ds::ui::Text*	body = level->addChildPtr(new ds::ui::Text(e));
+			body->setTextStyle("Sans", 14.0f);
+			body->setText("Level " + std::to_string(depth) + ", laid out again every frame");
+			body->mLayoutUserType = ds::ui::LayoutSprite::kFlexSize;
+			if (depth < 11) level = level->addChildPtr(new ds::ui::LayoutSprite(e));
+		}
+	}, [&top](ds::Engine&) {
+		DS_CHECK_EQ(top->mFrame, WARMUP_FRAMES + FRAMES);
+		DS_CHECK_EQ(top->mLeaf->getHeight(), 10.0f + static_cast<float>(top->mFrame % 10));
+		// A shrinking vertical flow is exactly as tall as its children and the spacing between them
+		float				height = 0.0f;
+		const std::vector<ds::ui::Sprite*>&	children = top->getChildren();
+		for (auto it = children.begin(), stop = children.end(); it != stop; ++it) height += (*it)->getScaleHeight();
+		height += 4.0f * static_cast<float>(children.size() - 1);
+		DS_CHECK(std::abs(top->getHeight() - height) < 0.01f);
+	});
+
+	ScrollList*				list = nullptr;
+	run_scene("scroll_list", [&list](ds::Engine& e) {
+		list = e.getRootSprite().addChildPtr(new ScrollList(e));
+	}, [&list, end](ds::Engine&) {
+		DS_CHECK(std::abs(list->getScroll() - ScrollList::SPEED * end) < 0.5f);
+		DS_CHECK_EQ(list->getFirst(), static_cast<int>(list->getScroll() / ScrollList::ROW_HEIGHT));
+		DS_CHECK(list->rowsInOrder());
+	});
+
+	return ds::test::result("headless_scenes_bench");
+}
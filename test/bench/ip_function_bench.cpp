@@ -0,0 +1,116 @@
+#include <string.h>
+#include <vector>
+#include <cinder/Surface.h>
+#include "ds/ui/ip/ip_defs.h"
+#include "ds/ui/ip/ip_function_list.h"
+#include "ds/ui/ip/ip_simd.h"
+#include "ds/ui/ip/functions/ip_circle_mask.h"
+#include "ds_test.h"
+#include "bench/bench.h"
+
+/**
+ * The built-in ip functions on 1080p and 4K surfaces: each SIMD level on one
+ * thread, then tiled across the thread pool, then chained. Every variant has
+ * to match the original per-pixel circle mask exactly.
+ */
+
+namespace {
+
+const int					REPS = 5;
+
+void						fill(ci::Surface8u& s) {
+	uint8_t*				p = s.getData();
+	const size_t			size = s.getRowBytes() * s.getHeight();
+	for (size_t i = 0; i < size; ++i) p[i] = static_cast<uint8_t>((i * 7 + 13) & 0xff);
+}
+
+// The per-pixel loop CircleMask used before it was a row kernel
+void						reference_circle_mask(ci::Surface8u& s) {
+	const int32_t			w = s.getWidth(), h = s.getHeight();
+	const float				cx = static_cast<float>(w) / 2.0f, cy = static_cast<float>(h) / 2.0f;
+	float					max = (cx <= cy ? cx : cy);
+	max = max * max;
+	ci::Surface8u::Iter		iter = s.getIter();
+	int32_t					y = 0;
+	while (iter.line()) {
+		int32_t				x = 0;
+		while (iter.pixel()) {
+			const float		dx = cx - static_cast<float>(x), dy = cy - static_cast<float>(y);
+			const float		d = dx * dx + dy * dy;
+			float			alpha_f = 1.0f;
+			if (d > max) alpha_f = 0.0f;
+			else if (d > max - 1.0f) alpha_f = 1.0f - (d - (max - 1.0f));
+			int32_t			a = static_cast<int32_t>(static_cast<float>(iter.a()) * alpha_f);
+			if (a < 0) a = 0;
+			else if (a > 255) a = 255;
+			iter.a() = static_cast<uint8_t>(a);
+			++x;
+		}
+		++y;
+	}
+}
+
+bool						same(const ci::Surface8u& a, const ci::Surface8u& b) {
+	return memcmp(a.getData(), b.getData(), a.getRowBytes() * a.getHeight()) == 0;
+}
+
+void						run(const int w, const int h, const ds::ui::ip::FunctionList& list) {
+	const std::string		size = std::to_string(w) + "x" + std::to_string(h);
+	ci::Surface8u			src(w, h, true, ci::SurfaceChannelOrder::RGBA), expected, work;
+	fill(src);
+	expected = src.clone();
+	ds::test::print_ms(size + " reference per-pixel", ds::test::best_ms(REPS, [&]() {
+		expected = src.clone();
+		reference_circle_mask(expected);
+	}));
+
+	ds::ui::ip::CircleMask	mask;
+	const char*				names[] = { "scalar", "sse2", "avx2" };
+	for (int level = ds::ui::ip::simd::LEVEL_SCALAR; level <= ds::ui::ip::simd::LEVEL_AVX2; ++level) {
+		ds::ui::ip::simd::setMaxLevel(level);
+		if (ds::ui::ip::simd::getLevel() != level) continue;
+		ds::test::print_ms(size + " circle_mask " + names[level] + ", 1 thread", ds::test::best_ms(REPS, [&]() {
+			work = src.clone();
+			mask.on("", work);
+		}));
+		DS_CHECK(same(work, expected));
+	}
+	ds::ui::ip::simd::setMaxLevel(ds::ui::ip::simd::LEVEL_AVX2);
+
+	const ds::ui::ip::FunctionRef	tiled = list.find(ds::ui::ip::CIRCLE_MASK);
+	ds::test::print_ms(size + " circle_mask tiled", ds::test::best_ms(REPS, [&]() {
+		work = src.clone();
+		tiled.on("", work);
+	}));
+	DS_CHECK(same(work, expected));
+
+	// Masking twice is a single pass when chained, and two when not
+	ci::Surface8u			twice = expected.clone();
+	reference_circle_mask(twice);
+	const std::string		chainKey = ds::ui::ip::CIRCLE_MASK + ds::ui::ip::CHAIN_SEPARATOR + ds::ui::ip::CIRCLE_MASK;
+	const std::string		chainParams(1, ds::ui::ip::CHAIN_SEPARATOR);
+	const ds::ui::ip::FunctionRef	chain = list.find(chainKey);
+	DS_CHECK(!chain.empty());
+	ds::test::print_ms(size + " circle_mask x2 chained", ds::test::best_ms(REPS, [&]() {
+		work = src.clone();
+		chain.on(chainParams, work);
+	}));
+	DS_CHECK(same(work, twice));
+	ds::test::print_ms(size + " circle_mask x2 separate", ds::test::best_ms(REPS, [&]() {
+		work = src.clone();
+		tiled.on("", work);
+		tiled.on("", work);
+	}));
+	DS_CHECK(same(work, twice));
+}
+
+}
+
+int main() {
+	ds::ui::ip::FunctionList	list;
+	list.add(ds::ui::ip::CIRCLE_MASK, ds::ui::ip::FunctionRef(new ds::ui::ip::CircleMask()));
+
+	run(1920, 1080, list);
+	run(3840, 2160, list);
+	return ds::test::result("ip_function_bench");
+}
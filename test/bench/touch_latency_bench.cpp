@@ -0,0 +1,179 @@
+#include "ds/ui/touch/touch_manager.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <Poco/Path.h>
+#include "ds/ui/touch/multi_touch_constraints.h"
+#include "ds/ui/touch/touch_event.h"
+#include "ds/ui/touch/touch_info.h"
+#include "ds_test.h"
+#include "bench/bench.h"
+#include "bench/headless_run.h"
+
+/**
+ * What touch:late_latch and touch:predict:ms buy, on ten fingers dragging
+ * sprites in circles through EngineHeadless. Prints how many frames a move
+ * waits between arriving and reaching its sprite with and without late
+ * latching, the mean from touch:latency_log, and how far the predicted point
+ * is from where the finger really is touch:predict:ms later, against the
+ * plain point. Smoothing is off, so the predictor is measured on its own.
+ */
+
+namespace {
+
+const int					FINGERS = 10;
+const int					WARMUP_FRAMES = 30;
+const int					FRAMES = 600;
+const float					RADIUS = 100.0f;
+// Radians a second, so fingers move at 600 px/s
+const float					SPEED = 6.0f;
+const float					PREDICT_MS = 33.0f;
+
+ci::vec2					home(const int finger) {
+	return ci::vec2(250.0f + (finger % 5) * 350.0f, 300.0f + (finger / 5) * 450.0f);
+}
+
+ci::vec2					finger_pos(const int finger, const double t) {
+	const float				a = static_cast<float>(t) * SPEED + static_cast<float>(finger);
+	return home(finger) + RADIUS * ci::vec2(std::cos(a), std::sin(a));
+}
+
+// Puts every finger down on the first frame and moves them every frame after, stamped with the engine time
+class Driver : public ds::ui::Sprite {
+public:
+	Driver(ds::ui::SpriteEngine& e) : ds::ui::Sprite(e), mFrame(0) {
+		mTouches.reserve(FINGERS);
+	}
+
+	int						mFrame;
+
+protected:
+	virtual void			onUpdateServer(const ds::UpdateParams&) {
+		ds::Engine&			engine = static_cast<ds::Engine&>(mEngine);
+		const double		t = engine.getElapsedTimeSeconds();
+		mTouches.clear();
+		for (int f = 0; f < FINGERS; ++f) {
+			const ci::vec2	p = finger_pos(f, t);
+			mTouches.push_back(ci::app::TouchEvent::Touch(p, finger_pos(f, t - ds::test::HEADLESS_DT), static_cast<uint32_t>(f), t, nullptr));
+		}
+		const ds::ui::TouchEvent	event(ci::app::WindowRef(), mTouches, true);
+		if (mFrame == 0) engine.injectTouchesBegin(event);
+		else engine.injectTouchesMoved(event);
+		++mFrame;
+	}
+
+private:
+	std::vector<ci::app::TouchEvent::Touch>	mTouches;
+};
+
+// What the sprites saw of the moves
+struct Moves {
+	Moves() : mCount(0), mLagFrames(0.0), mPlainError(0.0), mPredictedError(0.0) { }
+
+	int						mCount;
+	double					mLagFrames;
+	double					mPlainError;
+	double					mPredictedError;
+};
+
+// The mean oldest_ms column of a latency log, or -1 if it has no rows
+double						mean_latency(const std::string& path) {
+	std::ifstream			is(path.c_str());
+	std::string				line;
+	std::getline(is, line);
+	double					total = 0.0;
+	int						rows = 0;
+	while (std::getline(is, line)) {
+		std::stringstream	ss(line);
+		std::string			field;
+		for (int i = 0; i < 4 && std::getline(ss, field, ','); ++i) { }
+		total += std::stod(field);
+		++rows;
+	}
+	return rows > 0 ? total / rows : -1.0;
+}
+
+// One run with the given late latch and prediction
+Moves						run(const std::string& name, const bool lateLatch, const float predictMs) {
+	Poco::Path				logPath(Poco::Path::temp());
+	logPath.setFileName("ds_touch_latency_" + name + ".csv");
+
+	Moves					moves;
+	Driver*					driver = nullptr;
+	const std::string		report = ds::test::run_headless(name, WARMUP_FRAMES, FRAMES,
+		[&moves, &driver](ds::Engine& e) {
+			ds::ui::Sprite&	root = e.getRootSprite();
+			for (int f = 0; f < FINGERS; ++f) {
+				ds::ui::Sprite*	s = root.addChildPtr(new ds::ui::Sprite(e, 240.0f, 240.0f));
+				s->setTransparent(false);
+				s->setCenter(0.5f, 0.5f);
+				s->setPosition(home(f).x, home(f).y);
+				s->enable(true);
+				s->enableMultiTouch(ds::ui::MULTITOUCH_CAN_POSITION);
+				s->setProcessTouchCallback([&moves, &e](ds::ui::Sprite*, const ds::ui::TouchInfo& ti) {
+					if (ti.mPhase != ds::ui::TouchInfo::Moved || ti.mSampleCount < 1) return;
+					const double	t = ti.mSamples[ti.mSampleCount - 1].mTime;
+					const int		f = ti.mFingerId - 2;
+					// Where the finger really is when the prediction is aimed at
+					const ci::vec2	ahead = finger_pos(f, t + PREDICT_MS / 1000.0f);
+					const ci::vec2	plain(ti.mCurrentGlobalPoint);
+					const ci::vec2	predicted(ti.mCurrentGlobalPoint + ti.mPredictionOffset);
+					++moves.mCount;
+					moves.mLagFrames += std::floor((e.getElapsedTimeSeconds() - t) / ds::test::HEADLESS_DT + 0.5);
+					moves.mPlainError += glm::distance(ahead, plain);
+					moves.mPredictedError += glm::distance(ahead, predicted);
+				});
+			}
+			driver = root.addChildPtr(new Driver(e));
+		},
+		[&driver](ds::Engine&) {
+			DS_CHECK_EQ(driver->mFrame, WARMUP_FRAMES + FRAMES);
+		},
+		[lateLatch, predictMs, &logPath](ds::cfg::Settings::Editor& editor) {
+			editor.setText("touch_smoothing", "false")
+				.setText("touch:late_latch", lateLatch ? "true" : "false")
+				.setFloat("touch:predict:ms", predictMs)
+				.setFloat("touch:predict:acceleration", 1.0f)
+				.setFloat("touch:predict:max_distance", 100.0f)
+				.setText("touch:latency_log", logPath.toString());
+		});
+	DS_CHECK(!report.empty());
+	// Every finger moved every frame but the first
+	DS_CHECK(moves.mCount >= FINGERS * (WARMUP_FRAMES + FRAMES - 2));
+	if (moves.mCount > 0) {
+		moves.mLagFrames /= moves.mCount;
+		moves.mPlainError /= moves.mCount;
+		moves.mPredictedError /= moves.mCount;
+	}
+
+	const double			latency = mean_latency(logPath.toString());
+	DS_CHECK(latency >= 0.0);
+	ds::test::print_ms(name + " receive to end of frame", latency);
+	return moves;
+}
+
+}
+
+int main() {
+	const Moves				plain = run("touch_plain", false, 0.0f);
+	const Moves				latched = run("touch_late_latch", true, 0.0f);
+	const Moves				predicted = run("touch_predict", false, PREDICT_MS);
+
+	std::cout << "frames from arriving to the sprite: " << plain.mLagFrames << " plain, "
+			  << latched.mLagFrames << " late latched" << std::endl;
+	std::cout << "px from the finger " << PREDICT_MS << "ms on: " << predicted.mPlainError << " plain, "
+			  << predicted.mPredictedError << " predicted" << std::endl;
+
+	// Without late latching a move waits for the next update, with it the frame it arrived draws it
+	DS_CHECK(std::abs(plain.mLagFrames - 1.0) < 0.01);
+	DS_CHECK(std::abs(latched.mLagFrames) < 0.01);
+	// No prediction means no offset
+	DS_CHECK(std::abs(plain.mPredictedError - plain.mPlainError) < 0.001);
+	// On a smooth circle the guess lands much closer than where the finger was
+	DS_CHECK(predicted.mPredictedError < 0.25 * predicted.mPlainError);
+
+	return ds::test::result("touch_latency_bench");
+}
@@ -0,0 +1,133 @@
+#include "ds/ui/touch/touch_manager.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include "ds/ui/touch/multi_touch_constraints.h"
+#include "ds/ui/touch/touch_event.h"
+#include "ds_test.h"
+#include "bench/bench.h"
+#include "bench/headless_run.h"
+
+/**
+ * A 60 finger TUIO session replayed into EngineHeadless, each finger dragging
+ * its own sprite. Every frame arrives the way the TUIO receiver hands it over:
+ * at most one began, one moved and one ended event. The fingers lift and come
+ * down again every couple of seconds, so the finger table churns. Prints the
+ * touch dispatch and gesture phases from the report, and checks every sprite
+ * followed its finger.
+ */
+
+namespace {
+
+const int					FINGERS = 60;
+const int					WARMUP_FRAMES = 60;
+const int					FRAMES = 1200;
+// Fingers lift after this many frames down, and come back down the frame after
+const int					HOLD_FRAMES = 150;
+const float					RADIUS = 40.0f;
+
+ci::vec2					home(const int finger) {
+	return ci::vec2(160.0f + (finger % 10) * 170.0f, 160.0f + (finger / 10) * 150.0f);
+}
+
+// Where a finger is on a frame it's down
+ci::vec2					finger_pos(const int finger, const int frame) {
+	const float				a = static_cast<float>(frame) * 0.05f + static_cast<float>(finger);
+	return home(finger) + RADIUS * ci::vec2(std::cos(a), std::sin(a));
+}
+
+// Injects one TUIO frame a frame. Sits last in the root, so the sprites it touches are already there.
+class Replay : public ds::ui::Sprite {
+public:
+	Replay(ds::ui::SpriteEngine& e) : ds::ui::Sprite(e), mFrame(0), mSession(0) {
+		mBegan.reserve(FINGERS);
+		mMoved.reserve(FINGERS);
+		mEnded.reserve(FINGERS);
+	}
+
+	int						mFrame;
+	int						mSession;
+
+protected:
+	virtual void			onUpdateServer(const ds::UpdateParams&) {
+		ds::Engine&			engine = static_cast<ds::Engine&>(mEngine);
+		const int			phase = mFrame % (HOLD_FRAMES + 1);
+		mBegan.clear();
+		mMoved.clear();
+		mEnded.clear();
+		for (int f = 0; f < FINGERS; ++f) {
+			// Each touch down is a new TUIO session id
+			const uint32_t	id = static_cast<uint32_t>(mSession * FINGERS + f);
+			if (phase == 0) {
+				const ci::vec2	p = finger_pos(f, mFrame);
+				mBegan.push_back(ci::app::TouchEvent::Touch(p, p, id, 0.0, nullptr));
+			} else if (phase < HOLD_FRAMES) {
+				mMoved.push_back(ci::app::TouchEvent::Touch(finger_pos(f, mFrame), finger_pos(f, mFrame - 1), id, 0.0, nullptr));
+			} else {
+				const ci::vec2	p = finger_pos(f, mFrame - 1);
+				mEnded.push_back(ci::app::TouchEvent::Touch(p, p, id, 0.0, nullptr));
+			}
+		}
+		if (!mBegan.empty()) engine.injectTouchesBegin(ds::ui::TouchEvent(ci::app::WindowRef(), mBegan, true));
+		if (!mMoved.empty()) engine.injectTouchesMoved(ds::ui::TouchEvent(ci::app::WindowRef(), mMoved, true));
+		if (!mEnded.empty()) {
+			engine.injectTouchesEnded(ds::ui::TouchEvent(ci::app::WindowRef(), mEnded, true));
+			++mSession;
+		}
+		++mFrame;
+	}
+
+private:
+	std::vector<ci::app::TouchEvent::Touch>	mBegan, mMoved, mEnded;
+};
+
+}
+
+int main() {
+	std::vector<ds::ui::Sprite*>	targets;
+	Replay*					replay = nullptr;
+	const std::string		report = ds::test::run_headless("touch_replay", WARMUP_FRAMES, FRAMES,
+		[&targets, &replay](ds::Engine& e) {
+			ds::ui::Sprite&	root = e.getRootSprite();
+			for (int f = 0; f < FINGERS; ++f) {
+				ds::ui::Sprite*	s = root.addChildPtr(new ds::ui::Sprite(e, 120.0f, 120.0f));
+				s->setTransparent(false);
+				s->setCenter(0.5f, 0.5f);
+				s->setPosition(home(f).x, home(f).y);
+				s->enable(true);
+				s->enableMultiTouch(ds::ui::MULTITOUCH_CAN_POSITION);
+				targets.push_back(s);
+			}
+			replay = root.addChildPtr(new Replay(e));
+		},
+		[&targets, &replay](ds::Engine& e) {
+			DS_CHECK_EQ(replay->mFrame, WARMUP_FRAMES + FRAMES);
+			DS_CHECK(replay->mSession > 0);
+			// A drag moves the sprite by as much as the finger moved, so each one is still within reach of home
+			size_t			strays = 0, moved = 0;
+			for (int f = 0; f < FINGERS; ++f) {
+				const ci::vec2	p(targets[f]->getPosition());
+				if (glm::distance(p, home(f)) > 2.0f * RADIUS + 1.0f) ++strays;
+				if (glm::distance(p, home(f)) > 1.0f) ++moved;
+			}
+			DS_CHECK_EQ(strays, static_cast<size_t>(0));
+			DS_CHECK_EQ(moved, static_cast<size_t>(FINGERS));
+			// Every finger has been lifted or is down on its own sprite
+			for (int f = 0; f < FINGERS; ++f) {
+				ds::ui::Sprite*	s = e.getTouchManager().getSpriteForFinger(replay->mSession * FINGERS + f + 2);
+				if (s) DS_CHECK(s == targets[f]);
+			}
+		});
+	DS_CHECK(!report.empty());
+
+	const double			dispatch = ds::test::report_value(report, "/touch dispatch\"", "mean_ms");
+	const double			gestures = ds::test::report_value(report, "/gestures\"", "mean_ms");
+	const double			update = ds::test::report_value(report, "\"update_ms\"", "mean");
+	DS_CHECK(dispatch >= 0.0 && gestures >= 0.0 && update >= 0.0);
+	ds::test::print_ms("60 fingers, touch dispatch per frame", dispatch);
+	ds::test::print_ms("60 fingers, gestures per frame", gestures);
+	ds::test::print_ms("60 fingers, whole update per frame", update);
+
+	return ds::test::result("touch_replay_bench");
+}
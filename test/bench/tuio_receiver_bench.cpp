@@ -0,0 +1,236 @@
+#include "ds/ui/touch/tuio_receiver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <Poco/Timestamp.h>
+#include "ds_test.h"
+#include "bench/bench.h"
+
+/**
+ * Recorded TUIO sessions played through TuioReceiver::receive(), the way the
+ * receive thread hands it packets: 10 and 60 fingers in TUIO 1.1 bundles, and
+ * 60 in TUIO 2.0. Fingers move in circles and all lift every couple of
+ * seconds. Checks every touch comes out as one began, moves and one ended, at
+ * most one event of each a frame, and prints the time per packet, the
+ * touches a second, handlers included, and the p50, p99 and max time from
+ * receive() being called until each handler runs.
+ */
+
+namespace {
+
+const int					FRAMES = 1200;
+// Fingers are down this many frames, then lift for one
+const int					HOLD_FRAMES = 119;
+const int					REPS = 5;
+const ci::vec2				SCALE(1920.0f, 1080.0f);
+// Pixels a touch can be off by after the float round trip
+const float					TOLERANCE = 0.01f;
+
+// Writes one OSC message
+class OscMessage {
+public:
+	OscMessage(const std::string& address, const std::string& types) {
+		string(address);
+		mData.push_back(',');
+		string(types);
+	}
+
+	OscMessage&				i(const int32_t v) {
+		const uint32_t		u = static_cast<uint32_t>(v);
+		for (int shift = 24; shift >= 0; shift -= 8) mData.push_back(static_cast<char>((u >> shift) & 0xff));
+		return *this;
+	}
+	OscMessage&				f(const float v) {
+		int32_t				bits;
+		memcpy(&bits, &v, sizeof(bits));
+		return i(bits);
+	}
+	OscMessage&				s(const std::string& v) {
+		string(v);
+		return *this;
+	}
+
+	const std::string&		data() const						{ return mData; }
+
+private:
+	// Zero terminated and padded to 4 bytes
+	void					string(const std::string& v) {
+		mData += v;
+		do { mData.push_back('\0'); } while (mData.size() % 4);
+	}
+
+	std::string				mData;
+};
+
+class OscBundle {
+public:
+	OscBundle() : mData("#bundle\0", 8) {
+		// Immediate time tag
+		mData.append(7, '\0');
+		mData.push_back('\1');
+	}
+
+	OscBundle&				add(const OscMessage& m) {
+		const uint32_t		n = static_cast<uint32_t>(m.data().size());
+		for (int shift = 24; shift >= 0; shift -= 8) mData.push_back(static_cast<char>((n >> shift) & 0xff));
+		mData += m.data();
+		return *this;
+	}
+
+	const std::string&		data() const						{ return mData; }
+
+private:
+	std::string				mData;
+};
+
+ci::vec2					finger_pos(const int finger, const int frame) {
+	const float				a = static_cast<float>(frame) * 0.05f + static_cast<float>(finger);
+	const ci::vec2			home(0.1f + 0.08f * (finger % 10), 0.15f + 0.12f * (finger / 10));
+	return home + 0.03f * ci::vec2(std::cos(a), std::sin(a));
+}
+
+// A frame lifts everything if it's the last of a hold
+bool						lifted(const int frame)			{ return frame % (HOLD_FRAMES + 1) == HOLD_FRAMES; }
+int32_t						session_id(const int fingers, const int finger, const int frame) {
+	return (frame / (HOLD_FRAMES + 1)) * fingers + finger;
+}
+
+// One packet a frame. Frame ids start at 1.
+std::vector<std::string>	record(const int fingers, const bool tuio2) {
+	std::vector<std::string>	packets;
+	for (int frame = 0; frame < FRAMES; ++frame) {
+		OscBundle			bundle;
+		const bool			up = lifted(frame);
+		if (tuio2) {
+			bundle.add(OscMessage("/tuio2/frm", "itsi").i(frame + 1).i(0).i(0).s("bench").i(0));
+			OscMessage		alive("/tuio2/alv", std::string(up ? 0 : fingers, 'i'));
+			for (int f = 0; f < fingers && !up; ++f) {
+				const ci::vec2	p = finger_pos(f, frame);
+				bundle.add(OscMessage("/tuio2/ptr", "iiiffffff").i(session_id(fingers, f, frame)).i(0).i(0)
+							.f(p.x).f(p.y).f(0.0f).f(0.0f).f(0.0f).f(1.0f));
+				alive.i(session_id(fingers, f, frame));
+			}
+			bundle.add(alive);
+		} else {
+			bundle.add(OscMessage("/tuio/2Dcur", "ss").s("source").s("bench"));
+			OscMessage		alive("/tuio/2Dcur", "s" + std::string(up ? 0 : fingers, 'i'));
+			alive.s("alive");
+			for (int f = 0; f < fingers && !up; ++f) alive.i(session_id(fingers, f, frame));
+			bundle.add(alive);
+			for (int f = 0; f < fingers && !up; ++f) {
+				const ci::vec2	p = finger_pos(f, frame);
+				bundle.add(OscMessage("/tuio/2Dcur", "sifffff").s("set").i(session_id(fingers, f, frame))
+							.f(p.x).f(p.y).f(0.0f).f(0.0f).f(0.0f));
+			}
+			bundle.add(OscMessage("/tuio/2Dcur", "si").s("fseq").i(frame + 1));
+		}
+		packets.push_back(bundle.data());
+	}
+	return packets;
+}
+
+double						percentile(std::vector<double> v, const double p) {
+	if (v.empty()) return 0.0;
+	std::sort(v.begin(), v.end());
+	const size_t			k = std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())));
+	return v[k];
+}
+
+struct Counts {
+	Counts() : mBegan(0), mMoved(0), mEnded(0), mEvents(0), mWrongPos(0) { }
+
+	long long				mBegan, mMoved, mEnded, mEvents, mWrongPos;
+};
+
+void						run(const std::string& label, const int fingers, const bool tuio2) {
+	const std::vector<std::string>	packets = record(fingers, tuio2);
+	const Poco::Net::SocketAddress	from("127.0.0.1", 3333);
+
+	ds::ui::TuioReceiver	receiver;
+	receiver.setScale(SCALE);
+	Counts					counts;
+	int						frame = 0;
+	// Only while measuring latency, when receive() was called for the packet
+	std::vector<double>*	latencyUs = nullptr;
+	std::chrono::steady_clock::time_point	received;
+	auto					latency = [&latencyUs, &received]() {
+		if (latencyUs) latencyUs->push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - received).count());
+	};
+	receiver.setHandlers(
+		[&counts, &latency](const ds::ui::TouchEvent& e) {
+			latency();
+			counts.mBegan += e.getTouches().size();
+			++counts.mEvents;
+		},
+		[&counts, &frame, &latency, fingers](const ds::ui::TouchEvent& e) {
+			latency();
+			const std::vector<ci::app::TouchEvent::Touch>&	touches = e.getTouches();
+			counts.mMoved += touches.size();
+			++counts.mEvents;
+			for (auto it = touches.begin(), end = touches.end(); it != end; ++it) {
+				const int	f = static_cast<int>(it->getId()) % fingers;
+				if (glm::distance(it->getPos(), finger_pos(f, frame) * SCALE) > TOLERANCE) ++counts.mWrongPos;
+				if (glm::distance(it->getPrevPos(), finger_pos(f, frame - 1) * SCALE) > TOLERANCE) ++counts.mWrongPos;
+			}
+		},
+		[&counts, &latency](const ds::ui::TouchEvent& e) {
+			latency();
+			counts.mEnded += e.getTouches().size();
+			++counts.mEvents;
+		});
+
+	// Once through to check what came out
+	for (frame = 0; frame < FRAMES; ++frame) {
+		receiver.receive(packets[frame].data(), packets[frame].size(), from, Poco::Timestamp().epochMicroseconds());
+	}
+	const int				holds = FRAMES / (HOLD_FRAMES + 1);
+	DS_CHECK_EQ(FRAMES % (HOLD_FRAMES + 1), 0);
+	DS_CHECK_EQ(counts.mBegan, static_cast<long long>(holds * fingers));
+	DS_CHECK_EQ(counts.mMoved, static_cast<long long>(holds * (HOLD_FRAMES - 1) * fingers));
+	DS_CHECK_EQ(counts.mEnded, static_cast<long long>(holds * fingers));
+	// A began on the first frame of a hold, moves after, an ended on the lift
+	DS_CHECK_EQ(counts.mEvents, static_cast<long long>(holds * (HOLD_FRAMES + 1)));
+	DS_CHECK_EQ(counts.mWrongPos, static_cast<long long>(0));
+	const long long			perPass = counts.mBegan + counts.mMoved + counts.mEnded;
+
+	// Then timed. The recording starts its frame ids over, which counts as the tracker restarting.
+	const long long			touchesBefore = receiver.getStats().mTouches;
+	const double			ms = ds::test::best_ms(REPS, [&]() {
+		for (frame = 0; frame < FRAMES; ++frame) {
+			receiver.receive(packets[frame].data(), packets[frame].size(), from, Poco::Timestamp().epochMicroseconds());
+		}
+	});
+	const ds::ui::TuioReceiver::Stats	stats = receiver.getStats();
+	DS_CHECK_EQ(stats.mPackets, static_cast<long long>((REPS + 1) * FRAMES));
+	DS_CHECK_EQ(stats.mTouches - touchesBefore, static_cast<long long>(REPS) * perPass);
+
+	// Then once more, timing each handler call from its receive(), outside the timed passes
+	std::vector<double>		us;
+	us.reserve(FRAMES);
+	latencyUs = &us;
+	for (frame = 0; frame < FRAMES; ++frame) {
+		received = std::chrono::steady_clock::now();
+		receiver.receive(packets[frame].data(), packets[frame].size(), from, Poco::Timestamp().epochMicroseconds());
+	}
+	latencyUs = nullptr;
+	DS_CHECK_EQ(static_cast<long long>(us.size()), static_cast<long long>(holds * (HOLD_FRAMES + 1)));
+
+	ds::test::print_ms(label + ", " + std::to_string(FRAMES) + " packets", ms);
+	std::cout << label << ": " << std::fixed << std::setprecision(1) << static_cast<double>(perPass) / ms / 1000.0 << "M touches/s" << std::endl;
+	std::cout << label << ": receive() to handler p50 " << percentile(us, 0.5) << " us, p99 " << percentile(us, 0.99)
+			  << " us, max " << (us.empty() ? 0.0 : *std::max_element(us.begin(), us.end())) << " us" << std::endl;
+}
+
+}
+
+int main() {
+	run("TUIO 1.1, 10 fingers", 10, false);
+	run("TUIO 1.1, 60 fingers", 60, false);
+	run("TUIO 2.0, 60 fingers", 60, true);
+
+	return ds::test::result("tuio_receiver_bench");
+}
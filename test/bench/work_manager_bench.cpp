@@ -0,0 +1,244 @@
+#include "ds/thread/work_manager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ds/query/sqlite/sqlite3.h"
+#include "ds/thread/work_client.h"
+#include "ds_test.h"
+#include "bench/bench.h"
+
+/**
+ * A mixed load through WorkManager, the way an app sends it: image work in the
+ * interactive lane, SQLite queries and HTTP requests in the IO lane, and
+ * pinned decoder steps in the background lane that must run in order per
+ * stream. Sent all at once for the jobs a second the pool can do, then a
+ * batch each 60Hz frame while the main thread updates, like the engine does,
+ * for the p50, p99 and max latency from send until the client has the result
+ * on the main thread, for each kind.
+ *
+ * The queries run on a real in-memory SQLite database. HTTP is a blocking
+ * wait, there's no server to talk to here.
+ */
+
+namespace {
+
+enum Kind { IMAGE, SQLITE, HTTP, PINNED, KIND_COUNT };
+const char*					KIND_NAMES[KIND_COUNT] = { "image (interactive)", "sqlite (io)", "http (io)", "pinned (background)" };
+
+const int					JOBS = 4000;
+// Sent each frame, when paced
+const int					BATCH = 16;
+const auto					FRAME = std::chrono::microseconds(16667);
+const int					STREAMS = 4;
+const int					IMAGE_SIZE = 256;
+const int					SQL_ROWS = 200;
+const int					HTTP_WAIT_MS = 3;
+
+typedef std::chrono::steady_clock	Clock;
+
+class BenchRequest : public ds::WorkRequest {
+public:
+	BenchRequest(const void* clientId, const Kind kind, const int seq)
+		: ds::WorkRequest(clientId), mKind(kind), mSeq(seq), mResult(0), mStreamOrder(0) { }
+
+	virtual void			run() {
+		switch (mKind) {
+		case IMAGE:		mResult = blur(); break;
+		case SQLITE:	mResult = query(); break;
+		case HTTP:		std::this_thread::sleep_for(std::chrono::milliseconds(HTTP_WAIT_MS)); mResult = 1; break;
+		case PINNED:	mResult = decodeStep(); break;
+		default:		break;
+		}
+	}
+
+	const Kind				mKind;
+	const int				mSeq;
+	Clock::time_point		mSent;
+	long long				mResult;
+	// Pinned only, the step within its stream when it ran
+	int						mStreamOrder;
+	// Pinned only, set by the worker that runs the stream
+	static int				sStreamNext[STREAMS];
+
+private:
+	// A 3x3 box filter over one channel of a generated image, answers the sum
+	long long				blur() const {
+		std::vector<unsigned char>	src(IMAGE_SIZE * IMAGE_SIZE), dst(IMAGE_SIZE * IMAGE_SIZE, 0);
+		for (int i = 0; i < IMAGE_SIZE * IMAGE_SIZE; ++i) src[i] = static_cast<unsigned char>((i * 7 + mSeq) & 0xff);
+		long long				sum = 0;
+		for (int y = 1; y < IMAGE_SIZE - 1; ++y) {
+			for (int x = 1; x < IMAGE_SIZE - 1; ++x) {
+				int				v = 0;
+				for (int dy = -1; dy <= 1; ++dy) {
+					for (int dx = -1; dx <= 1; ++dx) v += src[(y + dy) * IMAGE_SIZE + x + dx];
+				}
+				dst[y * IMAGE_SIZE + x] = static_cast<unsigned char>(v / 9);
+				sum += dst[y * IMAGE_SIZE + x];
+			}
+		}
+		return sum;
+	}
+
+	// Fill a table and sum it back, answers the sum or -1
+	long long				query() const {
+		sqlite3*				db = nullptr;
+		if (sqlite3_open(":memory:", &db) != SQLITE_OK) {
+			sqlite3_close(db);
+			return -1;
+		}
+		long long				sum = -1;
+		std::string				sql = "CREATE TABLE t (id INTEGER PRIMARY KEY, v INTEGER); BEGIN;";
+		for (int k = 1; k <= SQL_ROWS; ++k) sql += " INSERT INTO t (v) VALUES (" + std::to_string(k) + ");";
+		sql += " COMMIT;";
+		sqlite3_stmt*			stmt = nullptr;
+		if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK
+				&& sqlite3_prepare_v2(db, "SELECT SUM(v) FROM t WHERE id % 2 = 0", -1, &stmt, nullptr) == SQLITE_OK
+				&& sqlite3_step(stmt) == SQLITE_ROW) {
+			sum = sqlite3_column_int64(stmt, 0);
+		}
+		sqlite3_finalize(stmt);
+		sqlite3_close(db);
+		return sum;
+	}
+
+	long long				decodeStep() {
+		const int				stream = mSeq % STREAMS;
+		mStreamOrder = sStreamNext[stream]++;
+		unsigned long long		h = static_cast<unsigned long long>(mSeq);
+		for (int k = 0; k < 20000; ++k) h = h * 6364136223846793005ULL + 1442695040888963407ULL;
+		return static_cast<long long>(h >> 1) | 1;
+	}
+};
+
+int							BenchRequest::sStreamNext[STREAMS];
+
+class BenchClient : public ds::WorkClient {
+public:
+	BenchClient(ds::WorkManager& wm)
+		: ds::WorkClient(wm), mReceived(0), mWrong(0), mOutOfOrder(0) {
+		for (int s = 0; s < STREAMS; ++s) mStreamSent[s] = 0;
+	}
+
+	bool					send(const Kind kind, const int seq) {
+		std::unique_ptr<BenchRequest>	r(new BenchRequest(this, kind, seq));
+		if (kind == IMAGE) r->setLane(ds::WorkRequest::LANE_INTERACTIVE);
+		else if (kind == SQLITE || kind == HTTP) r->setLane(ds::WorkRequest::LANE_IO);
+		else r->setAffinity(seq % STREAMS);
+		if (kind == PINNED) mExpectedOrder.push_back(mStreamSent[seq % STREAMS]++);
+		else mExpectedOrder.push_back(-1);
+		r->mSent = Clock::now();
+		return mManager.sendRequest(std::move(r));
+	}
+
+	int						mReceived;
+	int						mWrong;
+	int						mOutOfOrder;
+	std::vector<double>		mLatencyUs[KIND_COUNT];
+	std::vector<int>		mExpectedOrder;
+
+protected:
+	virtual void			handleResult(std::unique_ptr<ds::WorkRequest>& wr) {
+		const BenchRequest*	r = dynamic_cast<const BenchRequest*>(wr.get());
+		if (!r) return;
+		mLatencyUs[r->mKind].push_back(std::chrono::duration<double, std::micro>(Clock::now() - r->mSent).count());
+		++mReceived;
+		if (r->mKind == SQLITE && r->mResult != expectedSum()) ++mWrong;
+		if (r->mKind != SQLITE && r->mResult <= 0) ++mWrong;
+		if (r->mKind == PINNED && r->mStreamOrder != mExpectedOrder[r->mSeq]) ++mOutOfOrder;
+	}
+
+private:
+	// The even rows of 1..SQL_ROWS
+	static long long		expectedSum() {
+		long long			sum = 0;
+		for (int k = 2; k <= SQL_ROWS; k += 2) sum += k;
+		return sum;
+	}
+
+	int						mStreamSent[STREAMS];
+};
+
+// Roughly the share of each kind in an app that loads media over a CMS
+Kind						kind_for(const int seq) {
+	const int				slot = seq % 10;
+	if (slot < 5) return IMAGE;
+	if (slot < 7) return SQLITE;
+	if (slot < 8) return HTTP;
+	return PINNED;
+}
+
+double						percentile(std::vector<double> v, const double p) {
+	if (v.empty()) return 0.0;
+	std::sort(v.begin(), v.end());
+	const size_t			k = std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())));
+	return v[k];
+}
+
+void						print_latency(const std::string& label, const std::vector<double>& us) {
+	std::cout << std::left << std::setw(24) << label << std::right << std::fixed << std::setprecision(0)
+			  << std::setw(6) << us.size() << " jobs   p50 " << std::setw(7) << percentile(us, 0.5)
+			  << " us   p99 " << std::setw(7) << percentile(us, 0.99)
+			  << " us   max " << std::setw(7) << (us.empty() ? 0.0 : *std::max_element(us.begin(), us.end())) << " us" << std::endl;
+}
+
+// Answers the seconds to get every result back. paced sends a batch a frame, otherwise it's all at once.
+double						run(const bool paced, BenchClient& client, ds::WorkManager& wm) {
+	const auto				start = Clock::now();
+	const auto				give_up = start + std::chrono::seconds(60);
+	auto					nextFrame = start;
+	int						sent = 0;
+	while (client.mReceived < JOBS && Clock::now() < give_up) {
+		if (!paced || Clock::now() >= nextFrame) {
+			for (int k = 0; (!paced || k < BATCH) && sent < JOBS; ++k, ++sent) {
+				DS_CHECK(client.send(kind_for(sent), sent));
+			}
+			nextFrame += FRAME;
+		}
+		wm.update();
+		std::this_thread::yield();
+	}
+	const double			seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	DS_CHECK_EQ(client.mReceived, JOBS);
+	DS_CHECK_EQ(client.mWrong, 0);
+	DS_CHECK_EQ(client.mOutOfOrder, 0);
+	return seconds;
+}
+
+void						print_latencies(const BenchClient& client) {
+	std::vector<double>		all;
+	for (int k = 0; k < KIND_COUNT; ++k) {
+		print_latency(KIND_NAMES[k], client.mLatencyUs[k]);
+		all.insert(all.end(), client.mLatencyUs[k].begin(), client.mLatencyUs[k].end());
+	}
+	print_latency("all", all);
+}
+
+}
+
+int main() {
+	ds::WorkManager			wm;
+	wm.setUpdateBudget(0.0);
+
+	{
+		BenchClient			client(wm);
+		const double		seconds = run(false, client, wm);
+		std::cout << JOBS << " mixed jobs at once: " << std::fixed << std::setprecision(3) << seconds * 1000.0 << " ms, "
+				  << std::setprecision(0) << static_cast<double>(JOBS) / seconds << " jobs/s" << std::endl;
+		print_latencies(client);
+	}
+
+	for (int s = 0; s < STREAMS; ++s) BenchRequest::sStreamNext[s] = 0;
+	{
+		BenchClient			client(wm);
+		run(true, client, wm);
+		std::cout << JOBS << " mixed jobs, " << BATCH << " a frame at 60Hz:" << std::endl;
+		print_latencies(client);
+	}
+
+	wm.stopManager();
+	return ds::test::result("work_manager_bench");
+}
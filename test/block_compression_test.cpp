@@ -0,0 +1,77 @@
+#include "ds/gl/block_compression.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdlib.h>
+#include <vector>
+#include "ds_test.h"
+
+/**
+ * CPU round trip of the BC1/BC3 encoder: encode a synthetic image, decode it
+ * again and compare. Gradients with a little noise are what photos and UI
+ * art look like to a 4x4 block coder, so the PSNR floors are set there.
+ */
+
+namespace {
+
+// Smooth gradients plus low amplitude noise. Alpha is a diagonal ramp.
+std::vector<uint8_t>		make_image(const int w, const int h, const bool withAlpha) {
+	std::vector<uint8_t>	ans(static_cast<size_t>(w * h * 4));
+	srand(1234);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			uint8_t*		p = &ans[(y * w + x) * 4];
+			const int		noise = (rand() % 9) - 4;
+			p[0] = static_cast<uint8_t>(std::min(255, std::max(0, (x * 255) / (w - 1) + noise)));
+			p[1] = static_cast<uint8_t>(std::min(255, std::max(0, (y * 255) / (h - 1) + noise)));
+			p[2] = static_cast<uint8_t>(std::min(255, std::max(0, ((x + y) * 255) / (w + h - 2) + noise)));
+			p[3] = withAlpha ? static_cast<uint8_t>(((x + y) * 255) / (w + h - 2)) : 255;
+		}
+	}
+	return ans;
+}
+
+double						round_trip(const std::vector<uint8_t>& src, const int w, const int h, const GLenum fmt, const bool alpha) {
+	std::vector<uint8_t>	blocks, decoded;
+	if (!DS_CHECK(ds::gl::encodeBlocks(src.data(), w, h, static_cast<size_t>(w * 4), fmt, blocks))) return 0.0;
+	// 8 bytes per 4x4 block for BC1, 16 for BC3
+	const size_t			blockCount = static_cast<size_t>(((w + 3) / 4) * ((h + 3) / 4));
+	DS_CHECK_EQ(blocks.size(), blockCount * (fmt == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16));
+	if (!DS_CHECK(ds::gl::decodeBlocks(blocks.data(), blocks.size(), w, h, fmt, decoded))) return 0.0;
+	if (!DS_CHECK_EQ(decoded.size(), src.size())) return 0.0;
+	return ds::gl::computePsnr(src.data(), decoded.data(), static_cast<size_t>(w * h), alpha);
+}
+
+}
+
+int main() {
+	// Sizes that aren't a multiple of the block size exercise the partial edge blocks
+	const int					sizes[][2] = { { 256, 256 }, { 130, 67 }, { 37, 21 } };
+	for (auto it = std::begin(sizes); it != std::end(sizes); ++it) {
+		const int				w = (*it)[0], h = (*it)[1];
+
+		const std::vector<uint8_t>	opaque = make_image(w, h, false);
+		const double			bc1 = round_trip(opaque, w, h, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, false);
+		std::cout << "BC1 " << w << "x" << h << " rgb psnr=" << bc1 << " dB" << std::endl;
+		DS_CHECK(bc1 > 30.0);
+
+		const std::vector<uint8_t>	blended = make_image(w, h, true);
+		const double			bc3rgb = round_trip(blended, w, h, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, false);
+		const double			bc3rgba = round_trip(blended, w, h, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, true);
+		std::cout << "BC3 " << w << "x" << h << " rgb psnr=" << bc3rgb << " dB, rgba psnr=" << bc3rgba << " dB" << std::endl;
+		DS_CHECK(bc3rgb > 30.0);
+		DS_CHECK(bc3rgba > 30.0);
+	}
+
+	// A flat colour should come back exactly
+	std::vector<uint8_t>		flat(64 * 4);
+	for (size_t i = 0; i < flat.size(); i += 4) {
+		flat[i] = 200; flat[i + 1] = 100; flat[i + 2] = 50; flat[i + 3] = 255;
+	}
+	std::vector<uint8_t>		blocks, decoded;
+	DS_CHECK(ds::gl::encodeBlocks(flat.data(), 8, 8, 32, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, blocks));
+	DS_CHECK(ds::gl::decodeBlocks(blocks.data(), blocks.size(), 8, 8, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, decoded));
+	DS_CHECK(ds::gl::computePsnr(flat.data(), decoded.data(), 64, true) > 40.0);
+
+	return ds::test::result("block_compression_test");
+}
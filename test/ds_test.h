@@ -0,0 +1,42 @@
+#pragma once
+#ifndef DS_TEST_DSTEST_H_
+#define DS_TEST_DSTEST_H_
+
+#include <iostream>
+
+/**
+ * Minimal checks for the programs under test/. A failed check prints where it
+ * failed and counts, the program returns ds_test_result() from main().
+ */
+namespace ds {
+namespace test {
+
+inline int&				failure_count() {
+	static int			count = 0;
+	return count;
+}
+
+inline bool				report(const bool ok, const char* expr, const char* file, const int line) {
+	if (!ok) {
+		std::cerr << file << "(" << line << "): check failed: " << expr << std::endl;
+		++failure_count();
+	}
+	return ok;
+}
+
+inline int				result(const char* name) {
+	if (failure_count() == 0) {
+		std::cout << name << ": passed" << std::endl;
+		return 0;
+	}
+	std::cerr << name << ": " << failure_count() << " check(s) failed" << std::endl;
+	return 1;
+}
+
+} // namespace test
+} // namespace ds
+
+#define DS_CHECK(expr)			ds::test::report(!!(expr), #expr, __FILE__, __LINE__)
+#define DS_CHECK_EQ(a, b)		ds::test::report((a) == (b), #a " == " #b, __FILE__, __LINE__)
+
+#endif // DS_TEST_DSTEST_H_
@@ -0,0 +1,101 @@
+#pragma once
+#ifndef DS_TEST_FAKEGLUPLOADDEVICE_H_
+#define DS_TEST_FAKEGLUPLOADDEVICE_H_
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "ds/thread/gl_upload_pool.h"
+
+namespace ds {
+namespace test {
+
+/**
+ * \class ds::test::FakeGlUploadDevice
+ * \brief A GlUploadDevice without GL. Contexts do nothing and fences stay
+ * unsignaled until the test signals them, so it decides when the "GPU" is done.
+ * The device has to outlive the pool's workers, the pool owns a FakeGlUploadDevice::Handle.
+ */
+class FakeGlUploadDevice {
+public:
+	struct Fence {
+		Fence(const int id) : mId(id), mSignaled(false), mDeleted(false) { }
+		const int				mId;
+		bool					mSignaled;
+		bool					mDeleted;
+	};
+
+	FakeGlUploadDevice() : mNextId(0), mContexts(0) { }
+
+	// Hand this to GlUploadPool::setDevice()
+	std::unique_ptr<GlUploadDevice>	makeHandle()	{ return std::unique_ptr<GlUploadDevice>(new Handle(*this)); }
+
+	// Signal every fence made so far
+	void						signalAll() {
+		std::lock_guard<std::mutex>	l(mMutex);
+		for (auto it = mFences.begin(), end = mFences.end(); it != end; ++it) (*it)->mSignaled = true;
+	}
+
+	size_t						getFenceCount() const {
+		std::lock_guard<std::mutex>	l(mMutex);
+		return mFences.size();
+	}
+
+	size_t						getDeletedCount() const {
+		std::lock_guard<std::mutex>	l(mMutex);
+		return static_cast<size_t>(std::count_if(mFences.begin(), mFences.end(), [](const std::unique_ptr<Fence>& f) { return f->mDeleted; }));
+	}
+
+	// Number of contexts made current on a worker
+	size_t						getContextCount() const {
+		std::lock_guard<std::mutex>	l(mMutex);
+		return mContexts;
+	}
+
+private:
+	class Context : public GlUploadContext {
+	public:
+		Context(FakeGlUploadDevice& d) : mDevice(d) { }
+		virtual void			makeCurrent() {
+			std::lock_guard<std::mutex>	l(mDevice.mMutex);
+			++mDevice.mContexts;
+		}
+		virtual void*			fence() {
+			std::lock_guard<std::mutex>	l(mDevice.mMutex);
+			mDevice.mFences.push_back(std::unique_ptr<Fence>(new Fence(mDevice.mNextId++)));
+			return mDevice.mFences.back().get();
+		}
+	private:
+		FakeGlUploadDevice&		mDevice;
+	};
+
+	class Handle : public GlUploadDevice {
+	public:
+		Handle(FakeGlUploadDevice& d) : mDevice(d) { }
+		virtual std::unique_ptr<GlUploadContext>
+								createContext()			{ return std::unique_ptr<GlUploadContext>(new Context(mDevice)); }
+		virtual bool			isSignaled(void* fence) {
+			std::lock_guard<std::mutex>	l(mDevice.mMutex);
+			return static_cast<Fence*>(fence)->mSignaled;
+		}
+		virtual void			deleteFence(void* fence) {
+			std::lock_guard<std::mutex>	l(mDevice.mMutex);
+			static_cast<Fence*>(fence)->mDeleted = true;
+		}
+	private:
+		FakeGlUploadDevice&		mDevice;
+	};
+
+	mutable std::mutex			mMutex;
+	// Kept after they're deleted, so the test can count them
+	std::vector<std::unique_ptr<Fence>>
+								mFences;
+	int							mNextId;
+	size_t						mContexts;
+};
+
+} // namespace test
+} // namespace ds
+
+#endif // DS_TEST_FAKEGLUPLOADDEVICE_H_
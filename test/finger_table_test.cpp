@@ -0,0 +1,101 @@
+#include "ds/ui/touch/finger_table.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+#include "ds_test.h"
+
+/**
+ * Two million random adds and removes on a FingerTable, checked against a
+ * std::map after every operation, with a full comparison every so often.
+ * Ids come from a small range so the same ones keep coming back, and from
+ * the ends of the int range, so probes wrap around the hash.
+ */
+
+namespace {
+
+const size_t				CAPACITY = 256;
+const int					OPERATIONS = 2000000;
+const int					FULL_CHECK_EVERY = 1000;
+
+struct Record {
+	Record() : mId(-1), mValue(0) { }
+	int						mId;
+	int						mValue;
+};
+
+int							random_id(std::mt19937& rng) {
+	const unsigned			r = rng();
+	switch (r % 8) {
+		case 0:		return static_cast<int>(rng() >> 1);
+		case 1:		return -2 - static_cast<int>(rng() % 64);
+		default:	return static_cast<int>(r % 600);
+	}
+}
+
+// The table and the map hold the same ids and values, and the active list covers each once
+bool						same(const ds::ui::FingerTable<Record>& table, const std::map<int, int>& model) {
+	if (table.size() != model.size()) return false;
+	std::vector<int>		active;
+	for (size_t i = 0; i < table.size(); ++i) active.push_back(table.getActive(i).mId);
+	std::sort(active.begin(), active.end());
+	if (std::adjacent_find(active.begin(), active.end()) != active.end()) return false;
+	for (auto it = model.begin(), end = model.end(); it != end; ++it) {
+		const Record*		r = table.find(it->first);
+		if (!r || r->mId != it->first || r->mValue != it->second) return false;
+		if (!std::binary_search(active.begin(), active.end(), it->first)) return false;
+	}
+	return true;
+}
+
+}
+
+int main() {
+	ds::ui::FingerTable<Record>	table(CAPACITY);
+	std::map<int, int>		model;
+	std::mt19937			rng(42);
+
+	size_t					wrong = 0, full = 0, fullChecks = 0;
+	for (int op = 0; op < OPERATIONS; ++op) {
+		const int			id = random_id(rng);
+		// Lean towards adds while it's emptier, so the table spends time near full
+		const bool			adding = (rng() % 100) < (model.size() < CAPACITY / 2 ? 60u : 45u);
+
+		if (adding) {
+			Record*			r = table.add(id);
+			auto			found = model.find(id);
+			if (found != model.end()) {
+				if (!r || r->mId != id || r->mValue != found->second) ++wrong;
+			} else if (model.size() == CAPACITY) {
+				if (r) ++wrong;
+				++full;
+			} else if (!r) {
+				++wrong;
+			} else {
+				r->mId = id;
+				r->mValue = op;
+				model[id] = op;
+			}
+		} else {
+			const bool		had = model.erase(id) > 0;
+			if ((table.find(id) != nullptr) != had) ++wrong;
+			table.remove(id);
+			if (table.find(id)) ++wrong;
+		}
+
+		if (op % FULL_CHECK_EVERY == 0) {
+			++fullChecks;
+			if (!same(table, model)) ++wrong;
+		}
+	}
+	DS_CHECK_EQ(wrong, static_cast<size_t>(0));
+	DS_CHECK(same(table, model));
+	// The run really did fill the table
+	DS_CHECK(full > 0);
+
+	// -1 marks empty hash entries, so it can't be a finger
+	DS_CHECK(table.add(-1) == nullptr);
+
+	return ds::test::result("finger_table_test");
+}
@@ -0,0 +1,212 @@
+#include "ds/ui/touch/gesture_recognizers.h"
+
+#include <cmath>
+#include <vector>
+#include "ds_test.h"
+
+/**
+ * The tap, swipe and pinch recognizers on recorded touches, with no sprite or
+ * engine: taps, a drag and a second finger that stop a tap, double taps and a
+ * tap that waits out the double tap time, fast and slow flicks, and two
+ * finger scale and rotate.
+ */
+
+namespace {
+
+const float					MIN_TAP_DISTANCE = 20.0f;
+const float					DOUBLE_TAP_TIME = 0.35f;
+const size_t				SWIPE_QUEUE = 4;
+const float					SWIPE_MIN_VELOCITY = 800.0f;
+const float					SWIPE_MAX_TIME = 0.5f;
+const float					FRAME = 1.0f / 60.0f;
+
+// One touch as it reached a sprite
+struct Recorded {
+	ds::ui::TouchInfo::Phase	mPhase;
+	int						mFinger;
+	float					mX, mY;
+	float					mTime;
+};
+
+struct Tap {
+	ds::ui::TapRecognizer::Event	mEvent;
+	ci::vec3				mPos;
+};
+
+// Plays touches through a TapRecognizer the way TouchProcess does, checking for
+// a waiting tap at each touch's time. Answers the taps it saw.
+std::vector<Tap>			play_taps(const std::vector<Recorded>& touches, const bool waitForDouble, const float endTime) {
+	ds::ui::TapRecognizer	recognizer;
+	std::vector<Tap>		taps;
+	std::vector<ds::ui::TouchInfo>	down;
+
+	for (auto it = touches.begin(), end = touches.end(); it != end; ++it) {
+		Tap					waited;
+		waited.mEvent = recognizer.update(it->mTime, DOUBLE_TAP_TIME, waited.mPos);
+		if (waited.mEvent != ds::ui::TapRecognizer::NONE) taps.push_back(waited);
+
+		ds::ui::TouchInfo	ti;
+		ti.mPhase = it->mPhase;
+		ti.mFingerId = it->mFinger;
+		ti.mCurrentGlobalPoint = ci::vec3(it->mX, it->mY, 0.0f);
+		ti.mStartPoint = ti.mCurrentGlobalPoint;
+		ti.mPassedTouch = false;
+		for (auto d = down.begin(); d != down.end(); ++d) {
+			if (d->mFingerId == ti.mFingerId) ti.mStartPoint = d->mStartPoint;
+		}
+
+		if (ti.mPhase == ds::ui::TouchInfo::Added && down.empty()) {
+			recognizer.begin();
+		} else if (recognizer.follow(ti, down.size(), MIN_TAP_DISTANCE) && ti.mPhase == ds::ui::TouchInfo::Removed) {
+			Tap				tap;
+			tap.mEvent = recognizer.up(ti.mCurrentGlobalPoint, it->mTime, waitForDouble);
+			tap.mPos = ti.mCurrentGlobalPoint;
+			if (tap.mEvent != ds::ui::TapRecognizer::NONE) taps.push_back(tap);
+			if (down.size() == 1) recognizer.cancel();
+		}
+
+		if (ti.mPhase == ds::ui::TouchInfo::Added) {
+			down.push_back(ti);
+		} else if (ti.mPhase == ds::ui::TouchInfo::Removed) {
+			for (auto d = down.begin(); d != down.end(); ++d) {
+				if (d->mFingerId == ti.mFingerId) {
+					down.erase(d);
+					break;
+				}
+			}
+		}
+	}
+
+	Tap						waited;
+	waited.mEvent = recognizer.update(endTime, DOUBLE_TAP_TIME, waited.mPos);
+	if (waited.mEvent != ds::ui::TapRecognizer::NONE) taps.push_back(waited);
+	return taps;
+}
+
+// A finger that lands at x, y and moves by dx a frame for frames frames, then lifts
+std::vector<Recorded>		stroke(const int finger, const float x, const float y, const float dx, const int frames, const float start) {
+	std::vector<Recorded>	touches;
+	Recorded				r = { ds::ui::TouchInfo::Added, finger, x, y, start };
+	touches.push_back(r);
+	for (int i = 1; i <= frames; ++i) {
+		r.mPhase = ds::ui::TouchInfo::Moved;
+		r.mX = x + dx * i;
+		r.mTime = start + FRAME * i;
+		touches.push_back(r);
+	}
+	r.mPhase = ds::ui::TouchInfo::Removed;
+	r.mTime += FRAME;
+	touches.push_back(r);
+	return touches;
+}
+
+std::vector<Recorded>		join(std::vector<Recorded> a, const std::vector<Recorded>& b) {
+	a.insert(a.end(), b.begin(), b.end());
+	return a;
+}
+
+// Answers whether a flick of dx a frame counts as a swipe, and the swipe
+bool						flick(const float dx, const float lastAge, ci::vec3& swipe) {
+	ds::ui::SwipeRecognizer	recognizer;
+	float					t = 0.0f;
+	for (int i = 0; i < 10; ++i, t += FRAME) recognizer.add(ci::vec3(dx * i, 0.0f, 0.0f), t, SWIPE_QUEUE);
+	return recognizer.happened(t + lastAge, SWIPE_QUEUE, SWIPE_MIN_VELOCITY, SWIPE_MAX_TIME, swipe);
+}
+
+bool						near(const float a, const float b) {
+	return std::abs(a - b) < 0.001f;
+}
+
+}
+
+int main() {
+	// A still finger is a tap, where it lifted
+	{
+		const std::vector<Tap>	taps = play_taps(stroke(1, 100.0f, 100.0f, 2.0f, 5, 0.0f), false, 1.0f);
+		DS_CHECK_EQ(taps.size(), static_cast<size_t>(1));
+		DS_CHECK(!taps.empty() && taps[0].mEvent == ds::ui::TapRecognizer::TAP && near(taps[0].mPos.x, 110.0f));
+	}
+
+	// Moving past the tap distance makes it a drag
+	DS_CHECK(play_taps(stroke(1, 100.0f, 100.0f, 5.0f, 5, 0.0f), false, 1.0f).empty());
+
+	// So does a second finger
+	{
+		std::vector<Recorded>	touches;
+		const Recorded			recorded[] = {
+			{ ds::ui::TouchInfo::Added, 1, 100.0f, 100.0f, 0.0f },
+			{ ds::ui::TouchInfo::Added, 2, 200.0f, 100.0f, 0.02f },
+			{ ds::ui::TouchInfo::Moved, 1, 101.0f, 100.0f, 0.03f },
+			{ ds::ui::TouchInfo::Removed, 2, 200.0f, 100.0f, 0.05f },
+			{ ds::ui::TouchInfo::Removed, 1, 101.0f, 100.0f, 0.06f },
+		};
+		touches.assign(recorded, recorded + sizeof(recorded) / sizeof(recorded[0]));
+		DS_CHECK(play_taps(touches, false, 1.0f).empty());
+	}
+
+	// Two quick taps with double taps on are one double tap
+	{
+		const std::vector<Tap>	taps = play_taps(join(stroke(1, 100.0f, 100.0f, 0.0f, 3, 0.0f),
+													  stroke(2, 104.0f, 100.0f, 0.0f, 3, 0.2f)), true, 2.0f);
+		DS_CHECK_EQ(taps.size(), static_cast<size_t>(1));
+		DS_CHECK(!taps.empty() && taps[0].mEvent == ds::ui::TapRecognizer::DOUBLE_TAP);
+	}
+
+	// Two slow ones are two taps, the first reported once the double tap time runs out
+	{
+		const std::vector<Tap>	taps = play_taps(join(stroke(1, 100.0f, 100.0f, 0.0f, 3, 0.0f),
+													  stroke(2, 300.0f, 100.0f, 0.0f, 3, 1.0f)), true, 2.0f);
+		DS_CHECK_EQ(taps.size(), static_cast<size_t>(2));
+		DS_CHECK(taps.size() == 2 && taps[0].mEvent == ds::ui::TapRecognizer::TAP && near(taps[0].mPos.x, 100.0f));
+		DS_CHECK(taps.size() == 2 && taps[1].mEvent == ds::ui::TapRecognizer::TAP && near(taps[1].mPos.x, 300.0f));
+	}
+
+	// Nothing waits when double taps are off
+	{
+		ds::ui::TapRecognizer	tap;
+		tap.begin();
+		DS_CHECK(tap.up(ci::vec3(), 0.0f, false) == ds::ui::TapRecognizer::TAP);
+		DS_CHECK(!tap.isWaiting());
+	}
+
+	// A fast flick is a swipe, a slow drag or an old one isn't
+	{
+		ci::vec3				swipe;
+		DS_CHECK(flick(30.0f, 0.0f, swipe));
+		DS_CHECK(near(swipe.x, 30.0f) && near(swipe.y, 0.0f));
+		DS_CHECK(!flick(5.0f, 0.0f, swipe));
+		DS_CHECK(!flick(30.0f, SWIPE_MAX_TIME, swipe));
+
+		// The same flick from 120Hz input, two points a frame, is the same swipe
+		ds::ui::SwipeRecognizer	fast;
+		for (int i = 0; i < 10; ++i) fast.add(ci::vec3(15.0f * i, 0.0f, 0.0f), FRAME * 0.5f * i, SWIPE_QUEUE);
+		DS_CHECK(fast.happened(FRAME * 5.0f, SWIPE_QUEUE, SWIPE_MIN_VELOCITY, SWIPE_MAX_TIME, swipe));
+		DS_CHECK(near(swipe.x, 30.0f) && near(swipe.y, 0.0f));
+
+		// Not enough points yet
+		ds::ui::SwipeRecognizer	recognizer;
+		recognizer.add(ci::vec3(), 0.0f, SWIPE_QUEUE);
+		recognizer.add(ci::vec3(100.0f, 0.0f, 0.0f), FRAME, SWIPE_QUEUE);
+		DS_CHECK(!recognizer.happened(FRAME, SWIPE_QUEUE, SWIPE_MIN_VELOCITY, SWIPE_MAX_TIME, swipe));
+	}
+
+	// Spreading to twice as far apart while turning a quarter
+	{
+		ds::ui::Pinch			pinch;
+		pinch.measure(ci::vec3(0.0f, 0.0f, 0.0f), ci::vec3(100.0f, 0.0f, 0.0f),
+					  ci::vec3(0.0f, 0.0f, 0.0f), ci::vec3(0.0f, 200.0f, 0.0f), 10.0f);
+		DS_CHECK(near(pinch.mStartDistance, 100.0f) && near(pinch.mCurrentDistance, 200.0f));
+		DS_CHECK(near(pinch.mScale, 2.0f));
+		DS_CHECK(near(pinch.mAngle, -1.5707963f));
+
+		// Fingers on top of each other count as the minimum apart
+		pinch.measure(ci::vec3(0.0f, 0.0f, 0.0f), ci::vec3(100.0f, 0.0f, 0.0f),
+					  ci::vec3(50.0f, 0.0f, 0.0f), ci::vec3(50.0f, 0.0f, 0.0f), 10.0f);
+		DS_CHECK(near(pinch.mCurrentDistance, 10.0f) && near(pinch.mScale, 0.1f));
+
+		pinch.clear();
+		DS_CHECK(near(pinch.mScale, 1.0f) && near(pinch.mAngle, 0.0f));
+	}
+
+	return ds::test::result("gesture_recognizers_test");
+}
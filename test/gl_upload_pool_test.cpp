@@ -0,0 +1,233 @@
+#include "ds/thread/gl_upload_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ds_test.h"
+#include "fake_gl_upload_device.h"
+
+/**
+ * GlUploadPool on a fake device, so the test decides when fences signal.
+ */
+
+namespace {
+
+// Holds jobs on a worker until it's opened
+class Gate {
+public:
+	Gate() : mOpen(false), mWaiting(0) { }
+
+	void					wait() {
+		std::unique_lock<std::mutex>	l(mMutex);
+		++mWaiting;
+		mCondition.notify_all();
+		mCondition.wait(l, [this]() { return mOpen; });
+	}
+	void					open() {
+		std::lock_guard<std::mutex>	l(mMutex);
+		mOpen = true;
+		mCondition.notify_all();
+	}
+	// Block until count jobs are held
+	void					waitForHeld(const int count) {
+		std::unique_lock<std::mutex>	l(mMutex);
+		mCondition.wait(l, [this, count]() { return mWaiting >= count; });
+	}
+
+private:
+	std::mutex				mMutex;
+	std::condition_variable	mCondition;
+	bool					mOpen;
+	int						mWaiting;
+};
+
+void						serial_order() {
+	ds::test::FakeGlUploadDevice	device;
+	ds::GlUploadPool		pool;
+	pool.setDevice(device.makeHandle());
+	pool.start(4);
+	DS_CHECK(pool.isRunning());
+	DS_CHECK_EQ(device.getContextCount(), 4u);
+
+	// Two owners interleaved. Each owner's jobs must run one at a time, in order.
+	const int				COUNT = 200;
+	int						owners[2];
+	std::mutex				mutex;
+	std::vector<int>		order[2];
+	std::atomic<int>		inFlight[2];
+	bool					overlapped = false;
+	inFlight[0] = 0;
+	inFlight[1] = 0;
+	for (int k = 0; k < COUNT; ++k) {
+		for (int o = 0; o < 2; ++o) {
+			pool.uploadSerial(&owners[o], [&, o, k]() {
+				if (++inFlight[o] > 1) overlapped = true;
+				if (k % 7 == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+				{
+					std::lock_guard<std::mutex>	l(mutex);
+					order[o].push_back(k);
+				}
+				--inFlight[o];
+			});
+		}
+	}
+	pool.waitForIdle();
+	DS_CHECK(!overlapped);
+	for (int o = 0; o < 2; ++o) {
+		DS_CHECK_EQ(order[o].size(), static_cast<size_t>(COUNT));
+		for (size_t k = 0; k < order[o].size(); ++k) {
+			if (!DS_CHECK_EQ(order[o][k], static_cast<int>(k))) break;
+		}
+	}
+	// No callbacks, so no fences
+	DS_CHECK_EQ(device.getFenceCount(), 0u);
+	pool.stop();
+}
+
+void						coalesce() {
+	ds::test::FakeGlUploadDevice	device;
+	ds::GlUploadPool		pool;
+	pool.setDevice(device.makeHandle());
+	pool.start(2);
+
+	int						owner;
+	Gate					gate;
+	std::mutex				mutex;
+	std::vector<int>		ran;
+	auto					job = [&](const int id) {
+		return [&, id]() {
+			std::lock_guard<std::mutex>	l(mutex);
+			ran.push_back(id);
+		};
+	};
+
+	// The first job holds the owner's serial queue, so the rest wait behind it
+	pool.uploadSerial(&owner, [&]() { gate.wait(); job(0)(); });
+	gate.waitForHeld(1);
+	// Only the last of a run of coalescing jobs survives
+	for (int k = 1; k <= 5; ++k) pool.uploadSerial(&owner, job(k), nullptr, true);
+	// A plain serial job ends the run, so the next coalescing job queues behind it
+	pool.uploadSerial(&owner, job(6));
+	pool.uploadSerial(&owner, job(7), nullptr, true);
+	pool.uploadSerial(&owner, job(8), nullptr, true);
+	// Another owner's coalescing jobs don't touch mine
+	int						other;
+	pool.uploadSerial(&other, job(100), nullptr, true);
+
+	gate.open();
+	pool.waitForIdle();
+	std::vector<int>		mine;
+	bool					sawOther = false;
+	for (auto it = ran.begin(), end = ran.end(); it != end; ++it) {
+		if (*it == 100) sawOther = true;
+		else mine.push_back(*it);
+	}
+	DS_CHECK(sawOther);
+	DS_CHECK_EQ(mine.size(), 4u);
+	if (mine.size() == 4) {
+		DS_CHECK_EQ(mine[0], 0);
+		DS_CHECK_EQ(mine[1], 5);
+		DS_CHECK_EQ(mine[2], 6);
+		DS_CHECK_EQ(mine[3], 8);
+	}
+	pool.stop();
+}
+
+void						cancel() {
+	ds::test::FakeGlUploadDevice	device;
+	ds::GlUploadPool		pool;
+	pool.setDevice(device.makeHandle());
+	pool.start(2);
+
+	int						owner, other;
+	std::atomic<int>		callbacks(0), otherCallbacks(0);
+	std::atomic<bool>		waitingRan(false), runningFinished(false);
+	auto					onMain = [&callbacks]() { ++callbacks; };
+
+	// Done and past update(): the job sits in the pending list, waiting on its fence
+	pool.upload(&owner, []() { }, onMain);
+	pool.waitForIdle();
+	pool.update();
+	// Done, but update() hasn't seen it yet
+	pool.upload(&owner, []() { }, onMain);
+	pool.waitForIdle();
+	// Running: held on a worker
+	Gate					gate;
+	pool.uploadSerial(&owner, [&]() { gate.wait(); runningFinished = true; }, onMain);
+	gate.waitForHeld(1);
+	// Waiting: queued behind the running serial job
+	pool.uploadSerial(&owner, [&]() { waitingRan = true; }, onMain);
+	// Someone else's job, which has to be unaffected
+	pool.upload(&other, []() { }, [&otherCallbacks]() { ++otherCallbacks; });
+
+	pool.cancel(&owner);
+	gate.open();
+	pool.waitForIdle();
+	device.signalAll();
+	pool.update();
+	pool.update();
+
+	DS_CHECK(runningFinished);
+	DS_CHECK(!waitingRan);
+	DS_CHECK_EQ(callbacks.load(), 0);
+	DS_CHECK_EQ(otherCallbacks.load(), 1);
+	// Every fence is cleaned up, cancelled or not
+	DS_CHECK_EQ(device.getFenceCount(), 4u);
+	DS_CHECK_EQ(device.getDeletedCount(), device.getFenceCount());
+	pool.stop();
+}
+
+void						fenced_callbacks() {
+	ds::test::FakeGlUploadDevice	device;
+	ds::GlUploadPool		pool;
+	pool.setDevice(device.makeHandle());
+	pool.start(1);
+
+	int						owner;
+	int						callbacks = 0;
+	std::thread::id			callbackThread;
+	pool.upload(&owner, []() { }, [&]() { ++callbacks; callbackThread = std::this_thread::get_id(); });
+	pool.waitForIdle();
+
+	// The work is done, but the GPU isn't
+	pool.update();
+	pool.update();
+	DS_CHECK_EQ(callbacks, 0);
+	DS_CHECK_EQ(device.getDeletedCount(), 0u);
+
+	device.signalAll();
+	pool.update();
+	DS_CHECK_EQ(callbacks, 1);
+	DS_CHECK(callbackThread == std::this_thread::get_id());
+	DS_CHECK_EQ(device.getDeletedCount(), 1u);
+	pool.update();
+	DS_CHECK_EQ(callbacks, 1);
+	pool.stop();
+}
+
+void						no_workers() {
+	// Without start() jobs run inline, and callbacks wait for update() with no fence
+	ds::GlUploadPool		pool;
+	int						owner;
+	bool					worked = false;
+	int						callbacks = 0;
+	pool.upload(&owner, [&]() { worked = true; }, [&]() { ++callbacks; });
+	DS_CHECK(worked);
+	DS_CHECK_EQ(callbacks, 0);
+	pool.update();
+	DS_CHECK_EQ(callbacks, 1);
+}
+
+}
+
+int main() {
+	serial_order();
+	coalesce();
+	cancel();
+	fenced_callbacks();
+	no_workers();
+	return ds::test::result("gl_upload_pool_test");
+}
@@ -0,0 +1,192 @@
+#include "ds/thread/task.h"
+
+#include <chrono>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "ds/thread/work_manager.h"
+#include "ds_test.h"
+
+/**
+ * Task chains on a real WorkManager, with this thread standing in for the
+ * main thread. Also reports how long a three step chain takes from run() to
+ * deliver(), next to the same three steps written the old way, each one a
+ * WorkRequest whose handleResult() sends the next from the main thread.
+ */
+
+namespace {
+
+// Pump the manager until done is set, or give up after a few seconds
+bool					pump(ds::WorkManager& wm, const bool& done) {
+	const auto			give_up = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!done) {
+		if (std::chrono::steady_clock::now() > give_up) return false;
+		wm.update();
+		std::this_thread::yield();
+	}
+	return true;
+}
+
+// The three steps as nested requests, each result coming back through the main thread
+class NestedClient : public ds::WorkClient {
+public:
+	NestedClient(ds::WorkManager& wm) : ds::WorkClient(wm), mDone(false), mValue(0) { }
+
+	void					start(const int value) {
+		mDone = false;
+		send(value, 0);
+	}
+
+	bool					mDone;
+	int						mValue;
+
+private:
+	class Request : public ds::WorkRequest {
+	public:
+		Request(const void* clientId, const int value, const int step) : ds::WorkRequest(clientId), mValue(value), mStep(step) { }
+
+		virtual void		run()				{ mValue = (mStep == 0 ? mValue : mValue + 1); }
+
+		int					mValue;
+		const int			mStep;
+	};
+
+	void					send(const int value, const int step) {
+		mManager.sendRequest(std::unique_ptr<ds::WorkRequest>(new Request(this, value, step)));
+	}
+
+	virtual void			handleResult(std::unique_ptr<ds::WorkRequest>& wr) {
+		const Request*		r = dynamic_cast<const Request*>(wr.get());
+		if (!r) return;
+		if (r->mStep < 2) {
+			send(r->mValue, r->mStep + 1);
+			return;
+		}
+		mValue = r->mValue;
+		mDone = true;
+	}
+};
+
+}
+
+int main() {
+	ds::WorkManager			wm;
+	wm.setUpdateBudget(0.0);
+	const std::thread::id	mainId = std::this_thread::get_id();
+
+	{
+		ds::TaskClient		client(wm);
+
+		// Empty tasks chain to empty tasks, and never deliver
+		ds::Task<int>		empty;
+		DS_CHECK(empty.then([](const int& v) { return v + 1; }).empty());
+		DS_CHECK(!empty.getToken().isCancelled());
+		empty.cancel();
+		DS_CHECK(!ds::CancelToken::NONE.isCancelled());
+		bool				emptyDelivered = false;
+		empty.deliver([&emptyDelivered](const int&) { emptyDelivered = true; });
+
+		// Values flow through the chain, and are delivered on the main thread
+		bool				done = false;
+		int					value = 0;
+		bool				onMain = false;
+		client.run([]() { return 20; })
+			.then([](const int& v) { return v + 1; })
+			.then([](const int& v) { return std::to_string(v * 2); })
+			.deliver([&](const std::string& s) {
+				value = std::stoi(s);
+				onMain = (std::this_thread::get_id() == mainId);
+				done = true;
+			});
+		DS_CHECK(pump(wm, done));
+		DS_CHECK_EQ(value, 42);
+		DS_CHECK(onMain);
+		DS_CHECK(!emptyDelivered);
+
+		// A throwing step skips the rest and hands its error to deliver()
+		done = false;
+		bool				skipped = true;
+		std::string			error;
+		client.run([]() -> int { throw std::runtime_error("step failed"); })
+			.then([&skipped](const int& v) { skipped = false; return v; })
+			.deliver([&done](const int&) { done = true; },
+					 [&](const std::exception_ptr& e) {
+				try { std::rethrow_exception(e); } catch (std::exception const& ex) { error = ex.what(); }
+				done = true;
+			});
+		DS_CHECK(pump(wm, done));
+		DS_CHECK(skipped);
+		DS_CHECK_EQ(error, std::string("step failed"));
+
+		// Cancelling before the chain runs fails it with TaskCancelled
+		done = false;
+		bool				cancelled = false;
+		ds::CancelToken		token;
+		token.cancel();
+		client.run([]() { return 1; }, token)
+			.deliver([&done](const int&) { done = true; },
+					 [&](const std::exception_ptr& e) {
+				try { std::rethrow_exception(e); } catch (ds::TaskCancelled const&) { cancelled = true; } catch (...) { }
+				done = true;
+			});
+		DS_CHECK(pump(wm, done));
+		DS_CHECK(cancelled);
+
+		// whenAll gathers values in order
+		done = false;
+		std::vector<int>	all;
+		std::vector<ds::Task<int>>	tasks;
+		for (int k = 0; k < 8; ++k) tasks.push_back(client.run([k]() { return k * k; }));
+		client.whenAll(tasks).deliver([&](const std::vector<int>& v) { all = v; done = true; });
+		DS_CHECK(pump(wm, done));
+		DS_CHECK_EQ(all.size(), 8u);
+		for (size_t k = 0; k < all.size(); ++k) DS_CHECK_EQ(all[k], static_cast<int>(k * k));
+
+		// whenAll of an empty task fails instead of waiting forever
+		done = false;
+		bool				invalid = false;
+		tasks.push_back(ds::Task<int>());
+		client.whenAll(tasks).deliver([&done](const std::vector<int>&) { done = true; },
+									  [&](const std::exception_ptr& e) {
+			try { std::rethrow_exception(e); } catch (std::invalid_argument const&) { invalid = true; } catch (...) { }
+			done = true;
+		});
+		DS_CHECK(pump(wm, done));
+		DS_CHECK(invalid);
+
+		// Latency of three steps, from the first send until the main thread has the value:
+		// as a task chain, and as nested requests through the main thread
+		const int			RUNS = 1000;
+		NestedClient		nested(wm);
+		double				taskTotal = 0.0, taskWorst = 0.0, nestedTotal = 0.0, nestedWorst = 0.0;
+		for (int k = 0; k < RUNS; ++k) {
+			done = false;
+			int				taskValue = 0;
+			auto			start = std::chrono::steady_clock::now();
+			client.run([k]() { return k; })
+				.then([](const int& v) { return v + 1; })
+				.then([](const int& v) { return v + 1; })
+				.deliver([&](const int& v) { taskValue = v; done = true; });
+			if (!DS_CHECK(pump(wm, done))) break;
+			double			us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+			taskTotal += us;
+			taskWorst = std::max(taskWorst, us);
+
+			start = std::chrono::steady_clock::now();
+			nested.start(k);
+			if (!DS_CHECK(pump(wm, nested.mDone))) break;
+			us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+			nestedTotal += us;
+			nestedWorst = std::max(nestedWorst, us);
+			DS_CHECK_EQ(taskValue, k + 2);
+			DS_CHECK_EQ(nested.mValue, k + 2);
+		}
+		std::cout << std::fixed << std::setprecision(1) << "three step latency        mean      worst" << std::endl
+				  << "  run/then/then/deliver " << std::setw(7) << taskTotal / RUNS << " us " << std::setw(7) << taskWorst << " us" << std::endl
+				  << "  nested handleResult   " << std::setw(7) << nestedTotal / RUNS << " us " << std::setw(7) << nestedWorst << " us" << std::endl;
+	}
+
+	wm.stopManager();
+	return ds::test::result("task_test");
+}
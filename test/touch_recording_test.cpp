@@ -0,0 +1,229 @@
+#include "ds/debug/touch_recorder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Poco/Path.h>
+#include "ds/debug/touch_replayer.h"
+#include "ds/ui/touch/touch_event.h"
+#include "ds_test.h"
+
+/**
+ * A session through TouchRecorder and back out of TouchReplayer: every event
+ * comes back in order with its ids, positions, previous positions, source
+ * frame and world space flag; a finger left down is ended; an event too big
+ * for one record is split without losing touches; replays keep the recorded
+ * spacing, scaled by the speed, and loop; and broken files are refused or
+ * cut short.
+ */
+
+namespace {
+
+typedef ci::app::TouchEvent::Touch	Touch;
+
+// An event as a handler saw it
+struct Seen {
+	ds::TouchRecorder::Phase	mPhase;
+	bool					mInWorldSpace;
+	int32_t					mSourceFrame;
+	std::vector<Touch>		mTouches;
+};
+
+std::string					temp_path(const std::string& name) {
+	Poco::Path				path(Poco::Path::temp());
+	path.setFileName("ds_touch_recording_" + name + ".bin");
+	return path.toString();
+}
+
+ds::ui::TouchEvent			event(const std::vector<Touch>& touches, const int32_t sourceFrame, const bool inWorldSpace = false) {
+	ds::ui::TouchEvent		e(ci::app::WindowRef(), touches, inWorldSpace);
+	e.setSourceFrame(sourceFrame);
+	return e;
+}
+
+Touch						touch(const uint32_t id, const float x, const float y) {
+	return Touch(ci::vec2(x, y), ci::vec2(x, y), id, 0.0, nullptr);
+}
+
+void						listen(ds::TouchReplayer& replayer, std::vector<Seen>& seen) {
+	auto					handler = [&seen](const ds::TouchRecorder::Phase phase) {
+		return [&seen, phase](const ds::ui::TouchEvent& e) {
+			Seen			s;
+			s.mPhase = phase;
+			s.mInWorldSpace = e.getInWorldSpace();
+			s.mSourceFrame = e.getSourceFrame();
+			s.mTouches = e.getTouches();
+			seen.push_back(s);
+		};
+	};
+	replayer.setHandlers(handler(ds::TouchRecorder::BEGAN), handler(ds::TouchRecorder::MOVED), handler(ds::TouchRecorder::ENDED));
+}
+
+bool						at(const Touch& t, const uint32_t id, const float x, const float y, const float prevX, const float prevY) {
+	return t.getId() == id && t.getX() == x && t.getY() == y && t.getPrevPos().x == prevX && t.getPrevPos().y == prevY;
+}
+
+// Two fingers down, finger 1 drags, finger 2 lifts, and an ended so big it needs two records.
+// Finger 1 is still down at the end.
+const int					DRAG_MOVES = 5;
+const uint32_t				BIG_EVENT = 70000;
+
+void						record_session(const std::string& path) {
+	ds::TouchRecorder		recorder;
+	recorder.setPath(path);
+	DS_CHECK(recorder.isEnabled());
+	recorder.record(ds::TouchRecorder::BEGAN, event({ touch(1, 10.0f, 20.0f), touch(2, 30.0f, 40.0f) }, 7));
+	for (int i = 1; i <= DRAG_MOVES; ++i) {
+		recorder.record(ds::TouchRecorder::MOVED, event({ touch(1, 10.0f + 5.0f * i, 20.0f) }, 7 + i, true));
+	}
+	recorder.record(ds::TouchRecorder::ENDED, event({ touch(2, 30.0f, 40.0f) }, 20));
+
+	std::vector<Touch>		big;
+	for (uint32_t id = 0; id < BIG_EVENT; ++id) big.push_back(touch(1000 + id, 1.0f, 2.0f));
+	recorder.record(ds::TouchRecorder::ENDED, event(big, 21));
+	// No touches, nothing recorded
+	recorder.record(ds::TouchRecorder::MOVED, event(std::vector<Touch>(), 22));
+	recorder.setPath("");
+	DS_CHECK(!recorder.isEnabled());
+}
+
+}
+
+int main() {
+	const std::string		path = temp_path("session");
+	record_session(path);
+
+	// Everything comes back in order
+	{
+		ds::TouchReplayer	replayer;
+		std::vector<Seen>	seen;
+		listen(replayer, seen);
+		DS_CHECK(replayer.load(path));
+		DS_CHECK(replayer.isPlaying());
+		replayer.update(0.0);
+		replayer.update(60.0);
+		DS_CHECK(!replayer.isPlaying());
+
+		// began, the moves, finger 2's ended, the big ended in two, and finger 1 ended at the end
+		DS_CHECK_EQ(seen.size(), static_cast<size_t>(1 + DRAG_MOVES + 1 + 2 + 1));
+		if (seen.size() == static_cast<size_t>(1 + DRAG_MOVES + 1 + 2 + 1)) {
+			DS_CHECK(seen[0].mPhase == ds::TouchRecorder::BEGAN && seen[0].mSourceFrame == 7 && !seen[0].mInWorldSpace);
+			DS_CHECK(seen[0].mTouches.size() == 2 && at(seen[0].mTouches[0], 1, 10.0f, 20.0f, 10.0f, 20.0f)
+					 && at(seen[0].mTouches[1], 2, 30.0f, 40.0f, 30.0f, 40.0f));
+			for (int i = 1; i <= DRAG_MOVES; ++i) {
+				const Seen&	s = seen[i];
+				DS_CHECK(s.mPhase == ds::TouchRecorder::MOVED && s.mSourceFrame == 7 + i && s.mInWorldSpace);
+				DS_CHECK(s.mTouches.size() == 1 && at(s.mTouches[0], 1, 10.0f + 5.0f * i, 20.0f, 10.0f + 5.0f * (i - 1), 20.0f));
+			}
+			const Seen&		lifted = seen[DRAG_MOVES + 1];
+			DS_CHECK(lifted.mPhase == ds::TouchRecorder::ENDED && lifted.mSourceFrame == 20);
+			DS_CHECK(lifted.mTouches.size() == 1 && lifted.mTouches[0].getId() == 2);
+
+			const Seen&		big0 = seen[DRAG_MOVES + 2];
+			const Seen&		big1 = seen[DRAG_MOVES + 3];
+			DS_CHECK_EQ(big0.mTouches.size() + big1.mTouches.size(), static_cast<size_t>(BIG_EVENT));
+			DS_CHECK(!big1.mTouches.empty() && big1.mTouches.back().getId() == 1000 + BIG_EVENT - 1);
+
+			const Seen&		leftDown = seen.back();
+			DS_CHECK(leftDown.mPhase == ds::TouchRecorder::ENDED);
+			DS_CHECK(leftDown.mTouches.size() == 1 && at(leftDown.mTouches[0], 1, 10.0f + 5.0f * DRAG_MOVES, 20.0f, 10.0f + 5.0f * DRAG_MOVES, 20.0f));
+		}
+	}
+
+	// Looping plays it again
+	{
+		ds::TouchReplayer	replayer;
+		std::vector<Seen>	seen;
+		listen(replayer, seen);
+		replayer.setLoop(true);
+		DS_CHECK(replayer.load(path));
+		replayer.update(0.0);
+		replayer.update(60.0);
+		replayer.update(120.0);
+		DS_CHECK(replayer.isPlaying());
+		size_t				began = 0;
+		for (auto it = seen.begin(), end = seen.end(); it != end; ++it) {
+			if (it->mPhase == ds::TouchRecorder::BEGAN) ++began;
+		}
+		DS_CHECK_EQ(began, static_cast<size_t>(2));
+	}
+
+	// The gap between events plays back, scaled by the speed, and stop() ends the finger that's down
+	{
+		const std::string	timedPath = temp_path("timed");
+		{
+			ds::TouchRecorder	recorder;
+			recorder.setPath(timedPath);
+			recorder.record(ds::TouchRecorder::BEGAN, event({ touch(1, 0.0f, 0.0f) }, 1));
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			recorder.record(ds::TouchRecorder::ENDED, event({ touch(1, 0.0f, 0.0f) }, 2));
+		}
+
+		ds::TouchReplayer	replayer;
+		std::vector<Seen>	seen;
+		listen(replayer, seen);
+		replayer.setSpeed(2.0);
+		DS_CHECK(replayer.load(timedPath));
+		replayer.update(10.0);
+		replayer.update(10.05);
+		DS_CHECK_EQ(seen.size(), static_cast<size_t>(1));
+		// 200ms at double speed is due 100ms in
+		replayer.update(10.5);
+		DS_CHECK_EQ(seen.size(), static_cast<size_t>(2));
+		DS_CHECK(!replayer.isPlaying());
+
+		seen.clear();
+		DS_CHECK(replayer.load(timedPath));
+		replayer.update(0.0);
+		replayer.update(0.05);
+		replayer.stop();
+		DS_CHECK(!replayer.isPlaying());
+		DS_CHECK_EQ(seen.size(), static_cast<size_t>(2));
+		DS_CHECK(seen.size() == 2 && seen[1].mPhase == ds::TouchRecorder::ENDED && seen[1].mTouches.size() == 1
+				 && seen[1].mTouches[0].getId() == 1);
+	}
+
+	// A file that isn't a recording is refused, and a cut off one plays what's whole
+	{
+		const std::string	badPath = temp_path("bad");
+		{
+			std::ofstream	os(badPath.c_str(), std::ios::binary);
+			os << "not a touch recording";
+		}
+		ds::TouchReplayer	replayer;
+		DS_CHECK(!replayer.load(badPath));
+		DS_CHECK(!replayer.isPlaying());
+
+		std::vector<char>	data;
+		{
+			std::ifstream	is(path.c_str(), std::ios::binary);
+			data.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+		}
+		// The header, the began, and half of the first move
+		const size_t		cut = ds::TouchRecorder::MAGIC_SIZE + 1 + ds::TouchRecorder::RECORD_SIZE + 2 * ds::TouchRecorder::TOUCH_SIZE
+								  + ds::TouchRecorder::RECORD_SIZE / 2;
+		DS_CHECK(data.size() > cut);
+		const std::string	cutPath = temp_path("cut");
+		{
+			std::ofstream	os(cutPath.c_str(), std::ios::binary);
+			os.write(data.data(), static_cast<std::streamsize>(cut));
+		}
+		std::vector<Seen>	seen;
+		listen(replayer, seen);
+		DS_CHECK(replayer.load(cutPath));
+		replayer.update(0.0);
+		replayer.update(60.0);
+		// The began, then both fingers ended since the rest is gone
+		DS_CHECK_EQ(seen.size(), static_cast<size_t>(2));
+		DS_CHECK(seen.size() == 2 && seen[1].mPhase == ds::TouchRecorder::ENDED && seen[1].mTouches.size() == 2);
+	}
+
+	const char*				written[] = { "session", "timed", "bad", "cut" };
+	for (size_t k = 0; k < sizeof(written) / sizeof(written[0]); ++k) std::remove(temp_path(written[k]).c_str());
+
+	return ds::test::result("touch_recording_test");
+}